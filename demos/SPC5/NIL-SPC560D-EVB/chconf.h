@@ -283,6 +283,50 @@
 #define CH_CFG_USE_JOBS                     TRUE
 #endif
 
+/**
+ * @brief   Lock-free rings APIs.
+ * @details If enabled then the lock-free single producer, single consumer
+ *          rings APIs are included in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_RINGS)
+#define CH_CFG_USE_RINGS                    FALSE
+#endif
+
+/**
+ * @brief   Lock-free queues APIs.
+ * @details If enabled then the lock-free multiple producers, multiple
+ *          consumers queues APIs are included in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_LF_QUEUES)
+#define CH_CFG_USE_LF_QUEUES                FALSE
+#endif
+
+/**
+ * @brief   Record queues APIs.
+ * @details If enabled then the variable size records queues APIs are
+ *          included in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_REC_QUEUES)
+#define CH_CFG_USE_REC_QUEUES               FALSE
+#endif
+
+/**
+ * @brief   Reference-counted buffers APIs.
+ * @details If enabled then the reference-counted buffers APIs are included
+ *          in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_REF_BUFFERS)
+#define CH_CFG_USE_REF_BUFFERS              FALSE
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -119,6 +119,26 @@
 #define CH_CFG_NO_IDLE_THREAD               FALSE
 #endif
 
+/**
+ * @brief   Earliest deadline first scheduling band.
+ * @details If enabled then the threads at the @p CH_CFG_EDF_PRIORITY
+ *          priority level are scheduled by absolute deadline instead of
+ *          FIFO order, other priority levels are not affected.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_EDF)
+#define CH_CFG_USE_EDF                      FALSE
+#endif
+
+/**
+ * @brief   Priority level of the earliest deadline first band.
+ * @note    The priority must be greater than @p IDLEPRIO.
+ */
+#if !defined(CH_CFG_EDF_PRIORITY)
+#define CH_CFG_EDF_PRIORITY                 NORMALPRIO
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -181,6 +201,18 @@
 #define CH_CFG_USE_WAITEXIT                 TRUE
 #endif
 
+/**
+ * @brief   Periodic threads APIs.
+ * @details If enabled then the periodic activation APIs are included in
+ *          the kernel, periodic threads record response times, release
+ *          latencies, overruns and deadline misses.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_PERIODIC)
+#define CH_CFG_USE_PERIODIC                 FALSE
+#endif
+
 /**
  * @brief   Semaphores APIs.
  * @details If enabled then the Semaphores APIs are included in the kernel.
@@ -226,6 +258,34 @@
 #define CH_CFG_USE_MUTEXES_RECURSIVE        FALSE
 #endif
 
+/**
+ * @brief   Mutexes lock-free fast path.
+ * @details If enabled then uncontended mutexes are locked and unlocked
+ *          using an atomic compare-and-swap operation on the owner field,
+ *          the kernel is entered only on contention.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_MUTEXES.
+ * @note    Requires an architecture with atomic compare-and-swap, see
+ *          @p CH_MTX_CAS.
+ */
+#if !defined(CH_CFG_USE_MUTEXES_FAST_PATH)
+#define CH_CFG_USE_MUTEXES_FAST_PATH        FALSE
+#endif
+
+/**
+ * @brief   Mutexes priority ceiling protocol.
+ * @details If enabled then mutexes can be initialized with a priority
+ *          ceiling, the owner of such mutexes runs at the ceiling priority
+ *          without the priority inheritance overhead.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_MUTEXES.
+ */
+#if !defined(CH_CFG_USE_MUTEXES_CEILING)
+#define CH_CFG_USE_MUTEXES_CEILING          FALSE
+#endif
+
 /**
  * @brief   Conditional Variables APIs.
  * @details If enabled then the conditional variables APIs are included
@@ -250,6 +310,30 @@
 #define CH_CFG_USE_CONDVARS_TIMEOUT         TRUE
 #endif
 
+/**
+ * @brief   Read-Write Locks APIs.
+ * @details If enabled then the read-write locks APIs are included in the
+ *          kernel.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_MUTEXES.
+ */
+#if !defined(CH_CFG_USE_RWLOCKS)
+#define CH_CFG_USE_RWLOCKS                  FALSE
+#endif
+
+/**
+ * @brief   Maximum number of read-write locks held by a thread.
+ * @details Each thread has a holder record for each read-write lock it
+ *          can hold at the same time.
+ *
+ * @note    The default is @p 2.
+ * @note    Requires @p CH_CFG_USE_RWLOCKS.
+ */
+#if !defined(CH_CFG_RWLOCKS_MAX_HOLDS)
+#define CH_CFG_RWLOCKS_MAX_HOLDS            2
+#endif
+
 /**
  * @brief   Events Flags APIs.
  * @details If enabled then the event flags APIs are included in the kernel.
@@ -296,6 +380,41 @@
 #define CH_CFG_USE_MESSAGES_PRIORITY        FALSE
 #endif
 
+/**
+ * @brief   Message ports APIs.
+ * @details If enabled then threads can exchange zero-copy messages through
+ *          named ports with priority ordering and timeouts.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_MESSAGES.
+ */
+#if !defined(CH_CFG_USE_MESSAGE_PORTS)
+#define CH_CFG_USE_MESSAGE_PORTS            FALSE
+#endif
+
+/**
+ * @brief   Multiplexed wait APIs.
+ * @details If enabled then a thread can wait on a set of heterogeneous
+ *          objects at once using the polling APIs.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Pollable objects get an additional pollers queue.
+ */
+#if !defined(CH_CFG_USE_POLL)
+#define CH_CFG_USE_POLL                     FALSE
+#endif
+
+/**
+ * @brief   Threaded interrupt handlers APIs.
+ * @details If enabled then interrupt handlers can defer their processing
+ *          to bottom halves executed by IRQ threads.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_IRQ_THREADS)
+#define CH_CFG_USE_IRQ_THREADS              FALSE
+#endif
+
 /**
  * @brief   Dynamic Threads APIs.
  * @details If enabled then the dynamic threads creation APIs are included
@@ -436,6 +555,50 @@
 #define CH_CFG_USE_JOBS                     TRUE
 #endif
 
+/**
+ * @brief   Lock-free rings APIs.
+ * @details If enabled then the lock-free single producer, single consumer
+ *          rings APIs are included in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_RINGS)
+#define CH_CFG_USE_RINGS                    FALSE
+#endif
+
+/**
+ * @brief   Lock-free queues APIs.
+ * @details If enabled then the lock-free multiple producers, multiple
+ *          consumers queues APIs are included in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_LF_QUEUES)
+#define CH_CFG_USE_LF_QUEUES                FALSE
+#endif
+
+/**
+ * @brief   Record queues APIs.
+ * @details If enabled then the variable size records queues APIs are
+ *          included in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_REC_QUEUES)
+#define CH_CFG_USE_REC_QUEUES               TRUE
+#endif
+
+/**
+ * @brief   Reference-counted buffers APIs.
+ * @details If enabled then the reference-counted buffers APIs are included
+ *          in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_REF_BUFFERS)
+#define CH_CFG_USE_REF_BUFFERS              FALSE
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -0,0 +1,28 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    halconf.h
+ * @brief   HAL configuration header, CAN bus demo.
+ * @details Only the settings differing from the RT-Posix-Simulator demo are
+ *          defined here, everything else comes from its configuration.
+ */
+
+#define HAL_USE_CAN                         TRUE
+#define HAL_USE_EFL                         FALSE
+#define HAL_USE_SERIAL                      FALSE
+
+#include "../../RT-Posix-Simulator/cfg/halconf.h"
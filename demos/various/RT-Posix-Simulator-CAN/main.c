@@ -0,0 +1,301 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include "console.h"
+
+/*===========================================================================*/
+/* Benchmark settings.                                                       */
+/*===========================================================================*/
+
+/*
+ * Bus bit rate, zero for instantaneous frames.
+ */
+#if !defined(BENCH_BITRATE)
+#define BENCH_BITRATE                       1000000
+#endif
+
+/*
+ * Number and data length of the frames sent by a transmitter.
+ */
+#if !defined(BENCH_FRAMES)
+#define BENCH_FRAMES                        100000
+#endif
+
+#if !defined(BENCH_DLC)
+#define BENCH_DLC                           8
+#endif
+
+/*
+ * Default identifier of a transmitter.
+ */
+#if !defined(BENCH_ID)
+#define BENCH_ID                            0x100
+#endif
+
+/*
+ * Maximum number of transmitters tracked by a receiver.
+ */
+#if !defined(BENCH_MAX_SOURCES)
+#define BENCH_MAX_SOURCES                   8
+#endif
+
+/* Each instance would have its own virtual time base.*/
+#if SIM_USE_VIRTUAL_TIME == TRUE
+#error "the CAN benchmark requires SIM_USE_VIRTUAL_TIME == FALSE"
+#endif
+
+#if (BENCH_DLC < 4) || (BENCH_DLC > 8)
+#error "BENCH_DLC must be in the 4..8 range, frames carry a sequence number"
+#endif
+
+/*===========================================================================*/
+/* Benchmark code.                                                           */
+/*===========================================================================*/
+
+#define chp ((BaseSequentialStream *)&CD1)
+
+static const CANConfig cancfg = {
+  .bitrate = BENCH_BITRATE,
+  .path    = NULL
+};
+
+/*
+ * The receiver accepts standard data frames only.
+ */
+static const CANFilter canfilters[] = {
+  {
+    .mode       = 0,
+    .assignment = 0,
+    .register1  = 0U,
+    .register2  = CAN_FILTER_IDE | CAN_FILTER_RTR
+  }
+};
+
+/*
+ * Per transmitter receive statistics, transmitters put a sequence number
+ * in the first data word.
+ */
+typedef struct {
+  uint32_t  sid;
+  uint32_t  next;
+  uint32_t  frames;
+  uint32_t  lost;
+} bench_source_t;
+
+static bench_source_t sources[BENCH_MAX_SOURCES];
+static unsigned nsources;
+
+static uint64_t bench_elapsed_us(uint64_t start) {
+  uint64_t us = (_sim_get_time_ns() - start) / 1000U;
+
+  return us > 0U ? us : 1U;
+}
+
+static void bench_account(const CANRxFrame *crfp) {
+  bench_source_t *sp;
+  unsigned i;
+
+  for (i = 0U; i < nsources; i++) {
+    if (sources[i].sid == crfp->SID) {
+      break;
+    }
+  }
+  if (i >= nsources) {
+    if (nsources >= BENCH_MAX_SOURCES) {
+      return;
+    }
+    sources[nsources].sid    = crfp->SID;
+    sources[nsources].next   = crfp->data32[0];
+    sources[nsources].frames = 0U;
+    sources[nsources].lost   = 0U;
+    nsources++;
+  }
+
+  sp = &sources[i];
+  if (crfp->data32[0] != sp->next) {
+    sp->lost += crfp->data32[0] - sp->next;
+  }
+  sp->next = crfp->data32[0] + 1U;
+  sp->frames++;
+}
+
+/*
+ * Receiver, frames are fetched in batches with canTryReceiveI() each time
+ * the receive mailbox becomes non-empty, statistics are printed every
+ * second while there is traffic.
+ */
+static void bench_receiver(void) {
+  event_listener_t el;
+  CANRxFrame rxf;
+  uint64_t start = _sim_get_time_ns();
+  uint32_t total = 0U, overflows = 0U;
+  unsigned i;
+
+  chEvtRegister(&CAND1.rxfull_event, &el, 0);
+  chprintf(chp, "Receiving, bit rate %u bps\r\n", BENCH_BITRATE);
+
+  while (true) {
+    (void) chEvtWaitAnyTimeout(ALL_EVENTS, TIME_MS2I(100));
+
+    while (true) {
+      bool empty;
+
+      chSysLock();
+      empty = canTryReceiveI(&CAND1, CAN_ANY_MAILBOX, &rxf);
+      chSysUnlock();
+      if (empty) {
+        break;
+      }
+      bench_account(&rxf);
+      total++;
+    }
+
+    if (bench_elapsed_us(start) >= 1000000U) {
+      uint64_t us = bench_elapsed_us(start);
+
+      if (total > 0U) {
+        chprintf(chp, "%8u frames/s, %u overflows",
+                 (uint32_t)(((uint64_t)total * 1000000U) / us),
+                 CAND1.rxoverflows - overflows);
+        for (i = 0U; i < nsources; i++) {
+          chprintf(chp, ", 0x%03X: %u lost %u", sources[i].sid,
+                   sources[i].frames, sources[i].lost);
+          sources[i].frames = 0U;
+        }
+        chprintf(chp, "\r\n");
+      }
+      start     = _sim_get_time_ns();
+      total     = 0U;
+      overflows = CAND1.rxoverflows;
+    }
+  }
+}
+
+/*
+ * Transmitter, the mailboxes are refilled with canTryTransmitI() each time
+ * one of them becomes empty.
+ */
+static void bench_transmitter(uint32_t sid) {
+  event_listener_t el;
+  CANTxFrame txf;
+  uint64_t start, us;
+  uint32_t seq = 0U, bits;
+
+  chEvtRegister(&CAND1.txempty_event, &el, 0);
+
+  memset(&txf, 0, sizeof (txf));
+  txf.IDE = CAN_IDE_STD;
+  txf.RTR = CAN_RTR_DATA;
+  txf.SID = sid;
+  txf.DLC = BENCH_DLC;
+
+  chprintf(chp, "Transmitting %u frames with id 0x%03X, bit rate %u bps\r\n",
+           BENCH_FRAMES, sid, BENCH_BITRATE);
+
+  start = _sim_get_time_ns();
+  while (seq < BENCH_FRAMES) {
+    chSysLock();
+    while (seq < BENCH_FRAMES) {
+      txf.data32[0] = seq;
+      if (canTryTransmitI(&CAND1, CAN_ANY_MAILBOX, &txf)) {
+        break;
+      }
+      seq++;
+    }
+    chSysUnlock();
+    if (seq < BENCH_FRAMES) {
+      (void) chEvtWaitAny(ALL_EVENTS);
+    }
+  }
+
+  /* Waiting for the last frames to leave the mailboxes.*/
+  while (CAND1.txframes < BENCH_FRAMES) {
+    (void) chEvtWaitAny(ALL_EVENTS);
+  }
+  us = bench_elapsed_us(start);
+
+  /* Nominal bits of a standard data frame.*/
+  bits = 47U + (8U * BENCH_DLC);
+  chprintf(chp, "%u frames in %u us, %u frames/s",
+           BENCH_FRAMES, (uint32_t)us,
+           (uint32_t)(((uint64_t)BENCH_FRAMES * 1000000U) / us));
+#if BENCH_BITRATE > 0
+  chprintf(chp, ", bus load %u%%",
+           (uint32_t)(((uint64_t)BENCH_FRAMES * bits * 100000000U) /
+                      ((uint64_t)BENCH_BITRATE * us)));
+#else
+  (void)bits;
+#endif
+  chprintf(chp, "\r\n");
+}
+
+/*------------------------------------------------------------------------*
+ * Simulator main.                                                        *
+ *------------------------------------------------------------------------*/
+int main(int argc, char *argv[]) {
+  uint32_t sid = BENCH_ID;
+  bool rx;
+
+  if ((argc == 2) && (strcmp(argv[1], "rx") == 0)) {
+    rx = true;
+  }
+  else if (((argc == 2) || (argc == 3)) && (strcmp(argv[1], "tx") == 0)) {
+    rx = false;
+    if (argc == 3) {
+      sid = (uint32_t)strtoul(argv[2], NULL, 0) & 0x7FFU;
+    }
+  }
+  else {
+    printf("usage: %s rx|tx [id]\n", argv[0]);
+    return 1;
+  }
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  conInit();
+  chSysInit();
+
+  /*
+   * CAN driver activation, the first instance hosts the bus.
+   */
+  if (rx) {
+    canSimSetFilters(&CAND1, 1U, canfilters);
+  }
+  canStart(&CAND1, &cancfg);
+
+  if (rx) {
+    bench_receiver();
+  }
+  else {
+    bench_transmitter(sid);
+  }
+
+  canStop(&CAND1);
+
+  exit(0);
+}
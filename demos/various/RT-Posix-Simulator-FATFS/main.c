@@ -0,0 +1,329 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include "console.h"
+
+#include "ff.h"
+
+/*===========================================================================*/
+/* Benchmark settings.                                                       */
+/*===========================================================================*/
+
+/*
+ * Cluster size in bytes used when formatting, zero for the FatFs default.
+ */
+#if !defined(BENCH_CLUSTER_SIZE)
+#define BENCH_CLUSTER_SIZE                  0
+#endif
+
+/*
+ * Size of the file used by the sequential and random tests.
+ */
+#if !defined(BENCH_FILE_SIZE)
+#define BENCH_FILE_SIZE                     (4 * 1024 * 1024)
+#endif
+
+/*
+ * Size of each read/write call in the sequential test.
+ */
+#if !defined(BENCH_BUFFER_SIZE)
+#define BENCH_BUFFER_SIZE                   (16 * 1024)
+#endif
+
+/*
+ * Number and size of the operations in the random test.
+ */
+#if !defined(BENCH_RANDOM_OPS)
+#define BENCH_RANDOM_OPS                    1000
+#endif
+
+#if !defined(BENCH_RANDOM_SIZE)
+#define BENCH_RANDOM_SIZE                   512
+#endif
+
+/*
+ * Number and size of the files in the small files test.
+ */
+#if !defined(BENCH_SMALL_FILES)
+#define BENCH_SMALL_FILES                   256
+#endif
+
+#if !defined(BENCH_SMALL_SIZE)
+#define BENCH_SMALL_SIZE                    1024
+#endif
+
+/*===========================================================================*/
+/* Benchmark code.                                                           */
+/*===========================================================================*/
+
+#define chp ((BaseSequentialStream *)&CD1)
+
+static FATFS fs;
+static FIL fil;
+
+/* Data buffer, also used as work area by f_mkfs().*/
+static uint8_t buffer[BENCH_BUFFER_SIZE];
+
+/*
+ * Timings use the simulator clock, it has nanoseconds resolution and it
+ * follows the simulated time when SIM_USE_VIRTUAL_TIME is enabled.
+ */
+
+/* Pseudo random generator, the sequence is the same on each run.*/
+static uint32_t seed = 1U;
+
+static uint32_t bench_rand(void) {
+
+  seed = (seed * 1103515245U) + 12345U;
+  return seed >> 8;
+}
+
+static uint64_t bench_elapsed_us(uint64_t start) {
+  uint64_t us = (_sim_get_time_ns() - start) / 1000U;
+
+  return us > 0U ? us : 1U;
+}
+
+static void bench_failed(const char *what, FRESULT err) {
+
+  chprintf(chp, "%s failed (%d)\r\n", what, (int)err);
+  exit(1);
+}
+
+static void bench_report_rate(const char *name, uint32_t bytes,
+                              uint64_t start) {
+  uint64_t us = bench_elapsed_us(start);
+
+  chprintf(chp, "%-16s %8u KB %10u us %8u KB/s\r\n",
+           name, bytes / 1024U, (uint32_t)us,
+           (uint32_t)(((uint64_t)bytes * 1000000U) / (us * 1024U)));
+}
+
+static void bench_report_ops(const char *name, uint32_t ops,
+                             uint64_t start) {
+  uint64_t us = bench_elapsed_us(start);
+
+  chprintf(chp, "%-16s %8u op %10u us %8u op/s\r\n",
+           name, ops, (uint32_t)us,
+           (uint32_t)(((uint64_t)ops * 1000000U) / us));
+}
+
+/*
+ * Sequential write and read of a large file.
+ */
+static void bench_sequential(void) {
+  uint64_t start;
+  uint32_t n;
+  UINT bw;
+  FRESULT err;
+
+  memset(buffer, 0x55, sizeof buffer);
+
+  start = _sim_get_time_ns();
+  err = f_open(&fil, "/seq.dat", FA_CREATE_ALWAYS | FA_WRITE);
+  if (err != FR_OK) {
+    bench_failed("f_open()", err);
+  }
+  for (n = 0U; n < BENCH_FILE_SIZE; n += sizeof buffer) {
+    err = f_write(&fil, buffer, sizeof buffer, &bw);
+    if ((err != FR_OK) || (bw != sizeof buffer)) {
+      bench_failed("f_write()", err);
+    }
+  }
+  err = f_close(&fil);
+  if (err != FR_OK) {
+    bench_failed("f_close()", err);
+  }
+  bench_report_rate("seq write", BENCH_FILE_SIZE, start);
+
+  start = _sim_get_time_ns();
+  err = f_open(&fil, "/seq.dat", FA_READ);
+  if (err != FR_OK) {
+    bench_failed("f_open()", err);
+  }
+  for (n = 0U; n < BENCH_FILE_SIZE; n += sizeof buffer) {
+    err = f_read(&fil, buffer, sizeof buffer, &bw);
+    if ((err != FR_OK) || (bw != sizeof buffer)) {
+      bench_failed("f_read()", err);
+    }
+  }
+  (void) f_close(&fil);
+  bench_report_rate("seq read", BENCH_FILE_SIZE, start);
+}
+
+/*
+ * Random accesses within the large file.
+ */
+static void bench_random(void) {
+  uint64_t start;
+  uint32_t i;
+  UINT bw;
+  FRESULT err;
+
+  err = f_open(&fil, "/seq.dat", FA_READ | FA_WRITE);
+  if (err != FR_OK) {
+    bench_failed("f_open()", err);
+  }
+
+  start = _sim_get_time_ns();
+  for (i = 0U; i < BENCH_RANDOM_OPS; i++) {
+    FSIZE_t pos = (bench_rand() % (BENCH_FILE_SIZE / BENCH_RANDOM_SIZE)) *
+                  BENCH_RANDOM_SIZE;
+    err = f_lseek(&fil, pos);
+    if (err == FR_OK) {
+      err = f_read(&fil, buffer, BENCH_RANDOM_SIZE, &bw);
+    }
+    if (err != FR_OK) {
+      bench_failed("random read", err);
+    }
+  }
+  bench_report_ops("random read", BENCH_RANDOM_OPS, start);
+
+  start = _sim_get_time_ns();
+  for (i = 0U; i < BENCH_RANDOM_OPS; i++) {
+    FSIZE_t pos = (bench_rand() % (BENCH_FILE_SIZE / BENCH_RANDOM_SIZE)) *
+                  BENCH_RANDOM_SIZE;
+    err = f_lseek(&fil, pos);
+    if (err == FR_OK) {
+      err = f_write(&fil, buffer, BENCH_RANDOM_SIZE, &bw);
+    }
+    if (err != FR_OK) {
+      bench_failed("random write", err);
+    }
+  }
+  err = f_close(&fil);
+  if (err != FR_OK) {
+    bench_failed("f_close()", err);
+  }
+  bench_report_ops("random write", BENCH_RANDOM_OPS, start);
+}
+
+/*
+ * Creation, read and deletion of many small files.
+ */
+static void bench_small_files(void) {
+  uint64_t start;
+  char name[24];
+  uint32_t i;
+  UINT bw;
+  FRESULT err;
+
+  err = f_mkdir("/small");
+  if ((err != FR_OK) && (err != FR_EXIST)) {
+    bench_failed("f_mkdir()", err);
+  }
+
+  memset(buffer, 0xAA, BENCH_SMALL_SIZE);
+
+  start = _sim_get_time_ns();
+  for (i = 0U; i < BENCH_SMALL_FILES; i++) {
+    chsnprintf(name, sizeof name, "/small/f%05u.dat", i);
+    err = f_open(&fil, name, FA_CREATE_ALWAYS | FA_WRITE);
+    if (err == FR_OK) {
+      err = f_write(&fil, buffer, BENCH_SMALL_SIZE, &bw);
+      if (err == FR_OK) {
+        err = f_close(&fil);
+      }
+    }
+    if (err != FR_OK) {
+      bench_failed("small create", err);
+    }
+  }
+  bench_report_ops("small create", BENCH_SMALL_FILES, start);
+
+  start = _sim_get_time_ns();
+  for (i = 0U; i < BENCH_SMALL_FILES; i++) {
+    chsnprintf(name, sizeof name, "/small/f%05u.dat", i);
+    err = f_open(&fil, name, FA_READ);
+    if (err == FR_OK) {
+      err = f_read(&fil, buffer, BENCH_SMALL_SIZE, &bw);
+      (void) f_close(&fil);
+    }
+    if (err != FR_OK) {
+      bench_failed("small read", err);
+    }
+  }
+  bench_report_ops("small read", BENCH_SMALL_FILES, start);
+
+  start = _sim_get_time_ns();
+  for (i = 0U; i < BENCH_SMALL_FILES; i++) {
+    chsnprintf(name, sizeof name, "/small/f%05u.dat", i);
+    err = f_unlink(name);
+    if (err != FR_OK) {
+      bench_failed("small delete", err);
+    }
+  }
+  bench_report_ops("small delete", BENCH_SMALL_FILES, start);
+}
+
+/*------------------------------------------------------------------------*
+ * Simulator main.                                                        *
+ *------------------------------------------------------------------------*/
+int main(void) {
+  static const MKFS_PARM opt = {FM_ANY, 0, 0, 0, BENCH_CLUSTER_SIZE};
+  FRESULT err;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  conInit();
+  chSysInit();
+
+  /*
+   * Simulated SD card activation, the card image is created if missing.
+   */
+  sdcStart(&SDCD1, NULL);
+  if (sdcConnect(&SDCD1)) {
+    chprintf(chp, "sdcConnect() failed\r\n");
+    exit(1);
+  }
+
+  /*
+   * The card is formatted on each run so that results are comparable.
+   */
+  err = f_mkfs("/", &opt, buffer, sizeof buffer);
+  if (err != FR_OK) {
+    bench_failed("f_mkfs()", err);
+  }
+  err = f_mount(&fs, "/", 1);
+  if (err != FR_OK) {
+    bench_failed("f_mount()", err);
+  }
+  chprintf(chp, "FS: %u sectors, %u bytes per cluster, FF_FS_TINY=%d\r\n",
+           mmcsdGetCardCapacity(&SDCD1),
+           (uint32_t)fs.csize * MMCSD_BLOCK_SIZE, FF_FS_TINY);
+
+  bench_sequential();
+  bench_random();
+  bench_small_files();
+
+  (void) f_mount(NULL, "/", 0);
+  (void) sdcDisconnect(&SDCD1);
+  sdcStop(&SDCD1);
+
+  exit(0);
+}
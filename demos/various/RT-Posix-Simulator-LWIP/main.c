@@ -0,0 +1,457 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include "console.h"
+
+#include "lwipthread.h"
+
+#include "lwip/api.h"
+
+/*===========================================================================*/
+/* Benchmark settings.                                                       */
+/*===========================================================================*/
+
+/*
+ * TCP and UDP ports of the server.
+ */
+#if !defined(BENCH_TCP_PORT)
+#define BENCH_TCP_PORT                      5001
+#endif
+
+#if !defined(BENCH_UDP_PORT)
+#define BENCH_UDP_PORT                      5002
+#endif
+
+/*
+ * Amount of data sent by the client in the TCP test.
+ */
+#if !defined(BENCH_TCP_SIZE)
+#define BENCH_TCP_SIZE                      (32 * 1024 * 1024)
+#endif
+
+/*
+ * Size of each write in the TCP test.
+ */
+#if !defined(BENCH_TCP_BLOCK)
+#define BENCH_TCP_BLOCK                     (16 * 1024)
+#endif
+
+/*
+ * Number and payload size of the datagrams sent in the UDP test.
+ */
+#if !defined(BENCH_UDP_COUNT)
+#define BENCH_UDP_COUNT                     20000
+#endif
+
+#if !defined(BENCH_UDP_SIZE)
+#define BENCH_UDP_SIZE                      1470
+#endif
+
+/*
+ * UDP send rate in kilobytes per second, zero for sending as fast as
+ * possible.
+ */
+#if !defined(BENCH_UDP_RATE_KBS)
+#define BENCH_UDP_RATE_KBS                  0
+#endif
+
+/* Each instance would have its own virtual time base.*/
+#if SIM_USE_VIRTUAL_TIME == TRUE
+#error "the network benchmark requires SIM_USE_VIRTUAL_TIME == FALSE"
+#endif
+
+/*===========================================================================*/
+/* Common code.                                                              */
+/*===========================================================================*/
+
+#define chp ((BaseSequentialStream *)&CD1)
+
+/* Sequence number of the UDP datagram closing a test.*/
+#define BENCH_UDP_END                       0xFFFFFFFFU
+
+/*
+ * Results reported by the server to the client, network byte order.
+ */
+typedef struct {
+  uint32_t      packets;
+  uint32_t      lost;
+  uint32_t      kbytes;
+  uint32_t      us;
+} bench_report_t;
+
+/*
+ * Node addresses, the server is node zero.
+ */
+static uint8_t macaddr[2][6] = {
+  {0xC2, 0xAF, 0x51, 0x03, 0xCF, 0x46},
+  {0xC2, 0xAF, 0x51, 0x03, 0xCF, 0x47}
+};
+
+static const uint32_t ipaddr[2] = {
+  IP4_ADDR_VALUE(192, 168, 1, 10),
+  IP4_ADDR_VALUE(192, 168, 1, 11)
+};
+
+/* Data sent by the client, also used as receive buffer.*/
+static uint8_t buffer[BENCH_TCP_BLOCK];
+
+/*
+ * Timings use the simulator clock, it has nanoseconds resolution.
+ */
+static uint32_t bench_elapsed_us(uint64_t start) {
+  uint64_t us = (_sim_get_time_ns() - start) / 1000U;
+
+  return us > 0U ? (uint32_t)us : 1U;
+}
+
+static uint32_t bench_kbits(uint32_t kbytes, uint32_t us) {
+
+  return (uint32_t)(((uint64_t)kbytes * 8U * 1024U * 1000U) / us);
+}
+
+/*===========================================================================*/
+/* Server.                                                                   */
+/*===========================================================================*/
+
+/*
+ * TCP sink, it receives until the client closes its side then it replies
+ * with the report.
+ */
+static THD_WORKING_AREA(wa_tcp_server, 4096);
+static THD_FUNCTION(tcp_server, arg) {
+  struct netconn *listener, *conn;
+
+  (void)arg;
+  chRegSetThreadName("tcp_server");
+
+  listener = netconn_new(NETCONN_TCP);
+  (void) netconn_bind(listener, IP_ADDR_ANY, BENCH_TCP_PORT);
+  (void) netconn_listen(listener);
+
+  while (netconn_accept(listener, &conn) == ERR_OK) {
+    bench_report_t report = {0};
+    uint64_t bytes = 0U, start = 0U;
+    struct pbuf *p;
+
+    while (netconn_recv_tcp_pbuf(conn, &p) == ERR_OK) {
+      if (bytes == 0U) {
+        start = _sim_get_time_ns();
+      }
+      bytes += p->tot_len;
+      report.packets++;
+      pbuf_free(p);
+    }
+
+    report.kbytes = (uint32_t)(bytes / 1024U);
+    report.us     = bench_elapsed_us(start);
+    chprintf(chp, "TCP: received %u KB in %u us, %u kbit/s\r\n",
+             report.kbytes, report.us, bench_kbits(report.kbytes, report.us));
+
+    report.packets = lwip_htonl(report.packets);
+    report.kbytes  = lwip_htonl(report.kbytes);
+    report.us      = lwip_htonl(report.us);
+    (void) netconn_write(conn, &report, sizeof report, NETCONN_COPY);
+    (void) netconn_close(conn);
+    netconn_delete(conn);
+  }
+}
+
+/*
+ * UDP sink, it counts the datagrams and the gaps in the sequence numbers,
+ * the closing datagram is answered with the report.
+ */
+static THD_WORKING_AREA(wa_udp_server, 4096);
+static THD_FUNCTION(udp_server, arg) {
+  struct netconn *conn;
+  struct netbuf *nb;
+  uint32_t received = 0U, next = 0U, lost = 0U;
+  uint64_t bytes = 0U, start = 0U;
+
+  (void)arg;
+  chRegSetThreadName("udp_server");
+
+  conn = netconn_new(NETCONN_UDP);
+  (void) netconn_bind(conn, IP_ADDR_ANY, BENCH_UDP_PORT);
+
+  while (netconn_recv(conn, &nb) == ERR_OK) {
+    uint32_t seq;
+
+    if (netbuf_copy(nb, &seq, sizeof seq) != sizeof seq) {
+      netbuf_delete(nb);
+      continue;
+    }
+    seq = lwip_ntohl(seq);
+
+    if (seq != BENCH_UDP_END) {
+      if (received == 0U) {
+        start = _sim_get_time_ns();
+      }
+      if (seq > next) {
+        lost += seq - next;
+      }
+      if (seq >= next) {
+        next = seq + 1U;
+      }
+      received++;
+      bytes += netbuf_len(nb);
+    }
+    else {
+      bench_report_t report;
+      struct netbuf *rnb;
+
+      report.packets = received;
+      report.lost    = lost;
+      report.kbytes  = (uint32_t)(bytes / 1024U);
+      report.us      = received > 0U ? bench_elapsed_us(start) : 1U;
+      if (received > 0U) {
+        chprintf(chp, "UDP: received %u datagrams, %u lost, %u kbit/s\r\n",
+                 report.packets, report.lost,
+                 bench_kbits(report.kbytes, report.us));
+      }
+
+      report.packets = lwip_htonl(report.packets);
+      report.lost    = lwip_htonl(report.lost);
+      report.kbytes  = lwip_htonl(report.kbytes);
+      report.us      = lwip_htonl(report.us);
+      rnb = netbuf_new();
+      if (netbuf_ref(rnb, &report, sizeof report) == ERR_OK) {
+        (void) netconn_sendto(conn, rnb, netbuf_fromaddr(nb),
+                              netbuf_fromport(nb));
+      }
+      netbuf_delete(rnb);
+
+      /* Ready for the next test.*/
+      received = 0U;
+      next     = 0U;
+      lost     = 0U;
+      bytes    = 0U;
+    }
+    netbuf_delete(nb);
+  }
+}
+
+static void server(void) {
+
+  chThdCreateStatic(wa_tcp_server, sizeof wa_tcp_server, NORMALPRIO,
+                    tcp_server, NULL);
+  chThdCreateStatic(wa_udp_server, sizeof wa_udp_server, NORMALPRIO,
+                    udp_server, NULL);
+
+  while (true) {
+    chThdSleepMilliseconds(1000);
+  }
+}
+
+/*===========================================================================*/
+/* Client.                                                                   */
+/*===========================================================================*/
+
+static void client_failed(const char *what, err_t err) {
+
+  chprintf(chp, "%s failed (%d)\r\n", what, (int)err);
+  exit(1);
+}
+
+/*
+ * TCP test, the server is retried until it is reachable.
+ */
+static void client_tcp(const ip_addr_t *server) {
+  struct netconn *conn;
+  bench_report_t report;
+  uint64_t start;
+  uint32_t n, us;
+  struct netbuf *nb;
+  err_t err;
+  int i;
+
+  for (i = 0; i < 50; i++) {
+    conn = netconn_new(NETCONN_TCP);
+    err = netconn_connect(conn, server, BENCH_TCP_PORT);
+    if (err == ERR_OK) {
+      break;
+    }
+    netconn_delete(conn);
+    chThdSleepMilliseconds(200);
+  }
+  if (err != ERR_OK) {
+    client_failed("TCP connect", err);
+  }
+
+  start = _sim_get_time_ns();
+  for (n = 0U; n < BENCH_TCP_SIZE; n += sizeof buffer) {
+    err = netconn_write(conn, buffer, sizeof buffer, NETCONN_NOCOPY);
+    if (err != ERR_OK) {
+      client_failed("TCP write", err);
+    }
+  }
+  (void) netconn_shutdown(conn, 0, 1);
+
+  /* The report arrives after all the data has been received.*/
+  netconn_set_recvtimeout(conn, 10000);
+  err = netconn_recv(conn, &nb);
+  if (err != ERR_OK) {
+    client_failed("TCP report", err);
+  }
+  us = bench_elapsed_us(start);
+  (void) netbuf_copy(nb, &report, sizeof report);
+  netbuf_delete(nb);
+  (void) netconn_close(conn);
+  netconn_delete(conn);
+
+  chprintf(chp, "TCP: sent %u KB in %u us, %u kbit/s\r\n",
+           BENCH_TCP_SIZE / 1024, us, bench_kbits(BENCH_TCP_SIZE / 1024, us));
+  chprintf(chp, "     server %u KB in %u us, %u kbit/s, %u segments\r\n",
+           lwip_ntohl(report.kbytes), lwip_ntohl(report.us),
+           bench_kbits(lwip_ntohl(report.kbytes), lwip_ntohl(report.us)),
+           lwip_ntohl(report.packets));
+}
+
+/*
+ * UDP test, the closing datagram is repeated until the report arrives.
+ */
+static void client_udp(const ip_addr_t *server) {
+  struct netconn *conn;
+  struct netbuf *nb;
+  bench_report_t report;
+  uint64_t start;
+  uint32_t seq, us, kbytes;
+  systime_t pace;
+  err_t err;
+  int i;
+
+  conn = netconn_new(NETCONN_UDP);
+  err = netconn_connect(conn, server, BENCH_UDP_PORT);
+  if (err != ERR_OK) {
+    client_failed("UDP connect", err);
+  }
+
+  nb = netbuf_new();
+  start = _sim_get_time_ns();
+  pace = chVTGetSystemTimeX();
+  for (seq = 0U; seq < BENCH_UDP_COUNT; seq++) {
+    *(uint32_t *)buffer = lwip_htonl(seq);
+    (void) netbuf_ref(nb, buffer, BENCH_UDP_SIZE);
+    (void) netconn_send(conn, nb);
+
+#if BENCH_UDP_RATE_KBS > 0
+    /* Rate limiting, sleeping when ahead of the target.*/
+    {
+      sysinterval_t target = TIME_MS2I(((uint64_t)(seq + 1U) *
+                                        BENCH_UDP_SIZE * 1000U) /
+                                       (BENCH_UDP_RATE_KBS * 1024U));
+      if (target > chVTTimeElapsedSinceX(pace)) {
+        chThdSleepUntil(chTimeAddX(pace, target));
+      }
+    }
+#else
+    (void)pace;
+#endif
+  }
+  us = bench_elapsed_us(start);
+
+  netconn_set_recvtimeout(conn, 100);
+  for (i = 0; i < 50; i++) {
+    struct netbuf *rnb;
+
+    *(uint32_t *)buffer = lwip_htonl(BENCH_UDP_END);
+    (void) netbuf_ref(nb, buffer, sizeof (uint32_t));
+    (void) netconn_send(conn, nb);
+    if (netconn_recv(conn, &rnb) == ERR_OK) {
+      (void) netbuf_copy(rnb, &report, sizeof report);
+      netbuf_delete(rnb);
+      break;
+    }
+  }
+  netbuf_delete(nb);
+  netconn_delete(conn);
+  if (i >= 50) {
+    client_failed("UDP report", ERR_TIMEOUT);
+  }
+
+  kbytes = (uint32_t)(((uint64_t)BENCH_UDP_COUNT * BENCH_UDP_SIZE) / 1024U);
+  chprintf(chp, "UDP: sent %u datagrams in %u us, %u kbit/s\r\n",
+           BENCH_UDP_COUNT, us, bench_kbits(kbytes, us));
+  chprintf(chp, "     server %u datagrams, %u lost, %u kbit/s\r\n",
+           lwip_ntohl(report.packets), lwip_ntohl(report.lost),
+           bench_kbits(lwip_ntohl(report.kbytes), lwip_ntohl(report.us)));
+}
+
+static void client(void) {
+  ip_addr_t server;
+
+  ip_addr_set_ip4_u32(&server, ipaddr[0]);
+
+  memset(buffer, 0x55, sizeof buffer);
+  client_tcp(&server);
+  client_udp(&server);
+
+  chprintf(chp, "MAC: %u frames sent, %u received, %u dropped\r\n",
+           ETHD1.txframes, ETHD1.rxframes, ETHD1.txdrops);
+}
+
+/*------------------------------------------------------------------------*
+ * Simulator main.                                                        *
+ *------------------------------------------------------------------------*/
+int main(int argc, char *argv[]) {
+  static lwipthread_opts_t opts;
+  unsigned node;
+
+  if ((argc == 2) && (strcmp(argv[1], "server") == 0)) {
+    node = 0U;
+  }
+  else if ((argc == 2) && (strcmp(argv[1], "client") == 0)) {
+    node = 1U;
+  }
+  else {
+    printf("usage: %s server|client\n", argv[0]);
+    return 1;
+  }
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  conInit();
+  chSysInit();
+
+  /*
+   * TCP/IP stack initialization, the simulated MAC pairs automatically
+   * with the other running instance.
+   */
+  opts.macaddress = macaddr[node];
+  opts.address    = ipaddr[node];
+  opts.netmask    = IP4_ADDR_VALUE(255, 255, 255, 0);
+  opts.gateway    = IP4_ADDR_VALUE(192, 168, 1, 1);
+  opts.addrMode   = NET_ADDRESS_STATIC;
+  lwipInit(&opts);
+
+  if (node == 0U) {
+    server();
+  }
+  client();
+
+  exit(0);
+}
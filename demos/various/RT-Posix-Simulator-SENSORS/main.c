@@ -0,0 +1,325 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdlib.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include "console.h"
+
+#include "l3gd20.h"
+#include "lsm6dsl.h"
+
+#include "mems_model.h"
+
+/*===========================================================================*/
+/* Benchmark settings.                                                       */
+/*===========================================================================*/
+
+/*
+ * Number of samples read in each test.
+ */
+#if !defined(BENCH_SAMPLES)
+#define BENCH_SAMPLES                       1000
+#endif
+
+/*
+ * Simulated bus clocks in Hz, zero for instantaneous transfers.
+ */
+#if !defined(BENCH_SPI_CLOCK)
+#define BENCH_SPI_CLOCK                     10000000
+#endif
+
+#if !defined(BENCH_I2C_CLOCK)
+#define BENCH_I2C_CLOCK                     400000
+#endif
+
+/*===========================================================================*/
+/* Device models.                                                            */
+/*===========================================================================*/
+
+/*
+ * L3GD20 gyroscope on SPI, bit 6 of the command enables the address
+ * auto-increment.
+ */
+static const mems_model_config_t l3gd20_model_cfg = {
+  .whoami    = 0xD4U,
+  .addr_mask = 0x3FU,
+  .inc_mask  = 0x40U,
+  .out_first = L3GD20_AD_OUT_X_L,
+  .out_axes  = L3GD20_GYRO_NUMBER_OF_AXES
+};
+
+static mems_model_t l3gd20_model;
+
+static const sim_spi_device_t l3gd20_device = {
+  .select   = mems_model_spi_select,
+  .exchange = mems_model_spi_exchange,
+  .instance = &l3gd20_model
+};
+
+/*
+ * LSM6DSL inertial module on I2C, gyroscope and accelerometer outputs are
+ * contiguous, the driver enables the address auto-increment.
+ */
+static const mems_model_config_t lsm6dsl_model_cfg = {
+  .whoami    = 0x6AU,
+  .addr_mask = 0x7FU,
+  .inc_mask  = 0U,
+  .out_first = LSM6DSL_AD_OUTX_L_G,
+  .out_axes  = LSM6DSL_GYRO_NUMBER_OF_AXES + LSM6DSL_ACC_NUMBER_OF_AXES
+};
+
+static mems_model_t lsm6dsl_model;
+
+static const sim_i2c_device_t lsm6dsl_device = {
+  .addr     = LSM6DSL_SAD_VCC,
+  .start    = mems_model_i2c_start,
+  .write    = mems_model_i2c_write,
+  .read     = mems_model_i2c_read,
+  .stop     = NULL,
+  .instance = &lsm6dsl_model
+};
+
+static const sim_i2c_device_t * const i2c_devices[] = {
+  &lsm6dsl_device,
+  NULL
+};
+
+/*===========================================================================*/
+/* Drivers configurations.                                                   */
+/*===========================================================================*/
+
+static const SPIConfig spicfg = {
+  .end_cb = NULL,
+  .device = &l3gd20_device,
+  .clock  = BENCH_SPI_CLOCK
+};
+
+static const I2CConfig i2ccfg = {
+  .clock   = BENCH_I2C_CLOCK,
+  .devices = i2c_devices
+};
+
+static L3GD20Driver L3GD20D1;
+
+static const L3GD20Config l3gd20cfg = {
+  &SPID1,
+  &spicfg,
+  NULL,
+  NULL,
+  L3GD20_FS_250DPS,
+  L3GD20_ODR_760HZ,
+#if L3GD20_USE_ADVANCED
+  L3GD20_BDU_CONTINUOUS,
+  L3GD20_END_LITTLE,
+  L3GD20_BW3,
+  L3GD20_HPM_REFERENCE,
+  L3GD20_HPCF_8,
+  L3GD20_LP2M_ON,
+#endif
+};
+
+static LSM6DSLDriver LSM6DSLD1;
+
+static const LSM6DSLConfig lsm6dslcfg = {
+  &I2CD1,
+  &i2ccfg,
+  LSM6DSL_SAD_VCC,
+  NULL,
+  NULL,
+  LSM6DSL_ACC_FS_2G,
+  LSM6DSL_ACC_ODR_1P66Hz,
+#if LSM6DSL_USE_ADVANCED
+  LSM6DSL_ACC_LP_ENABLED,
+#endif
+  NULL,
+  NULL,
+  LSM6DSL_GYRO_FS_250DPS,
+  LSM6DSL_GYRO_ODR_1P66Hz,
+#if LSM6DSL_USE_ADVANCED
+  LSM6DSL_GYRO_LP_ENABLED,
+  LSM6DSL_GYRO_LPF_FTYPE1,
+  LSM6DSL_BDU_BLOCKED,
+  LSM6DSL_END_LITTLE
+#endif
+};
+
+/*===========================================================================*/
+/* Benchmark code.                                                           */
+/*===========================================================================*/
+
+#define chp ((BaseSequentialStream *)&CD1)
+
+/*
+ * Timings use the simulator clock, it has nanoseconds resolution and it
+ * follows the simulated time when SIM_USE_VIRTUAL_TIME is enabled.
+ */
+
+static uint64_t bench_elapsed_us(uint64_t start) {
+  uint64_t us = (_sim_get_time_ns() - start) / 1000U;
+
+  return us > 0U ? us : 1U;
+}
+
+static void bench_failed(const char *what, msg_t msg) {
+
+  chprintf(chp, "%s failed (%d)\r\n", what, (int)msg);
+  exit(1);
+}
+
+static void bench_report(const char *name, uint64_t start, uint32_t bytes) {
+  uint64_t us = bench_elapsed_us(start);
+
+  chprintf(chp, "%-16s %6u samples %10u us %8u samples/s %4u bytes/sample\r\n",
+           name, BENCH_SAMPLES, (uint32_t)us,
+           (uint32_t)(((uint64_t)BENCH_SAMPLES * 1000000U) / us),
+           bytes / BENCH_SAMPLES);
+}
+
+/*
+ * Reads the WHO_AM_I registers through the buses.
+ */
+static void bench_identify(void) {
+  uint8_t cmd = L3GD20_AD_WHO_AM_I | L3GD20_RW;
+  uint8_t id[2];
+  msg_t msg;
+
+  spiSelect(&SPID1);
+  spiSend(&SPID1, 1, &cmd);
+  spiReceive(&SPID1, 1, &id[0]);
+  spiUnselect(&SPID1);
+
+  cmd = LSM6DSL_AD_WHO_AM_I;
+  msg = i2cMasterTransmitTimeout(&I2CD1, LSM6DSL_SAD_VCC, &cmd, 1,
+                                 &id[1], 1, TIME_INFINITE);
+  if (msg != MSG_OK) {
+    bench_failed("LSM6DSL WHO_AM_I", msg);
+  }
+
+  chprintf(chp, "L3GD20 ID 0x%02X on SPI at %u Hz, "
+                "LSM6DSL ID 0x%02X on I2C at %u Hz\r\n",
+           id[0], BENCH_SPI_CLOCK, id[1], BENCH_I2C_CLOCK);
+}
+
+/*
+ * L3GD20 samples through the gyroscope interface.
+ */
+static void bench_l3gd20(void) {
+  int32_t axes[L3GD20_GYRO_NUMBER_OF_AXES];
+  uint32_t frames = SPID1.frames;
+  uint64_t start;
+  unsigned i;
+  msg_t msg;
+
+  start = _sim_get_time_ns();
+  for (i = 0U; i < BENCH_SAMPLES; i++) {
+    msg = l3gd20GyroscopeReadRaw(&L3GD20D1, axes);
+    if (msg != MSG_OK) {
+      bench_failed("l3gd20GyroscopeReadRaw()", msg);
+    }
+  }
+  bench_report("l3gd20 gyro", start, SPID1.frames - frames);
+}
+
+/*
+ * LSM6DSL samples through the accelerometer and gyroscope interfaces,
+ * two bus transactions for each sample.
+ */
+static void bench_lsm6dsl(void) {
+  int32_t acc[LSM6DSL_ACC_NUMBER_OF_AXES];
+  int32_t gyro[LSM6DSL_GYRO_NUMBER_OF_AXES];
+  uint32_t bytes = I2CD1.bytes;
+  uint64_t start;
+  unsigned i;
+  msg_t msg;
+
+  start = _sim_get_time_ns();
+  for (i = 0U; i < BENCH_SAMPLES; i++) {
+    msg = lsm6dslAccelerometerReadRaw(&LSM6DSLD1, acc);
+    if (msg == MSG_OK) {
+      msg = lsm6dslGyroscopeReadRaw(&LSM6DSLD1, gyro);
+    }
+    if (msg != MSG_OK) {
+      bench_failed("lsm6dsl read", msg);
+    }
+  }
+  bench_report("lsm6dsl acc+gyro", start, I2CD1.bytes - bytes);
+}
+
+/*
+ * LSM6DSL samples read in a single burst covering both sensors.
+ */
+static void bench_lsm6dsl_batched(void) {
+  uint8_t reg = LSM6DSL_AD_OUTX_L_G;
+  uint8_t buf[(LSM6DSL_GYRO_NUMBER_OF_AXES + LSM6DSL_ACC_NUMBER_OF_AXES) * 2];
+  uint32_t bytes = I2CD1.bytes;
+  uint64_t start;
+  unsigned i;
+  msg_t msg;
+
+  start = _sim_get_time_ns();
+  for (i = 0U; i < BENCH_SAMPLES; i++) {
+    i2cAcquireBus(&I2CD1);
+    msg = i2cMasterTransmitTimeout(&I2CD1, LSM6DSL_SAD_VCC, &reg, 1,
+                                   buf, sizeof buf, TIME_INFINITE);
+    i2cReleaseBus(&I2CD1);
+    if (msg != MSG_OK) {
+      bench_failed("lsm6dsl burst read", msg);
+    }
+  }
+  bench_report("lsm6dsl batched", start, I2CD1.bytes - bytes);
+}
+
+/*------------------------------------------------------------------------*
+ * Simulator main.                                                        *
+ *------------------------------------------------------------------------*/
+int main(void) {
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  conInit();
+  chSysInit();
+
+  /*
+   * Device models and sensor drivers activation, the sensor drivers also
+   * start the bus drivers.
+   */
+  mems_model_init(&l3gd20_model, &l3gd20_model_cfg);
+  mems_model_init(&lsm6dsl_model, &lsm6dsl_model_cfg);
+
+  l3gd20ObjectInit(&L3GD20D1);
+  l3gd20Start(&L3GD20D1, &l3gd20cfg);
+  lsm6dslObjectInit(&LSM6DSLD1);
+  lsm6dslStart(&LSM6DSLD1, &lsm6dslcfg);
+
+  bench_identify();
+  bench_l3gd20();
+  bench_lsm6dsl();
+  bench_lsm6dsl_batched();
+
+  l3gd20Stop(&L3GD20D1);
+  lsm6dslStop(&LSM6DSLD1);
+
+  exit(0);
+}
@@ -0,0 +1,150 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <string.h>
+
+#include "hal.h"
+
+#include "mems_model.h"
+
+#define MEMS_AD_WHO_AM_I                    0x0FU
+#define MEMS_ADDR_MASK                      0x7FU
+
+/* Triangle wave period in samples and amplitude.*/
+#define MEMS_WAVE_PERIOD                    256U
+#define MEMS_WAVE_AMPLITUDE                 8192
+
+static void mems_generate(mems_model_t *mp) {
+  const mems_model_config_t *cfg = mp->config;
+  unsigned i;
+
+  mp->samples++;
+  for (i = 0U; i < cfg->out_axes; i++) {
+    uint32_t phase = (mp->samples + (i * (MEMS_WAVE_PERIOD / 4U))) %
+                     MEMS_WAVE_PERIOD;
+    int32_t v = (int32_t)(phase < (MEMS_WAVE_PERIOD / 2U) ?
+                          phase : MEMS_WAVE_PERIOD - phase);
+    uint8_t reg = (uint8_t)(cfg->out_first + (i * 2U));
+
+    v = ((v * 4 * MEMS_WAVE_AMPLITUDE) / (int32_t)MEMS_WAVE_PERIOD) -
+        MEMS_WAVE_AMPLITUDE;
+    mp->regs[reg & MEMS_ADDR_MASK]        = (uint8_t)v;
+    mp->regs[(reg + 1U) & MEMS_ADDR_MASK] = (uint8_t)(v >> 8);
+  }
+}
+
+static void mems_set_address(mems_model_t *mp, uint8_t b) {
+  const mems_model_config_t *cfg = mp->config;
+
+  mp->addr = b & cfg->addr_mask;
+  mp->inc  = (cfg->inc_mask == 0U) || ((b & cfg->inc_mask) != 0U);
+  mp->cmd  = false;
+}
+
+static void mems_advance(mems_model_t *mp) {
+
+  if (mp->inc) {
+    mp->addr = (mp->addr + 1U) & MEMS_ADDR_MASK;
+  }
+}
+
+static uint8_t mems_read(mems_model_t *mp) {
+  const mems_model_config_t *cfg = mp->config;
+  uint8_t b;
+
+  if (mp->burst && (mp->addr >= cfg->out_first) &&
+      (mp->addr < cfg->out_first + (cfg->out_axes * 2U))) {
+    mems_generate(mp);
+  }
+  mp->burst = false;
+
+  b = mp->regs[mp->addr];
+  mems_advance(mp);
+
+  return b;
+}
+
+static void mems_write(mems_model_t *mp, uint8_t b) {
+
+  if (mp->addr != MEMS_AD_WHO_AM_I) {
+    mp->regs[mp->addr] = b;
+  }
+  mems_advance(mp);
+}
+
+void mems_model_init(mems_model_t *mp, const mems_model_config_t *config) {
+
+  memset(mp, 0, sizeof (*mp));
+  mp->config = config;
+  mp->regs[MEMS_AD_WHO_AM_I] = config->whoami;
+}
+
+/*
+ * SPI protocol, the first frame after the chip select assertion is the
+ * command.
+ */
+void mems_model_spi_select(void *ip, bool selected) {
+  mems_model_t *mp = ip;
+
+  mp->cmd = selected;
+}
+
+uint8_t mems_model_spi_exchange(void *ip, uint8_t frame) {
+  mems_model_t *mp = ip;
+
+  if (mp->cmd) {
+    mems_set_address(mp, frame);
+    mp->read  = (frame & 0x80U) != 0U;
+    mp->burst = true;
+    return 0xFFU;
+  }
+
+  if (mp->read) {
+    return mems_read(mp);
+  }
+
+  mems_write(mp, frame);
+  return 0xFFU;
+}
+
+/*
+ * I2C protocol, the first byte written after a start is the sub-address,
+ * a read continues from the current address.
+ */
+void mems_model_i2c_start(void *ip, bool read) {
+  mems_model_t *mp = ip;
+
+  mp->cmd   = !read;
+  mp->burst = read;
+}
+
+bool mems_model_i2c_write(void *ip, uint8_t b) {
+  mems_model_t *mp = ip;
+
+  if (mp->cmd) {
+    mems_set_address(mp, b);
+  }
+  else {
+    mems_write(mp, b);
+  }
+
+  return true;
+}
+
+uint8_t mems_model_i2c_read(void *ip) {
+
+  return mems_read(ip);
+}
@@ -0,0 +1,66 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef MEMS_MODEL_H
+#define MEMS_MODEL_H
+
+/*
+ * Register map model of an ST MEMS sensor. The first byte of a transfer
+ * selects the register, on SPI its MSB is the read flag. Reading a burst
+ * starting within the output registers generates a new sample, each axis
+ * follows a triangle wave with its own phase.
+ */
+typedef struct {
+  /* Value of the WHO_AM_I register, at address 0x0F.*/
+  uint8_t                   whoami;
+  /* Register address bits of the command or sub-address byte.*/
+  uint8_t                   addr_mask;
+  /* Auto-increment bit of the command or sub-address byte, zero if the
+     address is always incremented.*/
+  uint8_t                   inc_mask;
+  /* Output registers, 16 bits little endian for each axis.*/
+  uint8_t                   out_first;
+  uint8_t                   out_axes;
+} mems_model_config_t;
+
+typedef struct {
+  const mems_model_config_t *config;
+  uint8_t                   regs[128];
+  /* Transfer state, the next byte is the command when "cmd" is set, the
+     next read is the first of a burst when "burst" is set.*/
+  uint8_t                   addr;
+  bool                      inc;
+  bool                      cmd;
+  bool                      burst;
+  bool                      read;
+  /* Generated samples.*/
+  uint32_t                  samples;
+} mems_model_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void mems_model_init(mems_model_t *mp, const mems_model_config_t *config);
+  void mems_model_spi_select(void *ip, bool selected);
+  uint8_t mems_model_spi_exchange(void *ip, uint8_t frame);
+  void mems_model_i2c_start(void *ip, bool read);
+  bool mems_model_i2c_write(void *ip, uint8_t b);
+  uint8_t mems_model_i2c_read(void *ip);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEMS_MODEL_H */
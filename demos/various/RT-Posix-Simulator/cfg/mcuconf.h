@@ -17,4 +17,9 @@
 #ifndef MCUCONF_H
 #define MCUCONF_H
 
+/*
+ * Serial driver settings.
+ */
+#define SIM_SERIAL_USE_IRQ_THREAD           TRUE
+
 #endif /* MCUCONF_H */
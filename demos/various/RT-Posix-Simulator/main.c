@@ -19,6 +19,9 @@
 #include "shell.h"
 #include "chprintf.h"
 
+#include "hal_mfs.h"
+#include "mfs_test_root.h"
+
 #define SHELL_WA_SIZE       THD_WORKING_AREA_SIZE(4096)
 #define CONSOLE_WA_SIZE     THD_WORKING_AREA_SIZE(4096)
 #define TEST_WA_SIZE        THD_WORKING_AREA_SIZE(4096)
@@ -29,7 +32,43 @@ static thread_t *cdtp;
 static thread_t *shelltp1;
 static thread_t *shelltp2;
 
+/*
+ * MFS configuration, two banks of two sectors on the simulated flash.
+ */
+const MFSConfig mfscfg1 = {
+  .flashp           = (BaseFlash *)&EFLD1,
+  .erased           = 0xFFFFFFFFU,
+  .bank_size        = 8192U,
+  .bank0_start      = 0U,
+  .bank0_sectors    = 2U,
+  .bank1_start      = 2U,
+  .bank1_sectors    = 2U
+};
+
+static THD_FUNCTION(test_mfs, arg) {
+  BaseSequentialStream *chp = (BaseSequentialStream *)arg;
+  test_execute(chp, &mfs_test_suite);
+}
+
+static void cmd_mfs(BaseSequentialStream *chp, int argc, char *argv[]) {
+  thread_t *tp;
+
+  (void)argv;
+  if (argc > 0) {
+    shellUsage(chp, "mfs");
+    return;
+  }
+  tp = chThdCreateFromHeap(NULL, TEST_WA_SIZE, "test", chThdGetPriorityX(),
+                           test_mfs, chp);
+  if (tp == NULL) {
+    chprintf(chp, "out of memory" SHELL_NEWLINE_STR);
+    return;
+  }
+  chThdWait(tp);
+}
+
 static const ShellCommand commands[] = {
+  {"mfs", cmd_mfs},
   {NULL, NULL}
 };
 
@@ -169,6 +208,11 @@ int main(void) {
   sdStart(&SD1, NULL);
   sdStart(&SD2, NULL);
 
+  /*
+   * Simulated flash initialization, the content is kept in a file.
+   */
+  eflStart(&EFLD1, NULL);
+
   /*
    * Shell manager initialization.
    */
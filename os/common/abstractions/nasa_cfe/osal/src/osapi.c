@@ -66,6 +66,10 @@
 #error "NASA OSAL requires CH_CFG_USE_HEAP"
 #endif
 
+#if CH_CFG_USE_REC_QUEUES == FALSE
+#error "NASA OSAL requires CH_CFG_USE_REC_QUEUES"
+#endif
+
 /*===========================================================================*/
 /* Module local definitions.                                                 */
 /*===========================================================================*/
@@ -110,23 +114,12 @@ typedef struct {
 typedef struct {
   uint32                is_free;
   char                  name[OS_MAX_API_NAME];
-  semaphore_t           free_msgs;
-  memory_pool_t         messages;
-  mailbox_t             mb;
-  msg_t                 *mb_buffer;
-  void                  *q_buffer;
+  record_queue_t        rq;
+  uint8_t               *rq_buffer;
   uint32                depth;
   uint32                size;
 } osal_queue_t;
 
-/**
- * @brief   Type of an osal message with minimum size.
- */
-typedef struct {
-  size_t                size;
-  char                  buf[4];
-} osal_message_t;
-
 /**
  * @brief   Type of OSAL main structure.
  */
@@ -664,7 +657,7 @@ int32 OS_TimerGetInfo(uint32 timer_id, OS_timer_prop_t *timer_prop) {
 int32 OS_QueueCreate(uint32 *queue_id, const char *queue_name,
                      uint32 queue_depth, uint32 data_size, uint32 flags) {
   osal_queue_t *oqp;
-  size_t msgsize;
+  size_t bufsize;
 
   (void)flags;
 
@@ -699,32 +692,18 @@ int32 OS_QueueCreate(uint32 *queue_id, const char *queue_name,
     return OS_ERR_NO_FREE_IDS;
   }
 
-  /* Attempting messages buffer allocation.*/
-  msgsize = MEM_ALIGN_NEXT(data_size + sizeof (size_t), PORT_NATURAL_ALIGN);
-  oqp->mb_buffer = chHeapAllocAligned(NULL,
-                                      msgsize * (size_t)queue_depth,
-                                      PORT_NATURAL_ALIGN);
-  if (oqp->mb_buffer == NULL) {
-    *queue_id = 0;
-    return OS_ERROR;
-  }
-
-  /* Attempting queue buffer allocation.*/
-  oqp->q_buffer = chHeapAllocAligned(NULL,
-                                     sizeof (msg_t) * (size_t)queue_depth,
-                                     PORT_NATURAL_ALIGN);
-  if (oqp->q_buffer == NULL) {
+  /* Attempting records buffer allocation, it is sized for the specified
+     number of messages of maximum size.*/
+  bufsize = RQ_BUFFER_SIZE(data_size, queue_depth);
+  oqp->rq_buffer = chHeapAllocAligned(NULL, bufsize, RQ_ALIGN);
+  if (oqp->rq_buffer == NULL) {
     *queue_id = 0;
-    chHeapFree(oqp->mb_buffer);
     return OS_ERROR;
   }
 
   /* Initializing object static parts.*/
   strncpy(oqp->name, queue_name, OS_MAX_API_NAME - 1);
-  chMBObjectInit(&oqp->mb, oqp->q_buffer, (size_t)queue_depth);
-  chSemObjectInit(&oqp->free_msgs, (cnt_t)queue_depth);
-  chPoolObjectInit(&oqp->messages, msgsize, NULL);
-  chPoolLoadArray(&oqp->messages, oqp->mb_buffer, (size_t)queue_depth);
+  chRQObjectInit(&oqp->rq, oqp->rq_buffer, bufsize);
   oqp->depth   = queue_depth;
   oqp->size    = data_size;
   oqp->is_free = 0;   /* Note, last.*/
@@ -743,7 +722,7 @@ int32 OS_QueueCreate(uint32 *queue_id, const char *queue_name,
  */
 int32 OS_QueueDelete(uint32 queue_id) {
   osal_queue_t *oqp = (osal_queue_t *)queue_id;
-  void *q_buffer, *mb_buffer;
+  void *rq_buffer;
 
   /* Range check.*/
   if ((oqp < &osal.queues[0]) ||
@@ -758,13 +737,11 @@ int32 OS_QueueDelete(uint32 queue_id) {
   /* Marking as no more free, will be overwritten by the pool pointer.*/
   oqp->is_free = 1;
 
-  /* Pointers to areas to be freed.*/
-  q_buffer  = oqp->q_buffer;
-  mb_buffer = oqp->mb_buffer;
+  /* Pointer to the area to be freed.*/
+  rq_buffer = oqp->rq_buffer;
 
   /* Resetting the queue.*/
-  chMBResetI(&oqp->mb);
-  chSemResetI(&oqp->free_msgs, 0);
+  chRQResetI(&oqp->rq);
 
   /* Flagging it as unused and returning it to the pool.*/
   chPoolFreeI(&osal.queues_pool, (void *)oqp);
@@ -774,9 +751,8 @@ int32 OS_QueueDelete(uint32 queue_id) {
   /* Leaving critical zone.*/
   chSysUnlock();
 
-  /* Freeing buffers, outside critical zone, slow heap operation.*/
-  chHeapFree(q_buffer);
-  chHeapFree(mb_buffer);
+  /* Freeing buffer, outside critical zone, slow heap operation.*/
+  chHeapFree(rq_buffer);
 
   return OS_SUCCESS;
 }
@@ -797,8 +773,8 @@ int32 OS_QueueDelete(uint32 queue_id) {
 int32 OS_QueueGet(uint32 queue_id, void *data, uint32 size,
                   uint32 *size_copied, int32 timeout) {
   osal_queue_t *oqp = (osal_queue_t *)queue_id;
-  msg_t msg, msgsts;
-  void *body;
+  msg_t msgsts;
+  size_t n = (size_t)size;
 
   /* NULL pointer checks.*/
   if ((data == NULL) || (size_copied == NULL)) {
@@ -817,39 +793,31 @@ int32 OS_QueueGet(uint32 queue_id, void *data, uint32 size,
     return OS_QUEUE_INVALID_SIZE;
   }
 
-  /* Special time handling.*/
+  /* Special time handling, the message is copied directly from the
+     queue buffer.*/
   if (timeout == OS_PEND) {
-    msgsts = chMBFetchTimeout(&oqp->mb, &msg, TIME_INFINITE);
+    msgsts = chRQReceiveTimeout(&oqp->rq, data, &n, TIME_INFINITE);
     if (msgsts < MSG_OK) {
       *size_copied = 0;
       return OS_ERROR;
     }
   }
   else if (timeout == OS_CHECK) {
-    msgsts = chMBFetchTimeout(&oqp->mb, &msg, TIME_IMMEDIATE);
+    msgsts = chRQReceiveTimeout(&oqp->rq, data, &n, TIME_IMMEDIATE);
     if (msgsts < MSG_OK) {
       *size_copied = 0;
       return OS_QUEUE_EMPTY;
     }
   }
   else {
-    msgsts = chMBFetchTimeout(&oqp->mb, &msg, (sysinterval_t)timeout);
+    msgsts = chRQReceiveTimeout(&oqp->rq, data, &n, (sysinterval_t)timeout);
     if (msgsts < MSG_OK) {
       *size_copied = 0;
       return OS_QUEUE_TIMEOUT;
     }
   }
 
-  /* Message body and size.*/
-  *size_copied = ((osal_message_t *)msg)->size;
-  body  = (void *)((osal_message_t *)msg)->buf;
-
-  /* Copying the message body.*/
-  memcpy(data, body, *size_copied);
-
-  /* Freeing the message buffer.*/
-  chPoolFree(&oqp->messages, (void *)msg);
-  chSemSignal(&oqp->free_msgs);
+  *size_copied = (uint32)n;
 
   return OS_SUCCESS;
 }
@@ -868,7 +836,6 @@ int32 OS_QueueGet(uint32 queue_id, void *data, uint32 size,
 int32 OS_QueuePut(uint32 queue_id, void *data, uint32 size, uint32 flags) {
   osal_queue_t *oqp = (osal_queue_t *)queue_id;
   msg_t msgsts;
-  osal_message_t *omsg;
 
   (void)flags;
 
@@ -889,19 +856,8 @@ int32 OS_QueuePut(uint32 queue_id, void *data, uint32 size, uint32 flags) {
     return OS_QUEUE_INVALID_SIZE;
   }
 
-  /* Getting a message buffer from the pool.*/
-  msgsts = chSemWait(&oqp->free_msgs);
-  if (msgsts < MSG_OK) {
-    return OS_ERROR;
-  }
-  omsg = chPoolAlloc(&oqp->messages);
-
-  /* Filling message size and data.*/
-  omsg->size = (size_t)size;
-  memcpy(omsg->buf, data, size);
-
-  /* Posting the message.*/
-  msgsts = chMBPostTimeout(&oqp->mb, (msg_t)omsg, TIME_INFINITE);
+  /* Copying the message directly into the queue buffer.*/
+  msgsts = chRQSendTimeout(&oqp->rq, data, (size_t)size, TIME_INFINITE);
   if (msgsts < MSG_OK) {
     return OS_ERROR;
   }
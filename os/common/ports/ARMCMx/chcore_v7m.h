@@ -563,6 +563,15 @@ struct port_context {
 #define PORT_FAST_IRQ_HANDLER(id) void id(void)
 #endif
 
+/**
+ * @brief   Mutexes fast path compare-and-swap.
+ * @note    Implemented using exclusive access instructions without memory
+ *          barriers, the exclusive monitor is cleared on exceptions entry
+ *          and exit so the store fails if the sequence is preempted.
+ */
+#define CH_MTX_CAS(p, expp, v)                                              \
+  port_cas_ptr((void **)(p), (void **)(expp), (void *)(v))
+
 /**
  * @brief   Performs a context switch between two threads.
  * @details This is the most critical code in any port, this function
@@ -787,6 +796,28 @@ __STATIC_FORCEINLINE rtcnt_t port_rt_get_counter_value(void) {
   return DWT->CYCCNT;
 }
 
+/**
+ * @brief   Compare-and-swap of a pointer.
+ *
+ * @param[in] p         pointer to the variable
+ * @param[in] expp      pointer to the expected value
+ * @param[in] v         the new value
+ * @return              The operation status.
+ * @retval true         if the variable has been updated.
+ * @retval false        if the variable did not match the expected value.
+ */
+__STATIC_FORCEINLINE bool port_cas_ptr(void **p, void **expp, void *v) {
+
+  do {
+    if ((void *)__LDREXW((volatile uint32_t *)p) != *expp) {
+      __CLREX();
+      return false;
+    }
+  } while (__STREXW((uint32_t)v, (volatile uint32_t *)p) != 0U);
+
+  return true;
+}
+
 #endif /* !defined(_FROM_ASM_) */
 
 #endif /* CHCORE_V7M_H */
@@ -27,8 +27,6 @@
 
 #if defined(WIN32)
 #include <windows.h>
-#else
-#include <sys/time.h>
 #endif
 
 #include "ch.h"
@@ -110,21 +108,23 @@ void _port_thread_start(msg_t (*pf)(void *), void *p) {
 
 /**
  * @brief   Returns the current value of the realtime counter.
+ * @note    The counter counts nanoseconds, it wraps every 2^32
+ *          nanoseconds.
  *
  * @return              The realtime counter value.
  */
 rtcnt_t port_rt_get_counter_value(void) {
 #if defined(WIN32)
-  LARGE_INTEGER n;
+  LARGE_INTEGER n, f;
 
+  QueryPerformanceFrequency(&f);
   QueryPerformanceCounter(&n);
 
-  return (rtcnt_t)(n.QuadPart / 1000LL);
+  return (rtcnt_t)(((n.QuadPart / f.QuadPart) * 1000000000LL) +
+                   (((n.QuadPart % f.QuadPart) * 1000000000LL) / f.QuadPart));
 #else
-  struct timeval tv;
 
-  gettimeofday(&tv, NULL);
-  return ((rtcnt_t)tv.tv_sec * (rtcnt_t)1000000) + (rtcnt_t)tv.tv_usec;
+  return (rtcnt_t)_sim_get_time_ns();
 #endif
 }
 
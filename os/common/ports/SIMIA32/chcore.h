@@ -283,6 +283,14 @@ struct port_context {
 #define PORT_FAST_IRQ_HANDLER(id) void id(void)
 #endif
 
+/**
+ * @brief   Mutexes fast path compare-and-swap.
+ * @note    Interrupts are only processed synchronously in this port, a
+ *          plain compare and store is atomic.
+ */
+#define CH_MTX_CAS(p, expp, v)                                              \
+  port_cas_ptr((void **)(p), (void **)(expp), (void *)(v))
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -303,7 +311,9 @@ extern "C" {
                                                            void *p);
   /*lint -restore*/
   rtcnt_t port_rt_get_counter_value(void);
+  uint64_t _sim_get_time_ns(void);
   void _sim_check_for_interrupts(void);
+  void _sim_wait_for_interrupts(void);
 #ifdef __cplusplus
 }
 #endif
@@ -431,11 +441,32 @@ static inline void port_enable(void) {
  *          The simplest implementation is an empty function or macro but this
  *          would not take advantage of architecture-specific power saving
  *          modes.
- * @note    Implemented as an inlined @p WFI instruction.
+ * @note    The simulator HAL blocks the host thread until a simulated
+ *          interrupt source fires, if supported.
  */
 static inline void port_wait_for_interrupt(void) {
 
-  _sim_check_for_interrupts();
+  _sim_wait_for_interrupts();
+}
+
+/**
+ * @brief   Compare-and-swap of a pointer.
+ *
+ * @param[in] p         pointer to the variable
+ * @param[in] expp      pointer to the expected value
+ * @param[in] v         the new value
+ * @return              The operation status.
+ * @retval true         if the variable has been updated.
+ * @retval false        if the variable did not match the expected value.
+ */
+static inline bool port_cas_ptr(void **p, void **expp, void *v) {
+
+  if (*p != *expp) {
+    return false;
+  }
+  *p = v;
+
+  return true;
 }
 
 #endif /* !defined(_FROM_ASM_) */
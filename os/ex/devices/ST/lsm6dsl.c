@@ -1085,7 +1085,7 @@ void lsm6dslStart(LSM6DSLDriver *devp, const LSM6DSLConfig *config) {
  * @api
  */
 void lsm6dslStop(LSM6DSLDriver *devp) {
-  uint8_t cr[2];
+  uint8_t cr[3];
 
   osalDbgCheck(devp != NULL);
 
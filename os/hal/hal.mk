@@ -11,7 +11,10 @@ ifeq ($(HALCONFDIR),)
   endif
 endif
 
-HALCONF := $(strip $(shell cat $(HALCONFDIR)/halconf.h | egrep -e "\#define"))
+# HALCONFDIR can list more than one directory, a driver is built if it is
+# enabled in any of the halconf.h files found there.
+HALCONF := $(strip $(shell cat $(addsuffix /halconf.h,$(HALCONFDIR)) | \
+                           egrep -e "\#define"))
 
 HALSRC := $(CHIBIOS)/os/hal/src/hal.c \
           $(CHIBIOS)/os/hal/src/hal_st.c \
@@ -28,11 +28,18 @@
  * @{
  */
 
+#include <limits.h>
+
 #include "hal.h"
 #include "chprintf.h"
 #include "memstreams.h"
 
+/* Digits of the longest octal representation of a long.*/
+#if LONG_MAX > 0x7FFFFFFFL
+#define MAX_FILLER 22
+#else
 #define MAX_FILLER 11
+#endif
 #define FLOAT_PRECISION 9
 
 static char *long_to_string_with_divisor(char *p,
@@ -30,6 +30,11 @@
 /* Driver local definitions.                                                 */
 /*===========================================================================*/
 
+/**
+ * @brief   Nanoseconds in one second.
+ */
+#define ST_NS_PER_SEC                       1000000000ULL
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -42,10 +47,54 @@
 /* Driver local variables and types.                                         */
 /*===========================================================================*/
 
+#if (OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) || defined(__DOXYGEN__)
+/**
+ * @brief   Current alarm time.
+ */
+static systime_t st_alarm;
+
+/**
+ * @brief   Alarm active flag.
+ */
+static bool st_alarm_active;
+#endif
+
 /*===========================================================================*/
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+#if (OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the full width ticks counter.
+ * @details The counter is derived from the simulated time so it never
+ *          drifts regardless of the host scheduling.
+ *
+ * @return              The number of ticks since the system start.
+ */
+static uint64_t st_get_ticks(void) {
+  uint64_t ns = _sim_get_time_ns();
+
+  return ((ns / ST_NS_PER_SEC) * (uint64_t)OSAL_ST_FREQUENCY) +
+         (((ns % ST_NS_PER_SEC) * (uint64_t)OSAL_ST_FREQUENCY) /
+          ST_NS_PER_SEC);
+}
+
+/**
+ * @brief   Converts a full width ticks counter value in nanoseconds.
+ * @note    The result is rounded up so that the counter has reached the
+ *          specified value at the returned time.
+ *
+ * @param[in] ticks     the ticks counter value
+ * @return              The simulated time in nanoseconds.
+ */
+static uint64_t st_ticks2ns(uint64_t ticks) {
+
+  return ((ticks / (uint64_t)OSAL_ST_FREQUENCY) * ST_NS_PER_SEC) +
+         ((((ticks % (uint64_t)OSAL_ST_FREQUENCY) * ST_NS_PER_SEC) +
+           (uint64_t)OSAL_ST_FREQUENCY - 1ULL) / (uint64_t)OSAL_ST_FREQUENCY);
+}
+#endif /* OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING */
+
 /*===========================================================================*/
 /* Driver interrupt handlers.                                                */
 /*===========================================================================*/
@@ -60,7 +109,113 @@
  * @notapi
  */
 void st_lld_init(void) {
+
+#if OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING
+  st_alarm        = (systime_t)0;
+  st_alarm_active = false;
+#endif
+}
+
+#if (OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the time counter value.
+ *
+ * @return              The counter value.
+ *
+ * @notapi
+ */
+systime_t st_lld_get_counter(void) {
+
+  return (systime_t)st_get_ticks();
+}
+
+/**
+ * @brief   Starts the alarm.
+ * @note    Makes sure that no spurious alarms are triggered after
+ *          this call.
+ *
+ * @param[in] time      the time to be set for the first alarm
+ *
+ * @notapi
+ */
+void st_lld_start_alarm(systime_t time) {
+
+  st_alarm_active = true;
+  st_lld_set_alarm(time);
+}
+
+/**
+ * @brief   Stops the alarm interrupt.
+ *
+ * @notapi
+ */
+void st_lld_stop_alarm(void) {
+
+  st_alarm_active = false;
+  _sim_stop_alarm();
+}
+
+/**
+ * @brief   Sets the alarm time.
+ * @note    The host can delay the simulator for an arbitrary time, an
+ *          alarm time found to be in the past is triggered immediately
+ *          instead of waiting for a counter wrap.
+ *
+ * @param[in] time      the time to be set for the next alarm
+ *
+ * @notapi
+ */
+void st_lld_set_alarm(systime_t time) {
+  uint64_t now = st_get_ticks();
+  systime_t delta = (systime_t)(time - (systime_t)now);
+
+  st_alarm = time;
+  if (delta > (systime_t)((systime_t)-1 >> 1)) {
+    delta = (systime_t)0;
+  }
+  _sim_set_alarm(st_ticks2ns(now + (uint64_t)delta));
+}
+
+/**
+ * @brief   Returns the current alarm time.
+ *
+ * @return              The currently set alarm time.
+ *
+ * @notapi
+ */
+systime_t st_lld_get_alarm(void) {
+
+  return st_alarm;
+}
+
+/**
+ * @brief   Determines if the alarm is active.
+ *
+ * @return              The alarm status.
+ * @retval false        if the alarm is not active.
+ * @retval true         is the alarm is active
+ *
+ * @notapi
+ */
+bool st_lld_is_alarm_active(void) {
+
+  return st_alarm_active;
+}
+
+/**
+ * @brief   Simulated alarm interrupt handling code.
+ *
+ * @notapi
+ */
+void st_lld_serve_interrupt(void) {
+
+  if (st_alarm_active) {
+    osalSysLockFromISR();
+    osalOsTimerHandlerI();
+    osalSysUnlockFromISR();
+  }
 }
+#endif /* OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING */
 
 #endif /* OSAL_ST_MODE != OSAL_ST_MODE_NONE */
 
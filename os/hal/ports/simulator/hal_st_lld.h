@@ -39,6 +39,10 @@
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if (OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) && defined(WIN32)
+#error "free running ST mode not supported by the Win32 simulator"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -55,6 +59,15 @@
 extern "C" {
 #endif
   void st_lld_init(void);
+#if OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING
+  systime_t st_lld_get_counter(void);
+  void st_lld_start_alarm(systime_t time);
+  void st_lld_stop_alarm(void);
+  void st_lld_set_alarm(systime_t time);
+  systime_t st_lld_get_alarm(void);
+  bool st_lld_is_alarm_active(void);
+  void st_lld_serve_interrupt(void);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -63,79 +76,6 @@ extern "C" {
 /* Driver inline functions.                                                  */
 /*===========================================================================*/
 
-/**
- * @brief   Returns the time counter value.
- *
- * @return              The counter value.
- *
- * @notapi
- */
-static inline systime_t st_lld_get_counter(void) {
-
-  return (systime_t)0;
-}
-
-/**
- * @brief   Starts the alarm.
- * @note    Makes sure that no spurious alarms are triggered after
- *          this call.
- *
- * @param[in] time      the time to be set for the first alarm
- *
- * @notapi
- */
-static inline void st_lld_start_alarm(systime_t time) {
-
-  (void)time;
-}
-
-/**
- * @brief   Stops the alarm interrupt.
- *
- * @notapi
- */
-static inline void st_lld_stop_alarm(void) {
-
-}
-
-/**
- * @brief   Sets the alarm time.
- *
- * @param[in] time      the time to be set for the next alarm
- *
- * @notapi
- */
-static inline void st_lld_set_alarm(systime_t time) {
-
-  (void)time;
-}
-
-/**
- * @brief   Returns the current alarm time.
- *
- * @return              The currently set alarm time.
- *
- * @notapi
- */
-static inline systime_t st_lld_get_alarm(void) {
-
-  return (systime_t)0;
-}
-
-/**
- * @brief   Determines if the alarm is active.
- *
- * @return              The alarm status.
- * @retval false        if the alarm is not active.
- * @retval true         is the alarm is active
- *
- * @notapi
- */
-static inline bool st_lld_is_alarm_active(void) {
-
-  return false;
-}
-
 #endif /* HAL_ST_LLD_H */
 
 /** @} */
@@ -0,0 +1,1106 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/posix/hal_can_lld.c
+ * @brief   Posix simulator CAN subsystem low level driver source.
+ * @details The driver connects simulator instances to a virtual bus made
+ *          of UNIX datagram sockets. The bus is hosted by the first
+ *          instance starting its driver, the host collects the frames
+ *          queued by the nodes, puts them on the bus in arbitration order
+ *          and delivers each one to all the nodes after its bus time at
+ *          the transmitter bit rate. A frame is not transmitted until a
+ *          second node acknowledges it by being on the bus. Nodes announce
+ *          themselves periodically, if the host terminates then the next
+ *          node noticing it hosts the bus and the pending transmissions
+ *          are queued again.
+ *
+ * @addtogroup POSIX_CAN
+ * @{
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "hal.h"
+
+#if (HAL_USE_CAN == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @name    Transmit mailbox states
+ * @{
+ */
+#define SIM_CAN_MBX_FREE                    0U
+#define SIM_CAN_MBX_QUEUED                  1U
+#define SIM_CAN_MBX_SENT                    2U
+#define SIM_CAN_MBX_ABORT                   3U
+#define SIM_CAN_MBX_ABORTING                4U
+/** @} */
+
+/**
+ * @name    Bus messages
+ * @{
+ */
+#define SIM_CAN_MSG_JOIN                    0U  /**< Node to bus, presence. */
+#define SIM_CAN_MSG_LEAVE                   1U  /**< Node to bus, leaving.  */
+#define SIM_CAN_MSG_TX                      2U  /**< Node to bus, frame.    */
+#define SIM_CAN_MSG_ABORT                   3U  /**< Node to bus, abort.    */
+#define SIM_CAN_MSG_RX                      4U  /**< Bus to node, frame.    */
+#define SIM_CAN_MSG_TXDONE                  5U  /**< Bus to node, sent.     */
+#define SIM_CAN_MSG_ABORTED                 6U  /**< Bus to node, aborted.  */
+
+#define SIM_CAN_MSG_IDE                     1U
+#define SIM_CAN_MSG_RTR                     2U
+/** @} */
+
+/**
+ * @brief   Interval between the nodes presence messages.
+ */
+#define SIM_CAN_HEARTBEAT_NS                100000000U
+
+/**
+ * @brief   Delivery retry interval when a node socket is full.
+ */
+#define SIM_CAN_RETRY_NS                    100000U
+
+/**
+ * @brief   No frame on the bus.
+ */
+#define SIM_CAN_IDLE                        -1
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   CAN1 driver identifier.
+ */
+CANDriver CAND1;
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a bus message.
+ */
+typedef struct {
+  uint8_t                   type;
+  uint8_t                   mailbox;
+  uint8_t                   dlc;
+  uint8_t                   flags;
+  uint32_t                  id;
+  uint32_t                  bitrate;
+  uint8_t                   data[8];
+} sim_can_msg_t;
+
+/**
+ * @brief   Type of a frame waiting for the bus.
+ */
+typedef struct {
+  bool                      used;
+  unsigned                  node;
+  uint32_t                  key;
+  uint32_t                  order;
+  uint64_t                  arrival;
+  sim_can_msg_t             msg;
+} sim_can_pending_t;
+
+/**
+ * @brief   Type of the bus host state.
+ */
+typedef struct {
+  /**
+   * @brief   Bus socket, -1 if the bus is hosted by another instance.
+   */
+  int                       fd;
+  /**
+   * @brief   Bus socket address.
+   */
+  struct sockaddr_un        addr;
+  /**
+   * @brief   Nodes addresses.
+   */
+  struct sockaddr_un        nodes[SIM_CAN_MAX_NODES];
+  /**
+   * @brief   Mask of the nodes on the bus.
+   */
+  uint32_t                  members;
+  /**
+   * @brief   Frames waiting for the bus.
+   */
+  sim_can_pending_t         pending[SIM_CAN_MAX_NODES * CAN_TX_MAILBOXES];
+  /**
+   * @brief   Arrival counter, frames with the same identifier are sent in
+   *          arrival order.
+   */
+  uint32_t                  order;
+  /**
+   * @brief   Index of the frame on the bus or @p SIM_CAN_IDLE.
+   */
+  int                       current;
+  /**
+   * @brief   Mask of the nodes still to be notified of the current frame.
+   */
+  uint32_t                  deliver;
+  /**
+   * @brief   End time of the current or last frame.
+   */
+  uint64_t                  bus_end;
+} sim_can_bus_t;
+
+/**
+ * @brief   Bus hosted by this instance.
+ */
+static sim_can_bus_t can_sim_bus;
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Creates a non-blocking datagram socket.
+ *
+ * @return              The socket descriptor.
+ */
+static int can_sim_socket(void) {
+  int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+
+  if ((fd < 0) ||
+      (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0) ||
+      (fcntl(fd, F_SETFD, FD_CLOEXEC) < 0)) {
+    printf("CAND1: Error creating the bus sockets\n");
+    exit(1);
+  }
+
+  return fd;
+}
+
+/**
+ * @brief   Binds a socket, reusing a path left behind by a terminated
+ *          instance.
+ *
+ * @param[in] fd        socket descriptor
+ * @param[in] sap       pointer to the socket address
+ * @return              @p true if the socket has been bound.
+ */
+static bool can_sim_bind(int fd, const struct sockaddr_un *sap) {
+  int probe;
+  bool alive;
+
+  if (bind(fd, (const struct sockaddr *)sap, sizeof (*sap)) == 0) {
+    return true;
+  }
+  if (errno != EADDRINUSE) {
+    return false;
+  }
+
+  probe = socket(AF_UNIX, SOCK_DGRAM, 0);
+  alive = connect(probe, (const struct sockaddr *)sap, sizeof (*sap)) == 0;
+  (void) close(probe);
+  if (alive) {
+    return false;
+  }
+
+  (void) unlink(sap->sun_path);
+  return bind(fd, (const struct sockaddr *)sap, sizeof (*sap)) == 0;
+}
+
+/**
+ * @brief   Returns the arbitration field of a frame.
+ * @details Identifier, SRR/RTR, IDE, extended identifier and RTR bits in
+ *          transmission order, the lowest value wins the arbitration.
+ *
+ * @param[in] mp        pointer to the frame message
+ * @return              The arbitration field.
+ */
+static uint32_t can_sim_key(const sim_can_msg_t *mp) {
+  uint32_t rtr = (mp->flags & SIM_CAN_MSG_RTR) != 0U ? 1U : 0U;
+
+  if ((mp->flags & SIM_CAN_MSG_IDE) != 0U) {
+    return ((mp->id >> 18) << 21) | (1U << 20) | (1U << 19) |
+           ((mp->id & 0x3FFFFU) << 1) | rtr;
+  }
+
+  return (mp->id << 21) | (rtr << 20);
+}
+
+/**
+ * @brief   Returns the bus time of a frame.
+ * @details Nominal frame length including the interframe space, bit
+ *          stuffing is not accounted.
+ *
+ * @param[in] mp        pointer to the frame message
+ * @return              The bus time in nanoseconds.
+ */
+static uint64_t can_sim_frame_ns(const sim_can_msg_t *mp) {
+  uint32_t bits = (mp->flags & SIM_CAN_MSG_IDE) != 0U ? 67U : 47U;
+
+  if (mp->bitrate == 0U) {
+    return 0U;
+  }
+
+  if ((mp->flags & SIM_CAN_MSG_RTR) == 0U) {
+    bits += 8U * (mp->dlc > 8U ? 8U : mp->dlc);
+  }
+
+  return ((uint64_t)bits * 1000000000U) / mp->bitrate;
+}
+
+/**
+ * @brief   Sends a message from the bus to a node.
+ *
+ * @param[in] node      node index
+ * @param[in] mp        pointer to the message
+ * @return              The operation status.
+ * @retval MSG_OK       if the message has been sent.
+ * @retval MSG_TIMEOUT  if the node socket is full.
+ * @retval MSG_RESET    if the node is no more running.
+ */
+static msg_t can_sim_bus_send(unsigned node, const sim_can_msg_t *mp) {
+
+  if (sendto(can_sim_bus.fd, mp, sizeof (*mp), 0,
+             (const struct sockaddr *)&can_sim_bus.nodes[node],
+             sizeof (can_sim_bus.nodes[node])) >= 0) {
+    return MSG_OK;
+  }
+  if ((errno == EAGAIN) || (errno == EWOULDBLOCK) ||
+      (errno == ENOBUFS) || (errno == EINTR)) {
+    return MSG_TIMEOUT;
+  }
+
+  return MSG_RESET;
+}
+
+/**
+ * @brief   Removes a node and its pending frames from the bus.
+ *
+ * @param[in] node      node index
+ */
+static void can_sim_bus_remove(unsigned node) {
+  unsigned i;
+
+  for (i = 0U; i < SIM_CAN_MAX_NODES * CAN_TX_MAILBOXES; i++) {
+    if (can_sim_bus.pending[i].used && (can_sim_bus.pending[i].node == node) &&
+        ((int)i != can_sim_bus.current)) {
+      can_sim_bus.pending[i].used = false;
+    }
+  }
+  can_sim_bus.members &= ~(1U << node);
+  can_sim_bus.deliver &= ~(1U << node);
+}
+
+/**
+ * @brief   Returns the index of the node with the specified address.
+ * @details Unknown nodes are added to the bus.
+ *
+ * @param[in] sap       pointer to the node address
+ * @return              The node index or -1 if the bus is full.
+ */
+static int can_sim_bus_node(const struct sockaddr_un *sap) {
+  int free = -1;
+  unsigned i;
+
+  for (i = 0U; i < SIM_CAN_MAX_NODES; i++) {
+    if ((can_sim_bus.members & (1U << i)) == 0U) {
+      if (free < 0) {
+        free = (int)i;
+      }
+    }
+    else if (strcmp(can_sim_bus.nodes[i].sun_path, sap->sun_path) == 0) {
+      return (int)i;
+    }
+  }
+
+  if (free >= 0) {
+    can_sim_bus.nodes[free] = *sap;
+    can_sim_bus.members |= 1U << free;
+  }
+
+  return free;
+}
+
+/**
+ * @brief   Handles the messages received by the bus.
+ *
+ * @param[in] now       current time
+ */
+static void can_sim_bus_receive(uint64_t now) {
+  struct sockaddr_un from;
+  socklen_t len;
+  sim_can_msg_t msg;
+  ssize_t n;
+  unsigned slot;
+  int node;
+
+  while (true) {
+    len = sizeof (from);
+    memset(&from, 0, sizeof (from));
+    n = recvfrom(can_sim_bus.fd, &msg, sizeof (msg), MSG_TRUNC,
+                 (struct sockaddr *)&from, &len);
+    if (n < 0) {
+      break;
+    }
+    if ((n != (ssize_t)sizeof (msg)) || (from.sun_path[0] == '\0') ||
+        (msg.mailbox >= CAN_TX_MAILBOXES)) {
+      /* Invalid message or unnamed sender, purging.*/
+      continue;
+    }
+
+    node = can_sim_bus_node(&from);
+    if (node < 0) {
+      continue;
+    }
+
+    /* Slot of the node mailbox in the pending frames.*/
+    slot = ((unsigned)node * CAN_TX_MAILBOXES) + msg.mailbox;
+
+    switch (msg.type) {
+    case SIM_CAN_MSG_LEAVE:
+      can_sim_bus_remove((unsigned)node);
+      break;
+    case SIM_CAN_MSG_TX:
+      if ((int)slot != can_sim_bus.current) {
+        can_sim_bus.pending[slot].used    = true;
+        can_sim_bus.pending[slot].node    = (unsigned)node;
+        can_sim_bus.pending[slot].key     = can_sim_key(&msg);
+        can_sim_bus.pending[slot].order   = can_sim_bus.order++;
+        can_sim_bus.pending[slot].arrival = now;
+        can_sim_bus.pending[slot].msg     = msg;
+      }
+      break;
+    case SIM_CAN_MSG_ABORT:
+      /* A frame already on the bus completes normally.*/
+      if (can_sim_bus.pending[slot].used &&
+          ((int)slot != can_sim_bus.current)) {
+        can_sim_bus.pending[slot].used = false;
+        msg.type = SIM_CAN_MSG_ABORTED;
+        if (can_sim_bus_send((unsigned)node, &msg) == MSG_RESET) {
+          can_sim_bus_remove((unsigned)node);
+        }
+      }
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+/**
+ * @brief   Runs the bus.
+ * @details Delivers the frame on the bus when its time elapsed then
+ *          arbitrates among the pending frames, frames with the same
+ *          arbitration field are sent in request order. A frame pending
+ *          when the bus became free starts at the end of the previous
+ *          frame, the bus keeps its pace when the instance is served late.
+ *
+ * @param[in] now       current time
+ */
+static void can_sim_bus_serve(uint64_t now) {
+  sim_can_pending_t *pp;
+  sim_can_msg_t msg;
+  uint64_t start;
+  unsigned i;
+  int best;
+
+  can_sim_bus_receive(now);
+
+  while (true) {
+    if (can_sim_bus.current != SIM_CAN_IDLE) {
+      pp = &can_sim_bus.pending[can_sim_bus.current];
+
+      if (now < can_sim_bus.bus_end) {
+        _sim_set_wakeup(can_sim_bus.bus_end);
+        return;
+      }
+
+      /* End of frame, the transmitter is notified of the completion and
+         the other nodes receive the frame.*/
+      for (i = 0U; i < SIM_CAN_MAX_NODES; i++) {
+        if ((can_sim_bus.deliver & (1U << i)) != 0U) {
+          msg = pp->msg;
+          msg.type = i == pp->node ? SIM_CAN_MSG_TXDONE : SIM_CAN_MSG_RX;
+          switch (can_sim_bus_send(i, &msg)) {
+          case MSG_OK:
+            can_sim_bus.deliver &= ~(1U << i);
+            break;
+          case MSG_RESET:
+            can_sim_bus_remove(i);
+            break;
+          default:
+            break;
+          }
+        }
+      }
+      if (can_sim_bus.deliver != 0U) {
+        /* The bus is stalled until all nodes got the frame.*/
+        _sim_set_wakeup(now + SIM_CAN_RETRY_NS);
+        return;
+      }
+
+      pp->used = false;
+      can_sim_bus.current = SIM_CAN_IDLE;
+    }
+
+    /* The frames stay pending while there is nobody else to acknowledge
+       them.*/
+    if ((can_sim_bus.members & (can_sim_bus.members - 1U)) == 0U) {
+      return;
+    }
+
+    best = SIM_CAN_IDLE;
+    for (i = 0U; i < SIM_CAN_MAX_NODES * CAN_TX_MAILBOXES; i++) {
+      pp = &can_sim_bus.pending[i];
+      if (pp->used &&
+          ((best == SIM_CAN_IDLE) ||
+           (pp->key < can_sim_bus.pending[best].key) ||
+           ((pp->key == can_sim_bus.pending[best].key) &&
+            ((int32_t)(pp->order - can_sim_bus.pending[best].order) < 0)))) {
+        best = (int)i;
+      }
+    }
+    if (best == SIM_CAN_IDLE) {
+      return;
+    }
+
+    pp = &can_sim_bus.pending[best];
+    start = pp->arrival > can_sim_bus.bus_end ? pp->arrival :
+                                                can_sim_bus.bus_end;
+    can_sim_bus.current = best;
+    can_sim_bus.deliver = can_sim_bus.members;
+    can_sim_bus.bus_end = start + can_sim_frame_ns(&pp->msg);
+  }
+}
+
+/**
+ * @brief   Starts hosting the bus.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @return              @p true if the bus socket has been bound.
+ */
+static bool can_sim_bus_open(CANDriver *canp) {
+  unsigned i;
+
+  can_sim_bus.fd   = can_sim_socket();
+  can_sim_bus.addr = canp->bus;
+  if (!can_sim_bind(can_sim_bus.fd, &can_sim_bus.addr)) {
+    (void) close(can_sim_bus.fd);
+    can_sim_bus.fd = -1;
+    return false;
+  }
+
+  for (i = 0U; i < SIM_CAN_MAX_NODES * CAN_TX_MAILBOXES; i++) {
+    can_sim_bus.pending[i].used = false;
+  }
+  can_sim_bus.members = 0U;
+  can_sim_bus.current = SIM_CAN_IDLE;
+  can_sim_bus.deliver = 0U;
+  can_sim_bus.bus_end = 0U;
+  _sim_register_fd(can_sim_bus.fd);
+
+  return true;
+}
+
+/**
+ * @brief   Stops hosting the bus.
+ * @details The other instances notice it and one of them takes over.
+ */
+static void can_sim_bus_close(void) {
+
+  if (can_sim_bus.fd >= 0) {
+    /* Closed descriptors are removed from the interrupt sources.*/
+    (void) close(can_sim_bus.fd);
+    (void) unlink(can_sim_bus.addr.sun_path);
+    can_sim_bus.fd = -1;
+  }
+}
+
+/**
+ * @brief   Connects the node socket to the bus.
+ * @details If the bus is not hosted by a running instance then this
+ *          instance hosts it. Frames sent to a previous host are queued
+ *          again.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @return              @p true if the node is on the bus.
+ */
+static bool can_sim_attach(CANDriver *canp) {
+  sim_can_msg_t msg;
+  unsigned i;
+
+  if ((connect(canp->fd, (struct sockaddr *)&canp->bus,
+               sizeof (canp->bus)) != 0) &&
+      (!can_sim_bus_open(canp) ||
+       (connect(canp->fd, (struct sockaddr *)&canp->bus,
+                sizeof (canp->bus)) != 0))) {
+    return false;
+  }
+
+  for (i = 0U; i < CAN_TX_MAILBOXES; i++) {
+    if (canp->tx[i].state == SIM_CAN_MBX_SENT) {
+      canp->tx[i].state = SIM_CAN_MBX_QUEUED;
+    }
+    else if (canp->tx[i].state == SIM_CAN_MBX_ABORTING) {
+      canp->tx[i].state = SIM_CAN_MBX_ABORT;
+    }
+  }
+
+  memset(&msg, 0, sizeof (msg));
+  msg.type = SIM_CAN_MSG_JOIN;
+  (void) send(canp->fd, &msg, sizeof (msg), 0);
+
+  return true;
+}
+
+/**
+ * @brief   Sends a message from a node to the bus.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mp        pointer to the message
+ * @return              @p true if the message has been sent.
+ */
+static bool can_sim_send(CANDriver *canp, const sim_can_msg_t *mp) {
+
+  if (send(canp->fd, mp, sizeof (*mp), 0) >= 0) {
+    return true;
+  }
+  if ((errno == EAGAIN) || (errno == EWOULDBLOCK) ||
+      (errno == ENOBUFS) || (errno == EINTR)) {
+    return false;
+  }
+
+  /* Bus host terminated, one more attempt after attaching again.*/
+  return can_sim_attach(canp) && (send(canp->fd, mp, sizeof (*mp), 0) >= 0);
+}
+
+/**
+ * @brief   Sends the queued transmit mailboxes and abort requests.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ */
+static void can_sim_transmit(CANDriver *canp) {
+  sim_can_msg_t msg;
+  bool wait = false;
+  unsigned i;
+
+  for (i = 0U; (i < CAN_TX_MAILBOXES) && !wait; i++) {
+    sim_can_mailbox_t *mbp = &canp->tx[i];
+
+    memset(&msg, 0, sizeof (msg));
+    msg.mailbox = (uint8_t)i;
+    if (mbp->state == SIM_CAN_MBX_QUEUED) {
+      msg.type    = SIM_CAN_MSG_TX;
+      msg.dlc     = mbp->frame.DLC;
+      msg.flags   = (mbp->frame.IDE != 0U ? SIM_CAN_MSG_IDE : 0U) |
+                    (mbp->frame.RTR != 0U ? SIM_CAN_MSG_RTR : 0U);
+      msg.id      = mbp->frame.IDE != 0U ? mbp->frame.EID : mbp->frame.SID;
+      msg.bitrate = canp->config->bitrate;
+      memcpy(msg.data, mbp->frame.data8, sizeof (msg.data));
+      if (can_sim_send(canp, &msg)) {
+        /* The state could have been reset by attaching to a new host.*/
+        if (mbp->state == SIM_CAN_MBX_QUEUED) {
+          mbp->state = SIM_CAN_MBX_SENT;
+        }
+      }
+      else {
+        wait = true;
+      }
+    }
+    else if (mbp->state == SIM_CAN_MBX_ABORT) {
+      msg.type = SIM_CAN_MSG_ABORT;
+      if (can_sim_send(canp, &msg)) {
+        if (mbp->state == SIM_CAN_MBX_ABORT) {
+          mbp->state = SIM_CAN_MBX_ABORTING;
+        }
+      }
+      else {
+        wait = true;
+      }
+    }
+  }
+
+  /* Waking up on writable socket only while there are messages waiting.*/
+  if (canp->txwait != wait) {
+    canp->txwait = wait;
+    _sim_watch_fd(canp->fd, true, wait);
+  }
+}
+
+/**
+ * @brief   Applies the receive filters to a frame.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mp        pointer to the frame message
+ * @param[out] fifop    receive mailbox index for the frame
+ * @param[out] fmip     filter match index
+ * @return              @p true if the frame is accepted.
+ */
+static bool can_sim_filter(CANDriver *canp, const sim_can_msg_t *mp,
+                           unsigned *fifop, uint8_t *fmip) {
+  uint32_t w, fmi = 0U;
+  unsigned i;
+
+  *fifop = 0U;
+  *fmip  = 0U;
+  if (canp->num_filters == 0U) {
+    return true;
+  }
+
+  if ((mp->flags & SIM_CAN_MSG_IDE) != 0U) {
+    w = CAN_FILTER_EID(mp->id) | CAN_FILTER_IDE;
+  }
+  else {
+    w = CAN_FILTER_SID(mp->id);
+  }
+  if ((mp->flags & SIM_CAN_MSG_RTR) != 0U) {
+    w |= CAN_FILTER_RTR;
+  }
+
+  for (i = 0U; i < canp->num_filters; i++) {
+    const CANFilter *cfp = &canp->filters[i];
+
+    *fifop = cfp->assignment;
+    if (cfp->mode == 0U) {
+      if (((w ^ cfp->register1) & cfp->register2 & ~1U) == 0U) {
+        *fmip = (uint8_t)fmi;
+        return true;
+      }
+      fmi += 1U;
+    }
+    else {
+      if (w == (cfp->register1 & ~1U)) {
+        *fmip = (uint8_t)fmi;
+        return true;
+      }
+      if (w == (cfp->register2 & ~1U)) {
+        *fmip = (uint8_t)(fmi + 1U);
+        return true;
+      }
+      fmi += 2U;
+    }
+  }
+
+  return false;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Simulated CAN interrupt.
+ * @note    The bus hosted by this instance is also served here.
+ *
+ * @return              @p true if an interrupt has been served.
+ *
+ * @notapi
+ */
+bool can_lld_interrupt_pending(void) {
+  CANDriver *canp = &CAND1;
+  eventflags_t txflags = 0U, rxflags = 0U, errors = 0U;
+  bool wakeup = false;
+  sim_can_msg_t msg;
+  uint64_t now;
+
+  if ((canp->state != CAN_READY) && (canp->state != CAN_SLEEP)) {
+    return false;
+  }
+
+  now = _sim_get_time_ns();
+  if (can_sim_bus.fd >= 0) {
+    can_sim_bus_serve(now);
+  }
+
+  OSAL_IRQ_PROLOGUE();
+
+  while (recv(canp->fd, &msg, sizeof (msg), MSG_TRUNC) ==
+         (ssize_t)sizeof (msg)) {
+    sim_can_mailbox_t *mbp;
+    sim_can_fifo_t *fifop;
+    CANRxFrame *crfp;
+    unsigned fifo;
+    uint8_t fmi;
+
+    switch (msg.type) {
+    case SIM_CAN_MSG_RX:
+      if (canp->state == CAN_SLEEP) {
+        /* Bus activity wakes up the controller, the frame is lost.*/
+        canp->state = CAN_READY;
+        wakeup = true;
+        break;
+      }
+      if (!can_sim_filter(canp, &msg, &fifo, &fmi)) {
+        break;
+      }
+      fifop = &canp->rx[fifo];
+      if (fifop->count >= SIM_CAN_RX_FIFO_SIZE) {
+        canp->rxoverflows++;
+        errors |= CAN_OVERFLOW_ERROR;
+        break;
+      }
+      crfp = &fifop->frames[(fifop->head + fifop->count) %
+                            SIM_CAN_RX_FIFO_SIZE];
+      crfp->FMI  = fmi;
+      crfp->TIME = (uint16_t)(now / 1000U);
+      crfp->DLC  = msg.dlc;
+      crfp->RTR  = (msg.flags & SIM_CAN_MSG_RTR) != 0U ? 1U : 0U;
+      crfp->IDE  = (msg.flags & SIM_CAN_MSG_IDE) != 0U ? 1U : 0U;
+      if (crfp->IDE != 0U) {
+        crfp->EID = msg.id;
+      }
+      else {
+        crfp->SID = msg.id;
+      }
+      memcpy(crfp->data8, msg.data, sizeof (crfp->data8));
+      canp->rxframes++;
+      /* No more receive events until the mailbox has been emptied.*/
+      if (fifop->count++ == 0U) {
+        rxflags |= CAN_MAILBOX_TO_MASK(fifo + 1U);
+      }
+      break;
+    case SIM_CAN_MSG_TXDONE:
+    case SIM_CAN_MSG_ABORTED:
+      if (msg.mailbox >= CAN_TX_MAILBOXES) {
+        break;
+      }
+      mbp = &canp->tx[msg.mailbox];
+      if ((mbp->state == SIM_CAN_MBX_SENT) ||
+          (mbp->state == SIM_CAN_MBX_ABORT) ||
+          (mbp->state == SIM_CAN_MBX_ABORTING)) {
+        mbp->state = SIM_CAN_MBX_FREE;
+        txflags |= CAN_MAILBOX_TO_MASK(msg.mailbox + 1U);
+        if (msg.type == SIM_CAN_MSG_TXDONE) {
+          canp->txframes++;
+        }
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  /* Presence message, it also detects a terminated bus host.*/
+  if (now >= canp->heartbeat) {
+    memset(&msg, 0, sizeof (msg));
+    msg.type = SIM_CAN_MSG_JOIN;
+    (void) can_sim_send(canp, &msg);
+    canp->heartbeat = now + SIM_CAN_HEARTBEAT_NS;
+  }
+  _sim_set_wakeup(canp->heartbeat);
+
+  can_sim_transmit(canp);
+
+#if CAN_USE_SLEEP_MODE
+  if (wakeup) {
+    _can_wakeup_isr(canp);
+  }
+#else
+  (void)wakeup;
+#endif
+  if (txflags != 0U) {
+    _can_tx_empty_isr(canp, txflags);
+  }
+  if (rxflags != 0U) {
+    _can_rx_full_isr(canp, rxflags);
+  }
+  if (errors != 0U) {
+    _can_error_isr(canp, errors);
+  }
+
+  OSAL_IRQ_EPILOGUE();
+
+  return wakeup || (txflags != 0U) || (rxflags != 0U) || (errors != 0U);
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level CAN driver initialization.
+ *
+ * @notapi
+ */
+void can_lld_init(void) {
+
+  canObjectInit(&CAND1);
+  CAND1.fd          = -1;
+  CAND1.num_filters = 0U;
+  can_sim_bus.fd    = -1;
+}
+
+/**
+ * @brief   Configures and activates the CAN peripheral.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ *
+ * @notapi
+ */
+void can_lld_start(CANDriver *canp) {
+  const char *path = canp->config->path != NULL ? canp->config->path :
+                                                  SIM_CAN_PATH;
+  unsigned i;
+
+  for (i = 0U; i < CAN_TX_MAILBOXES; i++) {
+    canp->tx[i].state = SIM_CAN_MBX_FREE;
+  }
+  for (i = 0U; i < CAN_RX_MAILBOXES; i++) {
+    canp->rx[i].head  = 0U;
+    canp->rx[i].count = 0U;
+  }
+  canp->txwait      = false;
+  canp->txframes    = 0U;
+  canp->rxframes    = 0U;
+  canp->rxoverflows = 0U;
+  canp->heartbeat   = _sim_get_time_ns() + SIM_CAN_HEARTBEAT_NS;
+
+  memset(&canp->bus, 0, sizeof (canp->bus));
+  canp->bus.sun_family = AF_UNIX;
+  (void) snprintf(canp->bus.sun_path, sizeof (canp->bus.sun_path), "%s",
+                  path);
+  memset(&canp->local, 0, sizeof (canp->local));
+  canp->local.sun_family = AF_UNIX;
+  (void) snprintf(canp->local.sun_path, sizeof (canp->local.sun_path),
+                  "%s.%d", path, (int)getpid());
+
+  canp->fd = can_sim_socket();
+  (void) unlink(canp->local.sun_path);
+  if (bind(canp->fd, (struct sockaddr *)&canp->local,
+           sizeof (canp->local)) != 0) {
+    printf("%s: Error binding the node socket\n", canp->local.sun_path);
+    exit(1);
+  }
+  _sim_register_fd(canp->fd);
+
+  if (!can_sim_attach(canp)) {
+    printf("%s: Error attaching to the bus\n", path);
+    exit(1);
+  }
+}
+
+/**
+ * @brief   Deactivates the CAN peripheral.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ *
+ * @notapi
+ */
+void can_lld_stop(CANDriver *canp) {
+  sim_can_msg_t msg;
+
+  if (canp->fd >= 0) {
+    memset(&msg, 0, sizeof (msg));
+    msg.type = SIM_CAN_MSG_LEAVE;
+    (void) send(canp->fd, &msg, sizeof (msg), 0);
+
+    /* Closed descriptors are removed from the interrupt sources.*/
+    (void) close(canp->fd);
+    (void) unlink(canp->local.sun_path);
+    canp->fd = -1;
+
+    can_sim_bus_close();
+  }
+}
+
+/**
+ * @brief   Determines whether a frame can be transmitted.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mailbox   mailbox number, @p CAN_ANY_MAILBOX for any mailbox
+ *
+ * @return              The queue space availability.
+ * @retval false        no space in the transmit queue.
+ * @retval true         transmit slot available.
+ *
+ * @notapi
+ */
+bool can_lld_is_tx_empty(CANDriver *canp, canmbx_t mailbox) {
+  unsigned i;
+
+  if (mailbox != CAN_ANY_MAILBOX) {
+    return canp->tx[mailbox - 1U].state == SIM_CAN_MBX_FREE;
+  }
+
+  for (i = 0U; i < CAN_TX_MAILBOXES; i++) {
+    if (canp->tx[i].state == SIM_CAN_MBX_FREE) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief   Inserts a frame into the transmit queue.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] ctfp      pointer to the CAN frame to be transmitted
+ * @param[in] mailbox   mailbox number,  @p CAN_ANY_MAILBOX for any mailbox
+ *
+ * @notapi
+ */
+void can_lld_transmit(CANDriver *canp,
+                      canmbx_t mailbox,
+                      const CANTxFrame *ctfp) {
+  unsigned i = 0U;
+
+  if (mailbox != CAN_ANY_MAILBOX) {
+    i = mailbox - 1U;
+  }
+  else {
+    while (canp->tx[i].state != SIM_CAN_MBX_FREE) {
+      i++;
+    }
+  }
+
+  canp->tx[i].frame = *ctfp;
+  canp->tx[i].state = SIM_CAN_MBX_QUEUED;
+
+  /* Immediate transmission attempt.*/
+  can_sim_transmit(canp);
+}
+
+/**
+ * @brief   Determines whether a frame has been received.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mailbox   mailbox number, @p CAN_ANY_MAILBOX for any mailbox
+ *
+ * @return              The queue space availability.
+ * @retval false        no space in the transmit queue.
+ * @retval true         transmit slot available.
+ *
+ * @notapi
+ */
+bool can_lld_is_rx_nonempty(CANDriver *canp, canmbx_t mailbox) {
+
+  if (mailbox != CAN_ANY_MAILBOX) {
+    return canp->rx[mailbox - 1U].count > 0U;
+  }
+
+  return (canp->rx[0].count > 0U) || (canp->rx[1].count > 0U);
+}
+
+/**
+ * @brief   Receives a frame from the input queue.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mailbox   mailbox number, @p CAN_ANY_MAILBOX for any mailbox
+ * @param[out] crfp     pointer to the buffer where the CAN frame is copied
+ *
+ * @notapi
+ */
+void can_lld_receive(CANDriver *canp,
+                     canmbx_t mailbox,
+                     CANRxFrame *crfp) {
+  sim_can_fifo_t *fifop;
+
+  if (mailbox != CAN_ANY_MAILBOX) {
+    fifop = &canp->rx[mailbox - 1U];
+  }
+  else {
+    fifop = canp->rx[0].count > 0U ? &canp->rx[0] : &canp->rx[1];
+  }
+
+  *crfp = fifop->frames[fifop->head];
+  fifop->head = (fifop->head + 1U) % SIM_CAN_RX_FIFO_SIZE;
+  fifop->count--;
+}
+
+/**
+ * @brief   Tries to abort an ongoing transmission.
+ * @details A frame not yet on the bus is aborted, the mailbox becomes
+ *          empty when the bus confirms the abort or the transmission.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mailbox   mailbox number
+ *
+ * @notapi
+ */
+void can_lld_abort(CANDriver *canp,
+                   canmbx_t mailbox) {
+  sim_can_mailbox_t *mbp = &canp->tx[mailbox - 1U];
+
+  if (mbp->state == SIM_CAN_MBX_QUEUED) {
+    /* Not sent to the bus yet.*/
+    mbp->state = SIM_CAN_MBX_FREE;
+  }
+  else if (mbp->state == SIM_CAN_MBX_SENT) {
+    mbp->state = SIM_CAN_MBX_ABORT;
+    can_sim_transmit(canp);
+  }
+}
+
+#if CAN_USE_SLEEP_MODE || defined(__DOXYGEN__)
+/**
+ * @brief   Enters the sleep mode.
+ * @details Frames received in sleep mode wake up the controller and are
+ *          lost.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ *
+ * @notapi
+ */
+void can_lld_sleep(CANDriver *canp) {
+
+  (void)canp;
+}
+
+/**
+ * @brief   Enforces leaving the sleep mode.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ *
+ * @notapi
+ */
+void can_lld_wakeup(CANDriver *canp) {
+
+  (void)canp;
+}
+#endif /* CAN_USE_SLEEP_MODE */
+
+/**
+ * @brief   Programs the filters.
+ * @note    This is a simulator-specific API.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] num       number of entries in the filters array, if zero then
+ *                      all frames are received in the first mailbox
+ * @param[in] cfp       pointer to the filters array, can be @p NULL if
+ *                      (num == 0)
+ *
+ * @api
+ */
+void canSimSetFilters(CANDriver *canp, uint32_t num, const CANFilter *cfp) {
+
+  osalDbgCheck((canp != NULL) && (num <= SIM_CAN_MAX_FILTERS) &&
+               ((num == 0U) || (cfp != NULL)));
+  osalDbgAssert(canp->state == CAN_STOP, "invalid state");
+
+  if (num > 0U) {
+    memcpy(canp->filters, cfp, num * sizeof (CANFilter));
+  }
+  canp->num_filters = num;
+}
+
+#endif /* HAL_USE_CAN == TRUE */
+
+/** @} */
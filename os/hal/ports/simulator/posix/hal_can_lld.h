@@ -0,0 +1,476 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/posix/hal_can_lld.h
+ * @brief   Posix simulator CAN subsystem low level driver header.
+ *
+ * @addtogroup POSIX_CAN
+ * @{
+ */
+
+#ifndef HAL_CAN_LLD_H
+#define HAL_CAN_LLD_H
+
+#if (HAL_USE_CAN == TRUE) || defined(__DOXYGEN__)
+
+#include <sys/un.h>
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   This switch defines whether the driver implementation supports
+ *          a low power switch mode with automatic an wakeup feature.
+ */
+#define CAN_SUPPORTS_SLEEP          TRUE
+
+/**
+ * @brief   This implementation supports three transmit mailboxes.
+ */
+#define CAN_TX_MAILBOXES            3
+
+/**
+ * @brief   This implementation supports two receive mailboxes.
+ */
+#define CAN_RX_MAILBOXES            2
+
+/**
+ * @name    CAN frame helper macros
+ * @{
+ */
+#define CAN_IDE_STD                 0           /**< @brief Standard id.    */
+#define CAN_IDE_EXT                 1           /**< @brief Extended id.    */
+
+#define CAN_RTR_DATA                0           /**< @brief Data frame.     */
+#define CAN_RTR_REMOTE              1           /**< @brief Remote frame.   */
+/** @} */
+
+/**
+ * @name    CAN filter registers helper macros
+ * @details Filter registers have the STM32 32 bits scale layout.
+ * @{
+ */
+#define CAN_FILTER_SID(n)           ((uint32_t)(n) << 21)
+#define CAN_FILTER_EID(n)           ((uint32_t)(n) << 3)
+#define CAN_FILTER_IDE              (1U << 2)
+#define CAN_FILTER_RTR              (1U << 1)
+/** @} */
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   Depth of each receive mailbox.
+ */
+#if !defined(SIM_CAN_RX_FIFO_SIZE) || defined(__DOXYGEN__)
+#define SIM_CAN_RX_FIFO_SIZE                16
+#endif
+
+/**
+ * @brief   Maximum number of receive filters.
+ */
+#if !defined(SIM_CAN_MAX_FILTERS) || defined(__DOXYGEN__)
+#define SIM_CAN_MAX_FILTERS                 28
+#endif
+
+/**
+ * @brief   Maximum number of nodes on the simulated bus.
+ */
+#if !defined(SIM_CAN_MAX_NODES) || defined(__DOXYGEN__)
+#define SIM_CAN_MAX_NODES                   16
+#endif
+
+/**
+ * @brief   Default path of the simulated bus socket.
+ * @details The first simulator instance starting its driver binds the
+ *          bus socket and hosts the bus, the other instances connect to
+ *          it. Each instance also binds a node socket, the bus path
+ *          followed by the process id.
+ */
+#if !defined(SIM_CAN_PATH) || defined(__DOXYGEN__)
+#define SIM_CAN_PATH                        "/tmp/chibios_can1"
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if defined(WIN32)
+#error "the simulated CAN is not supported on Win32"
+#endif
+
+#if SIM_CAN_RX_FIFO_SIZE < 1
+#error "invalid SIM_CAN_RX_FIFO_SIZE value"
+#endif
+
+#if (SIM_CAN_MAX_NODES < 2) || (SIM_CAN_MAX_NODES > 32)
+#error "invalid SIM_CAN_MAX_NODES value"
+#endif
+
+#if CAN_USE_SLEEP_MODE && !CAN_SUPPORTS_SLEEP
+#error "CAN sleep mode not supported in this architecture"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a structure representing an CAN driver.
+ */
+typedef struct CANDriver CANDriver;
+
+/**
+ * @brief   Type of a transmission mailbox index.
+ */
+typedef uint32_t canmbx_t;
+
+#if (CAN_ENFORCE_USE_CALLBACKS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Type of a CAN notification callback.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object triggering the
+ *                      callback
+ * @param[in] flags     flags associated to the mailbox callback
+ */
+typedef void (*can_callback_t)(CANDriver *canp, uint32_t flags);
+#endif
+
+/**
+ * @brief   CAN transmission frame.
+ * @note    Accessing the frame data as word16 or word32 is not portable because
+ *          machine data endianness, it can be still useful for a quick filling.
+ */
+typedef struct {
+  struct {
+    uint8_t                 DLC:4;          /**< @brief Data length.        */
+    uint8_t                 RTR:1;          /**< @brief Frame type.         */
+    uint8_t                 IDE:1;          /**< @brief Identifier type.    */
+  };
+  union {
+    struct {
+      uint32_t              SID:11;         /**< @brief Standard identifier.*/
+    };
+    struct {
+      uint32_t              EID:29;         /**< @brief Extended identifier.*/
+    };
+  };
+  union {
+    uint8_t                 data8[8];       /**< @brief Frame data.         */
+    uint16_t                data16[4];      /**< @brief Frame data.         */
+    uint32_t                data32[2];      /**< @brief Frame data.         */
+    uint64_t                data64[1];      /**< @brief Frame data.         */
+  };
+} CANTxFrame;
+
+/**
+ * @brief   CAN received frame.
+ * @note    Accessing the frame data as word16 or word32 is not portable because
+ *          machine data endianness, it can be still useful for a quick filling.
+ * @note    In this implementation @p TIME is the reception time in
+ *          microseconds, modulo 65536.
+ */
+typedef struct {
+  struct {
+    uint8_t                 FMI;            /**< @brief Filter id.          */
+    uint16_t                TIME;           /**< @brief Time stamp.         */
+  };
+  struct {
+    uint8_t                 DLC:4;          /**< @brief Data length.        */
+    uint8_t                 RTR:1;          /**< @brief Frame type.         */
+    uint8_t                 IDE:1;          /**< @brief Identifier type.    */
+  };
+  union {
+    struct {
+      uint32_t              SID:11;         /**< @brief Standard identifier.*/
+    };
+    struct {
+      uint32_t              EID:29;         /**< @brief Extended identifier.*/
+    };
+  };
+  union {
+    uint8_t                 data8[8];       /**< @brief Frame data.         */
+    uint16_t                data16[4];      /**< @brief Frame data.         */
+    uint32_t                data32[2];      /**< @brief Frame data.         */
+    uint64_t                data64[1];      /**< @brief Frame data.         */
+  };
+} CANRxFrame;
+
+/**
+ * @brief   CAN filter.
+ * @details Filters are emulated in software, the registers have the
+ *          layout of the STM32 filters in 32 bits scale, see the
+ *          @p CAN_FILTER_* macros. The filter match index of a received
+ *          frame counts one index for each filter in mask mode and two
+ *          for each filter in list mode, in the filters order.
+ */
+typedef struct {
+  /**
+   * @brief   Filter mode.
+   * @note    0=mask mode, 1=list mode.
+   */
+  uint32_t                  mode:1;
+  /**
+   * @brief   Filter assignment.
+   * @note    0=receive mailbox 1, 1=receive mailbox 2.
+   */
+  uint32_t                  assignment:1;
+  /**
+   * @brief   Filter register 1 (identifier).
+   */
+  uint32_t                  register1;
+  /**
+   * @brief   Filter register 2 (mask/identifier depending on mode=0/1).
+   */
+  uint32_t                  register2;
+} CANFilter;
+
+/**
+ * @brief   Type of a simulated transmit mailbox.
+ */
+typedef struct {
+  /**
+   * @brief   Mailbox state.
+   */
+  uint32_t                  state;
+  /**
+   * @brief   Frame being transmitted.
+   */
+  CANTxFrame                frame;
+} sim_can_mailbox_t;
+
+/**
+ * @brief   Type of a simulated receive mailbox.
+ */
+typedef struct {
+  /**
+   * @brief   Index of the oldest frame.
+   */
+  uint32_t                  head;
+  /**
+   * @brief   Number of frames.
+   */
+  uint32_t                  count;
+  /**
+   * @brief   Frames buffer.
+   */
+  CANRxFrame                frames[SIM_CAN_RX_FIFO_SIZE];
+} sim_can_fifo_t;
+
+/**
+ * @brief   Driver configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Bit rate in bits per second, zero for instantaneous frames.
+   * @note    The bus time of a frame is computed on the transmitter bit
+   *          rate, the instances on a bus should use the same value.
+   */
+  uint32_t                  bitrate;
+  /**
+   * @brief   Bus socket path, @p NULL for @p SIM_CAN_PATH.
+   */
+  const char                *path;
+} CANConfig;
+
+/**
+ * @brief   Structure representing an CAN driver.
+ */
+struct CANDriver {
+  /**
+   * @brief   Driver state.
+   */
+  canstate_t                state;
+  /**
+   * @brief   Current configuration data.
+   */
+  const CANConfig           *config;
+  /**
+   * @brief   Transmission threads queue.
+   */
+  threads_queue_t           txqueue;
+  /**
+   * @brief   Receive threads queue.
+   */
+  threads_queue_t           rxqueue;
+#if (CAN_ENFORCE_USE_CALLBACKS == FALSE) || defined(__DOXYGEN__)
+  /**
+   * @brief   One or more frames become available.
+   * @note    After broadcasting this event it will not be broadcasted again
+   *          until the received frames queue has been completely emptied. It
+   *          is <b>not</b> broadcasted for each received frame. It is
+   *          responsibility of the application to empty the queue by
+   *          repeatedly invoking @p canReceive() when listening to this event.
+   *          This behavior minimizes the interrupt served by the system
+   *          because CAN traffic.
+   * @note    The flags associated to the listeners will indicate which
+   *          receive mailboxes become non-empty.
+   */
+  event_source_t            rxfull_event;
+  /**
+   * @brief   One or more transmission mailbox become available.
+   * @note    The flags associated to the listeners will indicate which
+   *          transmit mailboxes become empty.
+   */
+  event_source_t            txempty_event;
+  /**
+   * @brief   A CAN bus error happened.
+   * @note    The flags associated to the listeners will indicate that
+   *          receive error(s) have occurred.
+   */
+  event_source_t            error_event;
+#if CAN_USE_SLEEP_MODE || defined (__DOXYGEN__)
+  /**
+   * @brief   Entering sleep state event.
+   */
+  event_source_t            sleep_event;
+  /**
+   * @brief   Exiting sleep state event.
+   */
+  event_source_t            wakeup_event;
+#endif /* CAN_USE_SLEEP_MODE */
+#else /* CAN_ENFORCE_USE_CALLBACKS == TRUE */
+  /**
+   * @brief   One or more frames become available.
+   * @note    After calling this function it will not be called again
+   *          until the received frames queue has been completely emptied. It
+   *          is <b>not</b> called for each received frame. It is
+   *          responsibility of the application to empty the queue by
+   *          repeatedly invoking @p chTryReceiveI().
+   *          This behavior minimizes the interrupt served by the system
+   *          because CAN traffic.
+   */
+  can_callback_t            rxfull_cb;
+  /**
+   * @brief   One or more transmission mailbox become available.
+   * @note    The flags associated to the callback will indicate which
+   *          transmit mailboxes become empty.
+   */
+  can_callback_t            txempty_cb;
+  /**
+   * @brief   A CAN bus error happened.
+   */
+  can_callback_t            error_cb;
+#if (CAN_USE_SLEEP_MODE == TRUE) || defined (__DOXYGEN__)
+  /**
+   * @brief   Exiting sleep state.
+   */
+  can_callback_t            wakeup_cb;
+#endif
+#endif
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Node socket, connected to the bus socket.
+   */
+  int                       fd;
+  /**
+   * @brief   Node socket address.
+   */
+  struct sockaddr_un        local;
+  /**
+   * @brief   Bus socket address.
+   */
+  struct sockaddr_un        bus;
+  /**
+   * @brief   Messages waiting for the socket to become writable.
+   */
+  bool                      txwait;
+  /**
+   * @brief   Time of the next presence message to the bus.
+   */
+  uint64_t                  heartbeat;
+  /**
+   * @brief   Transmit mailboxes.
+   */
+  sim_can_mailbox_t         tx[CAN_TX_MAILBOXES];
+  /**
+   * @brief   Receive mailboxes.
+   */
+  sim_can_fifo_t            rx[CAN_RX_MAILBOXES];
+  /**
+   * @brief   Number of active filters, zero for receiving all frames
+   *          in the first receive mailbox.
+   */
+  uint32_t                  num_filters;
+  /**
+   * @brief   Receive filters.
+   */
+  CANFilter                 filters[SIM_CAN_MAX_FILTERS];
+  /**
+   * @brief   Transmitted frames.
+   */
+  uint32_t                  txframes;
+  /**
+   * @brief   Received frames, filtered frames excluded.
+   */
+  uint32_t                  rxframes;
+  /**
+   * @brief   Frames lost because a receive mailbox was full.
+   */
+  uint32_t                  rxoverflows;
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if !defined(__DOXYGEN__)
+extern CANDriver CAND1;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void can_lld_init(void);
+  void can_lld_start(CANDriver *canp);
+  void can_lld_stop(CANDriver *canp);
+  bool can_lld_is_tx_empty(CANDriver *canp, canmbx_t mailbox);
+  void can_lld_transmit(CANDriver *canp,
+                        canmbx_t mailbox,
+                        const CANTxFrame *crfp);
+  bool can_lld_is_rx_nonempty(CANDriver *canp, canmbx_t mailbox);
+  void can_lld_receive(CANDriver *canp,
+                       canmbx_t mailbox,
+                       CANRxFrame *ctfp);
+  void can_lld_abort(CANDriver *canp,
+                     canmbx_t mailbox);
+#if CAN_USE_SLEEP_MODE
+  void can_lld_sleep(CANDriver *canp);
+  void can_lld_wakeup(CANDriver *canp);
+#endif /* CAN_USE_SLEEP_MODE */
+  void canSimSetFilters(CANDriver *canp, uint32_t num, const CANFilter *cfp);
+  bool can_lld_interrupt_pending(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_CAN == TRUE */
+
+#endif /* HAL_CAN_LLD_H */
+
+/** @} */
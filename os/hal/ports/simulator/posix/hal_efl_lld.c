@@ -0,0 +1,522 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/posix/hal_efl_lld.c
+ * @brief   Posix simulator Embedded Flash subsystem low level driver source.
+ * @details The flash array is a file mapped in memory, the device behaves
+ *          like a NOR flash: erasing sets all bits to one, programming can
+ *          only clear bits.
+ *
+ * @addtogroup POSIX_EFL
+ * @{
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hal.h"
+
+#if (HAL_USE_EFL == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Erased byte value.
+ */
+#define SIM_EFL_ERASED                      0xFFU
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   EFL1 driver identifier.
+ */
+EFlashDriver EFLD1;
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Driver default configuration.
+ */
+static const EFlashConfig default_config = {
+  .path             = SIM_EFL_PATH,
+  .sectors_count    = SIM_EFL_SECTORS_COUNT,
+  .sector_size      = SIM_EFL_SECTOR_SIZE,
+  .page_size        = SIM_EFL_PAGE_SIZE,
+  .erase_time       = SIM_EFL_ERASE_TIME_US,
+  .program_time     = SIM_EFL_PROGRAM_TIME_US,
+  .powercut         = NULL
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Invokes the power cut hook.
+ *
+ * @param[in] eflp      pointer to a @p EFlashDriver structure
+ * @param[in] offset    offset of the operation
+ * @param[in] n         size of the operation
+ * @return              The number of bytes to be actually processed.
+ */
+static size_t sim_efl_powercut(EFlashDriver *eflp,
+                               flash_offset_t offset, size_t n) {
+  size_t done;
+
+  if (eflp->config->powercut == NULL) {
+    return n;
+  }
+
+  done = eflp->config->powercut(eflp, offset, n);
+  if (done < n) {
+    eflp->powerlost = true;
+    return done;
+  }
+
+  return n;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level Embedded Flash driver initialization.
+ *
+ * @notapi
+ */
+void efl_lld_init(void) {
+
+  /* Driver initialization.*/
+  eflObjectInit(&EFLD1);
+  EFLD1.fd    = -1;
+  EFLD1.array = NULL;
+}
+
+/**
+ * @brief   Configures and activates the Embedded Flash peripheral.
+ * @details The backing file is created or extended as needed, the added
+ *          space is erased. A restart also restores the power after a
+ *          simulated power cut.
+ *
+ * @param[in] eflp      pointer to a @p EFlashDriver structure
+ *
+ * @notapi
+ */
+void efl_lld_start(EFlashDriver *eflp) {
+  const EFlashConfig *config;
+  size_t size;
+
+  if (eflp->config == NULL) {
+    eflp->config = &default_config;
+  }
+  config = eflp->config;
+
+  osalDbgCheck((config->sectors_count > 0U) && (config->sector_size > 0U) &&
+               (config->page_size > 0U) &&
+               ((config->sector_size % config->page_size) == 0U));
+
+  if (eflp->state == FLASH_STOP) {
+    size = (size_t)config->sectors_count * (size_t)config->sector_size;
+
+    if (config->path != NULL) {
+      struct stat st;
+
+      eflp->fd = open(config->path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+      if ((eflp->fd < 0) || (fstat(eflp->fd, &st) < 0)) {
+        printf("%s: Error opening flash file\n", config->path);
+        exit(1);
+      }
+      if ((size_t)st.st_size < size) {
+        if (ftruncate(eflp->fd, (off_t)size) < 0) {
+          printf("%s: Error resizing flash file\n", config->path);
+          exit(1);
+        }
+      }
+      eflp->array = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         eflp->fd, 0);
+      if (eflp->array == MAP_FAILED) {
+        printf("%s: Error mapping flash file\n", config->path);
+        exit(1);
+      }
+
+      /* The added space is erased.*/
+      if ((size_t)st.st_size < size) {
+        memset(eflp->array + st.st_size, SIM_EFL_ERASED,
+               size - (size_t)st.st_size);
+      }
+    }
+    else {
+      eflp->array = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (eflp->array == MAP_FAILED) {
+        printf("Error allocating flash array\n");
+        exit(1);
+      }
+      memset(eflp->array, SIM_EFL_ERASED, size);
+    }
+
+    eflp->descriptor.attributes    = FLASH_ATTR_ERASED_IS_ONE |
+                                     FLASH_ATTR_MEMORY_MAPPED |
+                                     FLASH_ATTR_REWRITABLE;
+    eflp->descriptor.page_size     = config->page_size;
+    eflp->descriptor.sectors_count = config->sectors_count;
+    eflp->descriptor.sectors       = NULL;
+    eflp->descriptor.sectors_size  = config->sector_size;
+    eflp->descriptor.address       = eflp->array;
+    eflp->descriptor.size          = (uint32_t)size;
+  }
+
+  eflp->powerlost = false;
+}
+
+/**
+ * @brief   Deactivates the Embedded Flash peripheral.
+ *
+ * @param[in] eflp      pointer to a @p EFlashDriver structure
+ *
+ * @notapi
+ */
+void efl_lld_stop(EFlashDriver *eflp) {
+
+  if (eflp->state == FLASH_READY) {
+    (void) munmap(eflp->array, (size_t)eflp->descriptor.size);
+    eflp->array = NULL;
+    if (eflp->fd >= 0) {
+      (void) close(eflp->fd);
+      eflp->fd = -1;
+    }
+  }
+}
+
+/**
+ * @brief   Gets the flash descriptor structure.
+ *
+ * @param[in] ip                    pointer to a @p EFlashDriver instance
+ * @return                          A flash device descriptor.
+ *
+ * @notapi
+ */
+const flash_descriptor_t *efl_lld_get_descriptor(void *instance) {
+  EFlashDriver *devp = (EFlashDriver *)instance;
+
+  return &devp->descriptor;
+}
+
+/**
+ * @brief   Read operation.
+ *
+ * @param[in] ip                    pointer to a @p EFlashDriver instance
+ * @param[in] offset                flash offset
+ * @param[in] n                     number of bytes to be read
+ * @param[out] rp                   pointer to the data buffer
+ * @return                          An error code.
+ * @retval FLASH_NO_ERROR           if there is no erase operation in progress.
+ * @retval FLASH_BUSY_ERASING       if there is an erase operation in progress.
+ * @retval FLASH_ERROR_HW_FAILURE   if the power has been cut.
+ *
+ * @notapi
+ */
+flash_error_t efl_lld_read(void *instance, flash_offset_t offset,
+                           size_t n, uint8_t *rp) {
+  EFlashDriver *devp = (EFlashDriver *)instance;
+
+  osalDbgCheck((instance != NULL) && (rp != NULL) && (n > 0U));
+  osalDbgCheck((size_t)offset + n <= (size_t)devp->descriptor.size);
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE),
+                "invalid state");
+
+  if (devp->powerlost) {
+    return FLASH_ERROR_HW_FAILURE;
+  }
+
+  /* No reading while erasing.*/
+  if (devp->state == FLASH_ERASE) {
+    return FLASH_BUSY_ERASING;
+  }
+
+  memcpy((void *)rp, (const void *)(devp->array + offset), n);
+
+  return FLASH_NO_ERROR;
+}
+
+/**
+ * @brief   Program operation.
+ * @note    Programming can only clear bits, each page takes the configured
+ *          program time.
+ *
+ * @param[in] ip                    pointer to a @p EFlashDriver instance
+ * @param[in] offset                flash offset
+ * @param[in] n                     number of bytes to be programmed
+ * @param[in] pp                    pointer to the data buffer
+ * @return                          An error code.
+ * @retval FLASH_NO_ERROR           if there is no erase operation in progress.
+ * @retval FLASH_BUSY_ERASING       if there is an erase operation in progress.
+ * @retval FLASH_ERROR_HW_FAILURE   if the power has been cut.
+ *
+ * @notapi
+ */
+flash_error_t efl_lld_program(void *instance, flash_offset_t offset,
+                              size_t n, const uint8_t *pp) {
+  EFlashDriver *devp = (EFlashDriver *)instance;
+  uint32_t page_size = devp->descriptor.page_size;
+
+  osalDbgCheck((instance != NULL) && (pp != NULL) && (n > 0U));
+  osalDbgCheck((size_t)offset + n <= (size_t)devp->descriptor.size);
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE),
+                "invalid state");
+
+  if (devp->powerlost) {
+    return FLASH_ERROR_HW_FAILURE;
+  }
+
+  /* No programming while erasing.*/
+  if (devp->state == FLASH_ERASE) {
+    return FLASH_BUSY_ERASING;
+  }
+
+  /* FLASH_PGM state while the operation is performed.*/
+  devp->state = FLASH_PGM;
+
+  /* Programming page by page.*/
+  while (n > 0U) {
+    size_t chunk, done, i;
+
+    chunk = page_size - (offset % page_size);
+    if (chunk > n) {
+      chunk = n;
+    }
+
+    done = sim_efl_powercut(devp, offset, chunk);
+    for (i = 0U; i < done; i++) {
+      devp->array[offset + i] &= pp[i];
+    }
+    if (devp->powerlost) {
+      break;
+    }
+
+    _sim_busy_wait((uint64_t)devp->config->program_time * 1000U);
+
+    offset += (flash_offset_t)chunk;
+    pp     += chunk;
+    n      -= chunk;
+  }
+
+  /* Ready state again.*/
+  devp->state = FLASH_READY;
+
+  return devp->powerlost ? FLASH_ERROR_HW_FAILURE : FLASH_NO_ERROR;
+}
+
+/**
+ * @brief   Starts a whole-device erase operation.
+ *
+ * @param[in] ip                    pointer to a @p EFlashDriver instance
+ * @return                          An error code.
+ * @retval FLASH_NO_ERROR           if there is no erase operation in progress.
+ * @retval FLASH_BUSY_ERASING       if there is an erase operation in progress.
+ * @retval FLASH_ERROR_HW_FAILURE   if the power has been cut.
+ *
+ * @notapi
+ */
+flash_error_t efl_lld_start_erase_all(void *instance) {
+  EFlashDriver *devp = (EFlashDriver *)instance;
+  size_t done;
+
+  osalDbgCheck(instance != NULL);
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE),
+                "invalid state");
+
+  if (devp->powerlost) {
+    return FLASH_ERROR_HW_FAILURE;
+  }
+
+  /* No erasing while erasing.*/
+  if (devp->state == FLASH_ERASE) {
+    return FLASH_BUSY_ERASING;
+  }
+
+  /* FLASH_ERASE state while the operation is performed.*/
+  devp->state = FLASH_ERASE;
+
+  /* The array is erased immediately, the device cannot be accessed until
+     the erase time has elapsed.*/
+  done = sim_efl_powercut(devp, 0U, (size_t)devp->descriptor.size);
+  memset(devp->array, SIM_EFL_ERASED, done);
+  if (devp->powerlost) {
+    devp->state = FLASH_READY;
+    return FLASH_ERROR_HW_FAILURE;
+  }
+  devp->erase_end = _sim_get_time_ns() +
+                    ((uint64_t)devp->config->erase_time *
+                     (uint64_t)devp->descriptor.sectors_count * 1000U);
+
+  return FLASH_NO_ERROR;
+}
+
+/**
+ * @brief   Starts an sector erase operation.
+ *
+ * @param[in] ip                    pointer to a @p EFlashDriver instance
+ * @param[in] sector                sector to be erased
+ * @return                          An error code.
+ * @retval FLASH_NO_ERROR           if there is no erase operation in progress.
+ * @retval FLASH_BUSY_ERASING       if there is an erase operation in progress.
+ * @retval FLASH_ERROR_HW_FAILURE   if the power has been cut.
+ *
+ * @notapi
+ */
+flash_error_t efl_lld_start_erase_sector(void *instance,
+                                         flash_sector_t sector) {
+  EFlashDriver *devp = (EFlashDriver *)instance;
+  flash_offset_t offset;
+  size_t done;
+
+  osalDbgCheck(instance != NULL);
+  osalDbgCheck(sector < devp->descriptor.sectors_count);
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE),
+                "invalid state");
+
+  if (devp->powerlost) {
+    return FLASH_ERROR_HW_FAILURE;
+  }
+
+  /* No erasing while erasing.*/
+  if (devp->state == FLASH_ERASE) {
+    return FLASH_BUSY_ERASING;
+  }
+
+  /* FLASH_ERASE state while the operation is performed.*/
+  devp->state = FLASH_ERASE;
+
+  /* The sector is erased immediately, the device cannot be accessed until
+     the erase time has elapsed.*/
+  offset = sector * devp->descriptor.sectors_size;
+  done   = sim_efl_powercut(devp, offset,
+                            (size_t)devp->descriptor.sectors_size);
+  memset(devp->array + offset, SIM_EFL_ERASED, done);
+  if (devp->powerlost) {
+    devp->state = FLASH_READY;
+    return FLASH_ERROR_HW_FAILURE;
+  }
+  devp->erase_end = _sim_get_time_ns() +
+                    ((uint64_t)devp->config->erase_time * 1000U);
+
+  return FLASH_NO_ERROR;
+}
+
+/**
+ * @brief   Queries the driver for erase operation progress.
+ *
+ * @param[in] ip                    pointer to a @p EFlashDriver instance
+ * @param[out] msec                 recommended time, in milliseconds, that
+ *                                  should be spent before calling this
+ *                                  function again, can be @p NULL
+ * @return                          An error code.
+ * @retval FLASH_NO_ERROR           if there is no erase operation in progress.
+ * @retval FLASH_BUSY_ERASING       if there is an erase operation in progress.
+ * @retval FLASH_ERROR_HW_FAILURE   if the power has been cut.
+ *
+ * @api
+ */
+flash_error_t efl_lld_query_erase(void *instance, uint32_t *msec) {
+  EFlashDriver *devp = (EFlashDriver *)instance;
+  uint64_t now;
+
+  if (devp->powerlost) {
+    return FLASH_ERROR_HW_FAILURE;
+  }
+
+  /* If there is an erase in progress then the time must be checked.*/
+  if (devp->state == FLASH_ERASE) {
+    now = _sim_get_time_ns();
+    if (now < devp->erase_end) {
+
+      /* Recommended time before polling again, the remaining time rounded
+         up.*/
+      if (msec != NULL) {
+        *msec = (uint32_t)((devp->erase_end - now + 999999U) / 1000000U);
+      }
+
+      return FLASH_BUSY_ERASING;
+    }
+
+    /* Back to ready state.*/
+    devp->state = FLASH_READY;
+  }
+
+  return FLASH_NO_ERROR;
+}
+
+/**
+ * @brief   Returns the erase state of a sector.
+ *
+ * @param[in] ip                    pointer to a @p EFlashDriver instance
+ * @param[in] sector                sector to be verified
+ * @return                          An error code.
+ * @retval FLASH_NO_ERROR           if the sector is erased.
+ * @retval FLASH_BUSY_ERASING       if there is an erase operation in progress.
+ * @retval FLASH_ERROR_VERIFY       if the verify operation failed.
+ * @retval FLASH_ERROR_HW_FAILURE   if the power has been cut.
+ *
+ * @notapi
+ */
+flash_error_t efl_lld_verify_erase(void *instance, flash_sector_t sector) {
+  EFlashDriver *devp = (EFlashDriver *)instance;
+  const uint8_t *p;
+  uint32_t i;
+
+  osalDbgCheck(instance != NULL);
+  osalDbgCheck(sector < devp->descriptor.sectors_count);
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE),
+                "invalid state");
+
+  if (devp->powerlost) {
+    return FLASH_ERROR_HW_FAILURE;
+  }
+
+  /* No verifying while erasing.*/
+  if (devp->state == FLASH_ERASE) {
+    return FLASH_BUSY_ERASING;
+  }
+
+  /* Scanning the sector space.*/
+  p = devp->array + (sector * devp->descriptor.sectors_size);
+  for (i = 0U; i < devp->descriptor.sectors_size; i++) {
+    if (p[i] != SIM_EFL_ERASED) {
+      return FLASH_ERROR_VERIFY;
+    }
+  }
+
+  return FLASH_NO_ERROR;
+}
+
+#endif /* HAL_USE_EFL == TRUE */
+
+/** @} */
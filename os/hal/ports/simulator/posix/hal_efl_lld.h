@@ -0,0 +1,187 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/posix/hal_efl_lld.h
+ * @brief   Posix simulator Embedded Flash subsystem low level driver header.
+ *
+ * @addtogroup POSIX_EFL
+ * @{
+ */
+
+#ifndef HAL_EFL_LLD_H
+#define HAL_EFL_LLD_H
+
+#if (HAL_USE_EFL == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Posix simulator configuration options
+ * @details These settings are used when @p eflStart() is invoked with a
+ *          @p NULL configuration.
+ * @{
+ */
+/**
+ * @brief   Default backing file path.
+ * @details The file is created erased if it does not exist, its content
+ *          survives the simulator restarts.
+ */
+#if !defined(SIM_EFL_PATH) || defined(__DOXYGEN__)
+#define SIM_EFL_PATH                        "/tmp/chibios_efl1.bin"
+#endif
+
+/**
+ * @brief   Default number of sectors.
+ */
+#if !defined(SIM_EFL_SECTORS_COUNT) || defined(__DOXYGEN__)
+#define SIM_EFL_SECTORS_COUNT               64U
+#endif
+
+/**
+ * @brief   Default sector size.
+ */
+#if !defined(SIM_EFL_SECTOR_SIZE) || defined(__DOXYGEN__)
+#define SIM_EFL_SECTOR_SIZE                 4096U
+#endif
+
+/**
+ * @brief   Default program page size.
+ */
+#if !defined(SIM_EFL_PAGE_SIZE) || defined(__DOXYGEN__)
+#define SIM_EFL_PAGE_SIZE                   256U
+#endif
+
+/**
+ * @brief   Default sector erase time in microseconds.
+ */
+#if !defined(SIM_EFL_ERASE_TIME_US) || defined(__DOXYGEN__)
+#define SIM_EFL_ERASE_TIME_US               0U
+#endif
+
+/**
+ * @brief   Default page program time in microseconds.
+ */
+#if !defined(SIM_EFL_PROGRAM_TIME_US) || defined(__DOXYGEN__)
+#define SIM_EFL_PROGRAM_TIME_US             0U
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if defined(WIN32)
+#error "the simulated flash is not supported on Win32"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Power cut injection callback type.
+ * @details The callback is invoked before each page program and sector
+ *          erase, it returns the number of bytes of the operation which
+ *          are completed before the power is lost. Returning @p n lets the
+ *          operation complete normally.
+ *
+ * @param[in] eflp      pointer to the @p EFlashDriver object
+ * @param[in] offset    offset of the operation
+ * @param[in] n         size of the operation
+ * @return              The number of bytes actually written or erased.
+ */
+typedef size_t (*eflpowercut_t)(EFlashDriver *eflp,
+                                flash_offset_t offset,
+                                size_t n);
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level fields of the embedded flash driver structure.
+ */
+#define efl_lld_driver_fields                                               \
+  /* Device descriptor, the geometry comes from the configuration.*/        \
+  flash_descriptor_t        descriptor;                                     \
+  /* Backing file descriptor, -1 for an anonymous mapping.*/                \
+  int                       fd;                                             \
+  /* Mapped flash array.*/                                                  \
+  uint8_t                   *array;                                         \
+  /* Erase operation in progress deadline.*/                                \
+  uint64_t                  erase_end;                                      \
+  /* Power has been cut, the device is unusable until restarted.*/          \
+  bool                      powerlost
+
+/**
+ * @brief   Low level fields of the embedded flash configuration structure.
+ */
+#define efl_lld_config_fields                                               \
+  /* Backing file path, NULL for a volatile flash array.*/                  \
+  const char                *path;                                          \
+  /* Number of sectors.*/                                                   \
+  flash_sector_t            sectors_count;                                  \
+  /* Size of each sector.*/                                                 \
+  uint32_t                  sector_size;                                    \
+  /* Program page size, programs do not cross page boundaries.*/            \
+  uint32_t                  page_size;                                      \
+  /* Sector erase time in microseconds.*/                                   \
+  uint32_t                  erase_time;                                     \
+  /* Page program time in microseconds.*/                                   \
+  uint32_t                  program_time;                                   \
+  /* Power cut injection callback, can be NULL.*/                           \
+  eflpowercut_t             powercut
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if !defined(__DOXYGEN__)
+extern EFlashDriver EFLD1;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void efl_lld_init(void);
+  void efl_lld_start(EFlashDriver *eflp);
+  void efl_lld_stop(EFlashDriver *eflp);
+  const flash_descriptor_t *efl_lld_get_descriptor(void *instance);
+  flash_error_t efl_lld_read(void *instance, flash_offset_t offset,
+                             size_t n, uint8_t *rp);
+  flash_error_t efl_lld_program(void *instance, flash_offset_t offset,
+                                size_t n, const uint8_t *pp);
+  flash_error_t efl_lld_start_erase_all(void *instance);
+  flash_error_t efl_lld_start_erase_sector(void *instance,
+                                           flash_sector_t sector);
+  flash_error_t efl_lld_query_erase(void *instance, uint32_t *msec);
+  flash_error_t efl_lld_verify_erase(void *instance, flash_sector_t sector);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_EFL == TRUE */
+
+#endif /* HAL_EFL_LLD_H */
+
+/** @} */
@@ -0,0 +1,299 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/posix/hal_i2c_lld.c
+ * @brief   Posix simulator I2C subsystem low level driver source.
+ * @details The bus transfers are routed to the device model matching the
+ *          slave address among the models listed in the configuration.
+ *          The data is exchanged with the model when an operation starts,
+ *          the calling thread is then suspended for the time the bytes
+ *          would take on the bus at the configured clock.
+ *
+ * @addtogroup POSIX_I2C
+ * @{
+ */
+
+#include "hal.h"
+
+#if (HAL_USE_I2C == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   I2C1 driver identifier.
+ */
+I2CDriver I2CD1;
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the device model answering to an address.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] addr      slave device address
+ * @return              The device model or @p NULL if there is none.
+ */
+static const sim_i2c_device_t *i2c_sim_find(I2CDriver *i2cp,
+                                            i2caddr_t addr) {
+  const sim_i2c_device_t * const *devpp = i2cp->config->devices;
+
+  if (devpp != NULL) {
+    while (*devpp != NULL) {
+      if ((*devpp)->addr == addr) {
+        return *devpp;
+      }
+      devpp++;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Performs a transfer.
+ * @details The data is exchanged immediately, the completion is notified
+ *          after the bus time. Each byte takes 9 clock cycles, start and
+ *          stop conditions one cycle each.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] addr      slave device address
+ * @param[in] txbuf     pointer to the transmit buffer
+ * @param[in] txbytes   number of bytes to be transmitted
+ * @param[out] rxbuf    pointer to the receive buffer
+ * @param[in] rxbytes   number of bytes to be received
+ */
+static void i2c_sim_transfer(I2CDriver *i2cp, i2caddr_t addr,
+                             const uint8_t *txbuf, size_t txbytes,
+                             uint8_t *rxbuf, size_t rxbytes) {
+  const sim_i2c_device_t *devp = i2c_sim_find(i2cp, addr);
+  uint32_t bytes = 0U;
+  uint32_t conditions = 2U;
+  size_t i;
+
+  if (devp == NULL) {
+    /* Nobody acknowledging the address.*/
+    i2cp->errors |= I2C_ACK_FAILURE;
+    bytes = 1U;
+  }
+  else {
+    if (txbytes > 0U) {
+      if (devp->start != NULL) {
+        devp->start(devp->instance, false);
+      }
+      bytes++;
+      for (i = 0U; i < txbytes; i++) {
+        bytes++;
+        if (!devp->write(devp->instance, txbuf[i])) {
+          i2cp->errors |= I2C_ACK_FAILURE;
+          break;
+        }
+      }
+    }
+    if ((rxbytes > 0U) && (i2cp->errors == I2C_NO_ERROR)) {
+      if (devp->start != NULL) {
+        devp->start(devp->instance, true);
+      }
+      if (txbytes > 0U) {
+        conditions++;
+      }
+      bytes++;
+      for (i = 0U; i < rxbytes; i++) {
+        bytes++;
+        rxbuf[i] = devp->read(devp->instance);
+      }
+    }
+    if (devp->stop != NULL) {
+      devp->stop(devp->instance);
+    }
+  }
+
+  i2cp->bytes   += bytes;
+  i2cp->deadline = _sim_get_time_ns();
+  if (i2cp->config->clock > 0U) {
+    i2cp->deadline += (((uint64_t)bytes * 9U + conditions) * 1000000000U) /
+                      i2cp->config->clock;
+  }
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Simulated I2C interrupt.
+ *
+ * @return              @p true if an interrupt has been served.
+ *
+ * @notapi
+ */
+bool i2c_lld_interrupt_pending(void) {
+
+  /* No waiting thread means no operation or an operation timed out.*/
+  if (I2CD1.thread == NULL) {
+    return false;
+  }
+
+  if (_sim_get_time_ns() < I2CD1.deadline) {
+    _sim_set_wakeup(I2CD1.deadline);
+    return false;
+  }
+
+  OSAL_IRQ_PROLOGUE();
+
+  if (I2CD1.errors != I2C_NO_ERROR) {
+    _i2c_wakeup_error_isr(&I2CD1);
+  }
+  else {
+    _i2c_wakeup_isr(&I2CD1);
+  }
+
+  OSAL_IRQ_EPILOGUE();
+
+  return true;
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level I2C driver initialization.
+ *
+ * @notapi
+ */
+void i2c_lld_init(void) {
+
+  i2cObjectInit(&I2CD1);
+  I2CD1.thread = NULL;
+}
+
+/**
+ * @brief   Configures and activates the I2C peripheral.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ *
+ * @notapi
+ */
+void i2c_lld_start(I2CDriver *i2cp) {
+
+  if (i2cp->state == I2C_STOP) {
+    i2cp->bytes = 0U;
+  }
+}
+
+/**
+ * @brief   Deactivates the I2C peripheral.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ *
+ * @notapi
+ */
+void i2c_lld_stop(I2CDriver *i2cp) {
+
+  (void)i2cp;
+}
+
+/**
+ * @brief   Deactivates the I2C peripheral leaving it enabled.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ *
+ * @notapi
+ */
+void i2c_lld_soft_stop(I2CDriver *i2cp) {
+
+  (void)i2cp;
+}
+
+/**
+ * @brief   Receives data via the I2C bus as master.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] addr      slave device address
+ * @param[out] rxbuf    pointer to the receive buffer
+ * @param[in] rxbytes   number of bytes to be received
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if the function succeeded.
+ * @retval MSG_RESET    if one or more I2C errors occurred, the errors can
+ *                      be retrieved using @p i2cGetErrors().
+ * @retval MSG_TIMEOUT  if a timeout occurred before operation end. <b>After a
+ *                      timeout the driver must be stopped and restarted
+ *                      because the bus is in an uncertain state</b>.
+ *
+ * @notapi
+ */
+msg_t i2c_lld_master_receive_timeout(I2CDriver *i2cp, i2caddr_t addr,
+                                     uint8_t *rxbuf, size_t rxbytes,
+                                     sysinterval_t timeout) {
+
+  i2c_sim_transfer(i2cp, addr, NULL, 0U, rxbuf, rxbytes);
+
+  return osalThreadSuspendTimeoutS(&i2cp->thread, timeout);
+}
+
+/**
+ * @brief   Transmits data via the I2C bus as master.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] addr      slave device address
+ * @param[in] txbuf     pointer to the transmit buffer
+ * @param[in] txbytes   number of bytes to be transmitted
+ * @param[out] rxbuf    pointer to the receive buffer
+ * @param[in] rxbytes   number of bytes to be received
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if the function succeeded.
+ * @retval MSG_RESET    if one or more I2C errors occurred, the errors can
+ *                      be retrieved using @p i2cGetErrors().
+ * @retval MSG_TIMEOUT  if a timeout occurred before operation end. <b>After a
+ *                      timeout the driver must be stopped and restarted
+ *                      because the bus is in an uncertain state</b>.
+ *
+ * @notapi
+ */
+msg_t i2c_lld_master_transmit_timeout(I2CDriver *i2cp, i2caddr_t addr,
+                                      const uint8_t *txbuf, size_t txbytes,
+                                      uint8_t *rxbuf, size_t rxbytes,
+                                      sysinterval_t timeout) {
+
+  i2c_sim_transfer(i2cp, addr, txbuf, txbytes, rxbuf, rxbytes);
+
+  return osalThreadSuspendTimeoutS(&i2cp->thread, timeout);
+}
+
+#endif /* HAL_USE_I2C == TRUE */
+
+/** @} */
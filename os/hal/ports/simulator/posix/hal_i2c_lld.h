@@ -0,0 +1,196 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/posix/hal_i2c_lld.h
+ * @brief   Posix simulator I2C subsystem low level driver header.
+ *
+ * @addtogroup POSIX_I2C
+ * @{
+ */
+
+#ifndef HAL_I2C_LLD_H
+#define HAL_I2C_LLD_H
+
+#if (HAL_USE_I2C == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type representing an I2C address.
+ */
+typedef uint16_t i2caddr_t;
+
+/**
+ * @brief   Type of I2C Driver condition flags.
+ */
+typedef uint32_t i2cflags_t;
+
+/**
+ * @brief   Type of a simulated I2C device model.
+ * @details The model sees the bus one byte at a time, each transfer
+ *          addressing it starts with a start condition and ends with a
+ *          stop condition, a transmit-then-receive operation uses a
+ *          repeated start.
+ * @note    The callbacks are invoked from within the driver functions,
+ *          they must not use blocking APIs.
+ */
+typedef struct {
+  /**
+   * @brief   Device address, 7 bits.
+   */
+  i2caddr_t                 addr;
+  /**
+   * @brief   Start condition callback or @p NULL.
+   * @details Invoked with @p true when the device is addressed for
+   *          reading and with @p false when addressed for writing.
+   */
+  void                      (*start)(void *ip, bool read);
+  /**
+   * @brief   Byte write callback.
+   * @return                @p false for not acknowledging the byte.
+   */
+  bool                      (*write)(void *ip, uint8_t b);
+  /**
+   * @brief   Byte read callback.
+   */
+  uint8_t                   (*read)(void *ip);
+  /**
+   * @brief   Stop condition callback or @p NULL.
+   */
+  void                      (*stop)(void *ip);
+  /**
+   * @brief   Model instance passed to the callbacks.
+   */
+  void                      *instance;
+} sim_i2c_device_t;
+
+/**
+ * @brief   Type of I2C driver configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Bus clock in Hz, zero for instantaneous transfers.
+   */
+  uint32_t                  clock;
+  /**
+   * @brief   Device models on the bus, array terminated by @p NULL.
+   */
+  const sim_i2c_device_t * const *devices;
+} I2CConfig;
+
+/**
+ * @brief   Type of a structure representing an I2C driver.
+ */
+typedef struct I2CDriver I2CDriver;
+
+/**
+ * @brief   Structure representing an I2C driver.
+ */
+struct I2CDriver {
+  /**
+   * @brief   Driver state.
+   */
+  i2cstate_t                state;
+  /**
+   * @brief   Current configuration data.
+   */
+  const I2CConfig           *config;
+  /**
+   * @brief   Error flags.
+   */
+  i2cflags_t                errors;
+#if (I2C_USE_MUTUAL_EXCLUSION == TRUE) || defined(__DOXYGEN__)
+  mutex_t                   mutex;
+#endif
+#if defined(I2C_DRIVER_EXT_FIELDS)
+  I2C_DRIVER_EXT_FIELDS
+#endif
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Thread waiting for I/O completion.
+   */
+  thread_reference_t        thread;
+  /**
+   * @brief   Completion deadline of the current operation.
+   */
+  uint64_t                  deadline;
+  /**
+   * @brief   Bytes transferred since the driver start, addresses
+   *          included.
+   */
+  uint32_t                  bytes;
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Get errors from I2C driver.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ *
+ * @notapi
+ */
+#define i2c_lld_get_errors(i2cp) ((i2cp)->errors)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if !defined(__DOXYGEN__)
+extern I2CDriver I2CD1;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void i2c_lld_init(void);
+  void i2c_lld_start(I2CDriver *i2cp);
+  void i2c_lld_stop(I2CDriver *i2cp);
+  void i2c_lld_soft_stop(I2CDriver *i2cp);
+  msg_t i2c_lld_master_transmit_timeout(I2CDriver *i2cp, i2caddr_t addr,
+                                        const uint8_t *txbuf, size_t txbytes,
+                                        uint8_t *rxbuf, size_t rxbytes,
+                                        sysinterval_t timeout);
+  msg_t i2c_lld_master_receive_timeout(I2CDriver *i2cp, i2caddr_t addr,
+                                       uint8_t *rxbuf, size_t rxbytes,
+                                       sysinterval_t timeout);
+  bool i2c_lld_interrupt_pending(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_I2C == TRUE */
+
+#endif /* HAL_I2C_LLD_H */
+
+/** @} */
@@ -24,10 +24,39 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/time.h>
+#include <time.h>
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#endif
 
 #include "hal.h"
 
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Nanoseconds in one second.
+ */
+#define SIM_NS_PER_SEC      1000000000ULL
+
+/**
+ * @brief   System tick period in nanoseconds.
+ */
+#define SIM_TICK_NS         (SIM_NS_PER_SEC / (uint64_t)OSAL_ST_FREQUENCY)
+
+/**
+ * @brief   Maximum number of events processed on each wake up.
+ */
+#define SIM_MAX_EVENTS      8
+
+/**
+ * @brief   No wake up deadline requested.
+ */
+#define SIM_NO_DEADLINE     0xFFFFFFFFFFFFFFFFULL
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -36,61 +65,312 @@
 /* Driver local variables and types.                                         */
 /*===========================================================================*/
 
-static struct timeval nextcnt;
-static struct timeval tick = {0UL, 1000000UL / OSAL_ST_FREQUENCY};
+#if !SIM_USE_VIRTUAL_TIME || defined(__DOXYGEN__)
+/**
+ * @brief   Host time at system start, origin of the simulated time.
+ */
+static struct timespec sim_base;
+#endif
+
+#if SIM_USE_VIRTUAL_TIME || defined(__DOXYGEN__)
+/**
+ * @brief   Virtual time in nanoseconds.
+ */
+static uint64_t sim_vtime;
+#endif
+
+#if (OSAL_ST_MODE == OSAL_ST_MODE_PERIODIC) || defined(__DOXYGEN__)
+/**
+ * @brief   Next system tick deadline in nanoseconds.
+ */
+static uint64_t sim_tick;
+
+/**
+ * @brief   Earliest time for serving the next system tick.
+ */
+static uint64_t sim_tick_holdoff;
+#endif
+
+#if (OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) || defined(__DOXYGEN__)
+/**
+ * @brief   System timer alarm deadline in nanoseconds.
+ */
+static uint64_t sim_alarm;
+
+/**
+ * @brief   System timer alarm armed flag.
+ */
+static bool sim_alarm_armed;
+#endif
+
+#if ((OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) && !SIM_USE_VIRTUAL_TIME) ||  \
+    defined(__DOXYGEN__)
+/**
+ * @brief   Latest simulated time returned by @p _sim_get_time_ns().
+ */
+static uint64_t sim_last;
+#endif
+
+/**
+ * @brief   Earliest wake up deadline requested by the peripherals.
+ */
+static uint64_t sim_wakeup = SIM_NO_DEADLINE;
+
+#if defined(__linux__) || defined(__DOXYGEN__)
+/**
+ * @brief   Interrupt sources epoll instance.
+ */
+static int sim_epfd = -1;
+
+/**
+ * @brief   System tick timer.
+ */
+static int sim_tickfd = -1;
+
+/**
+ * @brief   Peripherals wake up timer.
+ */
+static int sim_wakefd = -1;
+#endif
+
+#if (defined(__linux__) && !SIM_USE_VIRTUAL_TIME) || defined(__DOXYGEN__)
+/**
+ * @brief   Deadline programmed in the peripherals wake up timer.
+ */
+static uint64_t sim_wakefd_ns = SIM_NO_DEADLINE;
+#endif
 
 /*===========================================================================*/
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
-/*===========================================================================*/
-/* Driver interrupt handlers.                                                */
-/*===========================================================================*/
+#if (defined(__linux__) && !SIM_USE_VIRTUAL_TIME) || defined(__DOXYGEN__)
+/**
+ * @brief   Programs a timer.
+ *
+ * @param[in] fd        the timer descriptor
+ * @param[in] ns        first expiration, in simulated time
+ * @param[in] period    reload period in nanoseconds, zero for one-shot
+ */
+static void sim_timer_set(int fd, uint64_t ns, uint64_t period) {
+  struct itimerspec its;
 
-/*===========================================================================*/
-/* Driver exported functions.                                                */
-/*===========================================================================*/
+  its.it_value.tv_sec     = sim_base.tv_sec + (time_t)(ns / SIM_NS_PER_SEC);
+  its.it_value.tv_nsec    = sim_base.tv_nsec + (long)(ns % SIM_NS_PER_SEC);
+  if (its.it_value.tv_nsec >= (long)SIM_NS_PER_SEC) {
+    its.it_value.tv_nsec -= (long)SIM_NS_PER_SEC;
+    its.it_value.tv_sec++;
+  }
+  its.it_interval.tv_sec  = (time_t)(period / SIM_NS_PER_SEC);
+  its.it_interval.tv_nsec = (long)(period % SIM_NS_PER_SEC);
+  (void) timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+#endif
 
+#if !SIM_USE_VIRTUAL_TIME || defined(__DOXYGEN__)
 /**
- * @brief Low level HAL driver initialization.
+ * @brief   Returns the host time elapsed since the simulated time origin.
+ *
+ * @return              The time in nanoseconds.
  */
-void hal_lld_init(void) {
+static uint64_t sim_get_host_time_ns(void) {
+  struct timespec ts;
 
-#if defined(__APPLE__)
-  puts("ChibiOS/RT simulator (OS X)\n");
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((uint64_t)(ts.tv_sec - sim_base.tv_sec) * SIM_NS_PER_SEC) +
+         (uint64_t)(ts.tv_nsec - sim_base.tv_nsec);
+}
+#endif
+
+#if ((OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) && !SIM_USE_VIRTUAL_TIME) ||  \
+    defined(__DOXYGEN__)
+/**
+ * @brief   Removes host delays from the simulated time.
+ * @details The simulated time origin is moved forward so that the time
+ *          continues from the specified value.
+ *
+ * @param[in] now       the current host time, as returned by
+ *                      @p sim_get_host_time_ns()
+ * @param[in] ns        the new simulated time, not less than the time
+ *                      already returned by @p _sim_get_time_ns()
+ */
+static void sim_skip_time(uint64_t now, uint64_t ns) {
+  uint64_t delay = now - ns;
+
+  sim_base.tv_sec  += (time_t)(delay / SIM_NS_PER_SEC);
+  sim_base.tv_nsec += (long)(delay % SIM_NS_PER_SEC);
+  if (sim_base.tv_nsec >= (long)SIM_NS_PER_SEC) {
+    sim_base.tv_nsec -= (long)SIM_NS_PER_SEC;
+    sim_base.tv_sec++;
+  }
+
+#if defined(__linux__)
+  /* The wake up timer deadline is relative to the old origin.*/
+  sim_wakefd_ns = SIM_NO_DEADLINE;
+#endif
+}
+#endif
+
+#if SIM_USE_VIRTUAL_TIME || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the next system timer or peripherals deadline.
+ *
+ * @param[out] nsp      pointer to the deadline in nanoseconds
+ * @return              @p false if there is no pending deadline.
+ */
+static bool sim_get_deadline(uint64_t *nsp) {
+  uint64_t ns = sim_wakeup;
+
+#if OSAL_ST_MODE == OSAL_ST_MODE_PERIODIC
+  if (sim_tick < ns) {
+    ns = sim_tick;
+  }
+#elif OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING
+  if (sim_alarm_armed && (sim_alarm < ns)) {
+    ns = sim_alarm;
+  }
+#endif
+
+  *nsp = ns;
+  return ns != SIM_NO_DEADLINE;
+}
+#endif /* SIM_USE_VIRTUAL_TIME */
+
+/**
+ * @brief   Waits for events on the registered descriptors.
+ *
+ * @param[in] timeout   @p epoll_wait() timeout in milliseconds, -1 for
+ *                      an infinite wait, 0 for just polling
+ * @return              @p true if an event occurred.
+ */
+static bool sim_wait_events(int timeout) {
+#if defined(__linux__)
+  struct epoll_event ev[SIM_MAX_EVENTS];
+  int i, n;
+
+  n = epoll_wait(sim_epfd, ev, SIM_MAX_EVENTS, timeout);
+  for (i = 0; i < n; i++) {
+    if ((ev[i].data.fd == sim_tickfd) || (ev[i].data.fd == sim_wakefd)) {
+      uint64_t expirations;
+
+      /* Just clearing the timer, the ticks are accounted by time.*/
+      (void) read(ev[i].data.fd, &expirations, sizeof (expirations));
+    }
+  }
+
+  return n > 0;
 #else
-  puts("ChibiOS/RT simulator (Linux)\n");
+  (void)timeout;
+
+  return false;
 #endif
-  gettimeofday(&nextcnt, NULL);
-  timeradd(&nextcnt, &tick, &nextcnt);
 }
 
 /**
- * @brief   Interrupt simulation.
+ * @brief   Serves the pending simulated interrupts.
+ * @details In periodic mode each elapsed tick period generates exactly one
+ *          system tick, in free running mode the system timer interrupt
+ *          is generated once when the alarm deadline is reached.
+ * @note    In tick-less real time mode an alarm served more than half a tick
+ *          period late makes the simulated time skip the excess delay, so
+ *          the counter reads the alarm time when the alarm is served, as
+ *          it would on a real system timer.
+ * @note    Ticks delayed by the host are recovered one at a time, at least
+ *          half a tick period apart. Serving them in a burst would wake up
+ *          threads already past their deadlines and would charge the
+ *          threads profiling counters with time not spent running.
+ * @note    The peripherals wake up deadlines are requested again on each
+ *          check by the peripherals still waiting for them.
+ *
+ * @return              @p true if an interrupt has been served.
  */
-void _sim_check_for_interrupts(void) {
-  struct timeval tv;
+static bool sim_serve_interrupts(void) {
+#if OSAL_ST_MODE != OSAL_ST_MODE_NONE
+  uint64_t now;
+#endif
   bool int_occurred = false;
 
+  sim_wakeup = SIM_NO_DEADLINE;
+
 #if HAL_USE_SERIAL
   if (sd_lld_interrupt_pending()) {
     int_occurred = true;
   }
 #endif
 
-  gettimeofday(&tv, NULL);
-  if (timercmp(&tv, &nextcnt, >=)) {
+#if HAL_USE_MAC
+  if (mac_lld_interrupt_pending()) {
     int_occurred = true;
-    timeradd(&nextcnt, &tick, &nextcnt);
+  }
+#endif
+
+#if HAL_USE_SPI
+  if (spi_lld_interrupt_pending()) {
+    int_occurred = true;
+  }
+#endif
+
+#if HAL_USE_I2C
+  if (i2c_lld_interrupt_pending()) {
+    int_occurred = true;
+  }
+#endif
+
+#if HAL_USE_CAN
+  if (can_lld_interrupt_pending()) {
+    int_occurred = true;
+  }
+#endif
+
+#if OSAL_ST_MODE == OSAL_ST_MODE_PERIODIC
+  now = _sim_get_time_ns();
+  if (now >= sim_tick) {
+    if (now < sim_tick_holdoff) {
+      /* Late tick, too close to the previous one.*/
+      _sim_set_wakeup(sim_tick_holdoff);
+    }
+    else {
+      int_occurred = true;
+      sim_tick += SIM_TICK_NS;
+      sim_tick_holdoff = now + (SIM_TICK_NS / 2U);
+
+      CH_IRQ_PROLOGUE();
+
+      chSysLockFromISR();
+      chSysTimerHandlerI();
+      chSysUnlockFromISR();
+
+      CH_IRQ_EPILOGUE();
+    }
+  }
+#elif OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING
+#if SIM_USE_VIRTUAL_TIME
+  now = _sim_get_time_ns();
+#else
+  now = sim_get_host_time_ns();
+#endif
+  if (sim_alarm_armed && (now >= sim_alarm)) {
+    int_occurred = true;
+
+#if !SIM_USE_VIRTUAL_TIME
+    if (now - sim_alarm > SIM_TICK_NS / 2U) {
+      uint64_t ns = sim_alarm + (SIM_TICK_NS / 2U);
+
+      sim_skip_time(now, ns > sim_last ? ns : sim_last);
+    }
+#endif
+
+    /* One-shot alarm, the handler is expected to program the next one.*/
+    sim_alarm_armed = false;
 
     CH_IRQ_PROLOGUE();
 
-    chSysLockFromISR();
-    chSysTimerHandlerI();
-    chSysUnlockFromISR();
+    st_lld_serve_interrupt();
 
     CH_IRQ_EPILOGUE();
   }
+#endif
 
   if (int_occurred) {
     _dbg_check_lock();
@@ -98,6 +378,250 @@ void _sim_check_for_interrupts(void) {
       chSchDoReschedule();
     _dbg_check_unlock();
   }
+
+  return int_occurred;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief Low level HAL driver initialization.
+ */
+void hal_lld_init(void) {
+
+#if defined(__APPLE__)
+  puts("ChibiOS/RT simulator (OS X)\n");
+#else
+  puts("ChibiOS/RT simulator (Linux)\n");
+#endif
+#if SIM_USE_VIRTUAL_TIME
+  sim_vtime = 0U;
+#else
+  clock_gettime(CLOCK_MONOTONIC, &sim_base);
+#endif
+#if OSAL_ST_MODE == OSAL_ST_MODE_PERIODIC
+  sim_tick         = SIM_TICK_NS;
+  sim_tick_holdoff = 0U;
+#endif
+
+#if defined(__linux__)
+  sim_epfd   = epoll_create1(EPOLL_CLOEXEC);
+  sim_tickfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  sim_wakefd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if ((sim_epfd == -1) || (sim_tickfd == -1) || (sim_wakefd == -1)) {
+    printf("Error creating the interrupt sources\n");
+    exit(1);
+  }
+#if (OSAL_ST_MODE == OSAL_ST_MODE_PERIODIC) && !SIM_USE_VIRTUAL_TIME
+  /* The tick timer expires on the same deadlines used for the ticks
+     accounting, it is only used for waking up the idle thread.*/
+  sim_timer_set(sim_tickfd, sim_tick, SIM_TICK_NS);
+#endif
+  _sim_register_fd(sim_tickfd);
+  _sim_register_fd(sim_wakefd);
+#endif
+}
+
+/**
+ * @brief   Returns the simulated time.
+ * @note    In virtual time mode each call advances the time by one
+ *          nanosecond so that polling loops always make progress.
+ * @note    In tick-less real time mode the time does not include the
+ *          host delays skipped when serving late alarms.
+ *
+ * @return              Nanoseconds elapsed since the HAL initialization.
+ */
+uint64_t _sim_get_time_ns(void) {
+#if SIM_USE_VIRTUAL_TIME
+
+  return sim_vtime++;
+#elif OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING
+
+  sim_last = sim_get_host_time_ns();
+  return sim_last;
+#else
+
+  return sim_get_host_time_ns();
+#endif
+}
+
+#if (OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) || defined(__DOXYGEN__)
+/**
+ * @brief   Programs the one-shot system timer alarm.
+ * @note    A deadline already in the past triggers the alarm on the next
+ *          interrupts check.
+ *
+ * @param[in] ns        the alarm deadline, as returned by
+ *                      @p _sim_get_time_ns()
+ */
+void _sim_set_alarm(uint64_t ns) {
+
+  sim_alarm       = ns;
+  sim_alarm_armed = true;
+
+#if defined(__linux__) && !SIM_USE_VIRTUAL_TIME
+  sim_timer_set(sim_tickfd, ns, 0U);
+#endif
+}
+
+/**
+ * @brief   Disarms the system timer alarm.
+ */
+void _sim_stop_alarm(void) {
+
+  sim_alarm_armed = false;
+
+#if defined(__linux__) && !SIM_USE_VIRTUAL_TIME
+  {
+    struct itimerspec its = {{0, 0}, {0, 0}};
+
+    (void) timerfd_settime(sim_tickfd, 0, &its, NULL);
+  }
+#endif
+}
+#endif /* OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING */
+
+/**
+ * @brief   Requests a wake up at the specified deadline.
+ * @details Used by the peripherals completing an operation after a
+ *          simulated delay, the idle thread does not sleep past the
+ *          earliest requested deadline. In virtual time mode the time
+ *          jumps to the deadline.
+ * @note    Requests are valid until the next interrupts check, a
+ *          peripheral still waiting must request the deadline again from
+ *          its interrupt check hook.
+ *
+ * @param[in] ns        the deadline, as returned by @p _sim_get_time_ns()
+ */
+void _sim_set_wakeup(uint64_t ns) {
+
+  if (ns < sim_wakeup) {
+    sim_wakeup = ns;
+  }
+}
+
+/**
+ * @brief   Registers a file descriptor as an interrupt source.
+ * @details The idle thread is woken up when the descriptor becomes
+ *          readable.
+ * @note    Closed descriptors are automatically removed.
+ *
+ * @param[in] fd        the file descriptor
+ */
+void _sim_register_fd(int fd) {
+#if defined(__linux__)
+  struct epoll_event ev;
+
+  ev.events  = EPOLLIN;
+  ev.data.fd = fd;
+  (void) epoll_ctl(sim_epfd, EPOLL_CTL_ADD, fd, &ev);
+#else
+  (void)fd;
+#endif
+}
+
+/**
+ * @brief   Selects the conditions of a descriptor acting as interrupt
+ *          sources.
+ * @details The idle thread is woken up when the descriptor becomes readable
+ *          and/or writable, the descriptor must have been registered using
+ *          @p _sim_register_fd().
+ *
+ * @param[in] fd        the file descriptor
+ * @param[in] input     @p true for waking up on readable descriptor
+ * @param[in] output    @p true for waking up on writable descriptor
+ */
+void _sim_watch_fd(int fd, bool input, bool output) {
+#if defined(__linux__)
+  struct epoll_event ev;
+
+  ev.events  = (input ? EPOLLIN : 0U) | (output ? EPOLLOUT : 0U);
+  ev.data.fd = fd;
+  (void) epoll_ctl(sim_epfd, EPOLL_CTL_MOD, fd, &ev);
+#else
+  (void)fd;
+  (void)input;
+  (void)output;
+#endif
+}
+
+/**
+ * @brief   Interrupt simulation.
+ * @note    In virtual time mode each check consumes
+ *          @p SIM_VIRTUAL_TIME_QUANTUM nanoseconds of simulated time.
+ */
+void _sim_check_for_interrupts(void) {
+
+#if SIM_USE_VIRTUAL_TIME
+  sim_vtime += (uint64_t)SIM_VIRTUAL_TIME_QUANTUM;
+#endif
+  (void) sim_serve_interrupts();
+}
+
+/**
+ * @brief   Busy waits for the specified simulated time.
+ * @details Models a CPU polling a peripheral, the interrupts are served
+ *          while waiting.
+ *
+ * @param[in] ns        time in nanoseconds
+ */
+void _sim_busy_wait(uint64_t ns) {
+  uint64_t end = _sim_get_time_ns() + ns;
+
+  while (_sim_get_time_ns() < end) {
+    _sim_check_for_interrupts();
+  }
+}
+
+/**
+ * @brief   Waits for simulated interrupts.
+ * @details If there is nothing pending the host thread sleeps until the
+ *          tick timer, a peripheral deadline or one of the registered
+ *          descriptors fires. In virtual time mode the simulated time
+ *          jumps to the next system timer or peripheral deadline instead,
+ *          the host thread sleeps only if there is no deadline pending.
+ */
+void _sim_wait_for_interrupts(void) {
+#if SIM_USE_VIRTUAL_TIME
+  uint64_t ns;
+#endif
+
+  if (sim_serve_interrupts()) {
+    return;
+  }
+
+#if SIM_USE_VIRTUAL_TIME
+  /* Descriptors can stay readable without producing interrupts, the time
+     must advance anyway.*/
+  if (sim_wait_events(0) && sim_serve_interrupts()) {
+    return;
+  }
+  if (sim_get_deadline(&ns)) {
+    if (ns > sim_vtime) {
+      sim_vtime = ns;
+    }
+  }
+  else {
+    (void) sim_wait_events(-1);
+  }
+#else
+#if defined(__linux__)
+  /* The wake up timer is programmed again only if the deadline changed.*/
+  if ((sim_wakeup != SIM_NO_DEADLINE) && (sim_wakeup != sim_wakefd_ns)) {
+    sim_wakefd_ns = sim_wakeup;
+    sim_timer_set(sim_wakefd, sim_wakeup, 0U);
+  }
+#endif
+  (void) sim_wait_events(-1);
+#endif
+
+  (void) sim_serve_interrupts();
 }
 
 /** @} */
@@ -53,6 +53,29 @@
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Virtual time mode.
+ * @details If enabled the simulated time is decoupled from the host clock,
+ *          it only advances when interrupts are checked and, when all
+ *          threads are waiting, it jumps to the next system timer
+ *          deadline. Runs become reproducible and much faster than real
+ *          time.
+ * @note    The tick-less mode is recommended, in periodic mode the idle
+ *          thread steps through all the ticks.
+ */
+#if !defined(SIM_USE_VIRTUAL_TIME) || defined(__DOXYGEN__)
+#define SIM_USE_VIRTUAL_TIME                FALSE
+#endif
+
+/**
+ * @brief   Simulated time consumed by each interrupts check.
+ * @details Time in nanoseconds added by @p _sim_check_for_interrupts()
+ *          in virtual time mode, it sets the speed of polling loops.
+ */
+#if !defined(SIM_VIRTUAL_TIME_QUANTUM) || defined(__DOXYGEN__)
+#define SIM_VIRTUAL_TIME_QUANTUM            1000
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -69,7 +92,17 @@
 extern "C" {
 #endif
   void hal_lld_init(void);
+  uint64_t _sim_get_time_ns(void);
+#if OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING
+  void _sim_set_alarm(uint64_t ns);
+  void _sim_stop_alarm(void);
+#endif
+  void _sim_set_wakeup(uint64_t ns);
+  void _sim_register_fd(int fd);
+  void _sim_watch_fd(int fd, bool input, bool output);
   void _sim_check_for_interrupts(void);
+  void _sim_busy_wait(uint64_t ns);
+  void _sim_wait_for_interrupts(void);
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,640 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/posix/hal_mac_lld.c
+ * @brief   Posix simulator MAC subsystem low level driver source.
+ * @details The driver connects two simulator instances with a point to
+ *          point link made of UNIX datagram sockets, each datagram carries
+ *          an Ethernet frame. Each instance receives on a socket bound to
+ *          its own address and transmits on a socket connected to the
+ *          peer address. A slow peer does not cause frames loss, the
+ *          transmit buffers stay queued until the socket becomes writable
+ *          again like in a DMA engine stalled by flow control. The link
+ *          is always up while the driver is active, frames sent while the
+ *          peer is not running are dropped like on a switch port with no
+ *          station behind it.
+ *
+ * @addtogroup POSIX_MAC
+ * @{
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "hal.h"
+
+#if (HAL_USE_MAC == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @name    Frame buffer states
+ * @{
+ */
+#define SIM_MAC_BUF_FREE                    0U
+#define SIM_MAC_BUF_LOCKED                  1U
+#define SIM_MAC_BUF_READY                   2U
+/** @} */
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Ethernet driver 1.
+ */
+MACDriver ETHD1;
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the buffer following @p bp in its ring.
+ *
+ * @param[in] bp        current buffer
+ * @param[in] base      first buffer of the ring
+ * @param[in] n         number of buffers in the ring
+ * @return              The next buffer.
+ */
+static sim_mac_buffer_t *mac_sim_next(sim_mac_buffer_t *bp,
+                                      sim_mac_buffer_t *base,
+                                      size_t n) {
+
+  return ++bp >= &base[n] ? base : bp;
+}
+
+/**
+ * @brief   Fills a UNIX socket address.
+ *
+ * @param[out] sap      pointer to the socket address
+ * @param[in] path      socket path
+ * @param[in] suffix    path suffix
+ */
+static void mac_sim_set_path(struct sockaddr_un *sap,
+                             const char *path, const char *suffix) {
+
+  memset(sap, 0, sizeof (*sap));
+  sap->sun_family = AF_UNIX;
+  (void) snprintf(sap->sun_path, sizeof (sap->sun_path), "%s%s",
+                  path, suffix);
+}
+
+/**
+ * @brief   Creates a non-blocking datagram socket.
+ *
+ * @return              The socket descriptor.
+ */
+static int mac_sim_socket(void) {
+  int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+
+  if ((fd < 0) ||
+      (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0) ||
+      (fcntl(fd, F_SETFD, FD_CLOEXEC) < 0)) {
+    printf("ETHD1: Error creating the link sockets\n");
+    exit(1);
+  }
+
+  return fd;
+}
+
+/**
+ * @brief   Binds the receive socket to the local address.
+ * @details A path left behind by a terminated instance is reused, a path
+ *          bound by a running instance is not.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              @p true if the socket has been bound.
+ */
+static bool mac_sim_bind(MACDriver *macp) {
+  int probe;
+  bool alive;
+
+  if (bind(macp->rxfd, (struct sockaddr *)&macp->local,
+           sizeof (macp->local)) == 0) {
+    return true;
+  }
+  if (errno != EADDRINUSE) {
+    return false;
+  }
+
+  probe = socket(AF_UNIX, SOCK_DGRAM, 0);
+  alive = connect(probe, (struct sockaddr *)&macp->local,
+                  sizeof (macp->local)) == 0;
+  (void) close(probe);
+  if (alive) {
+    return false;
+  }
+
+  (void) unlink(macp->local.sun_path);
+  return bind(macp->rxfd, (struct sockaddr *)&macp->local,
+              sizeof (macp->local)) == 0;
+}
+
+/**
+ * @brief   Connects the transmit socket to the peer.
+ * @note    Connecting again refreshes the association after a restart
+ *          of the peer instance.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              @p true if the peer instance is running.
+ */
+static bool mac_sim_connect(MACDriver *macp) {
+
+  return connect(macp->txfd, (struct sockaddr *)&macp->peer,
+                 sizeof (macp->peer)) == 0;
+}
+
+/**
+ * @brief   Sends the queued transmit buffers.
+ * @details Frames are sent in order until the socket is full, frames
+ *          addressed to an unreachable peer are dropped.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              @p true if at least a buffer has been freed.
+ */
+static bool mac_sim_transmit(MACDriver *macp) {
+  sim_mac_buffer_t *bp = macp->txsend;
+  bool freed = false;
+
+  while (bp->state == SIM_MAC_BUF_READY) {
+    ssize_t n = send(macp->txfd, bp->data, bp->size, 0);
+
+    if ((n < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) &&
+        (errno != ENOBUFS) && (errno != EINTR)) {
+      /* Peer restarted or not started yet, one more attempt after
+         connecting again.*/
+      n = mac_sim_connect(macp) ? send(macp->txfd, bp->data, bp->size, 0) :
+                                  -1;
+    }
+
+    if (n >= 0) {
+      macp->txframes++;
+    }
+    else if ((errno == EAGAIN) || (errno == EWOULDBLOCK) ||
+             (errno == ENOBUFS) || (errno == EINTR)) {
+      break;
+    }
+    else {
+      macp->txdrops++;
+    }
+
+    bp->state = SIM_MAC_BUF_FREE;
+    bp = mac_sim_next(bp, macp->txb, SIM_MAC_TRANSMIT_BUFFERS);
+    freed = true;
+  }
+  macp->txsend = bp;
+
+  /* Waking up on writable socket only while there are frames waiting.*/
+  if (macp->txwait != (bp->state == SIM_MAC_BUF_READY)) {
+    macp->txwait = !macp->txwait;
+    _sim_watch_fd(macp->txfd, true, macp->txwait);
+  }
+
+  return freed;
+}
+
+/**
+ * @brief   Moves the incoming frames into the free receive buffers.
+ * @details Frames not fitting the buffers are left in the socket as a
+ *          form of flow control.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              @p true if at least a frame has been received.
+ */
+static bool mac_sim_receive(MACDriver *macp) {
+  sim_mac_buffer_t *bp = macp->rxfill;
+  bool received = false;
+
+  while (bp->state == SIM_MAC_BUF_FREE) {
+    ssize_t n = recv(macp->rxfd, bp->data, sizeof (bp->data), MSG_TRUNC);
+
+    if (n < 0) {
+      break;
+    }
+    if ((n == 0) || ((size_t)n > sizeof (bp->data))) {
+      /* Invalid frame, purging.*/
+      continue;
+    }
+
+    bp->size  = (size_t)n;
+    bp->state = SIM_MAC_BUF_READY;
+    bp = mac_sim_next(bp, macp->rxb, SIM_MAC_RECEIVE_BUFFERS);
+    macp->rxframes++;
+    received = true;
+  }
+  macp->rxfill = bp;
+
+  return received;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Simulated MAC interrupt.
+ *
+ * @return              @p true if an interrupt has been served.
+ *
+ * @notapi
+ */
+bool mac_lld_interrupt_pending(void) {
+  bool rx, tx;
+
+  if (ETHD1.state != MAC_ACTIVE) {
+    return false;
+  }
+
+  OSAL_IRQ_PROLOGUE();
+
+  rx = mac_sim_receive(&ETHD1);
+  tx = mac_sim_transmit(&ETHD1);
+
+  osalSysLockFromISR();
+  if (rx) {
+    osalThreadDequeueAllI(&ETHD1.rdqueue, MSG_RESET);
+#if MAC_USE_EVENTS
+    osalEventBroadcastFlagsI(&ETHD1.rdevent, 0);
+#endif
+  }
+  if (tx) {
+    osalThreadDequeueAllI(&ETHD1.tdqueue, MSG_RESET);
+  }
+  osalSysUnlockFromISR();
+
+  OSAL_IRQ_EPILOGUE();
+
+  return rx || tx;
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level MAC initialization.
+ *
+ * @notapi
+ */
+void mac_lld_init(void) {
+
+  macObjectInit(&ETHD1);
+  ETHD1.link_up = false;
+  ETHD1.rxfd    = -1;
+  ETHD1.txfd    = -1;
+}
+
+/**
+ * @brief   Configures and activates the MAC peripheral.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ *
+ * @notapi
+ */
+void mac_lld_start(MACDriver *macp) {
+  unsigned i;
+
+  if (macp->state == MAC_STOP) {
+    macp->rxfd = mac_sim_socket();
+    macp->txfd = mac_sim_socket();
+
+    if (macp->config->local_path != NULL) {
+      mac_sim_set_path(&macp->local, macp->config->local_path, "");
+      mac_sim_set_path(&macp->peer, macp->config->peer_path, "");
+      if (!mac_sim_bind(macp)) {
+        printf("%s: Error binding the link socket\n",
+               macp->config->local_path);
+        exit(1);
+      }
+    }
+    else {
+      /* Automatic pairing, taking the first free end of the link.*/
+      for (i = 0U; i < 2U; i++) {
+        mac_sim_set_path(&macp->local, SIM_MAC_PATH, i == 0U ? ".0" : ".1");
+        mac_sim_set_path(&macp->peer,  SIM_MAC_PATH, i == 0U ? ".1" : ".0");
+        if (mac_sim_bind(macp)) {
+          break;
+        }
+      }
+      if (i >= 2U) {
+        printf("%s: Both link ends are in use\n", SIM_MAC_PATH);
+        exit(1);
+      }
+    }
+
+    _sim_register_fd(macp->rxfd);
+    _sim_register_fd(macp->txfd);
+  }
+
+  /* Buffers rings reset.*/
+  for (i = 0U; i < SIM_MAC_TRANSMIT_BUFFERS; i++) {
+    macp->txb[i].state = SIM_MAC_BUF_FREE;
+  }
+  for (i = 0U; i < SIM_MAC_RECEIVE_BUFFERS; i++) {
+    macp->rxb[i].state = SIM_MAC_BUF_FREE;
+  }
+  macp->txptr    = macp->txb;
+  macp->txsend   = macp->txb;
+  macp->rxptr    = macp->rxb;
+  macp->rxfill   = macp->rxb;
+  macp->txwait   = false;
+  macp->txframes = 0U;
+  macp->rxframes = 0U;
+  macp->txdrops  = 0U;
+
+  (void) mac_sim_connect(macp);
+  macp->link_up = true;
+}
+
+/**
+ * @brief   Deactivates the MAC peripheral.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ *
+ * @notapi
+ */
+void mac_lld_stop(MACDriver *macp) {
+
+  if (macp->state == MAC_ACTIVE) {
+    /* Closed descriptors are removed from the interrupt sources.*/
+    (void) close(macp->rxfd);
+    (void) close(macp->txfd);
+    (void) unlink(macp->local.sun_path);
+    macp->rxfd    = -1;
+    macp->txfd    = -1;
+    macp->link_up = false;
+  }
+}
+
+/**
+ * @brief   Returns a transmission descriptor.
+ * @details One of the available transmission descriptors is locked and
+ *          returned.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[out] tdp      pointer to a @p MACTransmitDescriptor structure
+ * @return              The operation status.
+ * @retval MSG_OK       the descriptor has been obtained.
+ * @retval MSG_TIMEOUT  descriptor not available.
+ *
+ * @notapi
+ */
+msg_t mac_lld_get_transmit_descriptor(MACDriver *macp,
+                                      MACTransmitDescriptor *tdp) {
+  sim_mac_buffer_t *bp = macp->txptr;
+
+  if (bp->state != SIM_MAC_BUF_FREE) {
+    return MSG_TIMEOUT;
+  }
+
+  bp->state   = SIM_MAC_BUF_LOCKED;
+  macp->txptr = mac_sim_next(bp, macp->txb, SIM_MAC_TRANSMIT_BUFFERS);
+
+  tdp->offset   = 0;
+  tdp->size     = SIM_MAC_BUFFERS_SIZE;
+  tdp->physdesc = bp;
+
+  return MSG_OK;
+}
+
+/**
+ * @brief   Releases a transmit descriptor and starts the transmission of the
+ *          enqueued data as a single frame.
+ *
+ * @param[in] tdp       the pointer to the @p MACTransmitDescriptor structure
+ *
+ * @notapi
+ */
+void mac_lld_release_transmit_descriptor(MACTransmitDescriptor *tdp) {
+
+  osalDbgAssert(tdp->physdesc->state == SIM_MAC_BUF_LOCKED,
+                "attempt to release descriptor not locked");
+
+  osalSysLock();
+
+  tdp->physdesc->size  = tdp->offset;
+  tdp->physdesc->state = SIM_MAC_BUF_READY;
+
+  /* Immediate transmission attempt, buffers freed here are found by the
+     next descriptor request.*/
+  (void) mac_sim_transmit(&ETHD1);
+
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Returns a receive descriptor.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[out] rdp      pointer to a @p MACReceiveDescriptor structure
+ * @return              The operation status.
+ * @retval MSG_OK       the descriptor has been obtained.
+ * @retval MSG_TIMEOUT  descriptor not available.
+ *
+ * @notapi
+ */
+msg_t mac_lld_get_receive_descriptor(MACDriver *macp,
+                                     MACReceiveDescriptor *rdp) {
+  sim_mac_buffer_t *bp = macp->rxptr;
+
+  if (bp->state != SIM_MAC_BUF_READY) {
+    return MSG_TIMEOUT;
+  }
+
+  bp->state   = SIM_MAC_BUF_LOCKED;
+  macp->rxptr = mac_sim_next(bp, macp->rxb, SIM_MAC_RECEIVE_BUFFERS);
+
+  rdp->offset   = 0;
+  rdp->size     = bp->size;
+  rdp->physdesc = bp;
+
+  return MSG_OK;
+}
+
+/**
+ * @brief   Releases a receive descriptor.
+ * @details The descriptor and its buffer are made available for more incoming
+ *          frames.
+ *
+ * @param[in] rdp       the pointer to the @p MACReceiveDescriptor structure
+ *
+ * @notapi
+ */
+void mac_lld_release_receive_descriptor(MACReceiveDescriptor *rdp) {
+
+  osalDbgAssert(rdp->physdesc->state == SIM_MAC_BUF_LOCKED,
+                "attempt to release descriptor not locked");
+
+  osalSysLock();
+
+  rdp->physdesc->state = SIM_MAC_BUF_FREE;
+
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Returns the link status.
+ * @details The link is up while the driver is active, a running peer
+ *          instance is not required.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              The link status.
+ * @retval true         if the link is active.
+ * @retval false        if the link is down.
+ *
+ * @notapi
+ */
+bool mac_lld_poll_link_status(MACDriver *macp) {
+
+  return macp->link_up;
+}
+
+/**
+ * @brief   Writes to a transmit descriptor's stream.
+ *
+ * @param[in] tdp       pointer to a @p MACTransmitDescriptor structure
+ * @param[in] buf       pointer to the buffer containing the data to be
+ *                      written
+ * @param[in] size      number of bytes to be written
+ * @return              The number of bytes written into the descriptor's
+ *                      stream, this value can be less than the amount
+ *                      specified in the parameter @p size if the maximum
+ *                      frame size is reached.
+ *
+ * @notapi
+ */
+size_t mac_lld_write_transmit_descriptor(MACTransmitDescriptor *tdp,
+                                         uint8_t *buf,
+                                         size_t size) {
+
+  osalDbgAssert(tdp->physdesc->state == SIM_MAC_BUF_LOCKED,
+                "attempt to write descriptor not locked");
+
+  if (size > tdp->size - tdp->offset)
+    size = tdp->size - tdp->offset;
+
+  if (size > 0) {
+    memcpy(tdp->physdesc->data + tdp->offset, buf, size);
+    tdp->offset += size;
+  }
+  return size;
+}
+
+/**
+ * @brief   Reads from a receive descriptor's stream.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @param[in] buf       pointer to the buffer that will receive the read data
+ * @param[in] size      number of bytes to be read
+ * @return              The number of bytes read from the descriptor's
+ *                      stream, this value can be less than the amount
+ *                      specified in the parameter @p size if there are
+ *                      no more bytes to read.
+ *
+ * @notapi
+ */
+size_t mac_lld_read_receive_descriptor(MACReceiveDescriptor *rdp,
+                                       uint8_t *buf,
+                                       size_t size) {
+
+  osalDbgAssert(rdp->physdesc->state == SIM_MAC_BUF_LOCKED,
+                "attempt to read descriptor not locked");
+
+  if (size > rdp->size - rdp->offset)
+    size = rdp->size - rdp->offset;
+
+  if (size > 0) {
+    memcpy(buf, rdp->physdesc->data + rdp->offset, size);
+    rdp->offset += size;
+  }
+  return size;
+}
+
+#if MAC_USE_ZERO_COPY || defined(__DOXYGEN__)
+/**
+ * @brief   Returns a pointer to the next transmit buffer in the descriptor
+ *          chain.
+ * @note    The API guarantees that enough buffers can be requested to fill
+ *          a whole frame.
+ *
+ * @param[in] tdp       pointer to a @p MACTransmitDescriptor structure
+ * @param[in] size      size of the requested buffer. Specify the frame size
+ *                      on the first call then scale the value down subtracting
+ *                      the amount of data already copied into the previous
+ *                      buffers.
+ * @param[out] sizep    pointer to variable receiving the buffer size, it is
+ *                      zero when the last buffer has already been returned.
+ *                      Note that a returned size lower than the amount
+ *                      requested means that more buffers must be requested
+ *                      in order to fill the frame data entirely.
+ * @return              Pointer to the returned buffer.
+ * @retval NULL         if the buffer chain has been entirely scanned.
+ *
+ * @notapi
+ */
+uint8_t *mac_lld_get_next_transmit_buffer(MACTransmitDescriptor *tdp,
+                                          size_t size,
+                                          size_t *sizep) {
+
+  if (tdp->offset == 0) {
+    *sizep      = tdp->size;
+    tdp->offset = size;
+    return tdp->physdesc->data;
+  }
+  *sizep = 0;
+  return NULL;
+}
+
+/**
+ * @brief   Returns a pointer to the next receive buffer in the descriptor
+ *          chain.
+ * @note    The API guarantees that the descriptor chain contains a whole
+ *          frame.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @param[out] sizep    pointer to variable receiving the buffer size, it is
+ *                      zero when the last buffer has already been returned.
+ * @return              Pointer to the returned buffer.
+ * @retval NULL         if the buffer chain has been entirely scanned.
+ *
+ * @notapi
+ */
+const uint8_t *mac_lld_get_next_receive_buffer(MACReceiveDescriptor *rdp,
+                                               size_t *sizep) {
+
+  if (rdp->size > 0) {
+    *sizep      = rdp->size;
+    rdp->offset = rdp->size;
+    rdp->size   = 0;
+    return rdp->physdesc->data;
+  }
+  *sizep = 0;
+  return NULL;
+}
+#endif /* MAC_USE_ZERO_COPY */
+
+#endif /* HAL_USE_MAC == TRUE */
+
+/** @} */
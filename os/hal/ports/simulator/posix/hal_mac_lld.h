@@ -0,0 +1,313 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/posix/hal_mac_lld.h
+ * @brief   Posix simulator MAC subsystem low level driver header.
+ *
+ * @addtogroup POSIX_MAC
+ * @{
+ */
+
+#ifndef HAL_MAC_LLD_H
+#define HAL_MAC_LLD_H
+
+#if (HAL_USE_MAC == TRUE) || defined(__DOXYGEN__)
+
+#include <sys/un.h>
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   This implementation supports the zero-copy mode API.
+ */
+#define MAC_SUPPORTS_ZERO_COPY              TRUE
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   Number of available transmit buffers.
+ */
+#if !defined(SIM_MAC_TRANSMIT_BUFFERS) || defined(__DOXYGEN__)
+#define SIM_MAC_TRANSMIT_BUFFERS            8
+#endif
+
+/**
+ * @brief   Number of available receive buffers.
+ */
+#if !defined(SIM_MAC_RECEIVE_BUFFERS) || defined(__DOXYGEN__)
+#define SIM_MAC_RECEIVE_BUFFERS             8
+#endif
+
+/**
+ * @brief   Maximum supported frame size.
+ */
+#if !defined(SIM_MAC_BUFFERS_SIZE) || defined(__DOXYGEN__)
+#define SIM_MAC_BUFFERS_SIZE                1522
+#endif
+
+/**
+ * @brief   Base path of the simulated link sockets.
+ * @details When the configuration does not specify the socket paths the
+ *          simulator instances pair automatically, the first instance
+ *          binds the path with suffix ".0", the second one the path with
+ *          suffix ".1", each one sends its frames to the other.
+ */
+#if !defined(SIM_MAC_PATH) || defined(__DOXYGEN__)
+#define SIM_MAC_PATH                        "/tmp/chibios_eth1"
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if defined(WIN32)
+#error "the simulated MAC is not supported on Win32"
+#endif
+
+#if SIM_MAC_TRANSMIT_BUFFERS < 1
+#error "invalid SIM_MAC_TRANSMIT_BUFFERS value"
+#endif
+
+#if SIM_MAC_RECEIVE_BUFFERS < 1
+#error "invalid SIM_MAC_RECEIVE_BUFFERS value"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a simulated frame buffer.
+ */
+typedef struct {
+  /**
+   * @brief   Buffer state.
+   */
+  volatile uint32_t     state;
+  /**
+   * @brief   Frame size.
+   */
+  size_t                size;
+  /**
+   * @brief   Frame data.
+   */
+  uint8_t               data[SIM_MAC_BUFFERS_SIZE];
+} sim_mac_buffer_t;
+
+/**
+ * @brief   Driver configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief MAC address.
+   */
+  uint8_t               *mac_address;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Local socket path, @p NULL for automatic pairing.
+   */
+  const char            *local_path;
+  /**
+   * @brief   Peer socket path, used if @p local_path is not @p NULL.
+   */
+  const char            *peer_path;
+} MACConfig;
+
+/**
+ * @brief   Structure representing a MAC driver.
+ */
+struct MACDriver {
+  /**
+   * @brief Driver state.
+   */
+  macstate_t            state;
+  /**
+   * @brief Current configuration data.
+   */
+  const MACConfig       *config;
+  /**
+   * @brief Transmit semaphore.
+   */
+  threads_queue_t       tdqueue;
+  /**
+   * @brief Receive semaphore.
+   */
+  threads_queue_t       rdqueue;
+#if MAC_USE_EVENTS || defined(__DOXYGEN__)
+  /**
+   * @brief Receive event.
+   */
+  event_source_t        rdevent;
+#endif
+  /* End of the mandatory fields.*/
+  /**
+   * @brief Link status flag.
+   */
+  bool                  link_up;
+  /**
+   * @brief Receive socket, bound to the local address.
+   */
+  int                   rxfd;
+  /**
+   * @brief Transmit socket, connected to the peer address.
+   */
+  int                   txfd;
+  /**
+   * @brief Local socket address.
+   */
+  struct sockaddr_un    local;
+  /**
+   * @brief Peer socket address.
+   */
+  struct sockaddr_un    peer;
+  /**
+   * @brief Transmit buffers waiting for the socket to become writable.
+   */
+  bool                  txwait;
+  /**
+   * @brief Next transmit buffer to be handed to the application.
+   */
+  sim_mac_buffer_t      *txptr;
+  /**
+   * @brief Next transmit buffer to be sent.
+   */
+  sim_mac_buffer_t      *txsend;
+  /**
+   * @brief Next receive buffer to be handed to the application.
+   */
+  sim_mac_buffer_t      *rxptr;
+  /**
+   * @brief Next receive buffer to be filled.
+   */
+  sim_mac_buffer_t      *rxfill;
+  /**
+   * @brief Transmitted frames.
+   */
+  uint32_t              txframes;
+  /**
+   * @brief Received frames.
+   */
+  uint32_t              rxframes;
+  /**
+   * @brief Frames dropped because the peer was unreachable.
+   */
+  uint32_t              txdrops;
+  /**
+   * @brief Transmit buffers.
+   */
+  sim_mac_buffer_t      txb[SIM_MAC_TRANSMIT_BUFFERS];
+  /**
+   * @brief Receive buffers.
+   */
+  sim_mac_buffer_t      rxb[SIM_MAC_RECEIVE_BUFFERS];
+};
+
+/**
+ * @brief   Structure representing a transmit descriptor.
+ */
+typedef struct {
+  /**
+   * @brief Current write offset.
+   */
+  size_t                    offset;
+  /**
+   * @brief Available space size.
+   */
+  size_t                    size;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief Pointer to the frame buffer.
+   */
+  sim_mac_buffer_t          *physdesc;
+} MACTransmitDescriptor;
+
+/**
+ * @brief   Structure representing a receive descriptor.
+ */
+typedef struct {
+  /**
+   * @brief Current read offset.
+   */
+  size_t                offset;
+  /**
+   * @brief Available data size.
+   */
+  size_t                size;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief Pointer to the frame buffer.
+   */
+  sim_mac_buffer_t      *physdesc;
+} MACReceiveDescriptor;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if !defined(__DOXYGEN__)
+extern MACDriver ETHD1;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void mac_lld_init(void);
+  void mac_lld_start(MACDriver *macp);
+  void mac_lld_stop(MACDriver *macp);
+  msg_t mac_lld_get_transmit_descriptor(MACDriver *macp,
+                                        MACTransmitDescriptor *tdp);
+  void mac_lld_release_transmit_descriptor(MACTransmitDescriptor *tdp);
+  msg_t mac_lld_get_receive_descriptor(MACDriver *macp,
+                                       MACReceiveDescriptor *rdp);
+  void mac_lld_release_receive_descriptor(MACReceiveDescriptor *rdp);
+  bool mac_lld_poll_link_status(MACDriver *macp);
+  size_t mac_lld_write_transmit_descriptor(MACTransmitDescriptor *tdp,
+                                           uint8_t *buf,
+                                           size_t size);
+  size_t mac_lld_read_receive_descriptor(MACReceiveDescriptor *rdp,
+                                         uint8_t *buf,
+                                         size_t size);
+#if MAC_USE_ZERO_COPY
+  uint8_t *mac_lld_get_next_transmit_buffer(MACTransmitDescriptor *tdp,
+                                            size_t size,
+                                            size_t *sizep);
+  const uint8_t *mac_lld_get_next_receive_buffer(MACReceiveDescriptor *rdp,
+                                                 size_t *sizep);
+#endif /* MAC_USE_ZERO_COPY */
+  bool mac_lld_interrupt_pending(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_MAC == TRUE */
+
+#endif /* HAL_MAC_LLD_H */
+
+/** @} */
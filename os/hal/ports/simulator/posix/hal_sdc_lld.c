@@ -0,0 +1,571 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/posix/hal_sdc_lld.c
+ * @brief   Posix simulator SDC subsystem low level driver source.
+ * @details The driver simulates an high capacity SD card stored in an
+ *          image file. The card answers to the commands used by the
+ *          high level driver, transfers take the time given by the
+ *          configured latency and throughput.
+ *
+ * @addtogroup POSIX_SDC
+ * @{
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "hal.h"
+
+#if (HAL_USE_SDC == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Simulated card RCA.
+ */
+#define SIM_SDC_RCA                         0x00010000U
+
+/**
+ * @brief   R1 response of a card in transfer state.
+ */
+#define SIM_SDC_R1_TRAN                     ((MMCSD_STS_TRAN << 9U) |       \
+                                             (1U << 8U))
+
+/**
+ * @brief   R1 response bit signaling an application command.
+ */
+#define SIM_SDC_R1_APP_CMD                  (1U << 5U)
+
+/**
+ * @brief   OCR of a powered up, high capacity card.
+ */
+#define SIM_SDC_OCR                         0xC0FF8000U
+
+/**
+ * @brief   Card capacity granularity in blocks, as encoded in the CSD.
+ */
+#define SIM_SDC_CSIZE_BLOCKS                1024U
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   SDCD1 driver identifier.
+ */
+SDCDriver SDCD1;
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Driver default configuration.
+ */
+static const SDCConfig sdc_default_cfg = {
+  .bus_width        = SDC_MODE_4BIT,
+  .path             = SIM_SDC_PATH,
+  .read_latency     = SIM_SDC_READ_LATENCY_US,
+  .write_latency    = SIM_SDC_WRITE_LATENCY_US,
+  .read_rate        = SIM_SDC_READ_RATE_KBS,
+  .write_rate       = SIM_SDC_WRITE_RATE_KBS
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Simulates the time taken by a transfer.
+ *
+ * @param[in] latency   request latency in microseconds
+ * @param[in] rate      throughput in kilobytes per second, zero for unlimited
+ * @param[in] n         number of blocks transferred
+ */
+static void sdc_sim_transfer_time(uint32_t latency, uint32_t rate,
+                                  uint32_t n) {
+  uint64_t ns = (uint64_t)latency * 1000U;
+
+  if (rate > 0U) {
+    ns += ((uint64_t)n * MMCSD_BLOCK_SIZE * 1000000000U) /
+          ((uint64_t)rate * 1024U);
+  }
+  if (ns > 0U) {
+    _sim_busy_wait(ns);
+  }
+}
+
+/**
+ * @brief   Builds the R1 response of a command.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @return              The R1 response.
+ */
+static uint32_t sdc_sim_r1(SDCDriver *sdcp) {
+
+  return sdcp->appcmd ? SIM_SDC_R1_TRAN | SIM_SDC_R1_APP_CMD :
+                        SIM_SDC_R1_TRAN;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level SDC driver initialization.
+ *
+ * @notapi
+ */
+void sdc_lld_init(void) {
+
+  sdcObjectInit(&SDCD1);
+  SDCD1.fd = -1;
+}
+
+/**
+ * @brief   Configures and activates the SDC peripheral.
+ * @details The card image is opened or created, a missing or empty image
+ *          is created with @p SIM_SDC_SIZE_MB size.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @notapi
+ */
+void sdc_lld_start(SDCDriver *sdcp) {
+
+  /* Checking configuration, using a default if NULL has been passed.*/
+  if (sdcp->config == NULL) {
+    sdcp->config = &sdc_default_cfg;
+  }
+
+  if (sdcp->state == BLK_STOP) {
+    struct stat st;
+
+    sdcp->fd = open(sdcp->config->path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if ((sdcp->fd < 0) || (fstat(sdcp->fd, &st) < 0)) {
+      printf("%s: Error opening card image\n", sdcp->config->path);
+      exit(1);
+    }
+    if (st.st_size == 0) {
+      st.st_size = (off_t)SIM_SDC_SIZE_MB * 1024 * 1024;
+      if (ftruncate(sdcp->fd, st.st_size) < 0) {
+        printf("%s: Error creating card image\n", sdcp->config->path);
+        exit(1);
+      }
+    }
+
+    /* The capacity is rounded down to what the CSD is able to encode.*/
+    sdcp->blocks = (uint32_t)(st.st_size / MMCSD_BLOCK_SIZE);
+    sdcp->blocks -= sdcp->blocks % SIM_SDC_CSIZE_BLOCKS;
+    if (sdcp->blocks == 0U) {
+      printf("%s: Card image too small\n", sdcp->config->path);
+      exit(1);
+    }
+  }
+}
+
+/**
+ * @brief   Deactivates the SDC peripheral.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @notapi
+ */
+void sdc_lld_stop(SDCDriver *sdcp) {
+
+  if (sdcp->state != BLK_STOP) {
+    (void) close(sdcp->fd);
+    sdcp->fd = -1;
+  }
+}
+
+/**
+ * @brief   Starts the SDIO clock and sets it to init mode (400kHz or less).
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @notapi
+ */
+void sdc_lld_start_clk(SDCDriver *sdcp) {
+
+  sdcp->appcmd = false;
+}
+
+/**
+ * @brief   Sets the SDIO clock to data mode (25MHz or less).
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] clk       the clock mode
+ *
+ * @notapi
+ */
+void sdc_lld_set_data_clk(SDCDriver *sdcp, sdcbusclk_t clk) {
+
+  (void)sdcp;
+  (void)clk;
+}
+
+/**
+ * @brief   Stops the SDIO clock.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @notapi
+ */
+void sdc_lld_stop_clk(SDCDriver *sdcp) {
+
+  (void)sdcp;
+}
+
+/**
+ * @brief   Switches the bus to 4 bits mode.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] mode      bus mode
+ *
+ * @notapi
+ */
+void sdc_lld_set_bus_mode(SDCDriver *sdcp, sdcbusmode_t mode) {
+
+  (void)sdcp;
+
+  osalDbgAssert(mode != SDC_MODE_8BIT, "invalid bus mode");
+}
+
+/**
+ * @brief   Sends an SDIO command with no response expected.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] cmd       card command
+ * @param[in] arg       command argument
+ *
+ * @notapi
+ */
+void sdc_lld_send_cmd_none(SDCDriver *sdcp, uint8_t cmd, uint32_t arg) {
+
+  (void)cmd;
+  (void)arg;
+
+  sdcp->appcmd = false;
+}
+
+/**
+ * @brief   Sends an SDIO command with a short response expected.
+ * @note    The CRC is not verified.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] cmd       card command
+ * @param[in] arg       command argument
+ * @param[out] resp     pointer to the response buffer (one word)
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @notapi
+ */
+bool sdc_lld_send_cmd_short(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
+                            uint32_t *resp) {
+  bool appcmd = sdcp->appcmd;
+
+  (void)arg;
+
+  sdcp->appcmd = false;
+
+  /* Only ACMD41 is answered, the card is not an MMC.*/
+  if (appcmd && (cmd == MMCSD_CMD_APP_OP_COND)) {
+    *resp = SIM_SDC_OCR;
+    return HAL_SUCCESS;
+  }
+
+  sdcp->errors |= SDC_COMMAND_TIMEOUT;
+  return HAL_FAILED;
+}
+
+/**
+ * @brief   Sends an SDIO command with a short response expected and CRC.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] cmd       card command
+ * @param[in] arg       command argument
+ * @param[out] resp     pointer to the response buffer (one word)
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @notapi
+ */
+bool sdc_lld_send_cmd_short_crc(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
+                                uint32_t *resp) {
+  bool appcmd = sdcp->appcmd;
+
+  sdcp->appcmd = false;
+
+  switch (cmd) {
+  case MMCSD_CMD_APP_CMD:
+    sdcp->appcmd = true;
+    *resp = sdc_sim_r1(sdcp);
+    return HAL_SUCCESS;
+  case MMCSD_CMD_SEND_IF_COND:
+    /* Voltage accepted, check pattern echoed.*/
+    *resp = arg & 0xFFFU;
+    return HAL_SUCCESS;
+  case MMCSD_CMD_SEND_RELATIVE_ADDR:
+    *resp = SIM_SDC_RCA;
+    return HAL_SUCCESS;
+  case MMCSD_CMD_SET_BUS_WIDTH:
+    /* ACMD6 only, CMD6 with a short response is the MMC switch.*/
+    if (!appcmd) {
+      break;
+    }
+    /* Falls through.*/
+  case MMCSD_CMD_SEL_DESEL_CARD:
+  case MMCSD_CMD_SEND_STATUS:
+  case MMCSD_CMD_SET_BLOCKLEN:
+  case MMCSD_CMD_ERASE_RW_BLK_START:
+  case MMCSD_CMD_ERASE_RW_BLK_END:
+  case MMCSD_CMD_ERASE:
+    /* Erasing is accepted but the content is left unchanged, as allowed
+       for a discard.*/
+    *resp = sdc_sim_r1(sdcp);
+    return HAL_SUCCESS;
+  default:
+    break;
+  }
+
+  sdcp->errors |= SDC_COMMAND_TIMEOUT;
+  return HAL_FAILED;
+}
+
+/**
+ * @brief   Sends an SDIO command with a long response expected and CRC.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] cmd       card command
+ * @param[in] arg       command argument
+ * @param[out] resp     pointer to the response buffer (four words)
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @notapi
+ */
+bool sdc_lld_send_cmd_long_crc(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
+                               uint32_t *resp) {
+  uint32_t csize;
+
+  (void)arg;
+
+  sdcp->appcmd = false;
+
+  switch (cmd) {
+  case MMCSD_CMD_ALL_SEND_CID:
+    /* Manufacturer 0xFF, "CH" application, "SIMSD" product name.*/
+    resp[3] = 0xFF434853U;
+    resp[2] = 0x494D5344U;
+    resp[1] = 0x10000000U;
+    resp[0] = 0x00013300U;
+    return HAL_SUCCESS;
+  case MMCSD_CMD_SEND_CSD:
+    /* CSD version 2.0, the capacity is (C_SIZE + 1) * 512kB.*/
+    csize = (sdcp->blocks / SIM_SDC_CSIZE_BLOCKS) - 1U;
+    resp[3] = 0x400E0032U;
+    resp[2] = 0x5B590000U | (csize >> 16U);
+    resp[1] = (csize << 16U) | 0x7F80U;
+    resp[0] = 0x0A400000U;
+    return HAL_SUCCESS;
+  default:
+    break;
+  }
+
+  sdcp->errors |= SDC_COMMAND_TIMEOUT;
+  return HAL_FAILED;
+}
+
+/**
+ * @brief   Reads special registers using data bus.
+ * @details Only the CMD6 switch function status is supported, the card
+ *          reports and accepts the high speed mode.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[out] buf      pointer to the read buffer
+ * @param[in] bytes     number of bytes to read
+ * @param[in] cmd       card command
+ * @param[in] arg       argument for command
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @notapi
+ */
+bool sdc_lld_read_special(SDCDriver *sdcp, uint8_t *buf, size_t bytes,
+                          uint8_t cmd, uint32_t arg) {
+
+  sdcp->appcmd = false;
+
+  if ((cmd != MMCSD_CMD_SWITCH) || (bytes < 17U)) {
+    sdcp->errors |= SDC_COMMAND_TIMEOUT;
+    return HAL_FAILED;
+  }
+
+  memset(buf, 0, bytes);
+
+  /* Group 1 supports default and high speed, selected function.*/
+  buf[13] = 0x03U;
+  buf[16] = (uint8_t)(arg & 0xFU);
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Reads one or more blocks.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] startblk  first block to read
+ * @param[out] buf      pointer to the read buffer
+ * @param[in] n         number of blocks to read
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @notapi
+ */
+bool sdc_lld_read(SDCDriver *sdcp, uint32_t startblk,
+                  uint8_t *buf, uint32_t n) {
+  size_t size = (size_t)n * MMCSD_BLOCK_SIZE;
+
+  if ((startblk >= sdcp->blocks) || (n > sdcp->blocks - startblk)) {
+    sdcp->errors |= SDC_OVERFLOW_ERROR;
+    return HAL_FAILED;
+  }
+
+  sdc_sim_transfer_time(sdcp->config->read_latency,
+                        sdcp->config->read_rate, n);
+
+  if (pread(sdcp->fd, buf, size,
+            (off_t)startblk * MMCSD_BLOCK_SIZE) != (ssize_t)size) {
+    sdcp->errors |= SDC_DATA_TIMEOUT;
+    return HAL_FAILED;
+  }
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Writes one or more blocks.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] startblk  first block to write
+ * @param[out] buf      pointer to the write buffer
+ * @param[in] n         number of blocks to write
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @notapi
+ */
+bool sdc_lld_write(SDCDriver *sdcp, uint32_t startblk,
+                   const uint8_t *buf, uint32_t n) {
+  size_t size = (size_t)n * MMCSD_BLOCK_SIZE;
+
+  if ((startblk >= sdcp->blocks) || (n > sdcp->blocks - startblk)) {
+    sdcp->errors |= SDC_OVERFLOW_ERROR;
+    return HAL_FAILED;
+  }
+
+  sdc_sim_transfer_time(sdcp->config->write_latency,
+                        sdcp->config->write_rate, n);
+
+  if (pwrite(sdcp->fd, buf, size,
+             (off_t)startblk * MMCSD_BLOCK_SIZE) != (ssize_t)size) {
+    sdcp->errors |= SDC_DATA_TIMEOUT;
+    return HAL_FAILED;
+  }
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Waits for card idle condition.
+ * @note    Writes are completed synchronously, there is nothing to wait.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  the operation succeeded.
+ * @retval HAL_FAILED   the operation failed.
+ *
+ * @api
+ */
+bool sdc_lld_sync(SDCDriver *sdcp) {
+
+  (void)sdcp;
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Card detection.
+ * @note    The card is inserted while the driver is active.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @return              The card state.
+ * @retval false        card not inserted.
+ * @retval true         card inserted.
+ *
+ * @api
+ */
+bool sdc_lld_is_card_inserted(SDCDriver *sdcp) {
+
+  return sdcp->fd >= 0;
+}
+
+/**
+ * @brief   Protection detection.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @return              The card state.
+ * @retval false        not write protected.
+ * @retval true         write protected.
+ *
+ * @api
+ */
+bool sdc_lld_is_write_protected(SDCDriver *sdcp) {
+
+  (void)sdcp;
+
+  return false;
+}
+
+#endif /* HAL_USE_SDC == TRUE */
+
+/** @} */
@@ -0,0 +1,255 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/posix/hal_sdc_lld.h
+ * @brief   Posix simulator SDC subsystem low level driver header.
+ *
+ * @addtogroup POSIX_SDC
+ * @{
+ */
+
+#ifndef HAL_SDC_LLD_H
+#define HAL_SDC_LLD_H
+
+#if (HAL_USE_SDC == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Posix simulator configuration options
+ * @details These settings are used when @p sdcStart() is invoked with a
+ *          @p NULL configuration.
+ * @{
+ */
+/**
+ * @brief   Default card image path.
+ * @details An existing image is used as it is, its size determines the
+ *          card capacity. A missing image is created empty with
+ *          @p SIM_SDC_SIZE_MB size.
+ */
+#if !defined(SIM_SDC_PATH) || defined(__DOXYGEN__)
+#define SIM_SDC_PATH                        "/tmp/chibios_sdc1.img"
+#endif
+
+/**
+ * @brief   Size of a newly created card image in megabytes.
+ */
+#if !defined(SIM_SDC_SIZE_MB) || defined(__DOXYGEN__)
+#define SIM_SDC_SIZE_MB                     64U
+#endif
+
+/**
+ * @brief   Default read request latency in microseconds.
+ */
+#if !defined(SIM_SDC_READ_LATENCY_US) || defined(__DOXYGEN__)
+#define SIM_SDC_READ_LATENCY_US             0U
+#endif
+
+/**
+ * @brief   Default write request latency in microseconds.
+ */
+#if !defined(SIM_SDC_WRITE_LATENCY_US) || defined(__DOXYGEN__)
+#define SIM_SDC_WRITE_LATENCY_US            0U
+#endif
+
+/**
+ * @brief   Default read throughput in kilobytes per second.
+ * @note    Zero means no transfer time.
+ */
+#if !defined(SIM_SDC_READ_RATE_KBS) || defined(__DOXYGEN__)
+#define SIM_SDC_READ_RATE_KBS               0U
+#endif
+
+/**
+ * @brief   Default write throughput in kilobytes per second.
+ * @note    Zero means no transfer time.
+ */
+#if !defined(SIM_SDC_WRITE_RATE_KBS) || defined(__DOXYGEN__)
+#define SIM_SDC_WRITE_RATE_KBS              0U
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if defined(WIN32)
+#error "the simulated SD card is not supported on Win32"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of card flags.
+ */
+typedef uint32_t sdcmode_t;
+
+/**
+ * @brief   SDC Driver condition flags type.
+ */
+typedef uint32_t sdcflags_t;
+
+/**
+ * @brief   Type of a structure representing an SDC driver.
+ */
+typedef struct SDCDriver SDCDriver;
+
+/**
+ * @brief   Driver configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Bus width.
+   */
+  sdcbusmode_t  bus_width;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Card image path.
+   */
+  const char    *path;
+  /**
+   * @brief   Read request latency in microseconds.
+   */
+  uint32_t      read_latency;
+  /**
+   * @brief   Write request latency in microseconds.
+   */
+  uint32_t      write_latency;
+  /**
+   * @brief   Read throughput in kilobytes per second, zero for unlimited.
+   */
+  uint32_t      read_rate;
+  /**
+   * @brief   Write throughput in kilobytes per second, zero for unlimited.
+   */
+  uint32_t      write_rate;
+} SDCConfig;
+
+/**
+ * @brief   @p SDCDriver specific methods.
+ */
+#define _sdc_driver_methods                                                 \
+  _mmcsd_block_device_methods
+
+/**
+ * @extends MMCSDBlockDeviceVMT
+ *
+ * @brief   @p SDCDriver virtual methods table.
+ */
+struct SDCDriverVMT {
+  _sdc_driver_methods
+};
+
+/**
+ * @brief   Structure representing an SDC driver.
+ */
+struct SDCDriver {
+  /**
+   * @brief Virtual Methods Table.
+   */
+  const struct SDCDriverVMT *vmt;
+  _mmcsd_block_device_data
+  /**
+   * @brief Current configuration data.
+   */
+  const SDCConfig           *config;
+  /**
+   * @brief Various flags regarding the mounted card.
+   */
+  sdcmode_t                 cardmode;
+  /**
+   * @brief Errors flags.
+   */
+  sdcflags_t                errors;
+  /**
+   * @brief Card RCA.
+   */
+  uint32_t                  rca;
+  /**
+   * @brief   Buffer for internal operations.
+   */
+  uint8_t                   buf[MMCSD_BLOCK_SIZE];
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Card image file descriptor.
+   */
+  int                       fd;
+  /**
+   * @brief   Card image size in blocks.
+   */
+  uint32_t                  blocks;
+  /**
+   * @brief   Next command is an application specific command.
+   */
+  bool                      appcmd;
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if !defined(__DOXYGEN__)
+extern SDCDriver SDCD1;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void sdc_lld_init(void);
+  void sdc_lld_start(SDCDriver *sdcp);
+  void sdc_lld_stop(SDCDriver *sdcp);
+  void sdc_lld_start_clk(SDCDriver *sdcp);
+  void sdc_lld_set_data_clk(SDCDriver *sdcp, sdcbusclk_t clk);
+  void sdc_lld_stop_clk(SDCDriver *sdcp);
+  void sdc_lld_set_bus_mode(SDCDriver *sdcp, sdcbusmode_t mode);
+  void sdc_lld_send_cmd_none(SDCDriver *sdcp, uint8_t cmd, uint32_t arg);
+  bool sdc_lld_send_cmd_short(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
+                              uint32_t *resp);
+  bool sdc_lld_send_cmd_short_crc(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
+                                  uint32_t *resp);
+  bool sdc_lld_send_cmd_long_crc(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
+                                 uint32_t *resp);
+  bool sdc_lld_read_special(SDCDriver *sdcp, uint8_t *buf, size_t bytes,
+                            uint8_t cmd, uint32_t argument);
+  bool sdc_lld_read(SDCDriver *sdcp, uint32_t startblk,
+                    uint8_t *buf, uint32_t n);
+  bool sdc_lld_write(SDCDriver *sdcp, uint32_t startblk,
+                     const uint8_t *buf, uint32_t n);
+  bool sdc_lld_sync(SDCDriver *sdcp);
+  bool sdc_lld_is_card_inserted(SDCDriver *sdcp);
+  bool sdc_lld_is_write_protected(SDCDriver *sdcp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_SDC == TRUE */
+
+#endif /* HAL_SDC_LLD_H */
+
+/** @} */
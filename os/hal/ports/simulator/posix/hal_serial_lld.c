@@ -22,9 +22,18 @@
  * @{
  */
 
+/* Required for the pseudo terminals API.*/
+#if !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/un.h>
 
 #include "hal.h"
 
@@ -52,46 +61,50 @@ SerialDriver SD2;
 static const SerialConfig default_config = {
 };
 
+#if SIM_SERIAL_USE_IRQ_THREAD || defined(__DOXYGEN__)
+/** @brief IRQ thread serving the sockets bottom halves.*/
+static irq_thread_t sd_irq_thread;
+
+/** @brief IRQ thread working area.*/
+static THD_WORKING_AREA(wa_sd_irq_thread, SIM_SERIAL_IRQ_THREAD_STACK_SIZE);
+
+/* Sockets are processed in thread context by the bottom half.*/
+#define sd_sys_lock()       osalSysLock()
+#define sd_sys_unlock()     osalSysUnlock()
+#else
+/* Sockets are processed in the simulated interrupt handler.*/
+#define sd_sys_lock()       osalSysLockFromISR()
+#define sd_sys_unlock()     osalSysUnlockFromISR()
+#endif
+
 /*===========================================================================*/
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
-static void init(SerialDriver *sdp, uint16_t port) {
-  struct sockaddr_in sad;
-  struct protoent *prtp;
-  int sockval = 1;
-  socklen_t socklen = sizeof(sockval);
+static void set_nonblocking(SerialDriver *sdp, int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
 
-  if ((prtp = getprotobyname("tcp")) == NULL) {
-    printf("%s: Error mapping protocol name to protocol number\n", sdp->com_name);
-    goto abort;
+  if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+    printf("%s: Unable to setup non blocking mode\n", sdp->com_name);
+    exit(1);
   }
+}
+
+static void init_listen(SerialDriver *sdp, int domain,
+                        const struct sockaddr *sap, socklen_t salen) {
+  int sockval = 1;
+  socklen_t socklen = sizeof(sockval);
 
-  sdp->com_listen = socket(PF_INET, SOCK_STREAM, prtp->p_proto);
+  sdp->com_listen = socket(domain, SOCK_STREAM, 0);
   if (sdp->com_listen == -1) {
     printf("%s: Error creating simulator socket\n", sdp->com_name);
     goto abort;
   }
 
   setsockopt(sdp->com_listen, SOL_SOCKET, SO_REUSEADDR, &sockval, socklen);
+  set_nonblocking(sdp, sdp->com_listen);
 
-#if 0
-  if (ioctl(sdp->com_listen, FIONBIO, &nb) != 0) {
-    printf("%s: Unable to setup non blocking mode on socket\n", sdp->com_name);
-    goto abort;
-  }
-#endif
-  int flags = fcntl(sdp->com_listen, F_GETFL, 0);
-  if (fcntl(sdp->com_listen, F_SETFL, flags | O_NONBLOCK) != 0) {
-    printf("%s: Unable to setup non blocking mode on socket\n", sdp->com_name);
-    goto abort;
-  }
-
-  memset(&sad, 0, sizeof(sad));
-  sad.sin_family = AF_INET;
-  sad.sin_addr.s_addr = INADDR_ANY;
-  sad.sin_port = htons(port);
-  if (bind(sdp->com_listen, (struct sockaddr *)&sad, sizeof(sad))) {
+  if (bind(sdp->com_listen, sap, salen)) {
     printf("%s: Error binding socket\n", sdp->com_name);
     goto abort;
   }
@@ -100,7 +113,7 @@ static void init(SerialDriver *sdp, uint16_t port) {
     printf("%s: Error listening socket\n", sdp->com_name);
     goto abort;
   }
-  printf("Full Duplex Channel %s listening on port %d\n", sdp->com_name, port);
+  _sim_register_fd(sdp->com_listen);
   return;
 
 abort:
@@ -109,71 +122,177 @@ abort:
   exit(1);
 }
 
+static void init_tcp(SerialDriver *sdp, uint16_t port) {
+  struct sockaddr_in sad;
+
+  memset(&sad, 0, sizeof(sad));
+  sad.sin_family = AF_INET;
+  sad.sin_addr.s_addr = INADDR_ANY;
+  sad.sin_port = htons(port);
+  init_listen(sdp, PF_INET, (struct sockaddr *)&sad, sizeof(sad));
+  printf("Full Duplex Channel %s listening on port %d\n", sdp->com_name, port);
+}
+
+static void init_unix(SerialDriver *sdp, const char *path) {
+  struct sockaddr_un sau;
+
+  memset(&sau, 0, sizeof(sau));
+  sau.sun_family = AF_UNIX;
+  strncpy(sau.sun_path, path, sizeof(sau.sun_path) - 1U);
+  (void) unlink(sau.sun_path);
+  init_listen(sdp, PF_UNIX, (struct sockaddr *)&sau, sizeof(sau));
+  printf("Full Duplex Channel %s listening on %s\n", sdp->com_name, path);
+}
+
+static void init_pty(SerialDriver *sdp) {
+  struct termios tio;
+  int slave;
+
+  /* The master side is connected on the first check, see connint().*/
+  sdp->com_listen = posix_openpt(O_RDWR | O_NOCTTY);
+  if ((sdp->com_listen == -1) ||
+      (grantpt(sdp->com_listen) != 0) || (unlockpt(sdp->com_listen) != 0)) {
+    printf("%s: Error creating pseudo terminal\n", sdp->com_name);
+    exit(1);
+  }
+
+  /* The slave side is kept open, this way terminal programs can attach
+     and detach without hanging up the master side.*/
+  slave = open(ptsname(sdp->com_listen), O_RDWR | O_NOCTTY);
+  if (slave == -1) {
+    printf("%s: Error opening pseudo terminal\n", sdp->com_name);
+    exit(1);
+  }
+
+  /* Raw mode, data is transferred unchanged.*/
+  if (tcgetattr(slave, &tio) == 0) {
+    cfmakeraw(&tio);
+    (void) tcsetattr(slave, TCSANOW, &tio);
+  }
+
+  printf("Full Duplex Channel %s on %s\n", sdp->com_name,
+         ptsname(sdp->com_listen));
+}
+
+static void init(SerialDriver *sdp, unsigned type,
+                 uint16_t port, const char *path) {
+
+  sdp->com_type  = type;
+  sdp->com_txcnt = 0U;
+  sdp->com_txpos = 0U;
+
+  switch (type) {
+  case SIM_SERIAL_UNIX:
+    init_unix(sdp, path);
+    break;
+  case SIM_SERIAL_PTY:
+    init_pty(sdp);
+    break;
+  default:
+    init_tcp(sdp, port);
+    break;
+  }
+}
+
+static void disconnect(SerialDriver *sdp) {
+
+  close(sdp->com_data);
+  sdp->com_data  = -1;
+  sdp->com_txcnt = 0U;
+  sdp->com_txpos = 0U;
+  sd_sys_lock();
+  chnAddFlagsI(sdp, CHN_DISCONNECTED);
+  sd_sys_unlock();
+}
+
 static bool connint(SerialDriver *sdp) {
 
-  if (sdp->com_data == -1) {
-    struct sockaddr addr;
+  if ((sdp->com_data == -1) && (sdp->com_listen != -1)) {
+    struct sockaddr_storage addr;
     socklen_t addrlen = sizeof(addr);
 
-    if ((sdp->com_data = accept(sdp->com_listen, &addr, &addrlen)) == -1)
+    if (sdp->com_type == SIM_SERIAL_PTY) {
+      /* A pseudo terminal is always connected.*/
+      sdp->com_data   = sdp->com_listen;
+      sdp->com_listen = -1;
+    }
+    else if ((sdp->com_data = accept(sdp->com_listen,
+                                     (struct sockaddr *)&addr,
+                                     &addrlen)) == -1)
       return false;
 
-#if 0
-    if (ioctl(sdp->com_data, FIONBIO, &nb) != 0) {
-      printf("%s: Unable to setup non blocking mode on data socket\n", sdp->com_name);
-      goto abort;
-    }
-#endif
-    int flags = fcntl(sdp->com_data, F_GETFL, 0);
-    if (fcntl(sdp->com_data, F_SETFL, flags | O_NONBLOCK) != 0) {
-      printf("%s: Unable to setup non blocking mode on data socket\n", sdp->com_name);
-      goto abort;
-    }
+    set_nonblocking(sdp, sdp->com_data);
+    _sim_register_fd(sdp->com_data);
+    sdp->com_rxfull = false;
 
-    osalSysLockFromISR();
+    sd_sys_lock();
     chnAddFlagsI(sdp, CHN_CONNECTED);
-    osalSysUnlockFromISR();
+    sd_sys_unlock();
     return true;
   }
   return false;
-abort:
-  if (sdp->com_listen != -1)
-    close(sdp->com_listen);
-  if (sdp->com_data != -1)
-    close(sdp->com_data);
-  exit(1);
+}
+
+/**
+ * @brief   Stops watching the input while the input queue is full.
+ * @details The data left in the host buffers would keep the descriptor
+ *          readable, waking up the idle thread and raising the interrupt
+ *          with nothing to do.
+ *
+ * @param[in] sdp       pointer to a @p SerialDriver object
+ */
+static void inwatch(SerialDriver *sdp) {
+
+  if (sdp->com_data != -1) {
+    bool full;
+
+    osalSysLockFromISR();
+    full = iqGetEmptyI(&sdp->iqueue) == 0U;
+    osalSysUnlockFromISR();
+    if (full != sdp->com_rxfull) {
+      sdp->com_rxfull = full;
+      _sim_watch_fd(sdp->com_data, !full, false);
+    }
+  }
 }
 
 static bool inint(SerialDriver *sdp) {
 
   if (sdp->com_data != -1) {
-    int i;
-    uint8_t data[32];
+    uint8_t data[SERIAL_BUFFERS_SIZE];
+    size_t space;
+    ssize_t n;
 
     /*
-     * Input.
+     * Input, the received chunk is moved into the queue at once. Only the
+     * data fitting the queue is read, the rest is left in the host buffers
+     * as a form of flow control.
      */
-    int n = recv(sdp->com_data, data, sizeof(data), 0);
-    switch (n) {
-    case 0:
-      close(sdp->com_data);
-      sdp->com_data = -1;
-      osalSysLockFromISR();
-      chnAddFlagsI(sdp, CHN_DISCONNECTED);
-      osalSysUnlockFromISR();
+    sd_sys_lock();
+    space = iqGetEmptyI(&sdp->iqueue);
+    sd_sys_unlock();
+    if (space == 0U)
       return false;
-    case -1:
-      if (errno == EWOULDBLOCK)
-        return false;
-      close(sdp->com_data);
-      sdp->com_data = -1;
+    if (space > sizeof(data))
+      space = sizeof(data);
+
+    n = read(sdp->com_data, data, space);
+    if (n == 0) {
+      disconnect(sdp);
       return false;
     }
-    for (i = 0; i < n; i++) {
-      osalSysLockFromISR();
-      sdIncomingDataI(sdp, data[i]);
-      osalSysUnlockFromISR();
+    if (n < 0) {
+      if ((errno == EWOULDBLOCK) || (errno == EAGAIN) || (errno == EINTR))
+        return false;
+      disconnect(sdp);
+      return false;
     }
+
+    sd_sys_lock();
+    if (iqIsEmptyI(&sdp->iqueue))
+      chnAddFlagsI(sdp, CHN_INPUT_AVAILABLE);
+    (void) iqWriteI(&sdp->iqueue, data, (size_t)n);
+    sd_sys_unlock();
     return true;
   }
   return false;
@@ -182,39 +301,98 @@ static bool inint(SerialDriver *sdp) {
 static bool outint(SerialDriver *sdp) {
 
   if (sdp->com_data != -1) {
-    int n;
-    uint8_t data[1];
+    ssize_t n;
 
     /*
-     * Input.
+     * Output, the queue is drained in bulk into the transmit buffer, data
+     * not accepted by the host is retried on the next check.
      */
-    osalSysLockFromISR();
-    n = sdRequestDataI(sdp);
-    osalSysUnlockFromISR();
-    if (n < 0)
-      return false;
-    data[0] = (uint8_t)n;
-    n = send(sdp->com_data, data, sizeof(data), 0);
-    switch (n) {
-    case 0:
-      close(sdp->com_data);
-      sdp->com_data = -1;
-      osalSysLockFromISR();
-      chnAddFlagsI(sdp, CHN_DISCONNECTED);
-      osalSysUnlockFromISR();
-      return false;
-    case -1:
-      if (errno == EWOULDBLOCK)
+    if (sdp->com_txpos >= sdp->com_txcnt) {
+      sd_sys_lock();
+      sdp->com_txcnt = oqReadI(&sdp->oqueue, sdp->com_txbuf,
+                               sizeof(sdp->com_txbuf));
+      sdp->com_txpos = 0U;
+      if (sdp->com_txcnt == 0U)
+        chnAddFlagsI(sdp, CHN_OUTPUT_EMPTY);
+      sd_sys_unlock();
+      if (sdp->com_txcnt == 0U)
         return false;
-      close(sdp->com_data);
-      sdp->com_data = -1;
+    }
+
+    n = write(sdp->com_data, sdp->com_txbuf + sdp->com_txpos,
+              sdp->com_txcnt - sdp->com_txpos);
+    if (n < 0) {
+      if ((errno == EWOULDBLOCK) || (errno == EAGAIN) || (errno == EINTR))
+        return false;
+      disconnect(sdp);
       return false;
     }
+    sdp->com_txpos += (size_t)n;
     return true;
   }
   return false;
 }
 
+#if SIM_SERIAL_USE_IRQ_THREAD || defined(__DOXYGEN__)
+/**
+ * @brief   Sockets bottom half.
+ * @details Processes connections and data transfers until there is nothing
+ *          more to do.
+ *
+ * @param[in] arg       pointer to a @p SerialDriver object
+ */
+static void sd_bh(void *arg) {
+  SerialDriver *sdp = (SerialDriver *)arg;
+
+  while (connint(sdp) || inint(sdp) || outint(sdp)) {
+  }
+
+  osalSysLock();
+  osalOsRescheduleS();
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Sockets top half.
+ * @details Checks the sockets state without performing any transfer, the
+ *          bottom half is raised if there is something to do.
+ *
+ * @param[in] sdp       pointer to a @p SerialDriver object
+ * @return              @p true if the bottom half has been raised.
+ */
+static bool sd_th(SerialDriver *sdp) {
+  struct pollfd pfd;
+
+  if (sdp->com_data == -1) {
+    /* A pseudo terminal master is connected as soon as it is writable.*/
+    pfd.fd     = sdp->com_listen;
+    pfd.events = sdp->com_type == SIM_SERIAL_PTY ? POLLOUT : POLLIN;
+  }
+  else {
+    pfd.fd     = sdp->com_data;
+    pfd.events = sdp->com_rxfull ? 0 : POLLIN;
+    osalSysLockFromISR();
+    if ((sdp->com_txpos < sdp->com_txcnt) || !oqIsEmptyI(&sdp->oqueue)) {
+      pfd.events |= POLLOUT;
+    }
+    osalSysUnlockFromISR();
+    if (pfd.events == 0) {
+      return false;
+    }
+  }
+
+  if ((pfd.fd == -1) || (poll(&pfd, 1, 0) <= 0)) {
+    return false;
+  }
+
+  osalSysLockFromISR();
+  (void) chIRQRaiseI(&sdp->com_irq);
+  osalSysUnlockFromISR();
+
+  return true;
+}
+#endif /* SIM_SERIAL_USE_IRQ_THREAD */
+
 /*===========================================================================*/
 /* Driver interrupt handlers.                                                */
 /*===========================================================================*/
@@ -228,11 +406,19 @@ static bool outint(SerialDriver *sdp) {
  */
 void sd_lld_init(void) {
 
+  /* Writing to a closed connection must not kill the simulator, the error
+     is handled as a disconnection.*/
+  signal(SIGPIPE, SIG_IGN);
+
 #if USE_SIM_SERIAL1
   sdObjectInit(&SD1, NULL, NULL);
   SD1.com_listen = -1;
   SD1.com_data = -1;
   SD1.com_name = "SD1";
+  SD1.com_rxfull = false;
+#if SIM_SERIAL_USE_IRQ_THREAD
+  chIRQSourceObjectInit(&SD1.com_irq, &sd_irq_thread, sd_bh, &SD1);
+#endif
 #endif
 
 #if USE_SIM_SERIAL2
@@ -240,6 +426,10 @@ void sd_lld_init(void) {
   SD2.com_listen = -1;
   SD2.com_data = -1;
   SD2.com_name = "SD2";
+  SD2.com_rxfull = false;
+#if SIM_SERIAL_USE_IRQ_THREAD
+  chIRQSourceObjectInit(&SD2.com_irq, &sd_irq_thread, sd_bh, &SD2);
+#endif
 #endif
 }
 
@@ -256,14 +446,26 @@ void sd_lld_start(SerialDriver *sdp, const SerialConfig *config) {
   if (config == NULL)
     config = &default_config;
 
+#if SIM_SERIAL_USE_IRQ_THREAD
+  /* The IRQ thread is shared by all the serial drivers, it has a higher
+     priority than the caller so a reschedule is required before the
+     kernel is unlocked by sdStart().*/
+  if (chIRQThreadGetThreadX(&sd_irq_thread) == NULL) {
+    (void) chIRQThreadCreateI(&sd_irq_thread,
+                              wa_sd_irq_thread, sizeof(wa_sd_irq_thread),
+                              SIM_SERIAL_IRQ_THREAD_PRIORITY, "serial_irq");
+    osalOsRescheduleS();
+  }
+#endif
+
 #if USE_SIM_SERIAL1
   if (sdp == &SD1)
-    init(&SD1, SIM_SD1_PORT);
+    init(&SD1, SIM_SD1_TYPE, SIM_SD1_PORT, SIM_SD1_PATH);
 #endif
 
 #if USE_SIM_SERIAL2
   if (sdp == &SD2)
-    init(&SD2, SIM_SD2_PORT);
+    init(&SD2, SIM_SD2_TYPE, SIM_SD2_PORT, SIM_SD2_PATH);
 #endif
 }
 
@@ -284,9 +486,19 @@ bool sd_lld_interrupt_pending(void) {
 
   OSAL_IRQ_PROLOGUE();
 
+  /* Updated before checking the sockets and before any idle wait.*/
+  inwatch(&SD1);
+  inwatch(&SD2);
+
+#if SIM_SERIAL_USE_IRQ_THREAD
+  /* Both top halves must run, the bottom halves are coalesced.*/
+  b = sd_th(&SD1);
+  b = sd_th(&SD2) || b;
+#else
   b =  connint(&SD1) || connint(&SD2) ||
        inint(&SD1)   || inint(&SD2)   ||
        outint(&SD1)  || outint(&SD2);
+#endif
 
   OSAL_IRQ_EPILOGUE();
 
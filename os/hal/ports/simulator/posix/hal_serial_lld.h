@@ -27,6 +27,19 @@
 
 #if HAL_USE_SERIAL || defined(__DOXYGEN__)
 
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Simulated serial port types
+ * @{
+ */
+#define SIM_SERIAL_TCP                      0U
+#define SIM_SERIAL_UNIX                     1U
+#define SIM_SERIAL_PTY                      2U
+/** @} */
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -58,20 +71,85 @@
 #define USE_SIM_SERIAL2                     TRUE
 #endif
 
+/**
+ * @brief   Port type for SD1.
+ * @details Can be @p SIM_SERIAL_TCP, @p SIM_SERIAL_UNIX for an UNIX-domain
+ *          socket or @p SIM_SERIAL_PTY for a pseudo terminal, the pseudo
+ *          terminal name is printed on startup.
+ */
+#if !defined(SIM_SD1_TYPE) || defined(__DOXYGEN__)
+#define SIM_SD1_TYPE                        SIM_SERIAL_TCP
+#endif
+
+/**
+ * @brief   Port type for SD2.
+ */
+#if !defined(SIM_SD2_TYPE) || defined(__DOXYGEN__)
+#define SIM_SD2_TYPE                        SIM_SERIAL_TCP
+#endif
+
 /**
  * @brief   Listen port for SD1.
  */
-#if !defined(SD1_PORT) || defined(__DOXYGEN__)
+#if !defined(SIM_SD1_PORT) || defined(__DOXYGEN__)
 #define SIM_SD1_PORT                        29001
 #endif
 
 /**
  * @brief   Listen port for SD2.
  */
-#if !defined(SD2_PORT) || defined(__DOXYGEN__)
+#if !defined(SIM_SD2_PORT) || defined(__DOXYGEN__)
 #define SIM_SD2_PORT                        29002
 #endif
 
+/**
+ * @brief   UNIX-domain socket path for SD1.
+ */
+#if !defined(SIM_SD1_PATH) || defined(__DOXYGEN__)
+#define SIM_SD1_PATH                        "/tmp/chibios_sd1"
+#endif
+
+/**
+ * @brief   UNIX-domain socket path for SD2.
+ */
+#if !defined(SIM_SD2_PATH) || defined(__DOXYGEN__)
+#define SIM_SD2_PATH                        "/tmp/chibios_sd2"
+#endif
+
+/**
+ * @brief   Threaded interrupt handler switch.
+ * @details If set to @p TRUE the socket processing is performed by bottom
+ *          halves executed by a kernel IRQ thread, the simulated interrupt
+ *          handler only checks the sockets state.
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_IRQ_THREADS.
+ */
+#if !defined(SIM_SERIAL_USE_IRQ_THREAD) || defined(__DOXYGEN__)
+#define SIM_SERIAL_USE_IRQ_THREAD           FALSE
+#endif
+
+/**
+ * @brief   Serial IRQ thread priority.
+ */
+#if !defined(SIM_SERIAL_IRQ_THREAD_PRIORITY) || defined(__DOXYGEN__)
+#define SIM_SERIAL_IRQ_THREAD_PRIORITY      (HIGHPRIO - 1)
+#endif
+
+/**
+ * @brief   Serial IRQ thread stack size.
+ */
+#if !defined(SIM_SERIAL_IRQ_THREAD_STACK_SIZE) || defined(__DOXYGEN__)
+#define SIM_SERIAL_IRQ_THREAD_STACK_SIZE    4096
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (SIM_SERIAL_USE_IRQ_THREAD == TRUE) && (CH_CFG_USE_IRQ_THREADS != TRUE)
+#error "SIM_SERIAL_USE_IRQ_THREAD requires CH_CFG_USE_IRQ_THREADS"
+#endif
+
 /*===========================================================================*/
 /* Unsupported event flags and custom events.                                */
 /*===========================================================================*/
@@ -91,6 +169,13 @@
 typedef struct {
 } SerialConfig;
 
+#if (SIM_SERIAL_USE_IRQ_THREAD == TRUE) || defined(__DOXYGEN__)
+#define _serial_driver_irq_data                                             \
+  irq_source_t              com_irq;
+#else
+#define _serial_driver_irq_data
+#endif
+
 /**
  * @brief   @p SerialDriver specific data.
  */
@@ -112,7 +197,19 @@ typedef struct {
   /* Data socket for simulated serial port.*/                               \
   int                       com_data;                                       \
   /* Port readable name.*/                                                  \
-  const char                *com_name;
+  const char                *com_name;                                      \
+  /* Port type.*/                                                           \
+  unsigned                  com_type;                                       \
+  /* Transmit buffer, drained from the output queue in bulk.*/              \
+  uint8_t                   com_txbuf[SERIAL_BUFFERS_SIZE];                 \
+  /* Number of bytes in the transmit buffer.*/                              \
+  size_t                    com_txcnt;                                      \
+  /* Number of bytes already transmitted.*/                                 \
+  size_t                    com_txpos;                                      \
+  /* Input not watched because the input queue is full.*/                   \
+  bool                      com_rxfull;                                     \
+  /* IRQ source for the sockets bottom half.*/                              \
+  _serial_driver_irq_data
 
 /*===========================================================================*/
 /* External declarations.                                                    */
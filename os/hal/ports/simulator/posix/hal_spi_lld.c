@@ -0,0 +1,327 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/posix/hal_spi_lld.c
+ * @brief   Posix simulator SPI subsystem low level driver source.
+ * @details The bus transfers are routed to the device model attached to
+ *          the current configuration. The data is exchanged with the
+ *          model when an operation starts, the operation completes after
+ *          the time the frames would take on the bus at the configured
+ *          clock, the waiting thread is suspended meanwhile as it would
+ *          be with a DMA transfer.
+ *
+ * @addtogroup POSIX_SPI
+ * @{
+ */
+
+#include "hal.h"
+
+#if (HAL_USE_SPI == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Frame read from an idle bus.
+ */
+#define SIM_SPI_IDLE_FRAME                  0xFFU
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   SPI1 driver identifier.
+ */
+SPIDriver SPID1;
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the bus time of a number of frames.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] n         number of frames
+ * @return              The time in nanoseconds.
+ */
+static uint64_t spi_sim_bus_time(SPIDriver *spip, size_t n) {
+
+  if (spip->config->clock == 0U) {
+    return 0U;
+  }
+
+  return ((uint64_t)n * 8U * 1000000000U) / spip->config->clock;
+}
+
+/**
+ * @brief   Exchanges a frame with the selected device model.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] frame     frame on MOSI
+ * @return              The frame on MISO.
+ */
+static uint8_t spi_sim_exchange_frame(SPIDriver *spip, uint8_t frame) {
+  const sim_spi_device_t *devp = spip->selected;
+
+  spip->frames++;
+  if (devp == NULL) {
+    return SIM_SPI_IDLE_FRAME;
+  }
+
+  return devp->exchange(devp->instance, frame);
+}
+
+/**
+ * @brief   Starts a transfer.
+ * @details The data is exchanged immediately, the completion is notified
+ *          after the bus time.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] n         number of frames
+ * @param[in] txbuf     the pointer to the transmit buffer or @p NULL
+ * @param[out] rxbuf    the pointer to the receive buffer or @p NULL
+ */
+static void spi_sim_start_transfer(SPIDriver *spip, size_t n,
+                                   const uint8_t *txbuf, uint8_t *rxbuf) {
+  size_t i;
+
+  for (i = 0U; i < n; i++) {
+    uint8_t frame;
+
+    frame = spi_sim_exchange_frame(spip, txbuf != NULL ?
+                                         txbuf[i] : SIM_SPI_IDLE_FRAME);
+    if (rxbuf != NULL) {
+      rxbuf[i] = frame;
+    }
+  }
+
+  spip->deadline = _sim_get_time_ns() + spi_sim_bus_time(spip, n);
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Simulated SPI interrupt.
+ *
+ * @return              @p true if an interrupt has been served.
+ *
+ * @notapi
+ */
+bool spi_lld_interrupt_pending(void) {
+
+  if (SPID1.state != SPI_ACTIVE) {
+    return false;
+  }
+
+  if (_sim_get_time_ns() < SPID1.deadline) {
+    _sim_set_wakeup(SPID1.deadline);
+    return false;
+  }
+
+  OSAL_IRQ_PROLOGUE();
+
+  _spi_isr_code(&SPID1);
+
+  OSAL_IRQ_EPILOGUE();
+
+  return true;
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level SPI driver initialization.
+ *
+ * @notapi
+ */
+void spi_lld_init(void) {
+
+  spiObjectInit(&SPID1);
+  SPID1.selected = NULL;
+}
+
+/**
+ * @brief   Configures and activates the SPI peripheral.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ *
+ * @notapi
+ */
+void spi_lld_start(SPIDriver *spip) {
+
+  if (spip->state == SPI_STOP) {
+    spip->frames = 0U;
+  }
+}
+
+/**
+ * @brief   Deactivates the SPI peripheral.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ *
+ * @notapi
+ */
+void spi_lld_stop(SPIDriver *spip) {
+
+  if (spip->state == SPI_READY) {
+    spi_lld_unselect(spip);
+  }
+}
+
+/**
+ * @brief   Asserts the slave select signal and prepares for transfers.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ *
+ * @notapi
+ */
+void spi_lld_select(SPIDriver *spip) {
+  const sim_spi_device_t *devp = spip->config->device;
+
+  spi_lld_unselect(spip);
+  spip->selected = devp;
+  if ((devp != NULL) && (devp->select != NULL)) {
+    devp->select(devp->instance, true);
+  }
+}
+
+/**
+ * @brief   Deasserts the slave select signal.
+ * @details The previously selected peripheral is unselected.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ *
+ * @notapi
+ */
+void spi_lld_unselect(SPIDriver *spip) {
+  const sim_spi_device_t *devp = spip->selected;
+
+  spip->selected = NULL;
+  if ((devp != NULL) && (devp->select != NULL)) {
+    devp->select(devp->instance, false);
+  }
+}
+
+/**
+ * @brief   Ignores data on the SPI bus.
+ * @details This asynchronous function starts the transmission of a series of
+ *          idle words on the SPI bus and ignores the received data.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] n         number of words to be ignored
+ *
+ * @notapi
+ */
+void spi_lld_ignore(SPIDriver *spip, size_t n) {
+
+  spi_sim_start_transfer(spip, n, NULL, NULL);
+}
+
+/**
+ * @brief   Exchanges data on the SPI bus.
+ * @details This asynchronous function starts a simultaneous transmit/receive
+ *          operation.
+ * @post    At the end of the operation the configured callback is invoked.
+ * @note    The buffers are organized as uint8_t arrays, frames are always
+ *          8 bits wide.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] n         number of words to be exchanged
+ * @param[in] txbuf     the pointer to the transmit buffer
+ * @param[out] rxbuf    the pointer to the receive buffer
+ *
+ * @notapi
+ */
+void spi_lld_exchange(SPIDriver *spip, size_t n,
+                      const void *txbuf, void *rxbuf) {
+
+  spi_sim_start_transfer(spip, n, txbuf, rxbuf);
+}
+
+/**
+ * @brief   Sends data over the SPI bus.
+ * @details This asynchronous function starts a transmit operation.
+ * @post    At the end of the operation the configured callback is invoked.
+ * @note    The buffers are organized as uint8_t arrays, frames are always
+ *          8 bits wide.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] n         number of words to send
+ * @param[in] txbuf     the pointer to the transmit buffer
+ *
+ * @notapi
+ */
+void spi_lld_send(SPIDriver *spip, size_t n, const void *txbuf) {
+
+  spi_sim_start_transfer(spip, n, txbuf, NULL);
+}
+
+/**
+ * @brief   Receives data from the SPI bus.
+ * @details This asynchronous function starts a receive operation.
+ * @post    At the end of the operation the configured callback is invoked.
+ * @note    The buffers are organized as uint8_t arrays, frames are always
+ *          8 bits wide.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] n         number of words to receive
+ * @param[out] rxbuf    the pointer to the receive buffer
+ *
+ * @notapi
+ */
+void spi_lld_receive(SPIDriver *spip, size_t n, void *rxbuf) {
+
+  spi_sim_start_transfer(spip, n, NULL, rxbuf);
+}
+
+/**
+ * @brief   Exchanges one frame using a polled wait.
+ * @details This synchronous function exchanges one frame using a polled
+ *          synchronization method. This function is useful when exchanging
+ *          small amount of data on high speed channels, usually in this
+ *          situation is much more efficient just wait for completion using
+ *          polling than suspending the thread waiting for an interrupt.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] frame     the data frame to send over the SPI bus
+ * @return              The received data frame from the SPI bus.
+ *
+ * @notapi
+ */
+uint16_t spi_lld_polled_exchange(SPIDriver *spip, uint16_t frame) {
+
+  frame = (uint16_t)spi_sim_exchange_frame(spip, (uint8_t)frame);
+  _sim_busy_wait(spi_sim_bus_time(spip, 1U));
+
+  return frame;
+}
+
+#endif /* HAL_USE_SPI == TRUE */
+
+/** @} */
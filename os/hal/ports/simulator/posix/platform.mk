@@ -1,6 +1,12 @@
 # List of all the Posix platform files.
 PLATFORMSRC = ${CHIBIOS}/os/hal/ports/simulator/posix/hal_lld.c \
+              ${CHIBIOS}/os/hal/ports/simulator/posix/hal_can_lld.c \
+              ${CHIBIOS}/os/hal/ports/simulator/posix/hal_efl_lld.c \
+              ${CHIBIOS}/os/hal/ports/simulator/posix/hal_i2c_lld.c \
+              ${CHIBIOS}/os/hal/ports/simulator/posix/hal_mac_lld.c \
+              ${CHIBIOS}/os/hal/ports/simulator/posix/hal_sdc_lld.c \
               ${CHIBIOS}/os/hal/ports/simulator/posix/hal_serial_lld.c \
+              ${CHIBIOS}/os/hal/ports/simulator/posix/hal_spi_lld.c \
               ${CHIBIOS}/os/hal/ports/simulator/console.c \
               ${CHIBIOS}/os/hal/ports/simulator/hal_pal_lld.c \
               ${CHIBIOS}/os/hal/ports/simulator/hal_st_lld.c
@@ -221,6 +221,12 @@
 #error "CH_CFG_USE_MUTEXES not defined in chconf.h"
 #endif
 
+/* Poll sets are not supported by NIL, the related OSLIB hooks are
+   disabled.*/
+#if !defined(CH_CFG_USE_POLL)
+#define CH_CFG_USE_POLL                     FALSE
+#endif
+
 #if !defined(CH_DBG_STATISTICS) || defined(__DOXYGEN__)
 #error "CH_DBG_STATISTICS not defined in chconf.h"
 #endif
@@ -0,0 +1,201 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    oslib/include/chlfqueues.h
+ * @brief   Lock-free queues macros and structures.
+ *
+ * @addtogroup oslib_lfqueues
+ * @{
+ */
+
+#ifndef CHLFQUEUES_H
+#define CHLFQUEUES_H
+
+#if (CH_CFG_USE_LF_QUEUES == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Cache line size used to separate producers and consumers data.
+ */
+#if !defined(CH_LFQ_CACHE_LINE_SIZE) || defined(__DOXYGEN__)
+#define CH_LFQ_CACHE_LINE_SIZE              32U
+#endif
+
+/**
+ * @brief   Atomic load with acquire semantic.
+ * @note    The default implementation uses the GCC atomic builtins, other
+ *          compilers require a specific definition.
+ */
+#if !defined(CH_LFQ_LOAD) || defined(__DOXYGEN__)
+#define CH_LFQ_LOAD(p)                      __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#endif
+
+/**
+ * @brief   Atomic store with release semantic.
+ * @note    The default implementation uses the GCC atomic builtins, other
+ *          compilers require a specific definition.
+ */
+#if !defined(CH_LFQ_STORE) || defined(__DOXYGEN__)
+#define CH_LFQ_STORE(p, v)                  __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#endif
+
+/**
+ * @brief   Atomic compare and swap.
+ * @details If the variable pointed by @p p is equal to the value pointed
+ *          by @p expp then it is replaced with @p v and the macro
+ *          evaluates to @p true, else the current value of the variable
+ *          is written in @p expp and the macro evaluates to @p false.
+ * @note    The default implementation uses the GCC atomic builtins, it
+ *          requires an architecture with exclusive access instructions,
+ *          ARMv6-M cores require a specific definition.
+ */
+#if !defined(CH_LFQ_CAS) || defined(__DOXYGEN__)
+#define CH_LFQ_CAS(p, expp, v)                                              \
+  __atomic_compare_exchange_n(p, expp, v, true,                             \
+                              __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)
+#endif
+
+/**
+ * @brief   Full memory barrier.
+ * @note    The default implementation uses the GCC atomic builtins, other
+ *          compilers require a specific definition.
+ */
+#if !defined(CH_LFQ_FULL_BARRIER) || defined(__DOXYGEN__)
+#define CH_LFQ_FULL_BARRIER()               __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (CH_LFQ_CACHE_LINE_SIZE & (CH_LFQ_CACHE_LINE_SIZE - 1U)) != 0U
+#error "CH_LFQ_CACHE_LINE_SIZE must be a power of two"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a lock-free queue cell.
+ */
+typedef struct {
+  volatile size_t       seq;            /**< @brief Cell sequence number.   */
+  msg_t                 msg;            /**< @brief Cell message.           */
+} lfq_cell_t;
+
+/**
+ * @brief   Structure representing a lock-free queue object.
+ * @note    Positions are free-running counters, the cell index is obtained
+ *          by masking them.
+ */
+typedef struct {
+  lfq_cell_t            *cells;         /**< @brief Pointer to the cells
+                                                    array.                  */
+  size_t                mask;           /**< @brief Cells number minus one. */
+  uint8_t               pad1[CH_LFQ_CACHE_LINE_SIZE];
+  volatile size_t       wrpos;          /**< @brief Producers position.     */
+  uint8_t               pad2[CH_LFQ_CACHE_LINE_SIZE];
+  volatile size_t       rdpos;          /**< @brief Consumers position.     */
+  uint8_t               pad3[CH_LFQ_CACHE_LINE_SIZE];
+  volatile cnt_t        nw;             /**< @brief Number of waiting
+                                                    writers.                */
+  threads_queue_t       qw;             /**< @brief Queued writers.         */
+  volatile cnt_t        nr;             /**< @brief Number of waiting
+                                                    readers.                */
+  threads_queue_t       qr;             /**< @brief Queued readers.         */
+} lf_queue_t;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chLFQObjectInit(lf_queue_t *lfqp, lfq_cell_t *cells, size_t n);
+  msg_t chLFQPostX(lf_queue_t *lfqp, msg_t msg);
+  msg_t chLFQFetchX(lf_queue_t *lfqp, msg_t *msgp);
+  msg_t chLFQPostTimeout(lf_queue_t *lfqp, msg_t msg, sysinterval_t timeout);
+  msg_t chLFQFetchTimeout(lf_queue_t *lfqp, msg_t *msgp,
+                          sysinterval_t timeout);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the lock-free queue size as number of messages.
+ *
+ * @param[in] lfqp      the pointer to an initialized @p lf_queue_t object
+ * @return              The size of the queue.
+ *
+ * @xclass
+ */
+static inline size_t chLFQGetSizeX(const lf_queue_t *lfqp) {
+
+  return lfqp->mask + (size_t)1;
+}
+
+/**
+ * @brief   Returns the number of used message slots into a lock-free queue.
+ * @note    The returned value is just a snapshot, producers and consumers
+ *          can change it at any time.
+ *
+ * @param[in] lfqp      the pointer to an initialized @p lf_queue_t object
+ * @return              The number of queued messages.
+ *
+ * @xclass
+ */
+static inline size_t chLFQGetUsedCountX(const lf_queue_t *lfqp) {
+  size_t rdpos = lfqp->rdpos;
+  size_t wrpos = lfqp->wrpos;
+
+  /* Positions are read separately, the difference could be transiently
+     out of range.*/
+  if ((ptrdiff_t)(wrpos - rdpos) < (ptrdiff_t)0) {
+    return (size_t)0;
+  }
+  if (wrpos - rdpos > chLFQGetSizeX(lfqp)) {
+    return chLFQGetSizeX(lfqp);
+  }
+
+  return wrpos - rdpos;
+}
+
+#endif /* CH_CFG_USE_LF_QUEUES == TRUE */
+
+#endif /* CHLFQUEUES_H */
+
+/** @} */
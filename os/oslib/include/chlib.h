@@ -120,6 +120,22 @@
 #error "CH_CFG_USE_JOBS not defined in chconf.h"
 #endif
 
+#if !defined(CH_CFG_USE_RINGS)
+#error "CH_CFG_USE_RINGS not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_USE_LF_QUEUES)
+#error "CH_CFG_USE_LF_QUEUES not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_USE_REC_QUEUES)
+#error "CH_CFG_USE_REC_QUEUES not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_USE_REF_BUFFERS)
+#error "CH_CFG_USE_REF_BUFFERS not defined in chconf.h"
+#endif
+
 /* Objects factory options checks.*/
 #if !defined(CH_CFG_USE_FACTORY)
 #error "CH_CFG_USE_FACTORY not defined in chconf.h"
@@ -186,6 +202,10 @@
 #undef CH_CFG_USE_OBJ_CACHES
 #undef CH_CFG_USE_DELEGATES
 #undef CH_CFG_USE_JOBS
+#undef CH_CFG_USE_RINGS
+#undef CH_CFG_USE_LF_QUEUES
+#undef CH_CFG_USE_REC_QUEUES
+#undef CH_CFG_USE_REF_BUFFERS
 
 #define CH_CFG_USE_HEAP                     FALSE
 #define CH_CFG_USE_MEMPOOLS                 FALSE
@@ -194,6 +214,10 @@
 #define CH_CFG_USE_OBJ_CACHES               FALSE
 #define CH_CFG_USE_DELEGATES                FALSE
 #define CH_CFG_USE_JOBS                     FALSE
+#define CH_CFG_USE_RINGS                    FALSE
+#define CH_CFG_USE_LF_QUEUES                FALSE
+#define CH_CFG_USE_REC_QUEUES               FALSE
+#define CH_CFG_USE_REF_BUFFERS              FALSE
 
 #endif /* (CH_CUSTOMER_LIC_OSLIB == FALSE) ||
           (CH_LICENSE_FEATURES == CH_FEATURES_BASIC) */
@@ -235,6 +259,10 @@
 #include "chobjcaches.h"
 #include "chdelegates.h"
 #include "chjobs.h"
+#include "chrings.h"
+#include "chlfqueues.h"
+#include "chrecqueues.h"
+#include "chrefbufs.h"
 #include "chfactory.h"
 
 /*===========================================================================*/
@@ -60,6 +60,10 @@ typedef struct {
   bool                  reset;          /**< @brief True in reset state.    */
   threads_queue_t       qw;             /**< @brief Queued writers.         */
   threads_queue_t       qr;             /**< @brief Queued readers.         */
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+  ch_queue_t            pollers;        /**< @brief Queue of the poll items
+                                                    linked to this mailbox. */
+#endif
 } mailbox_t;
 
 /*===========================================================================*/
@@ -75,6 +79,7 @@ typedef struct {
  * @param[in] buffer    pointer to the mailbox buffer array of @p msg_t
  * @param[in] size      number of @p msg_t elements in the buffer array
  */
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
 #define _MAILBOX_DATA(name, buffer, size) {                                 \
   (msg_t *)(buffer),                                                        \
   (msg_t *)(buffer) + size,                                                 \
@@ -84,7 +89,20 @@ typedef struct {
   false,                                                                    \
   _THREADS_QUEUE_DATA(name.qw),                                             \
   _THREADS_QUEUE_DATA(name.qr),                                             \
+  _CH_QUEUE_DATA(name.pollers),                                             \
 }
+#else
+#define _MAILBOX_DATA(name, buffer, size) {                                 \
+  (msg_t *)(buffer),                                                        \
+  (msg_t *)(buffer) + size,                                                 \
+  (msg_t *)(buffer),                                                        \
+  (msg_t *)(buffer),                                                        \
+  (size_t)0,                                                                \
+  false,                                                                    \
+  _THREADS_QUEUE_DATA(name.qw),                                             \
+  _THREADS_QUEUE_DATA(name.qr),                                             \
+}
+#endif
 
 /**
  * @brief   Static mailbox initializer.
@@ -117,6 +135,10 @@ extern "C" {
   msg_t chMBFetchTimeout(mailbox_t *mbp, msg_t *msgp, sysinterval_t timeout);
   msg_t chMBFetchTimeoutS(mailbox_t *mbp, msg_t *msgp, sysinterval_t timeout);
   msg_t chMBFetchI(mailbox_t *mbp, msg_t *msgp);
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+  void chPollAddMailbox(poll_set_t *psp, poll_item_t *pip,
+                        mailbox_t *mbp, unsigned dir);
+#endif
 #ifdef __cplusplus
 }
 #endif
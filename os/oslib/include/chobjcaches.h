@@ -46,6 +46,13 @@
 #define OC_FLAG_FORGET                      0x00000020U
 /** @} */
 
+/**
+ * @brief   Multiplier used by the default hash function.
+ * @note    It is the 32 bits golden ratio constant used in Fibonacci
+ *          hashing.
+ */
+#define OC_HASH_MULTIPLIER                  0x9E3779B9U
+
 /*===========================================================================*/
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -187,6 +194,32 @@ struct ch_oc_object {
   void                  *dptr;
 };
 
+/**
+ * @brief   Type of an hash table statistics structure.
+ */
+typedef struct {
+  /**
+   * @brief   Number of elements in the hash table.
+   */
+  ucnt_t                hashn;
+  /**
+   * @brief   Number of hash table elements with at least one object.
+   */
+  ucnt_t                used;
+  /**
+   * @brief   Number of objects currently in the hash table.
+   */
+  ucnt_t                objects;
+  /**
+   * @brief   Length of the longest collisions list.
+   */
+  ucnt_t                maxchain;
+  /**
+   * @brief   Number of objects sharing their slot with other objects.
+   */
+  ucnt_t                collisions;
+} oc_hash_stats_t;
+
 /**
  * @brief   Structure representing a cache object.
  */
@@ -252,6 +285,10 @@ extern "C" {
                          void *objvp,
                          oc_readf_t readf,
                          oc_writef_t writef);
+  oc_hash_header_t *chCacheResizeHash(objects_cache_t *ocp,
+                                      ucnt_t hashn,
+                                      oc_hash_header_t *hashp);
+  void chCacheGetHashStats(objects_cache_t *ocp, oc_hash_stats_t *hsp);
   oc_object_t *chCacheGetObject(objects_cache_t *ocp,
                                 uint32_t group,
                                 uint32_t key);
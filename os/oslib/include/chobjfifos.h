@@ -423,6 +423,38 @@ static inline msg_t chFifoReceiveObjectTimeout(objects_fifo_t *ofp,
   return chMBFetchTimeout(&ofp->mbx, (msg_t *)objpp, timeout);
 }
 
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Adds an objects FIFO to a poll set.
+ * @details An objects FIFO is ready for @p CH_POLL_IN when there are sent
+ *          objects to be received, it is ready for @p CH_POLL_OUT when
+ *          there are free objects to be taken.
+ * @note    The item is linked to the internal mailbox or to the internal
+ *          free objects semaphore depending on the direction,
+ *          @p chPollGetObjectX() returns a pointer to that object.
+ *
+ * @param[in] psp       pointer to the @p poll_set_t structure
+ * @param[out] pip      pointer to the @p poll_item_t structure
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[in] dir       the polling direction:
+ *                      - @a CH_POLL_IN sent objects available.
+ *                      - @a CH_POLL_OUT free objects available.
+ *                      .
+ *
+ * @api
+ */
+static inline void chPollAddObjectsFifo(poll_set_t *psp, poll_item_t *pip,
+                                        objects_fifo_t *ofp, unsigned dir) {
+
+  if (dir == CH_POLL_IN) {
+    chPollAddMailbox(psp, pip, &ofp->mbx, CH_POLL_IN);
+  }
+  else {
+    chPollAddSemaphore(psp, pip, &ofp->free.sem);
+  }
+}
+#endif /* CH_CFG_USE_POLL == TRUE */
+
 #endif /* CH_CFG_USE_OBJ_FIFOS == TRUE */
 
 #endif /* CHOBJFIFOS_H */
@@ -69,12 +69,27 @@ typedef struct {
   semaphore_t           wsem;           /**< @brief Write access semaphore. */
   semaphore_t           rsem;           /**< @brief Read access semaphore.  */
 #endif
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+  ch_queue_t            pollers;        /**< @brief Queue of the poll items
+                                                    linked to this pipe.    */
+#endif
 } pipe_t;
 
 /*===========================================================================*/
 /* Module macros.                                                            */
 /*===========================================================================*/
 
+/**
+ * @brief   Pollers queue part of a static pipe initializer.
+ *
+ * @param[in] name      the name of the pipe variable
+ */
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+#define __PIPE_POLLERS_DATA(name) _CH_QUEUE_DATA(name.pollers),
+#else
+#define __PIPE_POLLERS_DATA(name)
+#endif
+
 /**
  * @brief   Data part of a static pipe initializer.
  * @details This macro should be used when statically initializing a
@@ -97,6 +112,7 @@ typedef struct {
   _MUTEX_DATA(name.cmtx),                                                   \
   _MUTEX_DATA(name.wmtx),                                                   \
   _MUTEX_DATA(name.rmtx),                                                   \
+  __PIPE_POLLERS_DATA(name)                                                 \
 }
 #else /* CH_CFG_USE_MUTEXES == FALSE */
 #define _PIPE_DATA(name, buffer, size) {                                    \
@@ -111,6 +127,7 @@ typedef struct {
   _SEMAPHORE_DATA(name.csem, (cnt_t)1),                                     \
   _SEMAPHORE_DATA(name.wsem, (cnt_t)1),                                     \
   _SEMAPHORE_DATA(name.rsem, (cnt_t)1),                                     \
+  __PIPE_POLLERS_DATA(name)                                                 \
 }
 #endif /* CH_CFG_USE_MUTEXES == FALSE */
 
@@ -139,6 +156,10 @@ extern "C" {
                             size_t n, sysinterval_t timeout);
   size_t chPipeReadTimeout(pipe_t *pp, uint8_t *bp,
                            size_t n, sysinterval_t timeout);
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+  void chPollAddPipe(poll_set_t *psp, poll_item_t *pip,
+                     pipe_t *pp, unsigned dir);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,240 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    oslib/include/chrecqueues.h
+ * @brief   Record queues macros and structures.
+ *
+ * @addtogroup oslib_recqueues
+ * @{
+ */
+
+#ifndef CHRECQUEUES_H
+#define CHRECQUEUES_H
+
+#if (CH_CFG_USE_REC_QUEUES == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Records alignment.
+ * @note    Records are aligned to the natural alignment of the
+ *          architecture, the queue buffer must be aligned the same way.
+ */
+#define RQ_ALIGN                            PORT_NATURAL_ALIGN
+
+/**
+ * @brief   Size field value marking a padding record.
+ * @note    Padding records are inserted when a record does not fit
+ *          the space left at the end of the queue buffer.
+ */
+#define RQ_PADDING                          ((size_t)-1)
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a record header.
+ */
+typedef struct {
+  size_t                size;           /**< @brief Size of the record
+                                                    payload.                */
+} rq_header_t;
+
+/**
+ * @brief   Structure representing a record queue object.
+ */
+typedef struct {
+  uint8_t               *buffer;        /**< @brief Pointer to the queue
+                                                    buffer.                 */
+  size_t                size;           /**< @brief Size of the queue
+                                                    buffer.                 */
+  size_t                wroff;          /**< @brief Write offset.           */
+  size_t                rdoff;          /**< @brief Read offset.            */
+  size_t                cnt;            /**< @brief Used bytes including
+                                                    headers and padding.    */
+  size_t                rsvoff;         /**< @brief Offset of the current
+                                                    reservation.            */
+  bool                  wrbusy;         /**< @brief A reservation is in
+                                                    progress.               */
+  bool                  rdbusy;         /**< @brief A record is being
+                                                    accessed.               */
+  bool                  reset;          /**< @brief True in reset state.    */
+  threads_queue_t       qw;             /**< @brief Queued writers.         */
+  threads_queue_t       qr;             /**< @brief Queued readers.         */
+} record_queue_t;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Size of a queued record including header and alignment.
+ *
+ * @param[in] n         size of the record payload
+ * @return              The space taken by the record into a queue buffer.
+ */
+#define RQ_RECORD_SIZE(n)                                                   \
+  MEM_ALIGN_NEXT(sizeof (rq_header_t) + (size_t)(n), RQ_ALIGN)
+
+/**
+ * @brief   Size of a buffer able to contain a number of records.
+ * @note    The buffer has room for an extra maximum size record minus
+ *          the alignment, this is the worst case padding left at the end
+ *          of the buffer on wrap around when records have different sizes.
+ *
+ * @param[in] n         maximum size of the records payload
+ * @param[in] depth     number of records
+ * @return              The required buffer size.
+ */
+#define RQ_BUFFER_SIZE(n, depth)                                            \
+  ((RQ_RECORD_SIZE(n) * ((size_t)(depth) + (size_t)1)) - (size_t)RQ_ALIGN)
+
+/**
+ * @brief   Data part of a static record queue initializer.
+ * @details This macro should be used when statically initializing a
+ *          record queue that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the record queue variable
+ * @param[in] buffer    pointer to the queue buffer array of @p uint8_t
+ * @param[in] size      size of the queue buffer array, it must be a
+ *                      multiple of @p RQ_ALIGN
+ */
+#define _RECORD_QUEUE_DATA(name, buffer, size) {                            \
+  (uint8_t *)(buffer),                                                      \
+  (size_t)(size),                                                           \
+  (size_t)0,                                                                \
+  (size_t)0,                                                                \
+  (size_t)0,                                                                \
+  (size_t)0,                                                                \
+  false,                                                                    \
+  false,                                                                    \
+  false,                                                                    \
+  _THREADS_QUEUE_DATA(name.qw),                                             \
+  _THREADS_QUEUE_DATA(name.qr),                                             \
+}
+
+/**
+ * @brief   Static record queue initializer.
+ * @details Statically initialized record queues require no explicit
+ *          initialization using @p chRQObjectInit().
+ *
+ * @param[in] name      the name of the record queue variable
+ * @param[in] buffer    pointer to the queue buffer array of @p uint8_t
+ * @param[in] size      size of the queue buffer array, it must be a
+ *                      multiple of @p RQ_ALIGN
+ */
+#define RECORD_QUEUE_DECL(name, buffer, size)                               \
+  record_queue_t name = _RECORD_QUEUE_DATA(name, buffer, size)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chRQObjectInit(record_queue_t *rqp, uint8_t *buf, size_t n);
+  void chRQReset(record_queue_t *rqp);
+  void chRQResetI(record_queue_t *rqp);
+  void *chRQReserveTimeout(record_queue_t *rqp, size_t n,
+                           sysinterval_t timeout);
+  void *chRQReserveTimeoutS(record_queue_t *rqp, size_t n,
+                            sysinterval_t timeout);
+  void *chRQReserveI(record_queue_t *rqp, size_t n);
+  void chRQCommit(record_queue_t *rqp, size_t n);
+  void chRQCommitI(record_queue_t *rqp, size_t n);
+  void *chRQPeekTimeout(record_queue_t *rqp, size_t *np,
+                        sysinterval_t timeout);
+  void *chRQPeekTimeoutS(record_queue_t *rqp, size_t *np,
+                         sysinterval_t timeout);
+  void *chRQPeekI(record_queue_t *rqp, size_t *np);
+  void chRQRelease(record_queue_t *rqp);
+  void chRQReleaseI(record_queue_t *rqp);
+  msg_t chRQSendTimeout(record_queue_t *rqp, const void *p, size_t n,
+                        sysinterval_t timeout);
+  msg_t chRQSendI(record_queue_t *rqp, const void *p, size_t n);
+  msg_t chRQReceiveTimeout(record_queue_t *rqp, void *p, size_t *np,
+                           sysinterval_t timeout);
+  msg_t chRQReceiveI(record_queue_t *rqp, void *p, size_t *np);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the record queue buffer size.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @return              The size of the queue buffer.
+ *
+ * @xclass
+ */
+static inline size_t chRQGetSizeX(const record_queue_t *rqp) {
+
+  return rqp->size;
+}
+
+/**
+ * @brief   Returns the used space into a record queue.
+ * @note    The returned value includes records headers and padding.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @return              The number of used bytes.
+ *
+ * @iclass
+ */
+static inline size_t chRQGetUsedCountI(const record_queue_t *rqp) {
+
+  chDbgCheckClassI();
+
+  return rqp->cnt;
+}
+
+/**
+ * @brief   Terminates the reset state.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ *
+ * @xclass
+ */
+static inline void chRQResumeX(record_queue_t *rqp) {
+
+  rqp->reset = false;
+}
+
+#endif /* CH_CFG_USE_REC_QUEUES == TRUE */
+
+#endif /* CHRECQUEUES_H */
+
+/** @} */
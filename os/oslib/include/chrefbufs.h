@@ -0,0 +1,246 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    oslib/include/chrefbufs.h
+ * @brief   Reference-counted buffers macros and structures.
+ *
+ * @addtogroup oslib_refbufs
+ * @{
+ */
+
+#ifndef CHREFBUFS_H
+#define CHREFBUFS_H
+
+#if (CH_CFG_USE_REF_BUFFERS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if CH_CFG_USE_MEMPOOLS == FALSE
+#error "CH_CFG_USE_REF_BUFFERS requires CH_CFG_USE_MEMPOOLS"
+#endif
+
+#if CH_CFG_USE_SEMAPHORES == FALSE
+#error "CH_CFG_USE_REF_BUFFERS requires CH_CFG_USE_SEMAPHORES"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a reference-counted buffer.
+ */
+typedef struct ch_refbuf refbuf_t;
+
+/**
+ * @brief   Type of an external memory release callback.
+ * @note    The callback is invoked from within the system lock zone when
+ *          the last reference to a buffer wrapping external memory is
+ *          released.
+ *
+ * @param[in] rbp       pointer to the buffer being freed
+ */
+typedef void (*refbuf_release_t)(refbuf_t *rbp);
+
+/**
+ * @brief   Type of a buffers pool.
+ */
+typedef struct {
+  guarded_memory_pool_t pool;           /**< @brief Pool of buffer objects. */
+  size_t                size;           /**< @brief Size of the data area
+                                                    of each buffer.         */
+} refbuf_pool_t;
+
+/**
+ * @brief   Structure representing a reference-counted buffer.
+ * @details The buffer data area follows the structure in the same pool
+ *          object unless the buffer wraps external memory.
+ */
+struct ch_refbuf {
+  refbuf_t              *next;          /**< @brief Next buffer in the
+                                                    chain or @p NULL.       */
+  refbuf_pool_t         *owner;         /**< @brief Owner pool.             */
+  uint8_t               *buffer;        /**< @brief Start of the data area. */
+  size_t                size;           /**< @brief Size of the data area.  */
+  uint8_t               *data;          /**< @brief Start of the payload.   */
+  size_t                len;            /**< @brief Payload length.         */
+  cnt_t                 refs;           /**< @brief References counter.     */
+  refbuf_release_t      release;        /**< @brief External memory release
+                                                    callback or @p NULL.    */
+  void                  *link;          /**< @brief Application defined
+                                                    field.                  */
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Size of a buffer header within a pool object.
+ */
+#define REFBUF_HEADER_SIZE                                                  \
+  MEM_ALIGN_NEXT(sizeof (refbuf_t), PORT_NATURAL_ALIGN)
+
+/**
+ * @brief   Size of a pool object able to contain a buffer.
+ * @note    Pools of buffers wrapping external memory can use a zero size.
+ *
+ * @param[in] n         size of the buffers data area
+ * @return              The size of a pool object.
+ */
+#define REFBUF_OBJECT_SIZE(n)                                               \
+  (REFBUF_HEADER_SIZE + MEM_ALIGN_NEXT((size_t)(n), PORT_NATURAL_ALIGN))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chRBPoolObjectInit(refbuf_pool_t *rbpp, size_t size);
+  void chRBPoolLoadArray(refbuf_pool_t *rbpp, void *p, size_t n);
+  refbuf_t *chRBAllocTimeout(refbuf_pool_t *rbpp, size_t headroom,
+                             sysinterval_t timeout);
+  refbuf_t *chRBAllocI(refbuf_pool_t *rbpp, size_t headroom);
+  refbuf_t *chRBWrapTimeout(refbuf_pool_t *rbpp, void *p, size_t n,
+                            refbuf_release_t release, void *link,
+                            sysinterval_t timeout);
+  refbuf_t *chRBWrapI(refbuf_pool_t *rbpp, void *p, size_t n,
+                      refbuf_release_t release, void *link);
+  refbuf_t *chRBAddRef(refbuf_t *rbp);
+  refbuf_t *chRBAddRefI(refbuf_t *rbp);
+  void chRBRelease(refbuf_t *rbp);
+  void chRBReleaseI(refbuf_t *rbp);
+  void *chRBPushHead(refbuf_t *rbp, size_t n);
+  void *chRBPullHead(refbuf_t *rbp, size_t n);
+  void *chRBPutTail(refbuf_t *rbp, size_t n);
+  void chRBTrimTail(refbuf_t *rbp, size_t n);
+  void chRBChain(refbuf_t *rbp, refbuf_t *next);
+  size_t chRBGetChainLength(const refbuf_t *rbp);
+  size_t chRBCopyOut(const refbuf_t *rbp, size_t offset, void *p, size_t n);
+#if (CH_CFG_USE_PIPES == TRUE) || defined(__DOXYGEN__)
+  msg_t chRBPipeWriteTimeout(pipe_t *pp, refbuf_t *rbp,
+                             sysinterval_t timeout);
+  msg_t chRBPipeReadTimeout(pipe_t *pp, refbuf_t **rbpp,
+                            sysinterval_t timeout);
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns a pointer to the buffer payload.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @return              Pointer to the payload.
+ *
+ * @xclass
+ */
+static inline void *chRBGetDataX(const refbuf_t *rbp) {
+
+  return (void *)rbp->data;
+}
+
+/**
+ * @brief   Returns the buffer payload length.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @return              The payload length.
+ *
+ * @xclass
+ */
+static inline size_t chRBGetLengthX(const refbuf_t *rbp) {
+
+  return rbp->len;
+}
+
+/**
+ * @brief   Returns the space available in front of the payload.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @return              The headroom size.
+ *
+ * @xclass
+ */
+static inline size_t chRBGetHeadroomX(const refbuf_t *rbp) {
+
+  return (size_t)(rbp->data - rbp->buffer);
+}
+
+/**
+ * @brief   Returns the space available after the payload.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @return              The tailroom size.
+ *
+ * @xclass
+ */
+static inline size_t chRBGetTailroomX(const refbuf_t *rbp) {
+
+  return rbp->size - chRBGetHeadroomX(rbp) - rbp->len;
+}
+
+/**
+ * @brief   Returns the next buffer in a chain.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @return              The next buffer.
+ * @retval NULL         if the buffer is the last of the chain.
+ *
+ * @xclass
+ */
+static inline refbuf_t *chRBGetNextX(const refbuf_t *rbp) {
+
+  return rbp->next;
+}
+
+/**
+ * @brief   Returns the buffer application-defined link.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @return              The application-defined link.
+ *
+ * @xclass
+ */
+static inline void *chRBGetLinkX(const refbuf_t *rbp) {
+
+  return rbp->link;
+}
+
+#endif /* CH_CFG_USE_REF_BUFFERS == TRUE */
+
+#endif /* CHREFBUFS_H */
+
+/** @} */
@@ -0,0 +1,237 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    oslib/include/chrings.h
+ * @brief   Lock-free rings macros and structures.
+ *
+ * @addtogroup oslib_rings
+ * @{
+ */
+
+#ifndef CHRINGS_H
+#define CHRINGS_H
+
+#if (CH_CFG_USE_RINGS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Cache line size used to separate producer and consumer data.
+ * @details The producer and consumer indexes are kept in different cache
+ *          lines in order to avoid false sharing between cores or bus
+ *          masters.
+ */
+#if !defined(CH_RINGS_CACHE_LINE_SIZE) || defined(__DOXYGEN__)
+#define CH_RINGS_CACHE_LINE_SIZE            32U
+#endif
+
+/**
+ * @brief   Acquire memory barrier.
+ * @details Buffer accesses following the barrier cannot be moved before
+ *          the index read preceding it.
+ * @note    The default implementation uses the GCC atomic builtins, other
+ *          compilers require a specific definition.
+ */
+#if !defined(CH_RINGS_ACQUIRE_BARRIER) || defined(__DOXYGEN__)
+#define CH_RINGS_ACQUIRE_BARRIER()          __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+/**
+ * @brief   Release memory barrier.
+ * @details Buffer accesses preceding the barrier cannot be moved after
+ *          the index update following it.
+ * @note    The default implementation uses the GCC atomic builtins, other
+ *          compilers require a specific definition.
+ */
+#if !defined(CH_RINGS_RELEASE_BARRIER) || defined(__DOXYGEN__)
+#define CH_RINGS_RELEASE_BARRIER()          __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+/**
+ * @brief   Full memory barrier.
+ * @details The barrier orders an index update with respect to the
+ *          following check for a waiting thread.
+ * @note    The default implementation uses the GCC atomic builtins, other
+ *          compilers require a specific definition.
+ */
+#if !defined(CH_RINGS_FULL_BARRIER) || defined(__DOXYGEN__)
+#define CH_RINGS_FULL_BARRIER()             __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (CH_RINGS_CACHE_LINE_SIZE & (CH_RINGS_CACHE_LINE_SIZE - 1U)) != 0U
+#error "CH_RINGS_CACHE_LINE_SIZE must be a power of two"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a ring span.
+ * @details A span describes a contiguous area of the ring as two segments,
+ *          the second segment is used when the area wraps around the end
+ *          of the ring buffer, else its size is zero.
+ */
+typedef struct {
+  uint8_t               *p1;            /**< @brief First segment.          */
+  size_t                n1;             /**< @brief First segment size.     */
+  uint8_t               *p2;            /**< @brief Second segment.         */
+  size_t                n2;             /**< @brief Second segment size.    */
+} ring_span_t;
+
+/**
+ * @brief   Structure representing a lock-free ring object.
+ * @note    Indexes are free-running counters, the position in the buffer
+ *          is obtained by masking them.
+ */
+typedef struct {
+  uint8_t               *buffer;        /**< @brief Pointer to the ring
+                                                    buffer.                 */
+  size_t                mask;           /**< @brief Buffer size minus one.  */
+  volatile size_t       head;           /**< @brief Producer index.         */
+  thread_reference_t    wtr;            /**< @brief Waiting writer.         */
+  uint8_t               pad1[CH_RINGS_CACHE_LINE_SIZE];
+  volatile size_t       tail;           /**< @brief Consumer index.         */
+  thread_reference_t    rtr;            /**< @brief Waiting reader.         */
+  uint8_t               pad2[CH_RINGS_CACHE_LINE_SIZE];
+} ring_t;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Data part of a static ring initializer.
+ * @details This macro should be used when statically initializing a
+ *          ring that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the ring variable
+ * @param[in] buffer    pointer to the ring buffer array of @p uint8_t
+ * @param[in] size      number of @p uint8_t elements in the buffer array,
+ *                      must be a power of two
+ */
+#define _RING_DATA(name, buffer, size) {                                    \
+  (uint8_t *)(buffer),                                                      \
+  (size_t)(size) - (size_t)1,                                               \
+  (size_t)0,                                                                \
+  NULL,                                                                     \
+  {0},                                                                      \
+  (size_t)0,                                                                \
+  NULL,                                                                     \
+  {0}                                                                       \
+}
+
+/**
+ * @brief   Static ring initializer.
+ * @details Statically initialized rings require no explicit
+ *          initialization using @p chRingObjectInit().
+ *
+ * @param[in] name      the name of the ring variable
+ * @param[in] buffer    pointer to the ring buffer array of @p uint8_t
+ * @param[in] size      number of @p uint8_t elements in the buffer array,
+ *                      must be a power of two
+ */
+#define RING_DECL(name, buffer, size)                                       \
+  ring_t name = _RING_DATA(name, buffer, size)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chRingObjectInit(ring_t *rp, uint8_t *buf, size_t n);
+  size_t chRingGetWriteSpanX(ring_t *rp, ring_span_t *sp);
+  void chRingCommitX(ring_t *rp, size_t n);
+  size_t chRingGetReadSpanX(ring_t *rp, ring_span_t *sp);
+  void chRingReleaseX(ring_t *rp, size_t n);
+  size_t chRingWriteX(ring_t *rp, const uint8_t *bp, size_t n);
+  size_t chRingReadX(ring_t *rp, uint8_t *bp, size_t n);
+  size_t chRingWriteTimeout(ring_t *rp, const uint8_t *bp,
+                            size_t n, sysinterval_t timeout);
+  size_t chRingReadTimeout(ring_t *rp, uint8_t *bp,
+                           size_t n, sysinterval_t timeout);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the ring buffer size as number of bytes.
+ *
+ * @param[in] rp        the pointer to an initialized @p ring_t object
+ * @return              The size of the ring.
+ *
+ * @xclass
+ */
+static inline size_t chRingGetSizeX(const ring_t *rp) {
+
+  return rp->mask + (size_t)1;
+}
+
+/**
+ * @brief   Returns the number of used byte slots into a ring.
+ * @note    The returned value is exact only if invoked by the producer
+ *          or the consumer, for other callers it is just a snapshot.
+ *
+ * @param[in] rp        the pointer to an initialized @p ring_t object
+ * @return              The number of queued bytes.
+ *
+ * @xclass
+ */
+static inline size_t chRingGetUsedCountX(const ring_t *rp) {
+
+  return rp->head - rp->tail;
+}
+
+/**
+ * @brief   Returns the number of free byte slots into a ring.
+ * @note    The returned value is exact only if invoked by the producer
+ *          or the consumer, for other callers it is just a snapshot.
+ *
+ * @param[in] rp        the pointer to an initialized @p ring_t object
+ * @return              The number of empty byte slots.
+ *
+ * @xclass
+ */
+static inline size_t chRingGetFreeCountX(const ring_t *rp) {
+
+  return chRingGetSizeX(rp) - chRingGetUsedCountX(rp);
+}
+
+#endif /* CH_CFG_USE_RINGS == TRUE */
+
+#endif /* CHRINGS_H */
+
+/** @} */
@@ -35,6 +35,18 @@ endif
 ifneq ($(findstring CH_CFG_USE_DELEGATES TRUE,$(CHLIBCONF)),)
 LIBSRC += $(CHIBIOS)/os/oslib/src/chdelegates.c
 endif
+ifneq ($(findstring CH_CFG_USE_RINGS TRUE,$(CHLIBCONF)),)
+LIBSRC += $(CHIBIOS)/os/oslib/src/chrings.c
+endif
+ifneq ($(findstring CH_CFG_USE_LF_QUEUES TRUE,$(CHLIBCONF)),)
+LIBSRC += $(CHIBIOS)/os/oslib/src/chlfqueues.c
+endif
+ifneq ($(findstring CH_CFG_USE_REC_QUEUES TRUE,$(CHLIBCONF)),)
+LIBSRC += $(CHIBIOS)/os/oslib/src/chrecqueues.c
+endif
+ifneq ($(findstring CH_CFG_USE_REF_BUFFERS TRUE,$(CHLIBCONF)),)
+LIBSRC += $(CHIBIOS)/os/oslib/src/chrefbufs.c
+endif
 ifneq ($(findstring CH_CFG_USE_FACTORY TRUE,$(CHLIBCONF)),)
 LIBSRC += $(CHIBIOS)/os/oslib/src/chfactory.c
 endif
@@ -46,6 +58,10 @@ LIBSRC := $(CHIBIOS)/os/oslib/src/chmboxes.c \
           $(CHIBIOS)/os/oslib/src/chpipes.c \
           $(CHIBIOS)/os/oslib/src/chobjcaches.c \
           $(CHIBIOS)/os/oslib/src/chdelegates.c \
+          $(CHIBIOS)/os/oslib/src/chrings.c \
+          $(CHIBIOS)/os/oslib/src/chlfqueues.c \
+          $(CHIBIOS)/os/oslib/src/chrecqueues.c \
+          $(CHIBIOS)/os/oslib/src/chrefbufs.c \
           $(CHIBIOS)/os/oslib/src/chfactory.c
 endif
 
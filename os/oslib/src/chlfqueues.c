@@ -0,0 +1,369 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    oslib/src/chlfqueues.c
+ * @brief   Lock-free queues code.
+ * @details Bounded multiple producers, multiple consumers lock-free queues.
+ *          <h2>Operation mode</h2>
+ *          A lock-free queue is a bounded FIFO of messages, any number of
+ *          threads and ISRs can post and fetch messages concurrently.<br>
+ *          Each cell of the queue carries a sequence number telling if the
+ *          cell is ready to be written or read for a given position,
+ *          producers and consumers claim positions using an atomic compare
+ *          and swap, interrupts are never masked.<br>
+ *          Threads can also wait for the queue to become non-full or
+ *          non-empty, the kernel is entered by producers and consumers
+ *          only when a thread is waiting on the other side of the queue.
+ *          Operations defined for lock-free queues:
+ *          - <b>Post</b>: Adds a message to the queue.
+ *          - <b>Fetch</b>: A message is read from the queue and removed.
+ *          .
+ * @pre     In order to use the lock-free queues APIs the
+ *          @p CH_CFG_USE_LF_QUEUES option must be enabled in @p chconf.h.
+ * @note    Compatible with RT and NIL.
+ * @note    The queue size must be a power of two.
+ *
+ * @addtogroup oslib_lfqueues
+ * @{
+ */
+
+#include "ch.h"
+
+#if (CH_CFG_USE_LF_QUEUES == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Wakes up a thread waiting on the other side of the queue.
+ *
+ * @param[in] np        pointer to the waiting threads counter
+ * @param[in] tqp       pointer to the threads queue
+ *
+ * @notapi
+ */
+static void lfq_wakeup(volatile cnt_t *np, threads_queue_t *tqp) {
+
+  /* Making sure that the cell update is visible before checking for
+     waiting threads.*/
+  CH_LFQ_FULL_BARRIER();
+
+  if (*np > (cnt_t)0) {
+    syssts_t sts = chSysGetStatusAndLockX();
+    chThdDequeueNextI(tqp, MSG_OK);
+    chSysRestoreStatusX(sts);
+  }
+}
+
+/**
+ * @brief   Checks if the cell at the current producers position is free.
+ *
+ * @param[in] lfqp      the pointer to an initialized @p lf_queue_t object
+ * @return              The cell status.
+ *
+ * @notapi
+ */
+static bool lfq_can_post(lf_queue_t *lfqp) {
+  size_t pos = CH_LFQ_LOAD(&lfqp->wrpos);
+
+  return CH_LFQ_LOAD(&lfqp->cells[pos & lfqp->mask].seq) == pos;
+}
+
+/**
+ * @brief   Checks if the cell at the current consumers position is filled.
+ *
+ * @param[in] lfqp      the pointer to an initialized @p lf_queue_t object
+ * @return              The cell status.
+ *
+ * @notapi
+ */
+static bool lfq_can_fetch(lf_queue_t *lfqp) {
+  size_t pos = CH_LFQ_LOAD(&lfqp->rdpos);
+
+  return CH_LFQ_LOAD(&lfqp->cells[pos & lfqp->mask].seq) == pos + (size_t)1;
+}
+
+/**
+ * @brief   Waits for a condition on the queue.
+ *
+ * @param[in] lfqp      the pointer to an initialized @p lf_queue_t object
+ * @param[in] np        pointer to the waiting threads counter
+ * @param[in] tqp       pointer to the threads queue
+ * @param[in] readyf    function checking for the awaited condition
+ * @param[in] timeout   the number of ticks before the operation timeouts
+ * @return              The wait result.
+ *
+ * @notapi
+ */
+static msg_t lfq_wait(lf_queue_t *lfqp, volatile cnt_t *np,
+                      threads_queue_t *tqp,
+                      bool (*readyf)(lf_queue_t *lfqp),
+                      sysinterval_t timeout) {
+  msg_t msg;
+
+  chSysLock();
+
+  /* The counter is incremented before checking the queue again, a
+     producer or consumer acting after the check is guaranteed to see
+     it.*/
+  *np = *np + (cnt_t)1;
+  CH_LFQ_FULL_BARRIER();
+  if (readyf(lfqp)) {
+    msg = MSG_OK;
+  }
+  else {
+    msg = chThdEnqueueTimeoutS(tqp, timeout);
+  }
+  *np = *np - (cnt_t)1;
+
+  chSysUnlock();
+
+  return msg;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a @p lf_queue_t object.
+ *
+ * @param[out] lfqp     the pointer to the @p lf_queue_t structure to be
+ *                      initialized
+ * @param[in] cells     pointer to the cells array
+ * @param[in] n         number of elements in the cells array, must be a
+ *                      power of two
+ *
+ * @init
+ */
+void chLFQObjectInit(lf_queue_t *lfqp, lfq_cell_t *cells, size_t n) {
+  size_t i;
+
+  chDbgCheck((lfqp != NULL) && (cells != NULL) && (n > (size_t)0) &&
+             ((n & (n - (size_t)1)) == (size_t)0));
+
+  for (i = (size_t)0; i < n; i++) {
+    cells[i].seq = i;
+  }
+  lfqp->cells = cells;
+  lfqp->mask  = n - (size_t)1;
+  lfqp->wrpos = (size_t)0;
+  lfqp->rdpos = (size_t)0;
+  lfqp->nw    = (cnt_t)0;
+  chThdQueueObjectInit(&lfqp->qw);
+  lfqp->nr    = (cnt_t)0;
+  chThdQueueObjectInit(&lfqp->qr);
+}
+
+/**
+ * @brief   Posts a message into a lock-free queue without waiting.
+ * @details If a thread is waiting for messages then it is resumed.
+ * @note    Interrupts are masked only in order to resume a waiting thread,
+ *          if consumers never wait then this function can be called also
+ *          from interrupts not allowed to use the kernel.
+ *
+ * @param[in] lfqp      the pointer to an initialized @p lf_queue_t object
+ * @param[in] msg       the message to be posted on the queue
+ * @return              The operation status.
+ * @retval MSG_OK       if a message has been correctly posted.
+ * @retval MSG_TIMEOUT  if the queue is full and the message cannot be
+ *                      posted.
+ *
+ * @xclass
+ */
+msg_t chLFQPostX(lf_queue_t *lfqp, msg_t msg) {
+  lfq_cell_t *cp;
+  size_t pos;
+
+  chDbgCheck(lfqp != NULL);
+
+  pos = CH_LFQ_LOAD(&lfqp->wrpos);
+  while (true) {
+    ptrdiff_t diff;
+
+    cp   = &lfqp->cells[pos & lfqp->mask];
+    diff = (ptrdiff_t)(CH_LFQ_LOAD(&cp->seq) - pos);
+    if (diff == (ptrdiff_t)0) {
+      /* The cell is free, trying to claim the position, on failure the
+         current position is reloaded by the CAS.*/
+      if (CH_LFQ_CAS(&lfqp->wrpos, &pos, pos + (size_t)1)) {
+        break;
+      }
+    }
+    else if (diff < (ptrdiff_t)0) {
+      /* The cell still contains a message from the previous round, the
+         queue is full.*/
+      return MSG_TIMEOUT;
+    }
+    else {
+      /* Another producer claimed the position.*/
+      pos = CH_LFQ_LOAD(&lfqp->wrpos);
+    }
+  }
+
+  /* Filling the cell then making it available to consumers.*/
+  cp->msg = msg;
+  CH_LFQ_STORE(&cp->seq, pos + (size_t)1);
+
+  lfq_wakeup(&lfqp->nr, &lfqp->qr);
+
+  return MSG_OK;
+}
+
+/**
+ * @brief   Retrieves a message from a lock-free queue without waiting.
+ * @details If a thread is waiting for space then it is resumed.
+ * @note    Interrupts are masked only in order to resume a waiting thread,
+ *          if producers never wait then this function can be called also
+ *          from interrupts not allowed to use the kernel.
+ *
+ * @param[in] lfqp      the pointer to an initialized @p lf_queue_t object
+ * @param[out] msgp     pointer to a message variable for the received
+ *                      message
+ * @return              The operation status.
+ * @retval MSG_OK       if a message has been correctly fetched.
+ * @retval MSG_TIMEOUT  if the queue is empty and a message cannot be
+ *                      fetched.
+ *
+ * @xclass
+ */
+msg_t chLFQFetchX(lf_queue_t *lfqp, msg_t *msgp) {
+  lfq_cell_t *cp;
+  size_t pos;
+
+  chDbgCheck((lfqp != NULL) && (msgp != NULL));
+
+  pos = CH_LFQ_LOAD(&lfqp->rdpos);
+  while (true) {
+    ptrdiff_t diff;
+
+    cp   = &lfqp->cells[pos & lfqp->mask];
+    diff = (ptrdiff_t)(CH_LFQ_LOAD(&cp->seq) - (pos + (size_t)1));
+    if (diff == (ptrdiff_t)0) {
+      /* The cell is filled, trying to claim the position, on failure the
+         current position is reloaded by the CAS.*/
+      if (CH_LFQ_CAS(&lfqp->rdpos, &pos, pos + (size_t)1)) {
+        break;
+      }
+    }
+    else if (diff < (ptrdiff_t)0) {
+      /* The cell has not been filled yet, the queue is empty.*/
+      return MSG_TIMEOUT;
+    }
+    else {
+      /* Another consumer claimed the position.*/
+      pos = CH_LFQ_LOAD(&lfqp->rdpos);
+    }
+  }
+
+  /* Emptying the cell then making it available to producers for the
+     next round.*/
+  *msgp = cp->msg;
+  CH_LFQ_STORE(&cp->seq, pos + lfqp->mask + (size_t)1);
+
+  lfq_wakeup(&lfqp->nw, &lfqp->qw);
+
+  return MSG_OK;
+}
+
+/**
+ * @brief   Posts a message into a lock-free queue.
+ * @details The invoking thread waits until an empty slot in the queue
+ *          becomes available or the specified time runs out.
+ *
+ * @param[in] lfqp      the pointer to an initialized @p lf_queue_t object
+ * @param[in] msg       the message to be posted on the queue
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if a message has been correctly posted.
+ * @retval MSG_TIMEOUT  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t chLFQPostTimeout(lf_queue_t *lfqp, msg_t msg, sysinterval_t timeout) {
+  msg_t rdymsg;
+
+  while (chLFQPostX(lfqp, msg) != MSG_OK) {
+    rdymsg = lfq_wait(lfqp, &lfqp->nw, &lfqp->qw, lfq_can_post, timeout);
+    if (rdymsg != MSG_OK) {
+      return rdymsg;
+    }
+  }
+
+  return MSG_OK;
+}
+
+/**
+ * @brief   Retrieves a message from a lock-free queue.
+ * @details The invoking thread waits until a message is posted in the
+ *          queue or the specified time runs out.
+ *
+ * @param[in] lfqp      the pointer to an initialized @p lf_queue_t object
+ * @param[out] msgp     pointer to a message variable for the received
+ *                      message
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if a message has been correctly fetched.
+ * @retval MSG_TIMEOUT  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t chLFQFetchTimeout(lf_queue_t *lfqp, msg_t *msgp,
+                        sysinterval_t timeout) {
+  msg_t rdymsg;
+
+  while (chLFQFetchX(lfqp, msgp) != MSG_OK) {
+    rdymsg = lfq_wait(lfqp, &lfqp->nr, &lfqp->qr, lfq_can_fetch, timeout);
+    if (rdymsg != MSG_OK) {
+      return rdymsg;
+    }
+  }
+
+  return MSG_OK;
+}
+
+#endif /* CH_CFG_USE_LF_QUEUES == TRUE */
+
+/** @} */
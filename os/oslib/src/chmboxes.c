@@ -70,6 +70,20 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+static bool mb_poll_in(poll_item_t *pip) {
+  mailbox_t *mbp = (mailbox_t *)pip->objp;
+
+  return mbp->reset || (chMBGetUsedCountI(mbp) > (size_t)0);
+}
+
+static bool mb_poll_out(poll_item_t *pip) {
+  mailbox_t *mbp = (mailbox_t *)pip->objp;
+
+  return mbp->reset || (chMBGetFreeCountI(mbp) > (size_t)0);
+}
+#endif
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -96,6 +110,9 @@ void chMBObjectInit(mailbox_t *mbp, msg_t *buf, size_t n) {
   mbp->reset  = false;
   chThdQueueObjectInit(&mbp->qw);
   chThdQueueObjectInit(&mbp->qr);
+#if CH_CFG_USE_POLL == TRUE
+  ch_queue_init(&mbp->pollers);
+#endif
 }
 
 /**
@@ -141,6 +158,9 @@ void chMBResetI(mailbox_t *mbp) {
   mbp->reset = true;
   chThdDequeueAllI(&mbp->qw, MSG_RESET);
   chThdDequeueAllI(&mbp->qr, MSG_RESET);
+#if CH_CFG_USE_POLL == TRUE
+  chPollSignalI(&mbp->pollers);
+#endif
 }
 
 /**
@@ -213,6 +233,9 @@ msg_t chMBPostTimeoutS(mailbox_t *mbp, msg_t msg, sysinterval_t timeout) {
 
       /* If there is a reader waiting then makes it ready.*/
       chThdDequeueNextI(&mbp->qr, MSG_OK);
+#if CH_CFG_USE_POLL == TRUE
+      chPollSignalI(&mbp->pollers);
+#endif
       chSchRescheduleS();
 
       return MSG_OK;
@@ -260,6 +283,9 @@ msg_t chMBPostI(mailbox_t *mbp, msg_t msg) {
 
     /* If there is a reader waiting then makes it ready.*/
     chThdDequeueNextI(&mbp->qr, MSG_OK);
+#if CH_CFG_USE_POLL == TRUE
+    chPollSignalI(&mbp->pollers);
+#endif
 
     return MSG_OK;
   }
@@ -338,6 +364,9 @@ msg_t chMBPostAheadTimeoutS(mailbox_t *mbp, msg_t msg, sysinterval_t timeout) {
 
       /* If there is a reader waiting then makes it ready.*/
       chThdDequeueNextI(&mbp->qr, MSG_OK);
+#if CH_CFG_USE_POLL == TRUE
+      chPollSignalI(&mbp->pollers);
+#endif
       chSchRescheduleS();
 
       return MSG_OK;
@@ -385,6 +414,9 @@ msg_t chMBPostAheadI(mailbox_t *mbp, msg_t msg) {
 
     /* If there is a reader waiting then makes it ready.*/
     chThdDequeueNextI(&mbp->qr, MSG_OK);
+#if CH_CFG_USE_POLL == TRUE
+    chPollSignalI(&mbp->pollers);
+#endif
 
     return MSG_OK;
   }
@@ -463,6 +495,9 @@ msg_t chMBFetchTimeoutS(mailbox_t *mbp, msg_t *msgp, sysinterval_t timeout) {
 
       /* If there is a writer waiting then makes it ready.*/
       chThdDequeueNextI(&mbp->qw, MSG_OK);
+#if CH_CFG_USE_POLL == TRUE
+      chPollSignalI(&mbp->pollers);
+#endif
       chSchRescheduleS();
 
       return MSG_OK;
@@ -510,6 +545,9 @@ msg_t chMBFetchI(mailbox_t *mbp, msg_t *msgp) {
 
     /* If there is a writer waiting then makes it ready.*/
     chThdDequeueNextI(&mbp->qw, MSG_OK);
+#if CH_CFG_USE_POLL == TRUE
+    chPollSignalI(&mbp->pollers);
+#endif
 
     return MSG_OK;
   }
@@ -517,6 +555,34 @@ msg_t chMBFetchI(mailbox_t *mbp, msg_t *msgp) {
   /* No message, immediate timeout.*/
   return MSG_TIMEOUT;
 }
+
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Adds a mailbox to a poll set.
+ * @details A mailbox is ready for @p CH_POLL_IN when it contains messages,
+ *          it is ready for @p CH_POLL_OUT when it has free slots. A mailbox
+ *          in reset state is always ready.
+ *
+ * @param[in] psp       pointer to the @p poll_set_t structure
+ * @param[out] pip      pointer to the @p poll_item_t structure
+ * @param[in] mbp       the pointer to an initialized @p mailbox_t object
+ * @param[in] dir       the polling direction:
+ *                      - @a CH_POLL_IN messages available.
+ *                      - @a CH_POLL_OUT free slots available.
+ *                      .
+ *
+ * @api
+ */
+void chPollAddMailbox(poll_set_t *psp, poll_item_t *pip,
+                      mailbox_t *mbp, unsigned dir) {
+
+  chDbgCheck(mbp != NULL);
+
+  chPollAddObject(psp, pip, &mbp->pollers,
+                  dir == CH_POLL_IN ? mb_poll_in : mb_poll_out,
+                  (void *)mbp);
+}
+#endif /* CH_CFG_USE_POLL == TRUE */
 #endif /* CH_CFG_USE_MAILBOXES == TRUE */
 
 /** @} */
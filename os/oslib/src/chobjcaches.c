@@ -34,6 +34,12 @@
  *          should be dimensioned to minimize the risk of hash collisions,
  *          a factor of two is usually acceptable, it depends on the specific
  *          application requirements.<br>
+ *          The default hash function is a multiplicative (Fibonacci) hash
+ *          of both the group and the key, so structured key patterns,
+ *          for example sequential blocks in several groups, are spread
+ *          over the whole table. Collisions can be monitored at runtime
+ *          and the hash table can be replaced by a larger one without
+ *          losing the cached objects.<br>
  *          Operations defined for caches:
  *          - <b>Get Object</b>: Retrieves an object from cache, if not
  *            present then an empty buffer is returned.
@@ -59,10 +65,11 @@
 /* Module local definitions.                                                 */
 /*===========================================================================*/
 
-/* Default hash function.*/
+/* Default hash function, the index is taken from the low bits so the
+   product high bits are folded into them.*/
 #if !defined(OC_HASH_FUNCTION) || defined(__DOXYGEN__)
 #define OC_HASH_FUNCTION(ocp, group, key)                                   \
-  (((unsigned)(group) + (unsigned)(key)) & ((unsigned)(ocp)->hashn - 1U))
+  ((unsigned)hash_mix(group, key) & ((unsigned)(ocp)->hashn - 1U))
 #endif
 
 /* Insertion into an hash slot list.*/
@@ -119,6 +126,24 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Mixes an object identifier into a 32 bits hash value.
+ *
+ * @param[in] group     object group identifier
+ * @param[in] key       object identifier within the group
+ * @return              The hash value.
+ *
+ * @notapi
+ */
+static inline uint32_t hash_mix(uint32_t group, uint32_t key) {
+  uint32_t h;
+
+  h  = (group * OC_HASH_MULTIPLIER) ^ key;
+  h *= OC_HASH_MULTIPLIER;
+
+  return h ^ (h >> 16);
+}
+
 /**
  * @brief   Returns an object pointer from the cache, if present.
  *
@@ -258,6 +283,7 @@ void chCacheObjectInit(objects_cache_t *ocp,
   ocp->hashn            = hashn;
   ocp->hashp            = hashp;
   ocp->objn             = objn;
+  ocp->objsz            = objsz;
   ocp->objvp            = objvp;
   ocp->readf            = readf;
   ocp->writef           = writef;
@@ -288,6 +314,119 @@ void chCacheObjectInit(objects_cache_t *ocp,
   } while (objn > (ucnt_t)0);
 }
 
+/**
+ * @brief   Replaces the hash table of a cache.
+ * @details All the objects currently in the hash table are moved into the
+ *          new table, cached objects are not lost and objects owned by
+ *          threads are not affected.
+ * @note    The operation is performed in a single critical section and
+ *          its duration is proportional to the number of objects.
+ *
+ * @param[in] ocp       pointer to the @p objects_cache_t structure
+ * @param[in] hashn     number of elements in the new hash table array, must
+ *                      be a power of two and not lower than the number of
+ *                      objects
+ * @param[in] hashp     pointer to the new hash table as an array of
+ *                      @p oc_hash_header_t
+ * @return              The pointer to the previous hash table, it is no
+ *                      more used by the cache and can be reused.
+ *
+ * @api
+ */
+oc_hash_header_t *chCacheResizeHash(objects_cache_t *ocp,
+                                    ucnt_t hashn,
+                                    oc_hash_header_t *hashp) {
+  oc_hash_header_t *oldhashp, *hhp;
+  uint8_t *p;
+  ucnt_t n;
+
+  chDbgCheck((ocp != NULL) && (hashp != NULL) &&
+             ((hashn & (hashn - (ucnt_t)1)) == (ucnt_t)0) &&
+             (hashn >= ocp->objn));
+
+  /* New hash headers initialization, the table is not yet visible.*/
+  hhp = hashp;
+  do {
+    hhp->hash_next = (oc_object_t *)hhp;
+    hhp->hash_prev = (oc_object_t *)hhp;
+    hhp++;
+  } while (hhp < &hashp[hashn]);
+
+  chSysLock();
+
+  oldhashp   = ocp->hashp;
+  ocp->hashn = hashn;
+  ocp->hashp = hashp;
+
+  /* Moving all the hashed objects into the new table, the old collision
+     lists are simply abandoned.*/
+  p = (uint8_t *)ocp->objvp;
+  n = ocp->objn;
+  do {
+    oc_object_t *objp = (oc_object_t *)p;
+
+    if ((objp->obj_flags & OC_FLAG_INHASH) != 0U) {
+      HASH_INSERT(ocp, objp, objp->obj_group, objp->obj_key);
+    }
+    p += ocp->objsz;
+    n--;
+  } while (n > (ucnt_t)0);
+
+  chSysUnlock();
+
+  return oldhashp;
+}
+
+/**
+ * @brief   Returns the hash table statistics of a cache.
+ * @details The hash table is scanned in order to measure how well objects
+ *          are distributed over the table slots.
+ * @note    The scan is performed in a single critical section, this
+ *          function is meant for tuning and diagnostic purposes.
+ *
+ * @param[in] ocp       pointer to the @p objects_cache_t structure
+ * @param[out] hsp      pointer to the @p oc_hash_stats_t structure to be
+ *                      filled
+ *
+ * @api
+ */
+void chCacheGetHashStats(objects_cache_t *ocp, oc_hash_stats_t *hsp) {
+  oc_hash_header_t *hhp;
+
+  chDbgCheck((ocp != NULL) && (hsp != NULL));
+
+  hsp->used       = (ucnt_t)0;
+  hsp->objects    = (ucnt_t)0;
+  hsp->maxchain   = (ucnt_t)0;
+  hsp->collisions = (ucnt_t)0;
+
+  chSysLock();
+
+  hsp->hashn = ocp->hashn;
+  for (hhp = ocp->hashp; hhp < &ocp->hashp[ocp->hashn]; hhp++) {
+    oc_object_t *objp = hhp->hash_next;
+    ucnt_t len = (ucnt_t)0;
+
+    while (objp != (oc_object_t *)hhp) {
+      len++;
+      objp = objp->hash_next;
+    }
+
+    if (len > (ucnt_t)0) {
+      hsp->used++;
+      hsp->objects += len;
+      if (len > (ucnt_t)1) {
+        hsp->collisions += len;
+      }
+      if (len > hsp->maxchain) {
+        hsp->maxchain = len;
+      }
+    }
+  }
+
+  chSysUnlock();
+}
+
 /**
  * @brief   Retrieves an object from the cache.
  * @note    If the object is not in cache then the returned object is marked
@@ -88,6 +88,44 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+static bool pipe_poll_in(poll_item_t *pip) {
+  pipe_t *pp = (pipe_t *)pip->objp;
+
+  return pp->reset || (chPipeGetUsedCount(pp) > (size_t)0);
+}
+
+static bool pipe_poll_out(poll_item_t *pip) {
+  pipe_t *pp = (pipe_t *)pip->objp;
+
+  return pp->reset || (chPipeGetFreeCount(pp) > (size_t)0);
+}
+#endif
+
+/**
+ * @brief   Resumes a waiting thread after a transfer.
+ * @details The threads polling the pipe are also awakened.
+ *
+ * @param[in] pp        the pointer to an initialized @p pipe_t object
+ * @param[in] trp       a pointer to a thread reference object
+ *
+ * @notapi
+ */
+static void pipe_resume(pipe_t *pp, thread_reference_t *trp) {
+
+#if CH_CFG_USE_POLL == TRUE
+  chSysLock();
+  chThdResumeI(trp, MSG_OK);
+  chPollSignalI(&pp->pollers);
+  chSchRescheduleS();
+  chSysUnlock();
+#else
+  (void)pp;
+
+  chThdResume(trp, MSG_OK);
+#endif
+}
+
 /**
  * @brief   Non-blocking pipe write.
  * @details The function writes data from a buffer to a pipe. The
@@ -219,6 +257,9 @@ void chPipeObjectInit(pipe_t *pp, uint8_t *buf, size_t n) {
   PC_INIT(pp);
   PW_INIT(pp);
   PR_INIT(pp);
+#if CH_CFG_USE_POLL == TRUE
+  ch_queue_init(&pp->pollers);
+#endif
 }
 
 /**
@@ -247,6 +288,9 @@ void chPipeReset(pipe_t *pp) {
   chSysLock();
   chThdResumeI(&pp->wtr, MSG_RESET);
   chThdResumeI(&pp->rtr, MSG_RESET);
+#if CH_CFG_USE_POLL == TRUE
+  chPollSignalI(&pp->pollers);
+#endif
   chSchRescheduleS();
   chSysUnlock();
 
@@ -309,7 +353,7 @@ size_t chPipeWriteTimeout(pipe_t *pp, const uint8_t *bp,
       bp += done;
 
       /* Resuming the reader, if present.*/
-      chThdResume(&pp->rtr, MSG_OK);
+      pipe_resume(pp, &pp->rtr);
     }
   }
 
@@ -374,7 +418,7 @@ size_t chPipeReadTimeout(pipe_t *pp, uint8_t *bp,
       bp += done;
 
       /* Resuming the writer, if present.*/
-      chThdResume(&pp->wtr, MSG_OK);
+      pipe_resume(pp, &pp->wtr);
     }
   }
 
@@ -383,6 +427,34 @@ size_t chPipeReadTimeout(pipe_t *pp, uint8_t *bp,
   return max - n;
 }
 
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Adds a pipe to a poll set.
+ * @details A pipe is ready for @p CH_POLL_IN when it contains data, it is
+ *          ready for @p CH_POLL_OUT when it has free space. A pipe in reset
+ *          state is always ready.
+ *
+ * @param[in] psp       pointer to the @p poll_set_t structure
+ * @param[out] pip      pointer to the @p poll_item_t structure
+ * @param[in] pp        the pointer to an initialized @p pipe_t object
+ * @param[in] dir       the polling direction:
+ *                      - @a CH_POLL_IN data available.
+ *                      - @a CH_POLL_OUT free space available.
+ *                      .
+ *
+ * @api
+ */
+void chPollAddPipe(poll_set_t *psp, poll_item_t *pip,
+                   pipe_t *pp, unsigned dir) {
+
+  chDbgCheck(pp != NULL);
+
+  chPollAddObject(psp, pip, &pp->pollers,
+                  dir == CH_POLL_IN ? pipe_poll_in : pipe_poll_out,
+                  (void *)pp);
+}
+#endif /* CH_CFG_USE_POLL == TRUE */
+
 #endif /* CH_CFG_USE_PIPES == TRUE */
 
 /** @} */
@@ -0,0 +1,708 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    oslib/src/chrecqueues.c
+ * @brief   Record queues code.
+ * @details Queues of variable size records.
+ *          <h2>Operation mode</h2>
+ *          A record queue is a FIFO of variable size records stored
+ *          contiguously into a circular buffer, each record is prefixed
+ *          by its size. Records are written and read in-place:
+ *          - <b>Reserve</b>: Returns a pointer to a contiguous area large
+ *            enough for a record.
+ *          - <b>Commit</b>: The reserved area is queued as a record, its
+ *            size can be smaller than the reserved one.
+ *          - <b>Peek</b>: Returns a pointer to the oldest record and its
+ *            size.
+ *          - <b>Release</b>: The oldest record is removed from the queue.
+ *          .
+ *          When a record does not fit the space left at the end of the
+ *          buffer then that space is filled with padding and the record is
+ *          written at the buffer start.<br>
+ *          Reservations and peeks are exclusive, a second writer or reader
+ *          waits until the pending operation is completed.<br>
+ *          Copying variants are also provided for convenience.
+ * @pre     In order to use the record queues APIs the
+ *          @p CH_CFG_USE_REC_QUEUES option must be enabled in
+ *          @p chconf.h.
+ * @note    Compatible with RT and NIL.
+ *
+ * @addtogroup oslib_recqueues
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+
+#if (CH_CFG_USE_REC_QUEUES == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Searches space for a new record.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[in] n         size of the record payload
+ * @return              Pointer to the reserved record payload.
+ * @retval NULL         if there is not enough contiguous space.
+ *
+ * @notapi
+ */
+static void *rq_reserve(record_queue_t *rqp, size_t n) {
+  size_t need = RQ_RECORD_SIZE(n);
+  size_t off;
+
+  if (rqp->wrbusy || (need > rqp->size - rqp->cnt)) {
+    return NULL;
+  }
+
+  if (rqp->cnt == (size_t)0) {
+    /* Empty queue, restarting from the buffer start in order to have
+       the whole buffer contiguous.*/
+    rqp->wroff = (size_t)0;
+    rqp->rdoff = (size_t)0;
+    off = (size_t)0;
+  }
+  else if (rqp->wroff >= rqp->rdoff) {
+    if (rqp->size - rqp->wroff >= need) {
+      off = rqp->wroff;
+    }
+    else if (rqp->rdoff >= need) {
+      /* Wrapping, the space at the end of the buffer will be filled
+         with padding on commit.*/
+      off = (size_t)0;
+    }
+    else {
+      return NULL;
+    }
+  }
+  else {
+    /* The free space is contiguous and large enough.*/
+    off = rqp->wroff;
+  }
+
+  rqp->rsvoff = off;
+  rqp->wrbusy = true;
+
+  return (void *)&rqp->buffer[off + sizeof (rq_header_t)];
+}
+
+/**
+ * @brief   Returns the oldest record.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[out] np       pointer to a variable receiving the record size
+ * @return              Pointer to the record payload.
+ * @retval NULL         if there are no records available.
+ *
+ * @notapi
+ */
+static void *rq_peek(record_queue_t *rqp, size_t *np) {
+  rq_header_t *hp;
+
+  if (rqp->rdbusy || (rqp->cnt == (size_t)0)) {
+    return NULL;
+  }
+
+  /* Skipping the padding at the end of the buffer, it could be too small
+     to contain an header.*/
+  if ((rqp->size - rqp->rdoff < sizeof (rq_header_t)) ||
+      (((rq_header_t *)&rqp->buffer[rqp->rdoff])->size == RQ_PADDING)) {
+    rqp->cnt  -= rqp->size - rqp->rdoff;
+    rqp->rdoff = (size_t)0;
+  }
+
+  chDbgAssert(rqp->cnt > (size_t)0, "no record after padding");
+
+  hp = (rq_header_t *)&rqp->buffer[rqp->rdoff];
+  *np = hp->size;
+  rqp->rdbusy = true;
+
+  return (void *)(hp + 1);
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a @p record_queue_t object.
+ *
+ * @param[out] rqp      the pointer to the @p record_queue_t structure to be
+ *                      initialized
+ * @param[in] buf       pointer to the queue buffer, it must be aligned to
+ *                      @p RQ_ALIGN
+ * @param[in] n         size of the queue buffer, it must be a multiple of
+ *                      @p RQ_ALIGN
+ *
+ * @init
+ */
+void chRQObjectInit(record_queue_t *rqp, uint8_t *buf, size_t n) {
+
+  chDbgCheck((rqp != NULL) && (buf != NULL) &&
+             MEM_IS_ALIGNED(buf, RQ_ALIGN) &&
+             (n >= RQ_RECORD_SIZE(0)) && MEM_IS_ALIGNED(n, RQ_ALIGN));
+
+  rqp->buffer = buf;
+  rqp->size   = n;
+  rqp->wroff  = (size_t)0;
+  rqp->rdoff  = (size_t)0;
+  rqp->cnt    = (size_t)0;
+  rqp->rsvoff = (size_t)0;
+  rqp->wrbusy = false;
+  rqp->rdbusy = false;
+  rqp->reset  = false;
+  chThdQueueObjectInit(&rqp->qw);
+  chThdQueueObjectInit(&rqp->qr);
+}
+
+/**
+ * @brief   Resets a @p record_queue_t object.
+ * @details All the waiting threads are resumed with status @p MSG_RESET and
+ *          the queued records are lost, pending reservations and peeks are
+ *          invalidated.
+ * @post    The record queue is in reset state, all operations will fail
+ *          until the queue is enabled again using @p chRQResumeX().
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ *
+ * @api
+ */
+void chRQReset(record_queue_t *rqp) {
+
+  chSysLock();
+  chRQResetI(rqp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Resets a @p record_queue_t object.
+ * @details All the waiting threads are resumed with status @p MSG_RESET and
+ *          the queued records are lost, pending reservations and peeks are
+ *          invalidated.
+ * @post    The record queue is in reset state, all operations will fail
+ *          until the queue is enabled again using @p chRQResumeX().
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ *
+ * @iclass
+ */
+void chRQResetI(record_queue_t *rqp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(rqp != NULL);
+
+  rqp->wroff  = (size_t)0;
+  rqp->rdoff  = (size_t)0;
+  rqp->cnt    = (size_t)0;
+  rqp->wrbusy = false;
+  rqp->rdbusy = false;
+  rqp->reset  = true;
+  chThdDequeueAllI(&rqp->qw, MSG_RESET);
+  chThdDequeueAllI(&rqp->qr, MSG_RESET);
+}
+
+/**
+ * @brief   Reserves space for a record.
+ * @details The invoking thread waits until enough contiguous space becomes
+ *          available or the specified time runs out. The returned area can
+ *          be filled in-place then it is queued using @p chRQCommit().
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[in] n         maximum size of the record payload
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              Pointer to the reserved record payload.
+ * @retval NULL         if the operation has timed out or the queue has
+ *                      been reset.
+ *
+ * @api
+ */
+void *chRQReserveTimeout(record_queue_t *rqp, size_t n,
+                         sysinterval_t timeout) {
+  void *p;
+
+  chSysLock();
+  p = chRQReserveTimeoutS(rqp, n, timeout);
+  chSysUnlock();
+
+  return p;
+}
+
+/**
+ * @brief   Reserves space for a record.
+ * @details The invoking thread waits until enough contiguous space becomes
+ *          available or the specified time runs out. The returned area can
+ *          be filled in-place then it is queued using @p chRQCommit().
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[in] n         maximum size of the record payload
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              Pointer to the reserved record payload.
+ * @retval NULL         if the operation has timed out or the queue has
+ *                      been reset.
+ *
+ * @sclass
+ */
+void *chRQReserveTimeoutS(record_queue_t *rqp, size_t n,
+                          sysinterval_t timeout) {
+  void *p;
+
+  chDbgCheckClassS();
+  chDbgCheck((rqp != NULL) && (RQ_RECORD_SIZE(n) <= rqp->size));
+
+  while (!rqp->reset) {
+    p = rq_reserve(rqp, n);
+    if (p != NULL) {
+      return p;
+    }
+
+    /* No space or another reservation in progress, waiting.*/
+    if (chThdEnqueueTimeoutS(&rqp->qw, timeout) != MSG_OK) {
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Reserves space for a record.
+ * @details This variant is non-blocking, the function returns @p NULL
+ *          if there is not enough contiguous space or another reservation
+ *          is in progress.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[in] n         maximum size of the record payload
+ * @return              Pointer to the reserved record payload.
+ * @retval NULL         if the space is not available or the queue is in
+ *                      reset state.
+ *
+ * @iclass
+ */
+void *chRQReserveI(record_queue_t *rqp, size_t n) {
+
+  chDbgCheckClassI();
+  chDbgCheck((rqp != NULL) && (RQ_RECORD_SIZE(n) <= rqp->size));
+
+  if (rqp->reset) {
+    return NULL;
+  }
+
+  return rq_reserve(rqp, n);
+}
+
+/**
+ * @brief   Queues a reserved record.
+ * @details If there is a reader waiting then it is resumed.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[in] n         size of the record payload, it must not exceed the
+ *                      reserved size
+ *
+ * @api
+ */
+void chRQCommit(record_queue_t *rqp, size_t n) {
+
+  chSysLock();
+  chRQCommitI(rqp, n);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Queues a reserved record.
+ * @details If there is a reader waiting then it is resumed.
+ * @note    The commit is ignored if the queue has been reset after the
+ *          reservation.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[in] n         size of the record payload, it must not exceed the
+ *                      reserved size
+ *
+ * @iclass
+ */
+void chRQCommitI(record_queue_t *rqp, size_t n) {
+  size_t need = RQ_RECORD_SIZE(n);
+
+  chDbgCheckClassI();
+  chDbgCheck(rqp != NULL);
+
+  if (!rqp->wrbusy) {
+    return;
+  }
+
+  /* If the reservation wrapped then the space at the end of the buffer
+     becomes padding, an header is written only if there is space for
+     it.*/
+  if (rqp->rsvoff != rqp->wroff) {
+    if (rqp->size - rqp->wroff >= sizeof (rq_header_t)) {
+      ((rq_header_t *)&rqp->buffer[rqp->wroff])->size = RQ_PADDING;
+    }
+    rqp->cnt  += rqp->size - rqp->wroff;
+    rqp->wroff = (size_t)0;
+  }
+
+  chDbgAssert(rqp->size - rqp->wroff >= need, "reservation exceeded");
+
+  ((rq_header_t *)&rqp->buffer[rqp->wroff])->size = n;
+  rqp->wroff += need;
+  if (rqp->wroff >= rqp->size) {
+    rqp->wroff = (size_t)0;
+  }
+  rqp->cnt   += need;
+  rqp->wrbusy = false;
+
+  /* Waking up a reader and all waiting writers, the latter could be
+     waiting for the reservation to be completed.*/
+  chThdDequeueNextI(&rqp->qr, MSG_OK);
+  chThdDequeueAllI(&rqp->qw, MSG_OK);
+}
+
+/**
+ * @brief   Returns the oldest record.
+ * @details The invoking thread waits until a record is available or the
+ *          specified time runs out. The record can be accessed in-place
+ *          then it is removed from the queue using @p chRQRelease().
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[out] np       pointer to a variable receiving the record size
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              Pointer to the record payload.
+ * @retval NULL         if the operation has timed out or the queue has
+ *                      been reset.
+ *
+ * @api
+ */
+void *chRQPeekTimeout(record_queue_t *rqp, size_t *np,
+                      sysinterval_t timeout) {
+  void *p;
+
+  chSysLock();
+  p = chRQPeekTimeoutS(rqp, np, timeout);
+  chSysUnlock();
+
+  return p;
+}
+
+/**
+ * @brief   Returns the oldest record.
+ * @details The invoking thread waits until a record is available or the
+ *          specified time runs out. The record can be accessed in-place
+ *          then it is removed from the queue using @p chRQRelease().
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[out] np       pointer to a variable receiving the record size
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              Pointer to the record payload.
+ * @retval NULL         if the operation has timed out or the queue has
+ *                      been reset.
+ *
+ * @sclass
+ */
+void *chRQPeekTimeoutS(record_queue_t *rqp, size_t *np,
+                       sysinterval_t timeout) {
+  void *p;
+
+  chDbgCheckClassS();
+  chDbgCheck((rqp != NULL) && (np != NULL));
+
+  while (!rqp->reset) {
+    p = rq_peek(rqp, np);
+    if (p != NULL) {
+      return p;
+    }
+
+    /* No records or another peek in progress, waiting.*/
+    if (chThdEnqueueTimeoutS(&rqp->qr, timeout) != MSG_OK) {
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Returns the oldest record.
+ * @details This variant is non-blocking, the function returns @p NULL
+ *          if there are no records or another peek is in progress.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[out] np       pointer to a variable receiving the record size
+ * @return              Pointer to the record payload.
+ * @retval NULL         if there are no records available or the queue is
+ *                      in reset state.
+ *
+ * @iclass
+ */
+void *chRQPeekI(record_queue_t *rqp, size_t *np) {
+
+  chDbgCheckClassI();
+  chDbgCheck((rqp != NULL) && (np != NULL));
+
+  if (rqp->reset) {
+    return NULL;
+  }
+
+  return rq_peek(rqp, np);
+}
+
+/**
+ * @brief   Removes the oldest record from the queue.
+ * @details If there are writers waiting then they are resumed.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ *
+ * @api
+ */
+void chRQRelease(record_queue_t *rqp) {
+
+  chSysLock();
+  chRQReleaseI(rqp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Removes the oldest record from the queue.
+ * @details If there are writers waiting then they are resumed.
+ * @note    The release is ignored if the queue has been reset after the
+ *          peek.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ *
+ * @iclass
+ */
+void chRQReleaseI(record_queue_t *rqp) {
+  size_t need;
+
+  chDbgCheckClassI();
+  chDbgCheck(rqp != NULL);
+
+  if (!rqp->rdbusy) {
+    return;
+  }
+
+  need = RQ_RECORD_SIZE(((rq_header_t *)&rqp->buffer[rqp->rdoff])->size);
+  rqp->rdoff += need;
+  if (rqp->rdoff >= rqp->size) {
+    rqp->rdoff = (size_t)0;
+  }
+  rqp->cnt   -= need;
+  rqp->rdbusy = false;
+
+  /* Waking up all waiting writers and the next reader, the latter could
+     be waiting for the peek to be completed.*/
+  chThdDequeueAllI(&rqp->qw, MSG_OK);
+  chThdDequeueNextI(&rqp->qr, MSG_OK);
+}
+
+/**
+ * @brief   Sends a record by copy.
+ * @details The invoking thread waits until enough space becomes available
+ *          or the specified time runs out. The data is copied outside the
+ *          critical zone.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[in] p         pointer to the record data
+ * @param[in] n         size of the record data
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if the record has been queued.
+ * @retval MSG_RESET    if the queue has been reset.
+ * @retval MSG_TIMEOUT  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t chRQSendTimeout(record_queue_t *rqp, const void *p, size_t n,
+                      sysinterval_t timeout) {
+  void *rp;
+
+  chSysLock();
+  rp = chRQReserveTimeoutS(rqp, n, timeout);
+  if (rp == NULL) {
+    msg_t msg = rqp->reset ? MSG_RESET : MSG_TIMEOUT;
+    chSysUnlock();
+    return msg;
+  }
+  chSysUnlock();
+
+  memcpy(rp, p, n);
+
+  chRQCommit(rqp, n);
+
+  return MSG_OK;
+}
+
+/**
+ * @brief   Sends a record by copy.
+ * @details This variant is non-blocking, the function fails if there is
+ *          not enough space or another reservation is in progress.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[in] p         pointer to the record data
+ * @param[in] n         size of the record data
+ * @return              The operation status.
+ * @retval MSG_OK       if the record has been queued.
+ * @retval MSG_RESET    if the queue is in reset state.
+ * @retval MSG_TIMEOUT  if the record cannot be queued.
+ *
+ * @iclass
+ */
+msg_t chRQSendI(record_queue_t *rqp, const void *p, size_t n) {
+  void *rp;
+
+  chDbgCheckClassI();
+
+  rp = chRQReserveI(rqp, n);
+  if (rp == NULL) {
+    return rqp->reset ? MSG_RESET : MSG_TIMEOUT;
+  }
+
+  memcpy(rp, p, n);
+  chRQCommitI(rqp, n);
+
+  return MSG_OK;
+}
+
+/**
+ * @brief   Receives a record by copy.
+ * @details The invoking thread waits until a record is available or the
+ *          specified time runs out. The data is copied outside the
+ *          critical zone.
+ * @note    If the record is larger than the buffer then it is truncated,
+ *          the record is removed from the queue anyway.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[out] p        pointer to the receive buffer
+ * @param[in,out] np    on entry the size of the receive buffer, on exit the
+ *                      size of the received record
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if a record has been received.
+ * @retval MSG_RESET    if the queue has been reset.
+ * @retval MSG_TIMEOUT  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t chRQReceiveTimeout(record_queue_t *rqp, void *p, size_t *np,
+                         sysinterval_t timeout) {
+  void *rp;
+  size_t n;
+
+  chSysLock();
+  rp = chRQPeekTimeoutS(rqp, &n, timeout);
+  if (rp == NULL) {
+    msg_t msg = rqp->reset ? MSG_RESET : MSG_TIMEOUT;
+    chSysUnlock();
+    return msg;
+  }
+  chSysUnlock();
+
+  memcpy(p, rp, n < *np ? n : *np);
+  *np = n;
+
+  chRQRelease(rqp);
+
+  return MSG_OK;
+}
+
+/**
+ * @brief   Receives a record by copy.
+ * @details This variant is non-blocking, the function fails if there are
+ *          no records or another peek is in progress.
+ * @note    If the record is larger than the buffer then it is truncated,
+ *          the record is removed from the queue anyway.
+ *
+ * @param[in] rqp       the pointer to an initialized @p record_queue_t object
+ * @param[out] p        pointer to the receive buffer
+ * @param[in,out] np    on entry the size of the receive buffer, on exit the
+ *                      size of the received record
+ * @return              The operation status.
+ * @retval MSG_OK       if a record has been received.
+ * @retval MSG_RESET    if the queue is in reset state.
+ * @retval MSG_TIMEOUT  if there are no records available.
+ *
+ * @iclass
+ */
+msg_t chRQReceiveI(record_queue_t *rqp, void *p, size_t *np) {
+  void *rp;
+  size_t n;
+
+  chDbgCheckClassI();
+
+  rp = chRQPeekI(rqp, &n);
+  if (rp == NULL) {
+    return rqp->reset ? MSG_RESET : MSG_TIMEOUT;
+  }
+
+  memcpy(p, rp, n < *np ? n : *np);
+  *np = n;
+  chRQReleaseI(rqp);
+
+  return MSG_OK;
+}
+
+#endif /* CH_CFG_USE_REC_QUEUES == TRUE */
+
+/** @} */
@@ -0,0 +1,604 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    oslib/src/chrefbufs.c
+ * @brief   Reference-counted buffers code.
+ * @details Buffers shared between modules without copying.
+ *          <h2>Operation mode</h2>
+ *          Buffers are allocated from guarded memory pools, each buffer
+ *          has a references counter and is returned to its pool when the
+ *          last reference is released.<br>
+ *          The payload can be placed after an initial headroom so that
+ *          protocol headers can be prepended in-place while the data
+ *          travels down a processing pipeline. Buffers can be chained
+ *          in order to form larger packets, a buffer in a chain owns a
+ *          reference to the next one.<br>
+ *          Buffers can also wrap memory owned by other modules, a release
+ *          callback returns that memory to its owner when the last
+ *          reference is released.
+ * @note    Buffers must not be modified while shared.
+ * @pre     In order to use the reference-counted buffers APIs the
+ *          @p CH_CFG_USE_REF_BUFFERS option must be enabled in
+ *          @p chconf.h.
+ * @note    Compatible with RT and NIL.
+ *
+ * @addtogroup oslib_refbufs
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+
+#if (CH_CFG_USE_REF_BUFFERS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a buffer object.
+ *
+ * @param[in] rbpp      pointer to the owner @p refbuf_pool_t structure
+ * @param[in] objp      pointer to the pool object
+ * @param[in] p         pointer to the data area
+ * @param[in] n         size of the data area
+ * @return              The initialized buffer.
+ *
+ * @notapi
+ */
+static refbuf_t *rb_init(refbuf_pool_t *rbpp, void *objp, uint8_t *p,
+                         size_t n) {
+  refbuf_t *rbp = (refbuf_t *)objp;
+
+  rbp->next    = NULL;
+  rbp->owner   = rbpp;
+  rbp->buffer  = p;
+  rbp->size    = n;
+  rbp->data    = p;
+  rbp->len     = (size_t)0;
+  rbp->refs    = (cnt_t)1;
+  rbp->release = NULL;
+  rbp->link    = NULL;
+
+  return rbp;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes an empty buffers pool.
+ *
+ * @param[out] rbpp     pointer to a @p refbuf_pool_t structure
+ * @param[in] size      size of the buffers data area, zero for pools
+ *                      used only for wrapping external memory
+ *
+ * @init
+ */
+void chRBPoolObjectInit(refbuf_pool_t *rbpp, size_t size) {
+
+  chDbgCheck(rbpp != NULL);
+
+  chGuardedPoolObjectInit(&rbpp->pool, REFBUF_OBJECT_SIZE(size));
+  rbpp->size = MEM_ALIGN_NEXT(size, PORT_NATURAL_ALIGN);
+}
+
+/**
+ * @brief   Loads a buffers pool with an array of objects.
+ * @pre     The buffers pool must already be initialized.
+ * @pre     The array elements must be of size
+ *          @p REFBUF_OBJECT_SIZE(size) and aligned to
+ *          @p PORT_NATURAL_ALIGN.
+ *
+ * @param[in] rbpp      pointer to a @p refbuf_pool_t structure
+ * @param[in] p         pointer to the array first element
+ * @param[in] n         number of elements in the array
+ *
+ * @api
+ */
+void chRBPoolLoadArray(refbuf_pool_t *rbpp, void *p, size_t n) {
+
+  chGuardedPoolLoadArray(&rbpp->pool, p, n);
+}
+
+/**
+ * @brief   Allocates a buffer from a pool.
+ * @details The returned buffer has a single reference and an empty payload
+ *          placed after the specified headroom.
+ *
+ * @param[in] rbpp      pointer to a @p refbuf_pool_t structure
+ * @param[in] headroom  space to be left in front of the payload
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the allocated buffer.
+ * @retval NULL         if the operation timed out.
+ *
+ * @api
+ */
+refbuf_t *chRBAllocTimeout(refbuf_pool_t *rbpp, size_t headroom,
+                           sysinterval_t timeout) {
+  refbuf_t *rbp;
+  void *objp;
+
+  chDbgCheck((rbpp != NULL) && (headroom <= rbpp->size));
+
+  objp = chGuardedPoolAllocTimeout(&rbpp->pool, timeout);
+  if (objp == NULL) {
+    return NULL;
+  }
+
+  rbp = rb_init(rbpp, objp, (uint8_t *)objp + REFBUF_HEADER_SIZE,
+                rbpp->size);
+  rbp->data += headroom;
+
+  return rbp;
+}
+
+/**
+ * @brief   Allocates a buffer from a pool.
+ * @details The returned buffer has a single reference and an empty payload
+ *          placed after the specified headroom.
+ *
+ * @param[in] rbpp      pointer to a @p refbuf_pool_t structure
+ * @param[in] headroom  space to be left in front of the payload
+ * @return              The pointer to the allocated buffer.
+ * @retval NULL         if the pool is empty.
+ *
+ * @iclass
+ */
+refbuf_t *chRBAllocI(refbuf_pool_t *rbpp, size_t headroom) {
+  refbuf_t *rbp;
+  void *objp;
+
+  chDbgCheckClassI();
+  chDbgCheck((rbpp != NULL) && (headroom <= rbpp->size));
+
+  objp = chGuardedPoolAllocI(&rbpp->pool);
+  if (objp == NULL) {
+    return NULL;
+  }
+
+  rbp = rb_init(rbpp, objp, (uint8_t *)objp + REFBUF_HEADER_SIZE,
+                rbpp->size);
+  rbp->data += headroom;
+
+  return rbp;
+}
+
+/**
+ * @brief   Allocates a buffer wrapping external memory.
+ * @details The returned buffer has a single reference and a payload
+ *          covering the whole external memory area, there is no headroom.
+ *
+ * @param[in] rbpp      pointer to a @p refbuf_pool_t structure
+ * @param[in] p         pointer to the external memory area
+ * @param[in] n         size of the external memory area
+ * @param[in] release   callback returning the memory to its owner, it can
+ *                      be @p NULL
+ * @param[in] link      application defined field
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the allocated buffer.
+ * @retval NULL         if the operation timed out.
+ *
+ * @api
+ */
+refbuf_t *chRBWrapTimeout(refbuf_pool_t *rbpp, void *p, size_t n,
+                          refbuf_release_t release, void *link,
+                          sysinterval_t timeout) {
+  refbuf_t *rbp;
+  void *objp;
+
+  chDbgCheck((rbpp != NULL) && (p != NULL));
+
+  objp = chGuardedPoolAllocTimeout(&rbpp->pool, timeout);
+  if (objp == NULL) {
+    return NULL;
+  }
+
+  rbp = rb_init(rbpp, objp, (uint8_t *)p, n);
+  rbp->len     = n;
+  rbp->release = release;
+  rbp->link    = link;
+
+  return rbp;
+}
+
+/**
+ * @brief   Allocates a buffer wrapping external memory.
+ * @details The returned buffer has a single reference and a payload
+ *          covering the whole external memory area, there is no headroom.
+ *
+ * @param[in] rbpp      pointer to a @p refbuf_pool_t structure
+ * @param[in] p         pointer to the external memory area
+ * @param[in] n         size of the external memory area
+ * @param[in] release   callback returning the memory to its owner, it can
+ *                      be @p NULL
+ * @param[in] link      application defined field
+ * @return              The pointer to the allocated buffer.
+ * @retval NULL         if the pool is empty.
+ *
+ * @iclass
+ */
+refbuf_t *chRBWrapI(refbuf_pool_t *rbpp, void *p, size_t n,
+                    refbuf_release_t release, void *link) {
+  refbuf_t *rbp;
+  void *objp;
+
+  chDbgCheckClassI();
+  chDbgCheck((rbpp != NULL) && (p != NULL));
+
+  objp = chGuardedPoolAllocI(&rbpp->pool);
+  if (objp == NULL) {
+    return NULL;
+  }
+
+  rbp = rb_init(rbpp, objp, (uint8_t *)p, n);
+  rbp->len     = n;
+  rbp->release = release;
+  rbp->link    = link;
+
+  return rbp;
+}
+
+/**
+ * @brief   Adds a reference to a buffer.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @return              The buffer pointer passed as parameter.
+ *
+ * @api
+ */
+refbuf_t *chRBAddRef(refbuf_t *rbp) {
+
+  chSysLock();
+  (void) chRBAddRefI(rbp);
+  chSysUnlock();
+
+  return rbp;
+}
+
+/**
+ * @brief   Adds a reference to a buffer.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @return              The buffer pointer passed as parameter.
+ *
+ * @iclass
+ */
+refbuf_t *chRBAddRefI(refbuf_t *rbp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(rbp != NULL);
+  chDbgAssert(rbp->refs > (cnt_t)0, "not referenced");
+
+  rbp->refs++;
+
+  return rbp;
+}
+
+/**
+ * @brief   Releases a reference to a buffer.
+ * @details When the last reference is released the buffer is returned to
+ *          its pool and the reference to the next buffer in the chain, if
+ *          any, is released too.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ *
+ * @api
+ */
+void chRBRelease(refbuf_t *rbp) {
+
+  chSysLock();
+  chRBReleaseI(rbp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Releases a reference to a buffer.
+ * @details When the last reference is released the buffer is returned to
+ *          its pool and the reference to the next buffer in the chain, if
+ *          any, is released too.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ *
+ * @iclass
+ */
+void chRBReleaseI(refbuf_t *rbp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(rbp != NULL);
+
+  while (rbp != NULL) {
+    refbuf_t *next;
+
+    chDbgAssert(rbp->refs > (cnt_t)0, "not referenced");
+
+    if (--rbp->refs > (cnt_t)0) {
+      break;
+    }
+
+    next = rbp->next;
+    if (rbp->release != NULL) {
+      rbp->release(rbp);
+    }
+    chGuardedPoolFreeI(&rbp->owner->pool, (void *)rbp);
+    rbp = next;
+  }
+}
+
+/**
+ * @brief   Prepends space to the buffer payload.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @param[in] n         number of bytes to be prepended, it must not exceed
+ *                      the buffer headroom
+ * @return              Pointer to the new payload start.
+ *
+ * @xclass
+ */
+void *chRBPushHead(refbuf_t *rbp, size_t n) {
+
+  chDbgCheck((rbp != NULL) && (n <= chRBGetHeadroomX(rbp)));
+
+  rbp->data -= n;
+  rbp->len  += n;
+
+  return (void *)rbp->data;
+}
+
+/**
+ * @brief   Removes space from the start of the buffer payload.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @param[in] n         number of bytes to be removed, it must not exceed
+ *                      the payload length
+ * @return              Pointer to the new payload start.
+ *
+ * @xclass
+ */
+void *chRBPullHead(refbuf_t *rbp, size_t n) {
+
+  chDbgCheck((rbp != NULL) && (n <= rbp->len));
+
+  rbp->data += n;
+  rbp->len  -= n;
+
+  return (void *)rbp->data;
+}
+
+/**
+ * @brief   Appends space to the buffer payload.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @param[in] n         number of bytes to be appended, it must not exceed
+ *                      the buffer tailroom
+ * @return              Pointer to the appended space.
+ *
+ * @xclass
+ */
+void *chRBPutTail(refbuf_t *rbp, size_t n) {
+  uint8_t *p;
+
+  chDbgCheck((rbp != NULL) && (n <= chRBGetTailroomX(rbp)));
+
+  p = rbp->data + rbp->len;
+  rbp->len += n;
+
+  return (void *)p;
+}
+
+/**
+ * @brief   Removes space from the end of the buffer payload.
+ *
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @param[in] n         number of bytes to be removed, it must not exceed
+ *                      the payload length
+ *
+ * @xclass
+ */
+void chRBTrimTail(refbuf_t *rbp, size_t n) {
+
+  chDbgCheck((rbp != NULL) && (n <= rbp->len));
+
+  rbp->len -= n;
+}
+
+/**
+ * @brief   Appends a buffers chain to another chain.
+ * @note    The caller reference to @p next is transferred to the last
+ *          buffer of the chain starting at @p rbp.
+ *
+ * @param[in] rbp       pointer to the first buffer of a chain
+ * @param[in] next      pointer to the first buffer of the chain to be
+ *                      appended
+ *
+ * @xclass
+ */
+void chRBChain(refbuf_t *rbp, refbuf_t *next) {
+
+  chDbgCheck((rbp != NULL) && (next != NULL) && (rbp != next));
+
+  while (rbp->next != NULL) {
+    rbp = rbp->next;
+  }
+  rbp->next = next;
+}
+
+/**
+ * @brief   Returns the total payload length of a buffers chain.
+ *
+ * @param[in] rbp       pointer to the first buffer of a chain
+ * @return              The sum of the payload lengths.
+ *
+ * @xclass
+ */
+size_t chRBGetChainLength(const refbuf_t *rbp) {
+  size_t n = (size_t)0;
+
+  while (rbp != NULL) {
+    n += rbp->len;
+    rbp = rbp->next;
+  }
+
+  return n;
+}
+
+/**
+ * @brief   Copies data out of a buffers chain.
+ * @note    This function is meant for consumers requiring linear data, it
+ *          is not required when passing buffers between modules.
+ *
+ * @param[in] rbp       pointer to the first buffer of a chain
+ * @param[in] offset    offset of the first byte to be copied
+ * @param[out] p        pointer to the destination area
+ * @param[in] n         maximum number of bytes to be copied
+ * @return              The number of copied bytes.
+ *
+ * @xclass
+ */
+size_t chRBCopyOut(const refbuf_t *rbp, size_t offset, void *p, size_t n) {
+  uint8_t *dp = (uint8_t *)p;
+  size_t done = (size_t)0;
+
+  while ((rbp != NULL) && (done < n)) {
+    if (offset >= rbp->len) {
+      offset -= rbp->len;
+    }
+    else {
+      size_t chunk = rbp->len - offset;
+
+      if (chunk > n - done) {
+        chunk = n - done;
+      }
+      memcpy((void *)&dp[done], (const void *)&rbp->data[offset], chunk);
+      done  += chunk;
+      offset = (size_t)0;
+    }
+    rbp = rbp->next;
+  }
+
+  return done;
+}
+
+#if (CH_CFG_USE_PIPES == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Passes a buffer through a pipe.
+ * @details Only the buffer pointer is written into the pipe, the caller
+ *          reference is transferred to the reader.
+ * @pre     The pipe must be dedicated to buffers transfer and its size
+ *          must be a multiple of <tt>sizeof (refbuf_t *)</tt>.
+ * @note    Buffers still in the pipe when it is reset are not released.
+ *
+ * @param[in] pp        the pointer to an initialized @p pipe_t object
+ * @param[in] rbp       pointer to a @p refbuf_t object
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if the buffer has been written.
+ * @retval MSG_TIMEOUT  if the operation timed out.
+ * @retval MSG_RESET    if the pipe is in reset state.
+ *
+ * @api
+ */
+msg_t chRBPipeWriteTimeout(pipe_t *pp, refbuf_t *rbp,
+                           sysinterval_t timeout) {
+  size_t n;
+
+  chDbgCheck(rbp != NULL);
+
+  n = chPipeWriteTimeout(pp, (const uint8_t *)&rbp,
+                         sizeof (refbuf_t *), timeout);
+  if (n == sizeof (refbuf_t *)) {
+    return MSG_OK;
+  }
+
+  chDbgAssert(n == (size_t)0, "partial write");
+
+  return pp->reset ? MSG_RESET : MSG_TIMEOUT;
+}
+
+/**
+ * @brief   Receives a buffer from a pipe.
+ * @pre     The pipe must be dedicated to buffers transfer and its size
+ *          must be a multiple of <tt>sizeof (refbuf_t *)</tt>.
+ *
+ * @param[in] pp        the pointer to an initialized @p pipe_t object
+ * @param[out] rbpp     pointer to a variable receiving the buffer pointer
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if a buffer has been received.
+ * @retval MSG_TIMEOUT  if the operation timed out.
+ * @retval MSG_RESET    if the pipe is in reset state.
+ *
+ * @api
+ */
+msg_t chRBPipeReadTimeout(pipe_t *pp, refbuf_t **rbpp,
+                          sysinterval_t timeout) {
+  size_t n;
+
+  chDbgCheck(rbpp != NULL);
+
+  n = chPipeReadTimeout(pp, (uint8_t *)rbpp, sizeof (refbuf_t *), timeout);
+  if (n == sizeof (refbuf_t *)) {
+    return MSG_OK;
+  }
+
+  chDbgAssert(n == (size_t)0, "partial read");
+
+  return pp->reset ? MSG_RESET : MSG_TIMEOUT;
+}
+#endif /* CH_CFG_USE_PIPES == TRUE */
+
+#endif /* CH_CFG_USE_REF_BUFFERS == TRUE */
+
+/** @} */
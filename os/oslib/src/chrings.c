@@ -0,0 +1,454 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    oslib/src/chrings.c
+ * @brief   Lock-free rings code.
+ * @details Single producer, single consumer lock-free byte rings.
+ *          <h2>Operation mode</h2>
+ *          A ring is an asynchronous communication mechanism between
+ *          exactly one producer and one consumer, each one can be a thread
+ *          or an ISR.<br>
+ *          Data transfers do not require critical sections, the producer
+ *          only updates the head index and the consumer only updates the
+ *          tail index. The kernel is entered only when a thread is waiting
+ *          on the other side of the ring, this can only happen when the
+ *          ring is empty or full.<br>
+ *          Operations defined for rings:
+ *          - <b>Write</b>: Writes a buffer of data in the ring in FIFO
+ *            order.
+ *          - <b>Read</b>: A buffer of data is read from the ring and
+ *            removed.
+ *          - <b>Get Span</b>: Returns the free or used area of the ring
+ *            as two segments for in-place access.
+ *          - <b>Commit</b>/<b>Release</b>: Publishes data written or
+ *            frees data read in-place.
+ *          .
+ * @pre     In order to use the rings APIs the @p CH_CFG_USE_RINGS
+ *          option must be enabled in @p chconf.h.
+ * @note    Compatible with RT and NIL.
+ * @note    The ring size must be a power of two.
+ *
+ * @addtogroup oslib_rings
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+
+#if (CH_CFG_USE_RINGS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Fills a span structure.
+ *
+ * @param[in] rp        the pointer to an initialized @p ring_t object
+ * @param[in] index     index of the span start
+ * @param[in] n         size of the span
+ * @param[out] sp       pointer to the @p ring_span_t structure
+ *
+ * @notapi
+ */
+static void ring_span(ring_t *rp, size_t index, size_t n, ring_span_t *sp) {
+  size_t pos = index & rp->mask;
+  size_t s1 = chRingGetSizeX(rp) - pos;
+
+  sp->p1 = &rp->buffer[pos];
+  if (n <= s1) {
+    sp->n1 = n;
+    sp->p2 = NULL;
+    sp->n2 = (size_t)0;
+  }
+  else {
+    sp->n1 = s1;
+    sp->p2 = rp->buffer;
+    sp->n2 = n - s1;
+  }
+}
+
+/**
+ * @brief   Wakes up a thread waiting on the other side of the ring.
+ *
+ * @param[in] trp       a pointer to a thread reference object
+ *
+ * @notapi
+ */
+static void ring_wakeup(thread_reference_t *trp) {
+
+  /* Making sure that the index update is visible before checking for
+     a waiting thread.*/
+  CH_RINGS_FULL_BARRIER();
+
+  if (*trp != NULL) {
+    syssts_t sts = chSysGetStatusAndLockX();
+    chThdResumeI(trp, MSG_OK);
+    chSysRestoreStatusX(sts);
+  }
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a @p ring_t object.
+ *
+ * @param[out] rp       the pointer to the @p ring_t structure to be
+ *                      initialized
+ * @param[in] buf       pointer to the ring buffer as an array of @p uint8_t
+ * @param[in] n         number of elements in the buffer array, must be a
+ *                      power of two
+ *
+ * @init
+ */
+void chRingObjectInit(ring_t *rp, uint8_t *buf, size_t n) {
+
+  chDbgCheck((rp != NULL) && (buf != NULL) && (n > (size_t)0) &&
+             ((n & (n - (size_t)1)) == (size_t)0));
+
+  rp->buffer = buf;
+  rp->mask   = n - (size_t)1;
+  rp->head   = (size_t)0;
+  rp->wtr    = NULL;
+  rp->tail   = (size_t)0;
+  rp->rtr    = NULL;
+}
+
+/**
+ * @brief   Returns the free area of a ring.
+ * @details The free area can be filled in-place then the written data is
+ *          published using @p chRingCommitX().
+ * @note    This function can only be called by the producer.
+ *
+ * @param[in] rp        the pointer to an initialized @p ring_t object
+ * @param[out] sp       pointer to the @p ring_span_t structure describing
+ *                      the free area
+ * @return              The number of free bytes.
+ *
+ * @xclass
+ */
+size_t chRingGetWriteSpanX(ring_t *rp, ring_span_t *sp) {
+  size_t head, n;
+
+  chDbgCheck((rp != NULL) && (sp != NULL));
+
+  head = rp->head;
+  n    = chRingGetSizeX(rp) - (head - rp->tail);
+
+  /* The consumer finished reading the area before releasing it, the
+     buffer writes must not be moved before the tail read.*/
+  CH_RINGS_ACQUIRE_BARRIER();
+
+  ring_span(rp, head, n, sp);
+
+  return n;
+}
+
+/**
+ * @brief   Publishes data written in-place into a ring.
+ * @details If the consumer is a thread waiting for data then it is
+ *          resumed.
+ * @note    This function can only be called by the producer.
+ *
+ * @param[in] rp        the pointer to an initialized @p ring_t object
+ * @param[in] n         number of bytes to be published, it must not exceed
+ *                      the size of the area returned by
+ *                      @p chRingGetWriteSpanX()
+ *
+ * @xclass
+ */
+void chRingCommitX(ring_t *rp, size_t n) {
+
+  chDbgCheck((rp != NULL) && (n <= chRingGetFreeCountX(rp)));
+
+  /* Data must be in the buffer before the head index is updated.*/
+  CH_RINGS_RELEASE_BARRIER();
+
+  rp->head = rp->head + n;
+
+  ring_wakeup(&rp->rtr);
+}
+
+/**
+ * @brief   Returns the used area of a ring.
+ * @details The used area can be accessed in-place then it is freed using
+ *          @p chRingReleaseX().
+ * @note    This function can only be called by the consumer.
+ *
+ * @param[in] rp        the pointer to an initialized @p ring_t object
+ * @param[out] sp       pointer to the @p ring_span_t structure describing
+ *                      the used area
+ * @return              The number of used bytes.
+ *
+ * @xclass
+ */
+size_t chRingGetReadSpanX(ring_t *rp, ring_span_t *sp) {
+  size_t tail, n;
+
+  chDbgCheck((rp != NULL) && (sp != NULL));
+
+  tail = rp->tail;
+  n    = rp->head - tail;
+
+  /* The buffer reads must not be moved before the head read.*/
+  CH_RINGS_ACQUIRE_BARRIER();
+
+  ring_span(rp, tail, n, sp);
+
+  return n;
+}
+
+/**
+ * @brief   Frees data read in-place from a ring.
+ * @details If the producer is a thread waiting for space then it is
+ *          resumed.
+ * @note    This function can only be called by the consumer.
+ *
+ * @param[in] rp        the pointer to an initialized @p ring_t object
+ * @param[in] n         number of bytes to be freed, it must not exceed
+ *                      the size of the area returned by
+ *                      @p chRingGetReadSpanX()
+ *
+ * @xclass
+ */
+void chRingReleaseX(ring_t *rp, size_t n) {
+
+  chDbgCheck((rp != NULL) && (n <= chRingGetUsedCountX(rp)));
+
+  /* Data must be out of the buffer before the tail index is updated.*/
+  CH_RINGS_RELEASE_BARRIER();
+
+  rp->tail = rp->tail + n;
+
+  ring_wakeup(&rp->wtr);
+}
+
+/**
+ * @brief   Ring write without waiting.
+ * @details The function writes as much data as possible from a buffer to
+ *          a ring.
+ * @note    This function can only be called by the producer.
+ *
+ * @param[in] rp        the pointer to an initialized @p ring_t object
+ * @param[in] bp        pointer to the data buffer
+ * @param[in] n         the maximum number of bytes to be written
+ * @return              The number of bytes effectively transferred.
+ *
+ * @xclass
+ */
+size_t chRingWriteX(ring_t *rp, const uint8_t *bp, size_t n) {
+  ring_span_t span;
+  size_t max;
+
+  max = chRingGetWriteSpanX(rp, &span);
+  if (n > max) {
+    n = max;
+  }
+
+  if (n > (size_t)0) {
+    if (n <= span.n1) {
+      memcpy((void *)span.p1, (const void *)bp, n);
+    }
+    else {
+      memcpy((void *)span.p1, (const void *)bp, span.n1);
+      memcpy((void *)span.p2, (const void *)&bp[span.n1], n - span.n1);
+    }
+    chRingCommitX(rp, n);
+  }
+
+  return n;
+}
+
+/**
+ * @brief   Ring read without waiting.
+ * @details The function reads as much data as possible from a ring into
+ *          a buffer.
+ * @note    This function can only be called by the consumer.
+ *
+ * @param[in] rp        the pointer to an initialized @p ring_t object
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         the maximum number of bytes to be read
+ * @return              The number of bytes effectively transferred.
+ *
+ * @xclass
+ */
+size_t chRingReadX(ring_t *rp, uint8_t *bp, size_t n) {
+  ring_span_t span;
+  size_t max;
+
+  max = chRingGetReadSpanX(rp, &span);
+  if (n > max) {
+    n = max;
+  }
+
+  if (n > (size_t)0) {
+    if (n <= span.n1) {
+      memcpy((void *)bp, (const void *)span.p1, n);
+    }
+    else {
+      memcpy((void *)bp, (const void *)span.p1, span.n1);
+      memcpy((void *)&bp[span.n1], (const void *)span.p2, n - span.n1);
+    }
+    chRingReleaseX(rp, n);
+  }
+
+  return n;
+}
+
+/**
+ * @brief   Ring write with timeout.
+ * @details The function writes data from a buffer to a ring. The
+ *          operation completes when the specified amount of data has been
+ *          transferred or after the specified timeout.
+ * @note    This function can only be called by the producer.
+ *
+ * @param[in] rp        the pointer to an initialized @p ring_t object
+ * @param[in] bp        pointer to the data buffer
+ * @param[in] n         the number of bytes to be written, the value 0 is
+ *                      reserved
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of bytes effectively transferred. A number
+ *                      lower than @p n means that a timeout occurred.
+ *
+ * @api
+ */
+size_t chRingWriteTimeout(ring_t *rp, const uint8_t *bp,
+                          size_t n, sysinterval_t timeout) {
+  size_t max = n;
+
+  chDbgCheck(n > 0U);
+
+  while (n > 0U) {
+    size_t done;
+
+    done = chRingWriteX(rp, bp, n);
+    if (done == (size_t)0) {
+      msg_t msg;
+
+      /* The ring is checked again within the critical section, the
+         consumer could have freed some space in the meanwhile.*/
+      chSysLock();
+      if (chRingGetFreeCountX(rp) == (size_t)0) {
+        msg = chThdSuspendTimeoutS(&rp->wtr, timeout);
+      }
+      else {
+        msg = MSG_OK;
+      }
+      chSysUnlock();
+
+      /* Anything except MSG_OK causes the operation to stop.*/
+      if (msg != MSG_OK) {
+        break;
+      }
+    }
+    else {
+      n  -= done;
+      bp += done;
+    }
+  }
+
+  return max - n;
+}
+
+/**
+ * @brief   Ring read with timeout.
+ * @details The function reads data from a ring into a buffer. The
+ *          operation completes when the specified amount of data has been
+ *          transferred or after the specified timeout.
+ * @note    This function can only be called by the consumer.
+ *
+ * @param[in] rp        the pointer to an initialized @p ring_t object
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         the number of bytes to be read, the value 0 is
+ *                      reserved
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of bytes effectively transferred. A number
+ *                      lower than @p n means that a timeout occurred.
+ *
+ * @api
+ */
+size_t chRingReadTimeout(ring_t *rp, uint8_t *bp,
+                         size_t n, sysinterval_t timeout) {
+  size_t max = n;
+
+  chDbgCheck(n > 0U);
+
+  while (n > 0U) {
+    size_t done;
+
+    done = chRingReadX(rp, bp, n);
+    if (done == (size_t)0) {
+      msg_t msg;
+
+      /* The ring is checked again within the critical section, the
+         producer could have written some data in the meanwhile.*/
+      chSysLock();
+      if (chRingGetUsedCountX(rp) == (size_t)0) {
+        msg = chThdSuspendTimeoutS(&rp->rtr, timeout);
+      }
+      else {
+        msg = MSG_OK;
+      }
+      chSysUnlock();
+
+      /* Anything except MSG_OK causes the operation to stop.*/
+      if (msg != MSG_OK) {
+        break;
+      }
+    }
+    else {
+      n  -= done;
+      bp += done;
+    }
+  }
+
+  return max - n;
+}
+
+#endif /* CH_CFG_USE_RINGS == TRUE */
+
+/** @} */
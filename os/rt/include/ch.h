@@ -123,8 +123,11 @@ extern "C" {
 #include "chsem.h"
 #include "chmtx.h"
 #include "chcond.h"
+#include "chrwlock.h"
 #include "chevents.h"
 #include "chmsg.h"
+#include "chpoll.h"
+#include "chirq.h"
 
 /* OSLIB.*/
 #include "chlib.h"
@@ -82,6 +82,14 @@
 #error "CH_CFG_NO_IDLE_THREAD not defined in chconf.h"
 #endif
 
+#if !defined(CH_CFG_USE_EDF)
+#error "CH_CFG_USE_EDF not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_EDF_PRIORITY)
+#error "CH_CFG_EDF_PRIORITY not defined in chconf.h"
+#endif
+
 /* Performance options checks.*/
 #if !defined(CH_CFG_OPTIMIZE_SPEED)
 #error "CH_CFG_OPTIMIZE_SPEED not defined in chconf.h"
@@ -100,6 +108,10 @@
 #error "CH_CFG_USE_WAITEXIT not defined in chconf.h"
 #endif
 
+#if !defined(CH_CFG_USE_PERIODIC)
+#error "CH_CFG_USE_PERIODIC not defined in chconf.h"
+#endif
+
 #if !defined(CH_CFG_USE_SEMAPHORES)
 #error "CH_CFG_USE_SEMAPHORES not defined in chconf.h"
 #endif
@@ -116,6 +128,14 @@
 #error "CH_CFG_USE_MUTEXES_RECURSIVE not defined in chconf.h"
 #endif
 
+#if !defined(CH_CFG_USE_MUTEXES_FAST_PATH)
+#error "CH_CFG_USE_MUTEXES_FAST_PATH not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_USE_MUTEXES_CEILING)
+#error "CH_CFG_USE_MUTEXES_CEILING not defined in chconf.h"
+#endif
+
 #if !defined(CH_CFG_USE_CONDVARS)
 #error "CH_CFG_USE_CONDVARS not defined in chconf.h"
 #endif
@@ -124,6 +144,14 @@
 #error "CH_CFG_USE_CONDVARS_TIMEOUT not defined in chconf.h"
 #endif
 
+#if !defined(CH_CFG_USE_RWLOCKS)
+#error "CH_CFG_USE_RWLOCKS not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_RWLOCKS_MAX_HOLDS)
+#error "CH_CFG_RWLOCKS_MAX_HOLDS not defined in chconf.h"
+#endif
+
 #if !defined(CH_CFG_USE_EVENTS)
 #error "CH_CFG_USE_EVENTS not defined in chconf.h"
 #endif
@@ -140,6 +168,18 @@
 #error "CH_CFG_USE_MESSAGES_PRIORITY not defined in chconf.h"
 #endif
 
+#if !defined(CH_CFG_USE_MESSAGE_PORTS)
+#error "CH_CFG_USE_MESSAGE_PORTS not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_USE_POLL)
+#error "CH_CFG_USE_POLL not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_USE_IRQ_THREADS)
+#error "CH_CFG_USE_IRQ_THREADS not defined in chconf.h"
+#endif
+
 #if !defined(CH_CFG_USE_DYNAMIC)
 #error "CH_CFG_USE_DYNAMIC not defined in chconf.h"
 #endif
@@ -59,6 +59,8 @@
 typedef struct condition_variable {
   ch_queue_t            queue;              /**< @brief Condition variable
                                                  threads queue.             */
+  mutex_t               *mtxp;              /**< @brief Mutex associated to
+                                                 the waiting threads.       */
 } condition_variable_t;
 
 /*===========================================================================*/
@@ -72,7 +74,7 @@ typedef struct condition_variable {
  *
  * @param[in] name      the name of the condition variable
  */
-#define _CONDVAR_DATA(name) {_CH_QUEUE_DATA(name.queue)}
+#define _CONDVAR_DATA(name) {_CH_QUEUE_DATA(name.queue), NULL}
 
 /**
  * @brief Static condition variable initializer.
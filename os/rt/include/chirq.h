@@ -0,0 +1,199 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    rt/include/chirq.h
+ * @brief   Threaded interrupt handlers macros and structures.
+ *
+ * @addtogroup irq_threads
+ * @{
+ */
+
+#ifndef CHIRQ_H
+#define CHIRQ_H
+
+#if (CH_CFG_USE_IRQ_THREADS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of an IRQ thread.
+ */
+typedef struct ch_irq_thread irq_thread_t;
+
+/**
+ * @brief   Type of an IRQ source.
+ */
+typedef struct ch_irq_source irq_source_t;
+
+/**
+ * @brief   Type of a bottom half function.
+ *
+ * @param[in] arg       the argument specified at source initialization
+ */
+typedef void (*irq_bh_t)(void *arg);
+
+/**
+ * @brief   Structure representing an IRQ source.
+ * @details An IRQ source links the top half of an interrupt handler to its
+ *          bottom half, the source is queued on its IRQ thread when raised.
+ */
+struct ch_irq_source {
+  ch_queue_t            link;       /**< @brief Link into the pending queue
+                                                of the IRQ thread, it must
+                                                be the first field.         */
+  irq_thread_t          *itp;       /**< @brief Serving IRQ thread.         */
+  irq_bh_t              bh;         /**< @brief Bottom half function.       */
+  void                  *arg;       /**< @brief Bottom half argument.       */
+  bool                  pending;    /**< @brief Source queued and bottom half
+                                                not yet started.            */
+  ucnt_t                raised;     /**< @brief Number of raise operations. */
+  ucnt_t                coalesced;  /**< @brief Raise operations coalesced
+                                                into an already pending
+                                                bottom half.                */
+  ucnt_t                served;     /**< @brief Bottom half executions.     */
+#if (CH_CFG_USE_TM == TRUE) || defined(__DOXYGEN__)
+  time_measurement_t    tm;         /**< @brief Bottom half execution time
+                                                statistics.                 */
+#endif
+};
+
+/**
+ * @brief   Structure representing an IRQ thread.
+ * @details An IRQ thread executes, in FIFO order, the bottom halves of the
+ *          sources raised at its priority level.
+ */
+struct ch_irq_thread {
+  ch_queue_t            pending;    /**< @brief Queue of pending sources.   */
+  thread_t              *tp;        /**< @brief Pointer to the thread.      */
+  thread_reference_t    waiting;    /**< @brief Reference to the thread
+                                                while waiting for sources.  */
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Data part of a static IRQ source initializer.
+ * @details This macro should be used when statically initializing an
+ *          IRQ source that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the IRQ source variable
+ * @param[in] thread    the name of the serving IRQ thread variable
+ * @param[in] bh        the bottom half function
+ * @param[in] arg       the bottom half argument
+ */
+#if (CH_CFG_USE_TM == TRUE) || defined(__DOXYGEN__)
+#define _IRQ_SOURCE_DATA(name, thread, bh, arg)                             \
+  {{&(name).link, &(name).link}, &(thread), (bh), (arg), false,             \
+   (ucnt_t)0, (ucnt_t)0, (ucnt_t)0,                                         \
+   {(rtcnt_t)-1, (rtcnt_t)0, (rtcnt_t)0, (ucnt_t)0, (rttime_t)0}}
+#else
+#define _IRQ_SOURCE_DATA(name, thread, bh, arg)                             \
+  {{&(name).link, &(name).link}, &(thread), (bh), (arg), false,             \
+   (ucnt_t)0, (ucnt_t)0, (ucnt_t)0}
+#endif
+
+/**
+ * @brief   Static IRQ source initializer.
+ * @details Statically initialized IRQ sources require no explicit
+ *          initialization using @p chIRQSourceObjectInit().
+ *
+ * @param[in] name      the name of the IRQ source variable
+ * @param[in] thread    the name of the serving IRQ thread variable
+ * @param[in] bh        the bottom half function
+ * @param[in] arg       the bottom half argument
+ */
+#define IRQ_SOURCE_DECL(name, thread, bh, arg)                              \
+  irq_source_t name = _IRQ_SOURCE_DATA(name, thread, bh, arg)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  thread_t *chIRQThreadCreateI(irq_thread_t *itp, void *wsp,
+                               size_t size, tprio_t prio,
+                               const char *name);
+  thread_t *chIRQThreadCreateStatic(irq_thread_t *itp, void *wsp,
+                                    size_t size, tprio_t prio,
+                                    const char *name);
+  void chIRQSourceObjectInit(irq_source_t *isp, irq_thread_t *itp,
+                             irq_bh_t bh, void *arg);
+  bool chIRQRaiseI(irq_source_t *isp);
+  void chIRQRaiseS(irq_source_t *isp);
+  void chIRQRaise(irq_source_t *isp);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the thread serving an IRQ thread object.
+ *
+ * @param[in] itp       pointer to the @p irq_thread_t structure
+ * @return              Pointer to the thread.
+ *
+ * @xclass
+ */
+static inline thread_t *chIRQThreadGetThreadX(const irq_thread_t *itp) {
+
+  return itp->tp;
+}
+
+/**
+ * @brief   Returns @p true if the bottom half of a source is pending.
+ *
+ * @param[in] isp       pointer to the @p irq_source_t structure
+ * @return              The pending state.
+ *
+ * @iclass
+ */
+static inline bool chIRQIsPendingI(const irq_source_t *isp) {
+
+  chDbgCheckClassI();
+
+  return isp->pending;
+}
+
+#endif /* CH_CFG_USE_IRQ_THREADS == TRUE */
+
+#endif /* CHIRQ_H */
+
+/** @} */
@@ -28,12 +28,26 @@
 #ifndef CHMSG_H
 #define CHMSG_H
 
+#if (CH_CFG_USE_MESSAGE_PORTS == TRUE) && (CH_CFG_USE_MESSAGES == FALSE)
+#error "CH_CFG_USE_MESSAGE_PORTS requires CH_CFG_USE_MESSAGES"
+#endif
+
 #if (CH_CFG_USE_MESSAGES == TRUE) || defined(__DOXYGEN__)
 
 /*===========================================================================*/
 /* Module constants.                                                         */
 /*===========================================================================*/
 
+/**
+ * @name    Message descriptor states
+ * @{
+ */
+#define MSG_DESC_IDLE       (uint8_t)0  /**< @brief Not posted.             */
+#define MSG_DESC_QUEUED     (uint8_t)1  /**< @brief Queued on a port.       */
+#define MSG_DESC_RECEIVED   (uint8_t)2  /**< @brief Taken by the receiver.  */
+#define MSG_DESC_DONE       (uint8_t)3  /**< @brief Replied.                */
+/** @} */
+
 /*===========================================================================*/
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -46,10 +60,75 @@
 /* Module data structures and types.                                         */
 /*===========================================================================*/
 
+#if (CH_CFG_USE_MESSAGE_PORTS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Type of a message port structure.
+ */
+typedef struct ch_msg_port msg_port_t;
+
+/**
+ * @brief   Structure representing a message port.
+ */
+struct ch_msg_port {
+  ch_queue_t            queue;      /**< @brief Queue of the pending
+                                                message descriptors,
+                                                priority ordered.           */
+  msg_port_t            *next;      /**< @brief Next registered port.       */
+  const char            *name;      /**< @brief Port name or @p NULL.       */
+  thread_t              *owner;     /**< @brief Receiving thread or
+                                                @p NULL if the port is not
+                                                registered.                 */
+};
+
+/**
+ * @brief   Type of a message descriptor structure.
+ * @details A descriptor carries a reference to the message payload, the
+ *          payload itself is never copied. The descriptor and the
+ *          payload are owned by the sender and must remain valid until
+ *          the message has been replied or withdrawn.
+ */
+typedef struct {
+  ch_queue_t            link;       /**< @brief Port queue link, must be
+                                                the first field.            */
+  msg_port_t            *port;      /**< @brief Port the descriptor has
+                                                been posted to.             */
+  void                  *payload;   /**< @brief Message payload.            */
+  size_t                size;       /**< @brief Payload size.               */
+  tprio_t               prio;       /**< @brief Message priority.           */
+  uint8_t               state;      /**< @brief Descriptor state.           */
+  thread_reference_t    trp;        /**< @brief Thread waiting for the
+                                                reply or @p NULL.           */
+  msg_t                 result;     /**< @brief Reply message.              */
+} msg_desc_t;
+#endif /* CH_CFG_USE_MESSAGE_PORTS == TRUE */
+
 /*===========================================================================*/
 /* Module macros.                                                            */
 /*===========================================================================*/
 
+#if (CH_CFG_USE_MESSAGE_PORTS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Data part of a static message port initializer.
+ * @details This macro should be used when statically initializing a
+ *          message port that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the message port variable
+ * @param[in] pname     the port name string or @p NULL
+ */
+#define _MSG_PORT_DATA(name, pname)                                         \
+  {_CH_QUEUE_DATA(name.queue), NULL, (pname), NULL}
+
+/**
+ * @brief   Static message port initializer.
+ * @details Statically initialized message ports require no explicit
+ *          initialization using @p chMsgPortObjectInit().
+ *
+ * @param[in] name      the name of the message port variable
+ * @param[in] pname     the port name string or @p NULL
+ */
+#define MSG_PORT_DECL(name, pname) msg_port_t name = _MSG_PORT_DATA(name, pname)
+#endif /* CH_CFG_USE_MESSAGE_PORTS == TRUE */
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -62,6 +141,23 @@ extern "C" {
   thread_t *chMsgWaitTimeoutS(sysinterval_t timeout);
   thread_t *chMsgPollS(void);
   void chMsgRelease(thread_t *tp, msg_t msg);
+#if CH_CFG_USE_MESSAGE_PORTS == TRUE
+  void chMsgPortObjectInit(msg_port_t *mpp, const char *name);
+  void chMsgPortRegister(msg_port_t *mpp);
+  void chMsgPortUnregister(msg_port_t *mpp);
+  msg_port_t *chMsgPortFind(const char *name);
+  void chMsgDescObjectInit(msg_desc_t *mdp, void *payload, size_t size);
+  void chMsgPostI(msg_port_t *mpp, msg_desc_t *mdp, tprio_t prio);
+  void chMsgPost(msg_port_t *mpp, msg_desc_t *mdp, tprio_t prio);
+  msg_t chMsgSendTimeout(msg_port_t *mpp, msg_desc_t *mdp,
+                         sysinterval_t timeout);
+  msg_t chMsgCollectTimeoutS(msg_desc_t *mdp, sysinterval_t timeout);
+  msg_t chMsgCollectTimeout(msg_desc_t *mdp, sysinterval_t timeout);
+  msg_desc_t *chMsgReceiveTimeoutS(msg_port_t *mpp, sysinterval_t timeout);
+  msg_desc_t *chMsgReceiveTimeout(msg_port_t *mpp, sysinterval_t timeout);
+  void chMsgReplyI(msg_desc_t *mdp, msg_t msg);
+  void chMsgReply(msg_desc_t *mdp, msg_t msg);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -205,6 +301,96 @@ static inline void chMsgReleaseS(thread_t *tp, msg_t msg) {
   chSchWakeupS(tp, msg);
 }
 
+#if (CH_CFG_USE_MESSAGE_PORTS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the payload of a message descriptor.
+ *
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @return              The payload pointer.
+ *
+ * @xclass
+ */
+static inline void *chMsgDescGetPayloadX(msg_desc_t *mdp) {
+
+  return mdp->payload;
+}
+
+/**
+ * @brief   Returns the payload size of a message descriptor.
+ *
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @return              The payload size.
+ *
+ * @xclass
+ */
+static inline size_t chMsgDescGetSizeX(msg_desc_t *mdp) {
+
+  return mdp->size;
+}
+
+/**
+ * @brief   Returns the priority of a message descriptor.
+ *
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @return              The message priority.
+ *
+ * @xclass
+ */
+static inline tprio_t chMsgDescGetPrioX(msg_desc_t *mdp) {
+
+  return mdp->prio;
+}
+
+/**
+ * @brief   Returns @p true if the message has been replied.
+ *
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @return              The message state.
+ * @retval false        if the message is still pending.
+ * @retval true         if the message has been replied.
+ *
+ * @xclass
+ */
+static inline bool chMsgIsDoneX(msg_desc_t *mdp) {
+
+  return (bool)(mdp->state == MSG_DESC_DONE);
+}
+
+/**
+ * @brief   Returns @p true if there are messages pending on a port.
+ *
+ * @param[in] mpp       pointer to the @p msg_port_t structure
+ * @return              The port status.
+ *
+ * @iclass
+ */
+static inline bool chMsgPortIsPendingI(msg_port_t *mpp) {
+
+  chDbgCheckClassI();
+
+  return ch_queue_notempty(&mpp->queue);
+}
+
+/**
+ * @brief   Posts a message descriptor to a port.
+ * @details The message is queued by priority, among messages of the same
+ *          priority the order is FIFO. The function does not wait for
+ *          the reply, use @p chMsgCollectTimeout() in order to retrieve
+ *          it.
+ *
+ * @param[in] mpp       pointer to the @p msg_port_t structure
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @param[in] prio      the message priority
+ *
+ * @sclass
+ */
+static inline void chMsgPostS(msg_port_t *mpp, msg_desc_t *mdp, tprio_t prio) {
+
+  chMsgPostI(mpp, mdp, prio);
+  chSchRescheduleS();
+}
+#endif /* CH_CFG_USE_MESSAGE_PORTS == TRUE */
+
 #endif /* CH_CFG_USE_MESSAGES == TRUE */
 
 #endif /* CHMSG_H */
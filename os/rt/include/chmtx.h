@@ -34,10 +34,34 @@
 /* Module constants.                                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Flag of the owner field signaling waiting threads.
+ * @note    Only used when @p CH_CFG_USE_MUTEXES_FAST_PATH is enabled, it
+ *          forces the owner into the kernel slow path on unlock.
+ */
+#define CH_MTX_WAITERS_FLAG                 ((uintptr_t)1)
+
 /*===========================================================================*/
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Atomic compare and swap on the mutex owner field.
+ * @details If the variable pointed by @p p is equal to the value pointed
+ *          by @p expp then it is replaced with @p v and the macro
+ *          evaluates to @p true, else the macro evaluates to @p false.
+ * @note    The default implementation uses the GCC atomic builtins, it
+ *          requires an architecture with exclusive access instructions,
+ *          ARMv6-M cores require a specific definition.
+ * @note    The exclusive access must fail if an exception is taken between
+ *          the load and the store, this is the case for ARMv7-M cores.
+ */
+#if !defined(CH_MTX_CAS) || defined(__DOXYGEN__)
+#define CH_MTX_CAS(p, expp, v)                                              \
+  __atomic_compare_exchange_n(p, expp, v, false,                            \
+                              __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -58,12 +82,19 @@ struct ch_mutex {
   ch_queue_t            queue;      /**< @brief Queue of the threads sleeping
                                                 on this mutex.              */
   thread_t              *owner;     /**< @brief Owner @p thread_t pointer or
-                                                @p NULL.                    */
+                                                @p NULL, in fast path mode
+                                                it can be tagged with
+                                                @p CH_MTX_WAITERS_FLAG.     */
   mutex_t               *next;      /**< @brief Next @p mutex_t into an
                                                 owner-list or @p NULL.      */
 #if (CH_CFG_USE_MUTEXES_RECURSIVE == TRUE) || defined(__DOXYGEN__)
   cnt_t                 cnt;        /**< @brief Mutex recursion counter.    */
 #endif
+#if (CH_CFG_USE_MUTEXES_CEILING == TRUE) || defined(__DOXYGEN__)
+  tprio_t               ceiling;    /**< @brief Ceiling priority or
+                                                @p NOPRIO for priority
+                                                inheritance.                */
+#endif
 };
 
 /*===========================================================================*/
@@ -77,12 +108,32 @@ struct ch_mutex {
  *
  * @param[in] name      the name of the mutex variable
  */
-#if (CH_CFG_USE_MUTEXES_RECURSIVE == TRUE) || defined(__DOXYGEN__)
+#if (CH_CFG_USE_MUTEXES_CEILING == TRUE) || defined(__DOXYGEN__)
+#define _MUTEX_DATA(name) _MUTEX_CEILING_DATA(name, NOPRIO)
+#elif CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
 #define _MUTEX_DATA(name) {_CH_QUEUE_DATA(name.queue), NULL, NULL, 0}
 #else
 #define _MUTEX_DATA(name) {_CH_QUEUE_DATA(name.queue), NULL, NULL}
 #endif
 
+#if (CH_CFG_USE_MUTEXES_CEILING == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Data part of a static priority ceiling mutex initializer.
+ * @details This macro should be used when statically initializing a mutex
+ *          that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the mutex variable
+ * @param[in] ceiling   the ceiling priority
+ */
+#if (CH_CFG_USE_MUTEXES_RECURSIVE == TRUE) || defined(__DOXYGEN__)
+#define _MUTEX_CEILING_DATA(name, ceiling)                                  \
+  {_CH_QUEUE_DATA(name.queue), NULL, NULL, 0, ceiling}
+#else
+#define _MUTEX_CEILING_DATA(name, ceiling)                                  \
+  {_CH_QUEUE_DATA(name.queue), NULL, NULL, ceiling}
+#endif
+#endif
+
 /**
  * @brief   Static mutex initializer.
  * @details Statically initialized mutexes require no explicit initialization
@@ -92,6 +143,19 @@ struct ch_mutex {
  */
 #define MUTEX_DECL(name) mutex_t name = _MUTEX_DATA(name)
 
+#if (CH_CFG_USE_MUTEXES_CEILING == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Static priority ceiling mutex initializer.
+ * @details Statically initialized mutexes require no explicit initialization
+ *          using @p chMtxObjectInitCeiling().
+ *
+ * @param[in] name      the name of the mutex variable
+ * @param[in] ceiling   the ceiling priority
+ */
+#define MUTEX_CEILING_DECL(name, ceiling)                                   \
+  mutex_t name = _MUTEX_CEILING_DATA(name, ceiling)
+#endif
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -99,7 +163,13 @@ struct ch_mutex {
 #ifdef __cplusplus
 extern "C" {
 #endif
+  void _mtx_boost(thread_t *tp, tprio_t prio);
+  void _mtx_requeue_allI(mutex_t *mp, ch_queue_t *qp, msg_t msg);
+  tprio_t _mtx_get_prio(thread_t *tp);
   void chMtxObjectInit(mutex_t *mp);
+#if CH_CFG_USE_MUTEXES_CEILING == TRUE
+  void chMtxObjectInitCeiling(mutex_t *mp, tprio_t ceiling);
+#endif
   void chMtxLock(mutex_t *mp);
   void chMtxLockS(mutex_t *mp);
   bool chMtxTryLock(mutex_t *mp);
@@ -116,6 +186,24 @@ extern "C" {
 /* Module inline functions.                                                  */
 /*===========================================================================*/
 
+/**
+ * @brief   Returns the mutex owner thread removing the waiters flag.
+ *
+ * @param[in] mp        pointer to a @p mutex_t structure
+ * @return              The owner thread.
+ * @retval NULL         if the mutex is not owned.
+ *
+ * @notapi
+ */
+static inline thread_t *ch_mtx_get_owner(const mutex_t *mp) {
+
+#if CH_CFG_USE_MUTEXES_FAST_PATH == TRUE
+  return (thread_t *)((uintptr_t)mp->owner & ~CH_MTX_WAITERS_FLAG);
+#else
+  return mp->owner;
+#endif
+}
+
 /**
  * @brief   Returns @p true if the mutex queue contains at least a waiting
  *          thread.
@@ -145,7 +233,7 @@ static inline thread_t *chMtxGetOwnerI(mutex_t *mp) {
 
   chDbgCheckClassI();
 
-  return mp->owner;
+  return ch_mtx_get_owner(mp);
 }
 
 /**
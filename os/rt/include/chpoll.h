@@ -0,0 +1,243 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    rt/include/chpoll.h
+ * @brief   Multiplexed wait macros and structures.
+ *
+ * @addtogroup polling
+ * @{
+ */
+
+#ifndef CHPOLL_H
+#define CHPOLL_H
+
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Polling directions
+ * @{
+ */
+#define CH_POLL_IN          0U  /**< @brief Data or resource available.     */
+#define CH_POLL_OUT         1U  /**< @brief Space available.                */
+/** @} */
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a poll set.
+ */
+typedef struct ch_poll_set poll_set_t;
+
+/**
+ * @brief   Type of a poll item.
+ */
+typedef struct ch_poll_item poll_item_t;
+
+/**
+ * @brief   Type of a readiness test function.
+ * @details The function is invoked from within the system lock zone and
+ *          returns @p true if an operation on the object would not block.
+ *
+ * @param[in] pip       pointer to the @p poll_item_t structure
+ * @return              The readiness state.
+ */
+typedef bool (*poll_ready_t)(poll_item_t *pip);
+
+/**
+ * @brief   Structure representing a poll item.
+ * @details A poll item links a poll set to a single object, it is linked
+ *          into the pollers queue of the object while it belongs to the
+ *          set.
+ */
+struct ch_poll_item {
+  ch_queue_t            link;       /**< @brief Link into the pollers queue
+                                                of the object, it must be
+                                                the first field.            */
+  poll_item_t           *next;      /**< @brief Next item in the set.       */
+  poll_set_t            *psp;       /**< @brief Owner poll set.             */
+  poll_ready_t          ready;      /**< @brief Readiness test function.    */
+  void                  *objp;      /**< @brief Polled object.              */
+#if (CH_CFG_USE_EVENTS == TRUE) || defined(__DOXYGEN__)
+  eventmask_t           events;     /**< @brief Polled events mask, events
+                                                items only.                 */
+#endif
+  bool                  fired;      /**< @brief Item found ready by the
+                                                last wait.                  */
+};
+
+/**
+ * @brief   Structure representing a poll set.
+ */
+struct ch_poll_set {
+  poll_item_t           *items;     /**< @brief Items list.                 */
+  thread_t              *tp;        /**< @brief Thread waiting on the set
+                                                or @p NULL.                 */
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Data part of a static poll set initializer.
+ * @details This macro should be used when statically initializing a
+ *          poll set that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the poll set variable
+ */
+#define _POLL_SET_DATA(name) {NULL, NULL}
+
+/**
+ * @brief   Static poll set initializer.
+ * @details Statically initialized poll sets require no explicit
+ *          initialization using @p chPollObjectInit().
+ *
+ * @param[in] name      the name of the poll set variable
+ */
+#define POLL_SET_DECL(name) poll_set_t name = _POLL_SET_DATA(name)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void _poll_signalI(ch_queue_t *qp);
+  void chPollObjectInit(poll_set_t *psp);
+  void chPollAddObject(poll_set_t *psp, poll_item_t *pip, ch_queue_t *qp,
+                       poll_ready_t ready, void *objp);
+  void chPollRemove(poll_item_t *pip);
+#if (CH_CFG_USE_SEMAPHORES == TRUE) || defined(__DOXYGEN__)
+  void chPollAddSemaphore(poll_set_t *psp, poll_item_t *pip,
+                          semaphore_t *sp);
+#endif
+#if (CH_CFG_USE_EVENTS == TRUE) || defined(__DOXYGEN__)
+  void chPollAddEvents(poll_set_t *psp, poll_item_t *pip,
+                       eventmask_t events);
+#endif
+  cnt_t chPollWaitTimeoutS(poll_set_t *psp, sysinterval_t timeout);
+  cnt_t chPollWaitTimeout(poll_set_t *psp, sysinterval_t timeout);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Wakes up the threads polling an object.
+ * @details This function must be invoked by pollable objects each time
+ *          their state changes in a way that could make a blocking
+ *          operation possible.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] qp        pointer to the pollers queue of the object
+ *
+ * @iclass
+ */
+static inline void chPollSignalI(ch_queue_t *qp) {
+
+  chDbgCheckClassI();
+
+  if (ch_queue_notempty(qp)) {
+    _poll_signalI(qp);
+  }
+}
+
+/**
+ * @brief   Returns the readiness state found by the last wait.
+ *
+ * @param[in] pip       pointer to the @p poll_item_t structure
+ * @return              The readiness state.
+ * @retval true         if the object was ready.
+ * @retval false        if the object was not ready.
+ *
+ * @xclass
+ */
+static inline bool chPollIsReadyX(const poll_item_t *pip) {
+
+  return pip->fired;
+}
+
+/**
+ * @brief   Returns the object associated to a poll item.
+ *
+ * @param[in] pip       pointer to the @p poll_item_t structure
+ * @return              The pointer to the polled object.
+ *
+ * @xclass
+ */
+static inline void *chPollGetObjectX(const poll_item_t *pip) {
+
+  return pip->objp;
+}
+
+#if (CH_CFG_USE_EVENTS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Adds an event source to a poll set.
+ * @details The listener is registered on the event source for the current
+ *          thread using the specified events mask, then the mask is added
+ *          to the poll set.
+ * @note    The listener must be unregistered using @p chEvtUnregister()
+ *          after the item has been removed from the set.
+ *
+ * @param[in] psp       pointer to the @p poll_set_t structure
+ * @param[out] pip      pointer to the @p poll_item_t structure
+ * @param[in] esp       pointer to the @p event_source_t structure
+ * @param[out] elp      pointer to the @p event_listener_t structure
+ * @param[in] events    the mask of events to be ORed to the thread when
+ *                      the event source is broadcasted
+ *
+ * @api
+ */
+static inline void chPollAddEventSource(poll_set_t *psp, poll_item_t *pip,
+                                        event_source_t *esp,
+                                        event_listener_t *elp,
+                                        eventmask_t events) {
+
+  chEvtRegisterMask(esp, elp, events);
+  chPollAddEvents(psp, pip, events);
+}
+#endif /* CH_CFG_USE_EVENTS == TRUE */
+
+#endif /* CH_CFG_USE_POLL == TRUE */
+
+#endif /* CHPOLL_H */
+
+/** @} */
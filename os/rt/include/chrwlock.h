@@ -0,0 +1,182 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    rt/include/chrwlock.h
+ * @brief   Read-Write Locks macros and structures.
+ *
+ * @addtogroup rwlocks
+ * @{
+ */
+
+#ifndef CHRWLOCK_H
+#define CHRWLOCK_H
+
+#if (CH_CFG_USE_RWLOCKS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if CH_CFG_USE_MUTEXES == FALSE
+#error "CH_CFG_USE_RWLOCKS requires CH_CFG_USE_MUTEXES"
+#endif
+
+#if CH_CFG_RWLOCKS_MAX_HOLDS < 1
+#error "invalid CH_CFG_RWLOCKS_MAX_HOLDS value"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a read-write lock structure.
+ */
+typedef struct ch_rwlock rwlock_t;
+
+/**
+ * @brief   Read-write lock structure.
+ */
+struct ch_rwlock {
+  ch_queue_t            rqueue;     /**< @brief Queue of the threads waiting
+                                                for shared access.          */
+  ch_queue_t            wqueue;     /**< @brief Queue of the threads waiting
+                                                for exclusive access.       */
+  thread_t              *owner;     /**< @brief Exclusive owner or @p NULL. */
+  rwlock_holder_t       *holders;   /**< @brief List of the current holders
+                                                or @p NULL.                 */
+  cnt_t                 readers;    /**< @brief Number of shared holders.   */
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Data part of a static read-write lock initializer.
+ * @details This macro should be used when statically initializing a
+ *          read-write lock that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the read-write lock variable
+ */
+#define _RWLOCK_DATA(name) {_CH_QUEUE_DATA(name.rqueue),                    \
+                            _CH_QUEUE_DATA(name.wqueue),                    \
+                            NULL, NULL, (cnt_t)0}
+
+/**
+ * @brief   Static read-write lock initializer.
+ * @details Statically initialized read-write locks require no explicit
+ *          initialization using @p chRWLockObjectInit().
+ *
+ * @param[in] name      the name of the read-write lock variable
+ */
+#define RWLOCK_DECL(name) rwlock_t name = _RWLOCK_DATA(name)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void _rwlock_boost(thread_t *tp);
+  tprio_t _rwlock_get_prio(thread_t *tp, tprio_t prio);
+  void chRWLockObjectInit(rwlock_t *rwp);
+  msg_t chRWLockLockSharedTimeout(rwlock_t *rwp, sysinterval_t timeout);
+  msg_t chRWLockLockSharedTimeoutS(rwlock_t *rwp, sysinterval_t timeout);
+  msg_t chRWLockLockExclusiveTimeout(rwlock_t *rwp, sysinterval_t timeout);
+  msg_t chRWLockLockExclusiveTimeoutS(rwlock_t *rwp, sysinterval_t timeout);
+  void chRWLockUnlock(rwlock_t *rwp);
+  void chRWLockUnlockS(rwlock_t *rwp);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Acquires a read-write lock in shared mode.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ *
+ * @api
+ */
+static inline void chRWLockLockShared(rwlock_t *rwp) {
+
+  (void) chRWLockLockSharedTimeout(rwp, TIME_INFINITE);
+}
+
+/**
+ * @brief   Acquires a read-write lock in exclusive mode.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ *
+ * @api
+ */
+static inline void chRWLockLockExclusive(rwlock_t *rwp) {
+
+  (void) chRWLockLockExclusiveTimeout(rwp, TIME_INFINITE);
+}
+
+/**
+ * @brief   Returns @p true if the read-write lock is held in exclusive mode.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ * @return              The lock status.
+ *
+ * @iclass
+ */
+static inline bool chRWLockIsExclusiveI(rwlock_t *rwp) {
+
+  chDbgCheckClassI();
+
+  return (bool)(rwp->owner != NULL);
+}
+
+/**
+ * @brief   Returns the number of threads holding the lock in shared mode.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ * @return              The number of shared holders.
+ *
+ * @iclass
+ */
+static inline cnt_t chRWLockGetReadersI(rwlock_t *rwp) {
+
+  chDbgCheckClassI();
+
+  return rwp->readers;
+}
+
+#endif /* CH_CFG_USE_RWLOCKS == TRUE */
+
+#endif /* CHRWLOCK_H */
+
+/** @} */
@@ -79,6 +79,13 @@
 #define CH_STATE_WTMSG      (tstate_t)14     /**< @brief Waiting for a
                                                   message.                  */
 #define CH_STATE_FINAL      (tstate_t)15     /**< @brief Thread terminated. */
+#define CH_STATE_WTRWSH     (tstate_t)16     /**< @brief On a read-write
+                                                  lock, shared access.      */
+#define CH_STATE_WTRWEX     (tstate_t)17     /**< @brief On a read-write
+                                                  lock, exclusive access.   */
+#define CH_STATE_WTPOLL     (tstate_t)18     /**< @brief On a poll set.     */
+#define CH_STATE_WTPORT     (tstate_t)19     /**< @brief Waiting on message
+                                                  ports.                    */
 
 /**
  * @brief   Thread states as array of strings.
@@ -88,7 +95,7 @@
 #define CH_STATE_NAMES                                                     \
   "READY", "CURRENT", "WTSTART", "SUSPENDED", "QUEUED", "WTSEM", "WTMTX",  \
   "WTCOND", "SLEEPING", "WTEXIT", "WTOREVT", "WTANDEVT", "SNDMSGQ",        \
-  "SNDMSG", "WTMSG", "FINAL"
+  "SNDMSG", "WTMSG", "FINAL", "WTRWSH", "WTRWEX", "WTPOLL", "WTPORT"
 /** @} */
 
 /**
@@ -104,6 +111,8 @@
                                                  from a Memory Pool.        */
 #define CH_FLAG_TERMINATE   (tmode_t)4U     /**< @brief Termination requested
                                                  flag.                      */
+#define CH_FLAG_DEADLINE    (tmode_t)8U     /**< @brief Thread deadline
+                                                 assigned.                  */
 /** @} */
 
 /*===========================================================================*/
@@ -125,6 +134,58 @@ struct ch_threads_queue {
   ch_queue_t            queue;      /**< @brief Threads queue header.       */
 };
 
+#if (CH_CFG_USE_RWLOCKS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Structure representing a read-write lock holder record.
+ * @note    Holder records are part of the holding thread structure.
+ */
+struct ch_rwlock_holder {
+  rwlock_holder_t       *next;      /**< @brief Next holder of the same
+                                                lock or @p NULL.            */
+  thread_t              *tp;        /**< @brief Holding thread.             */
+  struct ch_rwlock      *rwp;       /**< @brief Held lock or @p NULL if the
+                                                record is not in use.       */
+};
+#endif
+
+#if (CH_CFG_USE_PERIODIC == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Type of a periodic thread deadline miss callback.
+ *
+ * @param[in] tp        pointer to the thread that missed its deadline
+ * @param[in] response  response time of the late activation
+ */
+typedef void (*periodic_cb_t)(thread_t *tp, sysinterval_t response);
+
+/**
+ * @brief   Periodic thread activation state and statistics.
+ * @note    Times are expressed in system ticks, the average response time
+ *          is @p rcumulative divided by @p n.
+ */
+typedef struct {
+  systime_t             release;    /**< @brief Release time of the current
+                                                activation.                 */
+  sysinterval_t         period;     /**< @brief Activation period or zero
+                                                if the thread is not
+                                                periodic.                   */
+  sysinterval_t         deadline;   /**< @brief Relative deadline.          */
+  periodic_cb_t         misscb;     /**< @brief Deadline miss callback or
+                                                @p NULL.                    */
+  ucnt_t                n;          /**< @brief Completed activations.      */
+  sysinterval_t         rbest;      /**< @brief Best response time.         */
+  sysinterval_t         rworst;     /**< @brief Worst response time.        */
+  rttime_t              rcumulative;/**< @brief Cumulative response time.   */
+  sysinterval_t         lbest;      /**< @brief Best release latency.       */
+  sysinterval_t         lworst;     /**< @brief Worst release latency, the
+                                                release jitter is
+                                                @p lworst - @p lbest.       */
+  ucnt_t                overruns;   /**< @brief Activations that ran past
+                                                the next release time.      */
+  ucnt_t                misses;     /**< @brief Activations that completed
+                                                after their deadline.       */
+} thread_periodic_t;
+#endif
+
 /**
  * @brief   Structure representing a thread.
  * @note    Not all the listed fields are always needed, by switching off some
@@ -210,7 +271,9 @@ struct ch_thread {
      * @brief   Pointer to a generic "wait" object.
      * @note    This field is used to get a generic pointer to a synchronization
      *          object and is valid when the thread is in one of the wait
-     *          states.
+     *          states. In @p CH_STATE_WTPORT state it points to the port
+     *          being waited on or is @p NULL when waiting on all the
+     *          ports owned by the thread.
      */
     void                *wtobjp;
     /**
@@ -244,11 +307,21 @@ struct ch_thread {
      */
     struct ch_mutex     *wtmtxp;
 #endif
+#if (CH_CFG_USE_RWLOCKS == TRUE) || defined(__DOXYGEN__)
+    /**
+     * @brief   Pointer to a generic read-write lock object.
+     * @note    This field is used to get a pointer to a synchronization
+     *          object and is valid when the thread is in @p CH_STATE_WTRWSH
+     *          or @p CH_STATE_WTRWEX states.
+     */
+    struct ch_rwlock    *wtrwlockp;
+#endif
 #if (CH_CFG_USE_EVENTS == TRUE) || defined(__DOXYGEN__)
     /**
      * @brief   Enabled events mask.
      * @note    This field is only valid while the thread is in the
-     *          @p CH_STATE_WTOREVT or @p CH_STATE_WTANDEVT states.
+     *          @p CH_STATE_WTOREVT, @p CH_STATE_WTANDEVT or
+     *          @p CH_STATE_WTPOLL states.
      */
     eventmask_t         ewmask;
 #endif
@@ -282,6 +355,30 @@ struct ch_thread {
    */
   tprio_t               realprio;
 #endif
+#if (CH_CFG_USE_EDF == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   Absolute deadline of the thread.
+   * @note    This field is only valid if the @p CH_FLAG_DEADLINE flag is
+   *          set.
+   */
+  systime_t             deadline;
+  /**
+   * @brief   Number of deadlines missed by the thread.
+   */
+  ucnt_t                dlmisses;
+#endif
+#if (CH_CFG_USE_PERIODIC == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   Periodic activation state and statistics.
+   */
+  thread_periodic_t     periodic;
+#endif
+#if (CH_CFG_USE_RWLOCKS == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   Read-write locks held by this thread.
+   */
+  rwlock_holder_t       rwholds[CH_CFG_RWLOCKS_MAX_HOLDS];
+#endif
 #if ((CH_CFG_USE_DYNAMIC == TRUE) && (CH_CFG_USE_MEMPOOLS == TRUE)) ||      \
     defined(__DOXYGEN__)
   /**
@@ -478,6 +575,7 @@ extern "C" {
   void _scheduler_init(void);
   thread_t *chSchReadyI(thread_t *tp);
   thread_t *chSchReadyAheadI(thread_t *tp);
+  void chSchReadyAllI(ch_queue_t *qp, msg_t msg);
   void chSchGoSleepS(tstate_t newstate);
   msg_t chSchGoSleepTimeoutS(tstate_t newstate, sysinterval_t timeout);
   void chSchWakeupS(thread_t *ntp, msg_t msg);
@@ -517,10 +615,63 @@ static inline void ch_sch_prio_insert(ch_queue_t *tp, ch_queue_t *qp) {
 #pragma GCC diagnostic pop
 #endif /* CH_CFG_OPTIMIZE_SPEED == TRUE */
 
+/**
+ * @brief   Compares two deadlines.
+ * @note    The deadlines must be less than half of the system time range
+ *          apart.
+ *
+ * @param[in] d1        the first deadline
+ * @param[in] d2        the second deadline
+ * @return              The comparison result.
+ * @retval true         if @p d1 is earlier than @p d2.
+ * @retval false        if @p d1 is equal or later than @p d2.
+ *
+ * @notapi
+ */
+static inline bool ch_sch_deadline_before(systime_t d1, systime_t d2) {
+  systime_t diff = (systime_t)(d2 - d1);
+
+  return (diff > (systime_t)0) && (diff <= ((systime_t)-1 / (systime_t)2));
+}
+
+/**
+ * @brief   Determines if a thread must run before another in the EDF band.
+ * @details Threads at the @p CH_CFG_EDF_PRIORITY level are ordered by
+ *          absolute deadline, threads without a deadline come after
+ *          threads having one.
+ *
+ * @param[in] tp1       pointer to the first thread
+ * @param[in] tp2       pointer to the second thread
+ * @return              The comparison result.
+ * @retval true         if both threads are in the EDF band and @p tp1 has
+ *                      an earlier deadline.
+ * @retval false        otherwise.
+ *
+ * @notapi
+ */
+static inline bool ch_sch_edf_before(const thread_t *tp1,
+                                     const thread_t *tp2) {
+
+#if CH_CFG_USE_EDF == TRUE
+  if ((tp1->hdr.pqueue.prio == CH_CFG_EDF_PRIORITY) &&
+      (tp2->hdr.pqueue.prio == CH_CFG_EDF_PRIORITY) &&
+      ((tp1->flags & CH_FLAG_DEADLINE) != (tmode_t)0)) {
+
+    return ((tp2->flags & CH_FLAG_DEADLINE) == (tmode_t)0) ||
+           ch_sch_deadline_before(tp1->deadline, tp2->deadline);
+  }
+#else
+  (void)tp1;
+  (void)tp2;
+#endif
+
+  return false;
+}
+
 /**
  * @brief   Determines if the current thread must reschedule.
  * @details This function returns @p true if there is a ready thread with
- *          higher priority.
+ *          higher priority or, in the EDF band, with an earlier deadline.
  *
  * @return              The priorities situation.
  * @retval false        if rescheduling is not necessary.
@@ -532,7 +683,8 @@ static inline bool chSchIsRescRequiredI(void) {
 
   chDbgCheckClassI();
 
-  return firstprio(&ch.rlist.pqueue) > currp->hdr.pqueue.prio;
+  return (firstprio(&ch.rlist.pqueue) > currp->hdr.pqueue.prio) ||
+         ch_sch_edf_before((thread_t *)ch.rlist.pqueue.next, currp);
 }
 
 /**
@@ -548,9 +700,16 @@ static inline bool chSchIsRescRequiredI(void) {
  */
 static inline bool chSchCanYieldS(void) {
 
+  tprio_t p1 = firstprio(&ch.rlist.pqueue);
+  tprio_t p2 = currp->hdr.pqueue.prio;
+
   chDbgCheckClassS();
 
-  return firstprio(&ch.rlist.pqueue) >= currp->hdr.pqueue.prio;
+  /* In the EDF band the current thread does not yield to threads with
+     later deadlines.*/
+  return (p1 > p2) ||
+         ((p1 == p2) &&
+          !ch_sch_edf_before(currp, (thread_t *)ch.rlist.pqueue.next));
 }
 
 /**
@@ -577,22 +736,23 @@ static inline void chSchDoYieldS(void) {
  * @special
  */
 static inline void chSchPreemption(void) {
+  thread_t *ntp = (thread_t *)ch.rlist.pqueue.next;
   tprio_t p1 = firstprio(&ch.rlist.pqueue);
   tprio_t p2 = currp->hdr.pqueue.prio;
 
 #if CH_CFG_TIME_QUANTUM > 0
   if (currp->ticks > (tslices_t)0) {
-    if (p1 > p2) {
+    if ((p1 > p2) || ch_sch_edf_before(ntp, currp)) {
       chSchDoRescheduleAhead();
     }
   }
   else {
-    if (p1 >= p2) {
+    if ((p1 > p2) || ((p1 == p2) && !ch_sch_edf_before(currp, ntp))) {
       chSchDoRescheduleBehind();
     }
   }
 #else /* CH_CFG_TIME_QUANTUM == 0 */
-  if (p1 > p2) {
+  if ((p1 > p2) || ch_sch_edf_before(ntp, currp)) {
     chSchDoRescheduleAhead();
   }
 #endif /* CH_CFG_TIME_QUANTUM == 0 */
@@ -53,6 +53,10 @@ typedef struct ch_semaphore {
   ch_queue_t            queue;      /**< @brief Queue of the threads sleeping
                                                 on this semaphore.          */
   cnt_t                 cnt;        /**< @brief The semaphore counter.      */
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+  ch_queue_t            pollers;    /**< @brief Queue of the poll items
+                                                linked to this semaphore.   */
+#endif
 } semaphore_t;
 
 /*===========================================================================*/
@@ -68,7 +72,12 @@ typedef struct ch_semaphore {
  * @param[in] n         the counter initial value, this value must be
  *                      non-negative
  */
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+#define _SEMAPHORE_DATA(name, n) {_CH_QUEUE_DATA(name.queue), n,            \
+                                  _CH_QUEUE_DATA(name.pollers)}
+#else
 #define _SEMAPHORE_DATA(name, n) {_CH_QUEUE_DATA(name.queue), n}
+#endif
 
 /**
  * @brief   Static semaphore initializer.
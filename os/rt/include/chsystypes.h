@@ -51,6 +51,11 @@
  */
 typedef struct ch_thread thread_t;
 
+/**
+ * @brief   Type of a read-write lock holder record.
+ */
+typedef struct ch_rwlock_holder rwlock_holder_t;
+
 /**
  * @brief   Type of a thread reference.
  */
@@ -257,6 +257,14 @@ extern "C" {
   void chThdSleepUntil(systime_t time);
   systime_t chThdSleepUntilWindowed(systime_t prev, systime_t next);
   void chThdYield(void);
+#if CH_CFG_USE_PERIODIC == TRUE
+  void chThdSetPeriodic(sysinterval_t period, sysinterval_t phase,
+                        sysinterval_t deadline, periodic_cb_t misscb);
+  bool chThdWaitNextPeriod(void);
+#endif
+#if CH_CFG_USE_EDF == TRUE
+  void chThdSetDeadline(systime_t deadline);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -307,6 +315,53 @@ static inline systime_t chThdGetTicksX(thread_t *tp) {
 }
 #endif
 
+#if (CH_CFG_USE_EDF == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the absolute deadline of the specified thread.
+ * @note    The value is only meaningful if a deadline has been assigned
+ *          to the thread.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The thread deadline.
+ *
+ * @xclass
+ */
+static inline systime_t chThdGetDeadlineX(thread_t *tp) {
+
+  return tp->deadline;
+}
+
+/**
+ * @brief   Returns the number of deadlines missed by the specified thread.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The number of missed deadlines.
+ *
+ * @xclass
+ */
+static inline ucnt_t chThdGetDeadlineMissesX(thread_t *tp) {
+
+  return tp->dlmisses;
+}
+#endif
+
+#if (CH_CFG_USE_PERIODIC == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the periodic activation statistics of a thread.
+ * @note    The statistics are updated by the thread itself, a consistent
+ *          snapshot requires reading them from within a critical zone.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              Pointer to the periodic activation structure.
+ *
+ * @xclass
+ */
+static inline const thread_periodic_t *chThdGetPeriodicX(thread_t *tp) {
+
+  return &tp->periodic;
+}
+#endif
+
 #if (CH_DBG_ENABLE_STACK_CHECK == TRUE) || (CH_CFG_USE_DYNAMIC == TRUE) ||  \
     defined(__DOXYGEN__)
 /**
@@ -37,12 +37,21 @@ endif
 ifneq ($(findstring CH_CFG_USE_CONDVARS TRUE,$(CHCONF)),)
 KERNSRC += $(CHIBIOS)/os/rt/src/chcond.c
 endif
+ifneq ($(findstring CH_CFG_USE_RWLOCKS TRUE,$(CHCONF)),)
+KERNSRC += $(CHIBIOS)/os/rt/src/chrwlock.c
+endif
 ifneq ($(findstring CH_CFG_USE_EVENTS TRUE,$(CHCONF)),)
 KERNSRC += $(CHIBIOS)/os/rt/src/chevents.c
 endif
 ifneq ($(findstring CH_CFG_USE_MESSAGES TRUE,$(CHCONF)),)
 KERNSRC += $(CHIBIOS)/os/rt/src/chmsg.c
 endif
+ifneq ($(findstring CH_CFG_USE_POLL TRUE,$(CHCONF)),)
+KERNSRC += $(CHIBIOS)/os/rt/src/chpoll.c
+endif
+ifneq ($(findstring CH_CFG_USE_IRQ_THREADS TRUE,$(CHCONF)),)
+KERNSRC += $(CHIBIOS)/os/rt/src/chirq.c
+endif
 ifneq ($(findstring CH_CFG_USE_DYNAMIC TRUE,$(CHCONF)),)
 KERNSRC += $(CHIBIOS)/os/rt/src/chdynamic.c
 endif
@@ -59,8 +68,11 @@ KERNSRC := $(CHIBIOS)/os/rt/src/chsys.c \
            $(CHIBIOS)/os/rt/src/chsem.c \
            $(CHIBIOS)/os/rt/src/chmtx.c \
            $(CHIBIOS)/os/rt/src/chcond.c \
+           $(CHIBIOS)/os/rt/src/chrwlock.c \
            $(CHIBIOS)/os/rt/src/chevents.c \
            $(CHIBIOS)/os/rt/src/chmsg.c \
+           $(CHIBIOS)/os/rt/src/chpoll.c \
+           $(CHIBIOS)/os/rt/src/chirq.c \
            $(CHIBIOS)/os/rt/src/chdynamic.c
 endif
 
@@ -32,6 +32,12 @@
  *          The condition variable is a synchronization object meant to be
  *          used inside a zone protected by a mutex. Mutexes and condition
  *          variables together can implement a Monitor construct.
+ *          <h2>Wait morphing</h2>
+ *          A broadcast does not awaken all the waiting threads, they are
+ *          moved directly on the queue of the associated mutex and are
+ *          awakened one at time as the mutex is passed along. All the
+ *          threads waiting on a condition variable must use the same
+ *          mutex.
  * @pre     In order to use the condition variable APIs the @p CH_CFG_USE_CONDVARS
  *          option must be enabled in @p chconf.h.
  * @{
@@ -77,6 +83,7 @@ void chCondObjectInit(condition_variable_t *cp) {
   chDbgCheck(cp != NULL);
 
   ch_queue_init(&cp->queue);
+  cp->mtxp = NULL;
 }
 
 /**
@@ -151,12 +158,11 @@ void chCondBroadcastI(condition_variable_t *cp) {
   chDbgCheckClassI();
   chDbgCheck(cp != NULL);
 
-  /* Empties the condition variable queue and inserts all the threads into the
-     ready list in FIFO order. The wakeup message is set to @p MSG_RESET in
-     order to make a chCondBroadcast() detectable from a chCondSignal().*/
-  while (ch_queue_notempty(&cp->queue)) {
-    chSchReadyI((thread_t *)ch_queue_fifo_remove(&cp->queue))->u.rdymsg = MSG_RESET;
-  }
+  /* Empties the condition variable queue moving all the threads on the
+     mutex queue, only the thread taking the mutex is awakened. The wakeup
+     message is set to @p MSG_RESET in order to make a chCondBroadcast()
+     detectable from a chCondSignal().*/
+  _mtx_requeue_allI(cp->mtxp, &cp->queue, MSG_RESET);
 }
 
 /**
@@ -211,14 +217,26 @@ msg_t chCondWaitS(condition_variable_t *cp) {
   chDbgCheck(cp != NULL);
   chDbgAssert(mp != NULL, "not owning a mutex");
 
+  chDbgAssert(ch_queue_isempty(&cp->queue) || (cp->mtxp == mp),
+              "different mutexes");
+
   /* Releasing "current" mutex.*/
   chMtxUnlockS(mp);
 
+  chDbgAssert(ch_mtx_get_owner(mp) != ctp, "mutex still owned");
+
   /* Start waiting on the condition variable, on exit the mutex is taken
      again.*/
   ctp->u.wtobjp = cp;
+  cp->mtxp = mp;
   ch_sch_prio_insert(&ctp->hdr.queue, &cp->queue);
   chSchGoSleepS(CH_STATE_WTCOND);
+
+  /* After a broadcast the mutex has already been assigned to this
+     thread.*/
+  if (ch_mtx_get_owner(mp) == ctp) {
+    return MSG_RESET;
+  }
   msg = ctp->u.rdymsg;
   chMtxLockS(mp);
 
@@ -300,14 +318,26 @@ msg_t chCondWaitTimeoutS(condition_variable_t *cp, sysinterval_t timeout) {
   chDbgCheck((cp != NULL) && (timeout != TIME_IMMEDIATE));
   chDbgAssert(mp != NULL, "not owning a mutex");
 
+  chDbgAssert(ch_queue_isempty(&cp->queue) || (cp->mtxp == mp),
+              "different mutexes");
+
   /* Releasing "current" mutex.*/
   chMtxUnlockS(mp);
 
+  chDbgAssert(ch_mtx_get_owner(mp) != currp, "mutex still owned");
+
   /* Start waiting on the condition variable, on exit the mutex is taken
      again.*/
   currp->u.wtobjp = cp;
+  cp->mtxp = mp;
   ch_sch_prio_insert(&currp->hdr.queue, &cp->queue);
   msg = chSchGoSleepTimeoutS(CH_STATE_WTCOND, timeout);
+
+  /* After a broadcast the mutex has already been assigned to this
+     thread, the timeout no more applies.*/
+  if (ch_mtx_get_owner(mp) == currp) {
+    return MSG_RESET;
+  }
   if (msg != MSG_TIMEOUT) {
     chMtxLockS(mp);
   }
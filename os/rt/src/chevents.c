@@ -81,6 +81,28 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Checks if the pending events satisfy the wait of a thread.
+ *
+ * @param[in] tp        the thread to be checked
+ * @return              The wakeup condition.
+ * @retval true         if the thread is waiting and must be made ready.
+ * @retval false        if the thread is not waiting or it must keep
+ *                      waiting.
+ */
+static bool evt_is_waking(thread_t *tp) {
+
+  /* Test on the AND/OR conditions wait states.*/
+  return (bool)(((tp->state == CH_STATE_WTOREVT) &&
+                 ((tp->epending & tp->u.ewmask) != (eventmask_t)0)) ||
+#if CH_CFG_USE_POLL == TRUE
+                ((tp->state == CH_STATE_WTPOLL) &&
+                 ((tp->epending & tp->u.ewmask) != (eventmask_t)0)) ||
+#endif
+                ((tp->state == CH_STATE_WTANDEVT) &&
+                 ((tp->epending & tp->u.ewmask) == tp->u.ewmask)));
+}
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -224,10 +246,13 @@ eventmask_t chEvtAddEvents(eventmask_t events) {
  */
 void chEvtBroadcastFlagsI(event_source_t *esp, eventflags_t flags) {
   event_listener_t *elp;
+  thread_t *tp;
+  ch_queue_t wakeups;
 
   chDbgCheckClassI();
   chDbgCheck(esp != NULL);
 
+  ch_queue_init(&wakeups);
   elp = esp->next;
   /*lint -save -e9087 -e740 [11.3, 1.3] Cast required by list handling.*/
   while (elp != (event_listener_t *)esp) {
@@ -237,10 +262,20 @@ void chEvtBroadcastFlagsI(event_source_t *esp, eventflags_t flags) {
        source does not emit any flag.*/
     if ((flags == (eventflags_t)0) ||
         ((flags & elp->wflags) != (eventflags_t)0)) {
-      chEvtSignalI(elp->listener, elp->events);
+      tp = elp->listener;
+      tp->epending |= elp->events;
+      if (evt_is_waking(tp)) {
+        /* The thread is collected and made ready together with the others,
+           the state change prevents a second insertion if the thread
+           listens to this source more than once.*/
+        tp->state = CH_STATE_QUEUED;
+        ch_queue_insert(&tp->hdr.queue, &wakeups);
+      }
     }
     elp = elp->next;
   }
+
+  chSchReadyAllI(&wakeups, MSG_OK);
 }
 
 /**
@@ -301,11 +336,7 @@ void chEvtSignalI(thread_t *tp, eventmask_t events) {
   chDbgCheck(tp != NULL);
 
   tp->epending |= events;
-  /* Test on the AND/OR conditions wait states.*/
-  if (((tp->state == CH_STATE_WTOREVT) &&
-       ((tp->epending & tp->u.ewmask) != (eventmask_t)0)) ||
-      ((tp->state == CH_STATE_WTANDEVT) &&
-       ((tp->epending & tp->u.ewmask) == tp->u.ewmask))) {
+  if (evt_is_waking(tp)) {
     tp->u.rdymsg = MSG_OK;
     (void) chSchReadyI(tp);
   }
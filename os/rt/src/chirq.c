@@ -0,0 +1,323 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    rt/src/chirq.c
+ * @brief   Threaded interrupt handlers code.
+ *
+ * @addtogroup irq_threads
+ * @details Threaded interrupt handlers services.
+ *          <h2>Operation mode</h2>
+ *          Interrupt handlers are split in two parts, the top half runs
+ *          in the ISR and only acknowledges the hardware, the bottom half
+ *          runs in thread context and performs the actual processing.
+ *          This keeps ISRs short and the bottom halves become subject to
+ *          the normal scheduling rules.<br>
+ *          An IRQ thread serves all the sources raised at its priority
+ *          level, bottom halves are executed in FIFO order. A source is
+ *          queued only once, raising a source whose bottom half is still
+ *          pending is counted as coalesced and has no other effect. The
+ *          pending state is cleared just before the bottom half is
+ *          started so a raise during its execution schedules it again.<br>
+ *          Each source keeps counters of raises, coalesced raises and
+ *          executions, the bottom half execution time is also measured
+ *          when the @p CH_CFG_USE_TM option is enabled.<br>
+ *          Sources raised from thread context using @p chIRQRaiseS()
+ *          switch directly to the IRQ thread if it has a greater priority
+ *          than the caller.
+ * @pre     In order to use the threaded interrupt handlers APIs the
+ *          @p CH_CFG_USE_IRQ_THREADS option must be enabled in
+ *          @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if (CH_CFG_USE_IRQ_THREADS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Queues a source on its IRQ thread.
+ *
+ * @param[in] isp       pointer to the @p irq_source_t structure
+ * @return              The queuing result.
+ * @retval true         if the source has been queued.
+ * @retval false        if the bottom half was already pending.
+ */
+static bool irq_enqueue(irq_source_t *isp) {
+
+  isp->raised++;
+  if (isp->pending) {
+    isp->coalesced++;
+    return false;
+  }
+
+  isp->pending = true;
+  ch_queue_insert(&isp->link, &isp->itp->pending);
+
+  return true;
+}
+
+/**
+ * @brief   IRQ thread function.
+ *
+ * @param[in] p         pointer to the @p irq_thread_t structure
+ */
+static THD_FUNCTION(irq_thread, p) {
+  irq_thread_t *itp = (irq_thread_t *)p;
+  irq_source_t *isp;
+
+  chSysLock();
+  while (true) {
+    if (ch_queue_isempty(&itp->pending)) {
+      (void) chThdSuspendS(&itp->waiting);
+      continue;
+    }
+
+    isp = (irq_source_t *)ch_queue_fifo_remove(&itp->pending);
+    isp->pending = false;
+    isp->served++;
+    chSysUnlock();
+
+#if CH_CFG_USE_TM == TRUE
+    chTMStartMeasurementX(&isp->tm);
+    isp->bh(isp->arg);
+    chTMStopMeasurementX(&isp->tm);
+#else
+    isp->bh(isp->arg);
+#endif
+
+    chSysLock();
+  }
+}
+
+/**
+ * @brief   Initializes an @p irq_thread_t structure and the descriptor of
+ *          its thread.
+ *
+ * @param[out] itp      pointer to the @p irq_thread_t structure
+ * @param[out] tdp      pointer to the @p thread_descriptor_t structure
+ * @param[in] wsp       pointer to a working area dedicated to the thread
+ *                      stack
+ * @param[in] size      size of the working area
+ * @param[in] prio      the priority level for the bottom halves
+ * @param[in] name      the thread name or @p NULL
+ */
+static void irq_thread_init(irq_thread_t *itp, thread_descriptor_t *tdp,
+                            void *wsp, size_t size, tprio_t prio,
+                            const char *name) {
+
+  chDbgCheck((itp != NULL) && (wsp != NULL));
+
+  tdp->name  = name;
+  tdp->wbase = (stkalign_t *)wsp;
+  tdp->wend  = (stkalign_t *)((uint8_t *)wsp + size);
+  tdp->prio  = prio;
+  tdp->funcp = irq_thread;
+  tdp->arg   = (void *)itp;
+
+  ch_queue_init(&itp->pending);
+  itp->waiting = NULL;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Creates an IRQ thread into a static memory area.
+ * @details The IRQ thread is made ready to execute but no reschedule is
+ *          performed, drivers can use this function from within their
+ *          start functions.
+ * @note    When invoked from thread context the caller must perform a
+ *          reschedule using @p chSchRescheduleS() before leaving the
+ *          critical zone, the IRQ thread could have a higher priority.
+ * @note    A single IRQ thread should be created for each priority level
+ *          used by bottom halves, sources are then attached to the IRQ
+ *          thread at the required priority.
+ *
+ * @param[out] itp      pointer to the @p irq_thread_t structure
+ * @param[out] wsp      pointer to a working area dedicated to the thread
+ *                      stack
+ * @param[in] size      size of the working area
+ * @param[in] prio      the priority level for the bottom halves
+ * @param[in] name      the thread name or @p NULL
+ * @return              The pointer to the @p thread_t structure allocated
+ *                      for the IRQ thread.
+ *
+ * @iclass
+ */
+thread_t *chIRQThreadCreateI(irq_thread_t *itp, void *wsp,
+                             size_t size, tprio_t prio,
+                             const char *name) {
+  thread_descriptor_t td;
+
+  chDbgCheckClassI();
+
+  irq_thread_init(itp, &td, wsp, size, prio, name);
+  itp->tp = chThdCreateI(&td);
+
+  return itp->tp;
+}
+
+/**
+ * @brief   Creates an IRQ thread into a static memory area.
+ * @note    A single IRQ thread should be created for each priority level
+ *          used by bottom halves, sources are then attached to the IRQ
+ *          thread at the required priority.
+ *
+ * @param[out] itp      pointer to the @p irq_thread_t structure
+ * @param[out] wsp      pointer to a working area dedicated to the thread
+ *                      stack
+ * @param[in] size      size of the working area
+ * @param[in] prio      the priority level for the bottom halves
+ * @param[in] name      the thread name or @p NULL
+ * @return              The pointer to the @p thread_t structure allocated
+ *                      for the IRQ thread.
+ *
+ * @api
+ */
+thread_t *chIRQThreadCreateStatic(irq_thread_t *itp, void *wsp,
+                                  size_t size, tprio_t prio,
+                                  const char *name) {
+  thread_descriptor_t td;
+
+  irq_thread_init(itp, &td, wsp, size, prio, name);
+  itp->tp = chThdCreate(&td);
+
+  return itp->tp;
+}
+
+/**
+ * @brief   Initializes an @p irq_source_t structure.
+ *
+ * @param[out] isp      pointer to the @p irq_source_t structure
+ * @param[in] itp       pointer to the serving @p irq_thread_t structure
+ * @param[in] bh        the bottom half function
+ * @param[in] arg       the bottom half argument
+ *
+ * @init
+ */
+void chIRQSourceObjectInit(irq_source_t *isp, irq_thread_t *itp,
+                           irq_bh_t bh, void *arg) {
+
+  chDbgCheck((isp != NULL) && (itp != NULL) && (bh != NULL));
+
+  ch_queue_init(&isp->link);
+  isp->itp       = itp;
+  isp->bh        = bh;
+  isp->arg       = arg;
+  isp->pending   = false;
+  isp->raised    = (ucnt_t)0;
+  isp->coalesced = (ucnt_t)0;
+  isp->served    = (ucnt_t)0;
+#if CH_CFG_USE_TM == TRUE
+  chTMObjectInit(&isp->tm);
+#endif
+}
+
+/**
+ * @brief   Raises an IRQ source.
+ * @details This function is meant to be invoked by top halves, the bottom
+ *          half is queued on the IRQ thread unless it is already pending.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] isp       pointer to the @p irq_source_t structure
+ * @return              The queuing result.
+ * @retval true         if the bottom half has been queued.
+ * @retval false        if the raise has been coalesced into an already
+ *                      pending bottom half.
+ *
+ * @iclass
+ */
+bool chIRQRaiseI(irq_source_t *isp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(isp != NULL);
+
+  if (!irq_enqueue(isp)) {
+    return false;
+  }
+  chThdResumeI(&isp->itp->waiting, MSG_OK);
+
+  return true;
+}
+
+/**
+ * @brief   Raises an IRQ source from thread context.
+ * @details The bottom half is queued on the IRQ thread unless it is already
+ *          pending. If the IRQ thread is waiting and it has a greater
+ *          priority than the caller then a direct context switch is
+ *          performed, the ready list is not scanned.
+ *
+ * @param[in] isp       pointer to the @p irq_source_t structure
+ *
+ * @sclass
+ */
+void chIRQRaiseS(irq_source_t *isp) {
+
+  chDbgCheckClassS();
+  chDbgCheck(isp != NULL);
+
+  if (irq_enqueue(isp)) {
+    chThdResumeS(&isp->itp->waiting, MSG_OK);
+  }
+}
+
+/**
+ * @brief   Raises an IRQ source from thread context.
+ * @details The bottom half is queued on the IRQ thread unless it is already
+ *          pending.
+ *
+ * @param[in] isp       pointer to the @p irq_source_t structure
+ *
+ * @api
+ */
+void chIRQRaise(irq_source_t *isp) {
+
+  chSysLock();
+  chIRQRaiseS(isp);
+  chSysUnlock();
+}
+
+#endif /* CH_CFG_USE_IRQ_THREADS == TRUE */
+
+/** @} */
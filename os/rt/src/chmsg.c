@@ -36,6 +36,15 @@
  *          Messages are usually processed in FIFO order but it is possible to
  *          process them in priority order by enabling the
  *          @p CH_CFG_USE_MESSAGES_PRIORITY option in @p chconf.h.<br>
+ *          <h2>Message Ports</h2>
+ *          When the @p CH_CFG_USE_MESSAGE_PORTS option is enabled threads
+ *          can also exchange messages through ports. A port is owned by
+ *          the receiving thread and can be found by name, a thread can
+ *          own and receive from multiple ports. Messages are carried by
+ *          descriptors pointing to a sender-owned payload, payloads are
+ *          never copied. Descriptors are queued by priority and can be
+ *          sent synchronously, with an optional timeout, or posted and
+ *          collected later.<br>
  * @pre     In order to use the message APIs the @p CH_CFG_USE_MESSAGES option
  *          must be enabled in @p chconf.h.
  * @post    Enabling messages requires 6-12 (depending on the architecture)
@@ -43,6 +52,8 @@
  * @{
  */
 
+#include <string.h>
+
 #include "ch.h"
 
 #if (CH_CFG_USE_MESSAGES == TRUE) || defined(__DOXYGEN__)
@@ -59,6 +70,13 @@
 /* Module local variables.                                                   */
 /*===========================================================================*/
 
+#if (CH_CFG_USE_MESSAGE_PORTS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   List of the registered message ports.
+ */
+static msg_port_t *ports;
+#endif
+
 /*===========================================================================*/
 /* Module local functions.                                                   */
 /*===========================================================================*/
@@ -69,6 +87,57 @@
 #define msg_insert(tp, qp) ch_queue_insert(&tp->hdr.queue, qp)
 #endif
 
+#if (CH_CFG_USE_MESSAGE_PORTS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Inserts a descriptor in a port queue.
+ * @details The descriptor is positioned behind all descriptors with higher
+ *          or equal priority.
+ *
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @param[in] qp        pointer to the port queue
+ */
+static void desc_insert(msg_desc_t *mdp, ch_queue_t *qp) {
+  ch_queue_t *cp = qp->next;
+
+  while ((cp != qp) && (((msg_desc_t *)cp)->prio >= mdp->prio)) {
+    cp = cp->next;
+  }
+  ch_queue_insert(&mdp->link, cp);
+}
+
+/**
+ * @brief   Returns the highest priority descriptor available to a receiver.
+ *
+ * @param[in] mpp       pointer to the @p msg_port_t structure or @p NULL
+ *                      for any port owned by the current thread
+ * @return              The descriptor or @p NULL if none is pending.
+ */
+static msg_desc_t *desc_find(msg_port_t *mpp) {
+  msg_desc_t *mdp = NULL;
+
+  if (mpp != NULL) {
+    if (ch_queue_notempty(&mpp->queue)) {
+      mdp = (msg_desc_t *)mpp->queue.next;
+    }
+  }
+  else {
+    thread_t *ctp = currp;
+
+    for (mpp = ports; mpp != NULL; mpp = mpp->next) {
+      if ((mpp->owner == ctp) && ch_queue_notempty(&mpp->queue)) {
+        msg_desc_t *hp = (msg_desc_t *)mpp->queue.next;
+
+        if ((mdp == NULL) || (hp->prio > mdp->prio)) {
+          mdp = hp;
+        }
+      }
+    }
+  }
+
+  return mdp;
+}
+#endif
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -216,6 +285,428 @@ void chMsgRelease(thread_t *tp, msg_t msg) {
   chSysUnlock();
 }
 
+#if (CH_CFG_USE_MESSAGE_PORTS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes a message port object.
+ *
+ * @param[out] mpp      pointer to the @p msg_port_t structure
+ * @param[in] name      the port name or @p NULL
+ *
+ * @init
+ */
+void chMsgPortObjectInit(msg_port_t *mpp, const char *name) {
+
+  chDbgCheck(mpp != NULL);
+
+  ch_queue_init(&mpp->queue);
+  mpp->next  = NULL;
+  mpp->name  = name;
+  mpp->owner = NULL;
+}
+
+/**
+ * @brief   Registers a message port.
+ * @details The calling thread becomes the owner of the port and the only
+ *          thread allowed to receive from it, the port can then be found
+ *          by name using @p chMsgPortFind().
+ *
+ * @param[in] mpp       pointer to the @p msg_port_t structure
+ *
+ * @api
+ */
+void chMsgPortRegister(msg_port_t *mpp) {
+
+  chDbgCheck(mpp != NULL);
+
+  chSysLock();
+  chDbgAssert(mpp->owner == NULL, "already registered");
+  mpp->owner = currp;
+  mpp->next  = ports;
+  ports      = mpp;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Unregisters a message port.
+ * @details All the pending messages are replied with @p MSG_RESET.
+ *
+ * @param[in] mpp       pointer to the @p msg_port_t structure
+ *
+ * @api
+ */
+void chMsgPortUnregister(msg_port_t *mpp) {
+  msg_port_t **pp;
+
+  chDbgCheck(mpp != NULL);
+
+  chSysLock();
+  chDbgAssert(mpp->owner == currp, "not owner");
+  for (pp = &ports; *pp != NULL; pp = &(*pp)->next) {
+    if (*pp == mpp) {
+      *pp = mpp->next;
+      break;
+    }
+  }
+  mpp->next  = NULL;
+  mpp->owner = NULL;
+  while (ch_queue_notempty(&mpp->queue)) {
+    chMsgReplyI((msg_desc_t *)ch_queue_fifo_remove(&mpp->queue), MSG_RESET);
+  }
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Finds a registered message port by name.
+ *
+ * @param[in] name      the port name
+ * @return              A pointer to the port.
+ * @retval NULL         if a port with the specified name is not registered.
+ *
+ * @api
+ */
+msg_port_t *chMsgPortFind(const char *name) {
+  msg_port_t *mpp;
+
+  chDbgCheck(name != NULL);
+
+  chSysLock();
+  for (mpp = ports; mpp != NULL; mpp = mpp->next) {
+    if ((mpp->name != NULL) && (strcmp(mpp->name, name) == 0)) {
+      break;
+    }
+  }
+  chSysUnlock();
+
+  return mpp;
+}
+
+/**
+ * @brief   Initializes a message descriptor object.
+ *
+ * @param[out] mdp      pointer to the @p msg_desc_t structure
+ * @param[in] payload   pointer to the message payload
+ * @param[in] size      size of the message payload
+ *
+ * @init
+ */
+void chMsgDescObjectInit(msg_desc_t *mdp, void *payload, size_t size) {
+
+  chDbgCheck(mdp != NULL);
+
+  mdp->port    = NULL;
+  mdp->payload = payload;
+  mdp->size    = size;
+  mdp->prio    = NOPRIO;
+  mdp->state   = MSG_DESC_IDLE;
+  mdp->trp     = NULL;
+  mdp->result  = MSG_OK;
+}
+
+/**
+ * @brief   Posts a message descriptor to a port.
+ * @details The message is queued by priority, among messages of the same
+ *          priority the order is FIFO. The function does not wait for
+ *          the reply, use @p chMsgCollectTimeout() in order to retrieve
+ *          it.
+ * @note    If the port is not registered then the message is not queued
+ *          and its reply is @p MSG_RESET, as it happens to the messages
+ *          pending on a port being unregistered.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note
+ *          that interrupt handlers always reschedule on exit so an
+ *          explicit reschedule must not be performed in ISRs.
+ *
+ * @param[in] mpp       pointer to the @p msg_port_t structure
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @param[in] prio      the message priority
+ *
+ * @iclass
+ */
+void chMsgPostI(msg_port_t *mpp, msg_desc_t *mdp, tprio_t prio) {
+  thread_t *tp;
+
+  chDbgCheckClassI();
+  chDbgCheck((mpp != NULL) && (mdp != NULL));
+  chDbgAssert((mdp->state == MSG_DESC_IDLE) || (mdp->state == MSG_DESC_DONE),
+              "descriptor in use");
+
+  mdp->port   = mpp;
+  mdp->prio   = prio;
+
+  /* No receiver, the message is completed immediately.*/
+  tp = mpp->owner;
+  if (tp == NULL) {
+    mdp->state  = MSG_DESC_DONE;
+    mdp->result = MSG_RESET;
+    return;
+  }
+
+  mdp->state  = MSG_DESC_QUEUED;
+  mdp->result = MSG_OK;
+  desc_insert(mdp, &mpp->queue);
+
+  /* Waking up the owner if it is waiting on this port or on all its
+     ports.*/
+  if ((tp->state == CH_STATE_WTPORT) &&
+      ((tp->u.wtobjp == NULL) || (tp->u.wtobjp == (void *)mpp))) {
+    tp->u.rdymsg = MSG_OK;
+    (void) chSchReadyI(tp);
+  }
+}
+
+/**
+ * @brief   Posts a message descriptor to a port.
+ * @details The message is queued by priority, among messages of the same
+ *          priority the order is FIFO. The function does not wait for
+ *          the reply, use @p chMsgCollectTimeout() in order to retrieve
+ *          it.
+ * @note    If the port is not registered then the message is not queued
+ *          and its reply is @p MSG_RESET.
+ *
+ * @param[in] mpp       pointer to the @p msg_port_t structure
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @param[in] prio      the message priority
+ *
+ * @api
+ */
+void chMsgPost(msg_port_t *mpp, msg_desc_t *mdp, tprio_t prio) {
+
+  chSysLock();
+  chMsgPostS(mpp, mdp, prio);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Sends a message descriptor to a port and waits for the reply.
+ * @details The message is queued with the priority of the sender thread.
+ *          If the timeout expires before the receiver takes the message
+ *          then the message is withdrawn, once the message has been taken
+ *          the sender waits for the reply regardless of the timeout.
+ *
+ * @param[in] mpp       pointer to the @p msg_port_t structure
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The reply message from @p chMsgReply().
+ * @retval MSG_TIMEOUT  if the message has not been taken in time.
+ * @retval MSG_RESET    if the port is not registered or has been
+ *                      unregistered.
+ *
+ * @api
+ */
+msg_t chMsgSendTimeout(msg_port_t *mpp, msg_desc_t *mdp,
+                       sysinterval_t timeout) {
+  msg_t msg;
+
+  chDbgCheck((mpp != NULL) && (mdp != NULL));
+
+  chSysLock();
+  chDbgAssert(mpp->owner != currp, "sending to own port");
+  chMsgPostI(mpp, mdp, currp->hdr.pqueue.prio);
+  msg = chMsgCollectTimeoutS(mdp, timeout);
+  if (msg == MSG_TIMEOUT) {
+    if (mdp->state == MSG_DESC_QUEUED) {
+      /* Not taken yet, withdrawing the message.*/
+      (void) ch_queue_dequeue(&mdp->link);
+      mdp->state = MSG_DESC_IDLE;
+    }
+    else {
+      /* Already taken, the reply is due.*/
+      msg = chMsgCollectTimeoutS(mdp, TIME_INFINITE);
+    }
+  }
+  chSysUnlock();
+
+  return msg;
+}
+
+/**
+ * @brief   Waits for the reply to a posted message.
+ * @note    A timeout does not withdraw the message, the reply can be
+ *          collected later.
+ *
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The reply message from @p chMsgReply().
+ * @retval MSG_TIMEOUT  if the reply did not arrive in time.
+ *
+ * @sclass
+ */
+msg_t chMsgCollectTimeoutS(msg_desc_t *mdp, sysinterval_t timeout) {
+
+  chDbgCheckClassS();
+  chDbgCheck(mdp != NULL);
+  chDbgAssert(mdp->state != MSG_DESC_IDLE, "not posted");
+
+  if (mdp->state == MSG_DESC_DONE) {
+    return mdp->result;
+  }
+
+  return chThdSuspendTimeoutS(&mdp->trp, timeout);
+}
+
+/**
+ * @brief   Waits for the reply to a posted message.
+ * @note    A timeout does not withdraw the message, the reply can be
+ *          collected later.
+ *
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The reply message from @p chMsgReply().
+ * @retval MSG_TIMEOUT  if the reply did not arrive in time.
+ *
+ * @api
+ */
+msg_t chMsgCollectTimeout(msg_desc_t *mdp, sysinterval_t timeout) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chMsgCollectTimeoutS(mdp, timeout);
+  chSysUnlock();
+
+  return msg;
+}
+
+/**
+ * @brief   Receives a message from a port.
+ * @details The highest priority message is taken, when waiting on all
+ *          the owned ports ties between ports are resolved in
+ *          registration order, most recent first.
+ * @post    The message must be replied using @p chMsgReply(), the payload
+ *          is stable until then.
+ *
+ * @param[in] mpp       pointer to the @p msg_port_t structure or @p NULL
+ *                      for any port owned by the current thread
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A pointer to the received message descriptor.
+ * @retval NULL         if a timeout occurred.
+ *
+ * @sclass
+ */
+msg_desc_t *chMsgReceiveTimeoutS(msg_port_t *mpp, sysinterval_t timeout) {
+  msg_desc_t *mdp;
+  systime_t start = chVTGetSystemTimeX();
+
+  chDbgCheckClassS();
+  chDbgAssert((mpp == NULL) || (mpp->owner == currp), "not owner");
+
+  while ((mdp = desc_find(mpp)) == NULL) {
+    systime_t now;
+
+    if (TIME_IMMEDIATE == timeout) {
+      return NULL;
+    }
+    currp->u.wtobjp = (void *)mpp;
+    if (chSchGoSleepTimeoutS(CH_STATE_WTPORT, timeout) != MSG_OK) {
+      return NULL;
+    }
+    /* The message could have been withdrawn by a timed out sender before
+       this thread had a chance to run, waiting again for the remaining
+       time.*/
+    now = chVTGetSystemTimeX();
+    if (TIME_INFINITE != timeout) {
+      sysinterval_t elapsed = chTimeDiffX(start, now);
+
+      timeout = (elapsed < timeout) ? timeout - elapsed : TIME_IMMEDIATE;
+    }
+    start = now;
+  }
+  (void) ch_queue_dequeue(&mdp->link);
+  mdp->state = MSG_DESC_RECEIVED;
+
+  return mdp;
+}
+
+/**
+ * @brief   Receives a message from a port.
+ * @details The highest priority message is taken, when waiting on all
+ *          the owned ports ties between ports are resolved in
+ *          registration order, most recent first.
+ * @post    The message must be replied using @p chMsgReply(), the payload
+ *          is stable until then.
+ *
+ * @param[in] mpp       pointer to the @p msg_port_t structure or @p NULL
+ *                      for any port owned by the current thread
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A pointer to the received message descriptor.
+ * @retval NULL         if a timeout occurred.
+ *
+ * @api
+ */
+msg_desc_t *chMsgReceiveTimeout(msg_port_t *mpp, sysinterval_t timeout) {
+  msg_desc_t *mdp;
+
+  chSysLock();
+  mdp = chMsgReceiveTimeoutS(mpp, timeout);
+  chSysUnlock();
+
+  return mdp;
+}
+
+/**
+ * @brief   Replies to a message.
+ * @details The sender, if waiting, is resumed with the reply message.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note
+ *          that interrupt handlers always reschedule on exit so an
+ *          explicit reschedule must not be performed in ISRs.
+ *
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @param[in] msg       the reply message
+ *
+ * @iclass
+ */
+void chMsgReplyI(msg_desc_t *mdp, msg_t msg) {
+
+  chDbgCheckClassI();
+  chDbgCheck(mdp != NULL);
+
+  mdp->result = msg;
+  mdp->state  = MSG_DESC_DONE;
+  chThdResumeI(&mdp->trp, msg);
+}
+
+/**
+ * @brief   Replies to a message.
+ * @details The sender, if waiting, is resumed with the reply message.
+ * @pre     Invoke this function only after a message has been received
+ *          using @p chMsgReceiveTimeout().
+ *
+ * @param[in] mdp       pointer to the @p msg_desc_t structure
+ * @param[in] msg       the reply message
+ *
+ * @api
+ */
+void chMsgReply(msg_desc_t *mdp, msg_t msg) {
+
+  chSysLock();
+  chDbgAssert(mdp->state == MSG_DESC_RECEIVED, "not received");
+  chMsgReplyI(mdp, msg);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+#endif /* CH_CFG_USE_MESSAGE_PORTS == TRUE */
+
 #endif /* CH_CFG_USE_MESSAGES == TRUE */
 
 /** @} */
@@ -62,6 +62,18 @@
  *          The mechanism works with any number of nested mutexes and any
  *          number of involved threads. The algorithm complexity (worst case)
  *          is N with N equal to the number of nested mutexes.
+ *
+ *          <h2>Priority ceiling</h2>
+ *          If the option @p CH_CFG_USE_MUTEXES_CEILING is enabled then
+ *          mutexes can be initialized with a ceiling priority using
+ *          @p chMtxObjectInitCeiling(), such mutexes use the immediate
+ *          priority ceiling protocol instead of priority inheritance.<br>
+ *          The owner is raised to the ceiling priority as soon as it locks
+ *          the mutex so no other thread using the mutex can preempt it,
+ *          blocking is bounded to a single critical section and there are
+ *          no owner chains to be explored. The ceiling must be equal or
+ *          greater than the base priority of all the threads locking the
+ *          mutex, this is checked by an assertion.
  * @pre     In order to use the mutex APIs the @p CH_CFG_USE_MUTEXES option
  *          must be enabled in @p chconf.h.
  * @post    Enabling mutexes requires 5-12 (depending on the architecture)
@@ -89,10 +101,257 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if (CH_CFG_USE_MUTEXES_FAST_PATH == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Tags the mutex owner if there are threads waiting on the mutex.
+ * @details The tag makes the owner compare-and-swap fail on unlock so that
+ *          the waiting threads are handled by the kernel slow path.
+ *
+ * @param[in] mp        pointer to the @p mutex_t structure
+ */
+static inline void mtx_update_waiters(mutex_t *mp) {
+
+  if (ch_queue_notempty(&mp->queue)) {
+    mp->owner = (thread_t *)((uintptr_t)mp->owner | CH_MTX_WAITERS_FLAG);
+  }
+}
+#endif
+
+/**
+ * @brief   Returns @p true if the mutex uses the priority ceiling protocol.
+ *
+ * @param[in] mp        pointer to the @p mutex_t structure
+ * @return              The protocol used by the mutex.
+ */
+static inline bool mtx_is_ceiling(const mutex_t *mp) {
+
+#if CH_CFG_USE_MUTEXES_CEILING == TRUE
+  return (bool)(mp->ceiling != NOPRIO);
+#else
+  (void)mp;
+
+  return false;
+#endif
+}
+
+/**
+ * @brief   Raises the priority of the new owner of a mutex to its ceiling.
+ * @note    The thread must not be in a priority ordered queue, this is
+ *          true for the current thread and for threads being made ready.
+ *
+ * @param[in] mp        pointer to the @p mutex_t structure
+ * @param[in] tp        pointer to the owner thread
+ */
+static inline void mtx_raise_ceiling(const mutex_t *mp, thread_t *tp) {
+
+#if CH_CFG_USE_MUTEXES_CEILING == TRUE
+  if (mp->ceiling > tp->hdr.pqueue.prio) {
+    tp->hdr.pqueue.prio = mp->ceiling;
+  }
+#else
+  (void)mp;
+  (void)tp;
+#endif
+}
+
+/**
+ * @brief   Calculates the priority of a thread owning mutexes.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The highest priority among the thread base priority,
+ *                      the threads waiting on the owned mutexes, the ceilings
+ *                      of the owned mutexes and the held read-write locks.
+ */
+static tprio_t mtx_get_prio(thread_t *tp) {
+  tprio_t newprio = _mtx_get_prio(tp);
+
+#if CH_CFG_USE_RWLOCKS == TRUE
+  newprio = _rwlock_get_prio(tp, newprio);
+#endif
+
+  return newprio;
+}
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
 
+/**
+ * @brief   Priority inheritance protocol.
+ * @details Explores the thread-mutex dependencies boosting the priority of
+ *          all the affected threads to the specified priority.
+ *
+ * @param[in] tp        pointer to the first thread to be boosted
+ * @param[in] prio      the new priority
+ *
+ * @notapi
+ */
+void _mtx_boost(thread_t *tp, tprio_t prio) {
+
+  /* Does the new priority exceed the thread priority? */
+  while (tp->hdr.pqueue.prio < prio) {
+    /* Make priority of thread tp match the new priority.*/
+    tp->hdr.pqueue.prio = prio;
+
+    /* The following states need priority queues reordering.*/
+    switch (tp->state) {
+    case CH_STATE_WTMTX:
+      /* Re-enqueues the mutex owner with its new priority.*/
+      ch_sch_prio_insert(ch_queue_dequeue(&tp->hdr.queue),
+                         &tp->u.wtmtxp->queue);
+      tp = ch_mtx_get_owner(tp->u.wtmtxp);
+      /*lint -e{9042} [16.1] Continues the while.*/
+      continue;
+#if CH_CFG_USE_RWLOCKS == TRUE
+    case CH_STATE_WTRWSH:
+    case CH_STATE_WTRWEX:
+      /* Re-enqueues tp and boosts the read-write lock holders.*/
+      _rwlock_boost(tp);
+      break;
+#endif
+#if (CH_CFG_USE_CONDVARS == TRUE) ||                                        \
+    ((CH_CFG_USE_SEMAPHORES == TRUE) &&                                     \
+     (CH_CFG_USE_SEMAPHORES_PRIORITY == TRUE)) ||                           \
+    ((CH_CFG_USE_MESSAGES == TRUE) &&                                       \
+     (CH_CFG_USE_MESSAGES_PRIORITY == TRUE))
+#if CH_CFG_USE_CONDVARS == TRUE
+    case CH_STATE_WTCOND:
+#endif
+#if (CH_CFG_USE_SEMAPHORES == TRUE) &&                                      \
+    (CH_CFG_USE_SEMAPHORES_PRIORITY == TRUE)
+    case CH_STATE_WTSEM:
+#endif
+#if (CH_CFG_USE_MESSAGES == TRUE) && (CH_CFG_USE_MESSAGES_PRIORITY == TRUE)
+    case CH_STATE_SNDMSGQ:
+#endif
+      /* Re-enqueues tp with its new priority on the queue.*/
+      ch_sch_prio_insert(ch_queue_dequeue(&tp->hdr.queue),
+                         &tp->u.wtmtxp->queue);
+      break;
+#endif
+    case CH_STATE_READY:
+#if CH_DBG_ENABLE_ASSERTS == TRUE
+      /* Prevents an assertion in chSchReadyI().*/
+      tp->state = CH_STATE_CURRENT;
+#endif
+      /* Re-enqueues tp with its new priority on the ready list.*/
+      (void) chSchReadyI((thread_t *)ch_queue_dequeue(&tp->hdr.queue));
+      break;
+    default:
+      /* Nothing to do for other states.*/
+      break;
+    }
+    break;
+  }
+}
+
+/**
+ * @brief   Moves all the threads waiting in a queue on a mutex.
+ * @details This is the wait morphing operation, the threads are inserted in
+ *          the mutex queue by priority without being awakened. If the mutex
+ *          is not owned then it is assigned to the first thread that is
+ *          made ready with the specified message.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] mp        pointer to the @p mutex_t structure
+ * @param[in] qp        pointer to a queue of sleeping threads
+ * @param[in] msg       wakeup message for the thread taking the mutex
+ *
+ * @notapi
+ */
+void _mtx_requeue_allI(mutex_t *mp, ch_queue_t *qp, msg_t msg) {
+  thread_t *tp;
+  ch_queue_t *cp, *ip;
+
+  if (ch_queue_isempty(qp)) {
+    return;
+  }
+
+  /* If the mutex is not owned then the first thread takes it.*/
+  if (mp->owner == NULL) {
+    tp = (thread_t *)ch_queue_fifo_remove(qp);
+#if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
+    mp->cnt = (cnt_t)1;
+#endif
+    mp->owner = tp;
+    mp->next = tp->mtxlist;
+    tp->mtxlist = mp;
+    mtx_raise_ceiling(mp, tp);
+    tp->u.rdymsg = msg;
+    (void) chSchReadyI(tp);
+  }
+
+  /* The other threads are moved on the mutex queue, the scan is resumed
+     from the last moved thread unless the next one has a greater priority
+     so a priority ordered queue is merged in a single pass.*/
+  cp = &mp->queue;
+  while (ch_queue_notempty(qp)) {
+    tp = (thread_t *)ch_queue_fifo_remove(qp);
+    tp->state = CH_STATE_WTMTX;
+    tp->u.wtmtxp = mp;
+    if ((cp != &mp->queue) &&
+        (tp->hdr.pqueue.prio > ((thread_t *)cp)->hdr.pqueue.prio)) {
+      cp = &mp->queue;
+    }
+    ip = cp;
+    do {
+      ip = ip->next;
+    } while ((ip != &mp->queue) &&
+             (((thread_t *)ip)->hdr.pqueue.prio >= tp->hdr.pqueue.prio));
+    tp->hdr.queue.next       = ip;
+    tp->hdr.queue.prev       = ip->prev;
+    tp->hdr.queue.prev->next = &tp->hdr.queue;
+    ip->prev                 = &tp->hdr.queue;
+    cp = &tp->hdr.queue;
+  }
+
+  /* The owner inherits the priority of the moved threads.*/
+  if (chMtxQueueNotEmptyS(mp)) {
+    _mtx_boost(ch_mtx_get_owner(mp),
+               ((thread_t *)mp->queue.next)->hdr.pqueue.prio);
+#if CH_CFG_USE_MUTEXES_FAST_PATH == TRUE
+    mtx_update_waiters(mp);
+#endif
+  }
+}
+
+/**
+ * @brief   Calculates the priority of a thread owning mutexes.
+ * @details Scans the owned mutexes list of the thread, read-write locks
+ *          are not considered.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The highest priority among the thread base priority,
+ *                      the threads waiting on the owned mutexes and the
+ *                      ceilings of the owned mutexes.
+ *
+ * @notapi
+ */
+tprio_t _mtx_get_prio(thread_t *tp) {
+  tprio_t newprio = tp->realprio;
+  mutex_t *lmp = tp->mtxlist;
+
+  while (lmp != NULL) {
+    /* If the highest priority thread waiting in the mutexes list has a
+       greater priority than the thread base priority then the final
+       priority will have at least that priority.*/
+    if (chMtxQueueNotEmptyS(lmp) &&
+        (((thread_t *)lmp->queue.next)->hdr.pqueue.prio > newprio)) {
+      newprio = ((thread_t *)lmp->queue.next)->hdr.pqueue.prio;
+    }
+#if CH_CFG_USE_MUTEXES_CEILING == TRUE
+    /* Owned ceiling mutexes keep the thread at the ceiling priority.*/
+    if (lmp->ceiling > newprio) {
+      newprio = lmp->ceiling;
+    }
+#endif
+    lmp = lmp->next;
+  }
+
+  return newprio;
+}
+
 /**
  * @brief   Initializes s @p mutex_t structure.
  *
@@ -109,7 +368,33 @@ void chMtxObjectInit(mutex_t *mp) {
 #if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
   mp->cnt = (cnt_t)0;
 #endif
+#if CH_CFG_USE_MUTEXES_CEILING == TRUE
+  mp->ceiling = NOPRIO;
+#endif
+}
+
+#if (CH_CFG_USE_MUTEXES_CEILING == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes s @p mutex_t structure with a priority ceiling.
+ * @details The mutex uses the immediate priority ceiling protocol, the
+ *          owner is raised to the ceiling priority when it locks the mutex
+ *          so no other thread using the mutex can preempt it. The ceiling
+ *          must be equal or greater than the base priority of all the
+ *          threads locking the mutex.
+ *
+ * @param[out] mp       pointer to a @p mutex_t structure
+ * @param[in] ceiling   the ceiling priority
+ *
+ * @init
+ */
+void chMtxObjectInitCeiling(mutex_t *mp, tprio_t ceiling) {
+
+  chDbgCheck((ceiling > NOPRIO) && (ceiling <= HIGHPRIO));
+
+  chMtxObjectInit(mp);
+  mp->ceiling = ceiling;
 }
+#endif
 
 /**
  * @brief   Locks the specified mutex.
@@ -121,6 +406,25 @@ void chMtxObjectInit(mutex_t *mp) {
  * @api
  */
 void chMtxLock(mutex_t *mp) {
+#if CH_CFG_USE_MUTEXES_FAST_PATH == TRUE
+  thread_t *currtp = chThdGetSelfX();
+  thread_t *tp = NULL;
+
+  chDbgCheck(mp != NULL);
+
+  /* Fast path, the mutex is not owned and it is taken without entering
+     the kernel. Other threads modify the owned mutexes list of a thread
+     only while it is waiting for a mutex, never while it is running.
+     Ceiling mutexes need to change the owner priority in the kernel.*/
+  if (!mtx_is_ceiling(mp) && CH_MTX_CAS(&mp->owner, &tp, currtp)) {
+#if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
+    mp->cnt = (cnt_t)1;
+#endif
+    mp->next = currtp->mtxlist;
+    currtp->mtxlist = mp;
+    return;
+  }
+#endif
 
   chSysLock();
   chMtxLockS(mp);
@@ -141,16 +445,20 @@ void chMtxLockS(mutex_t *mp) {
 
   chDbgCheckClassS();
   chDbgCheck(mp != NULL);
+#if CH_CFG_USE_MUTEXES_CEILING == TRUE
+  chDbgAssert(!mtx_is_ceiling(mp) || (currtp->realprio <= mp->ceiling),
+              "above ceiling");
+#endif
 
   /* Is the mutex already locked? */
   if (mp->owner != NULL) {
 #if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
 
-    chDbgAssert(mp->cnt >= (cnt_t)1, "counter is not positive");
-
     /* If the mutex is already owned by this thread, the counter is increased
        and there is no need of more actions.*/
-    if (mp->owner == currtp) {
+    if (ch_mtx_get_owner(mp) == currtp) {
+      chDbgAssert(mp->cnt >= (cnt_t)1, "counter is not positive");
+
       mp->cnt++;
     }
     else {
@@ -158,66 +466,20 @@ void chMtxLockS(mutex_t *mp) {
       /* Priority inheritance protocol; explores the thread-mutex dependencies
          boosting the priority of all the affected threads to equal the
          priority of the running thread requesting the mutex.*/
-      thread_t *tp = mp->owner;
-
-      /* Does the running thread have higher priority than the mutex
-         owning thread? */
-      while (tp->hdr.pqueue.prio < currtp->hdr.pqueue.prio) {
-        /* Make priority of thread tp match the running thread's priority.*/
-        tp->hdr.pqueue.prio = currtp->hdr.pqueue.prio;
-
-        /* The following states need priority queues reordering.*/
-        switch (tp->state) {
-        case CH_STATE_WTMTX:
-          /* Re-enqueues the mutex owner with its new priority.*/
-          ch_sch_prio_insert(ch_queue_dequeue(&tp->hdr.queue),
-                             &tp->u.wtmtxp->queue);
-          tp = tp->u.wtmtxp->owner;
-          /*lint -e{9042} [16.1] Continues the while.*/
-          continue;
-#if (CH_CFG_USE_CONDVARS == TRUE) ||                                        \
-    ((CH_CFG_USE_SEMAPHORES == TRUE) &&                                     \
-     (CH_CFG_USE_SEMAPHORES_PRIORITY == TRUE)) ||                           \
-    ((CH_CFG_USE_MESSAGES == TRUE) &&                                       \
-     (CH_CFG_USE_MESSAGES_PRIORITY == TRUE))
-#if CH_CFG_USE_CONDVARS == TRUE
-        case CH_STATE_WTCOND:
-#endif
-#if (CH_CFG_USE_SEMAPHORES == TRUE) &&                                      \
-    (CH_CFG_USE_SEMAPHORES_PRIORITY == TRUE)
-        case CH_STATE_WTSEM:
-#endif
-#if (CH_CFG_USE_MESSAGES == TRUE) && (CH_CFG_USE_MESSAGES_PRIORITY == TRUE)
-        case CH_STATE_SNDMSGQ:
-#endif
-          /* Re-enqueues tp with its new priority on the queue.*/
-          ch_sch_prio_insert(ch_queue_dequeue(&tp->hdr.queue),
-                             &tp->u.wtmtxp->queue);
-          break;
-#endif
-        case CH_STATE_READY:
-#if CH_DBG_ENABLE_ASSERTS == TRUE
-          /* Prevents an assertion in chSchReadyI().*/
-          tp->state = CH_STATE_CURRENT;
-#endif
-          /* Re-enqueues tp with its new priority on the ready list.*/
-          (void) chSchReadyI((thread_t *)ch_queue_dequeue(&tp->hdr.queue));
-          break;
-        default:
-          /* Nothing to do for other states.*/
-          break;
-        }
-        break;
-      }
+      _mtx_boost(ch_mtx_get_owner(mp), currtp->hdr.pqueue.prio);
 
       /* Sleep on the mutex.*/
       ch_sch_prio_insert(&currtp->hdr.queue, &mp->queue);
       currtp->u.wtmtxp = mp;
+#if CH_CFG_USE_MUTEXES_FAST_PATH == TRUE
+      /* The owner is forced into the slow path on unlock.*/
+      mtx_update_waiters(mp);
+#endif
       chSchGoSleepS(CH_STATE_WTMTX);
 
       /* It is assumed that the thread performing the unlock operation assigns
          the mutex to this thread.*/
-      chDbgAssert(mp->owner == currtp, "not owner");
+      chDbgAssert(ch_mtx_get_owner(mp) == currtp, "not owner");
       chDbgAssert(currtp->mtxlist == mp, "not owned");
 #if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
       chDbgAssert(mp->cnt == (cnt_t)1, "counter is not one");
@@ -226,14 +488,23 @@ void chMtxLockS(mutex_t *mp) {
   }
   else {
 #if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
+#if CH_CFG_USE_MUTEXES_FAST_PATH == TRUE
+    /* The fast unlock leaves the counter at one.*/
+    mp->cnt = (cnt_t)1;
+#else
     chDbgAssert(mp->cnt == (cnt_t)0, "counter is not zero");
 
     mp->cnt++;
+#endif
 #endif
     /* It was not owned, inserted in the owned mutexes list.*/
     mp->owner = currtp;
     mp->next = currtp->mtxlist;
     currtp->mtxlist = mp;
+
+    /* Immediate priority ceiling, the current thread is not in any queue
+       so there is no need to walk owner chains or reorder queues.*/
+    mtx_raise_ceiling(mp, currtp);
   }
 }
 
@@ -256,6 +527,23 @@ void chMtxLockS(mutex_t *mp) {
  */
 bool chMtxTryLock(mutex_t *mp) {
   bool b;
+#if CH_CFG_USE_MUTEXES_FAST_PATH == TRUE
+  thread_t *currtp = chThdGetSelfX();
+  thread_t *tp = NULL;
+
+  chDbgCheck(mp != NULL);
+
+  /* Fast path, the mutex is not owned and it is taken without entering
+     the kernel.*/
+  if (!mtx_is_ceiling(mp) && CH_MTX_CAS(&mp->owner, &tp, currtp)) {
+#if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
+    mp->cnt = (cnt_t)1;
+#endif
+    mp->next = currtp->mtxlist;
+    currtp->mtxlist = mp;
+    return true;
+  }
+#endif
 
   chSysLock();
   b = chMtxTryLockS(mp);
@@ -286,13 +574,17 @@ bool chMtxTryLockS(mutex_t *mp) {
 
   chDbgCheckClassS();
   chDbgCheck(mp != NULL);
+#if CH_CFG_USE_MUTEXES_CEILING == TRUE
+  chDbgAssert(!mtx_is_ceiling(mp) || (currtp->realprio <= mp->ceiling),
+              "above ceiling");
+#endif
 
   if (mp->owner != NULL) {
 #if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
 
-    chDbgAssert(mp->cnt >= (cnt_t)1, "counter is not positive");
+    if (ch_mtx_get_owner(mp) == currtp) {
+      chDbgAssert(mp->cnt >= (cnt_t)1, "counter is not positive");
 
-    if (mp->owner == currtp) {
       mp->cnt++;
       return true;
     }
@@ -300,14 +592,20 @@ bool chMtxTryLockS(mutex_t *mp) {
     return false;
   }
 #if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
+#if CH_CFG_USE_MUTEXES_FAST_PATH == TRUE
+  /* The fast unlock leaves the counter at one.*/
+  mp->cnt = (cnt_t)1;
+#else
 
   chDbgAssert(mp->cnt == (cnt_t)0, "counter is not zero");
 
   mp->cnt++;
+#endif
 #endif
   mp->owner = currtp;
   mp->next = currtp->mtxlist;
   currtp->mtxlist = mp;
+  mtx_raise_ceiling(mp, currtp);
   return true;
 }
 
@@ -325,14 +623,42 @@ bool chMtxTryLockS(mutex_t *mp) {
  */
 void chMtxUnlock(mutex_t *mp) {
   thread_t *currtp = chThdGetSelfX();
-  mutex_t *lmp;
 
   chDbgCheck(mp != NULL);
 
+#if CH_CFG_USE_MUTEXES_FAST_PATH == TRUE
+  /* Fast path, no threads are waiting on the mutex, the waiters flag
+     makes the compare-and-swap fail if a thread started waiting.*/
+  if ((mp->owner == currtp) && !mtx_is_ceiling(mp)) {
+    thread_t *tp = currtp;
+    mutex_t *lmp;
+
+    chDbgAssert(currtp->mtxlist == mp, "not next in list");
+
+#if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
+    chDbgAssert(mp->cnt >= (cnt_t)1, "counter is not positive");
+
+    if (mp->cnt > (cnt_t)1) {
+      mp->cnt--;
+      return;
+    }
+#endif
+    /* The counter is left at one, it is only meaningful while the mutex
+       is owned and it is set by the next lock. Clearing it after the
+       release would race with a thread taking the mutex meanwhile.*/
+    lmp = mp->next;
+    if (CH_MTX_CAS(&mp->owner, &tp, NULL)) {
+      currtp->mtxlist = lmp;
+      return;
+    }
+  }
+#endif
+
   chSysLock();
 
   chDbgAssert(currtp->mtxlist != NULL, "owned mutexes list empty");
-  chDbgAssert(currtp->mtxlist->owner == currtp, "ownership failure");
+  chDbgAssert(ch_mtx_get_owner(currtp->mtxlist) == currtp,
+              "ownership failure");
 #if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
   chDbgAssert(mp->cnt >= (cnt_t)1, "counter is not positive");
 
@@ -350,24 +676,9 @@ void chMtxUnlock(mutex_t *mp) {
     if (chMtxQueueNotEmptyS(mp)) {
       thread_t *tp;
 
-      /* Recalculates the optimal thread priority by scanning the owned
-         mutexes list.*/
-      tprio_t newprio = currtp->realprio;
-      lmp = currtp->mtxlist;
-      while (lmp != NULL) {
-        /* If the highest priority thread waiting in the mutexes list has a
-           greater priority than the current thread base priority then the
-           final priority will have at least that priority.*/
-        if (chMtxQueueNotEmptyS(lmp) &&
-            (((thread_t *)lmp->queue.next)->hdr.pqueue.prio > newprio)) {
-          newprio = ((thread_t *)lmp->queue.next)->hdr.pqueue.prio;
-        }
-        lmp = lmp->next;
-      }
-
       /* Assigns to the current thread the highest priority among all the
          waiting threads.*/
-      currtp->hdr.pqueue.prio = newprio;
+      currtp->hdr.pqueue.prio = mtx_get_prio(currtp);
 
       /* Awakens the highest priority thread waiting for the unlocked mutex and
          assigns the mutex to it.*/
@@ -378,6 +689,10 @@ void chMtxUnlock(mutex_t *mp) {
       mp->owner = tp;
       mp->next = tp->mtxlist;
       tp->mtxlist = mp;
+      mtx_raise_ceiling(mp, tp);
+#if CH_CFG_USE_MUTEXES_FAST_PATH == TRUE
+      mtx_update_waiters(mp);
+#endif
 
       /* Note, not using chSchWakeupS() because that function expects the
          current thread to have the higher or equal priority than the ones
@@ -388,6 +703,12 @@ void chMtxUnlock(mutex_t *mp) {
     }
     else {
       mp->owner = NULL;
+
+      /* Leaving the ceiling priority, a preemption could be required.*/
+      if (mtx_is_ceiling(mp)) {
+        currtp->hdr.pqueue.prio = mtx_get_prio(currtp);
+        chSchRescheduleS();
+      }
     }
 #if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
   }
@@ -412,13 +733,13 @@ void chMtxUnlock(mutex_t *mp) {
  */
 void chMtxUnlockS(mutex_t *mp) {
   thread_t *currtp = chThdGetSelfX();
-  mutex_t *lmp;
 
   chDbgCheckClassS();
   chDbgCheck(mp != NULL);
 
   chDbgAssert(currtp->mtxlist != NULL, "owned mutexes list empty");
-  chDbgAssert(currtp->mtxlist->owner == currtp, "ownership failure");
+  chDbgAssert(ch_mtx_get_owner(currtp->mtxlist) == currtp,
+              "ownership failure");
 #if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
   chDbgAssert(mp->cnt >= (cnt_t)1, "counter is not positive");
 
@@ -436,24 +757,9 @@ void chMtxUnlockS(mutex_t *mp) {
     if (chMtxQueueNotEmptyS(mp)) {
       thread_t *tp;
 
-      /* Recalculates the optimal thread priority by scanning the owned
-         mutexes list.*/
-      tprio_t newprio = currtp->realprio;
-      lmp = currtp->mtxlist;
-      while (lmp != NULL) {
-        /* If the highest priority thread waiting in the mutexes list has a
-           greater priority than the current thread base priority then the
-           final priority will have at least that priority.*/
-        if (chMtxQueueNotEmptyS(lmp) &&
-            (((thread_t *)lmp->queue.next)->hdr.pqueue.prio > newprio)) {
-          newprio = ((thread_t *)lmp->queue.next)->hdr.pqueue.prio;
-        }
-        lmp = lmp->next;
-      }
-
       /* Assigns to the current thread the highest priority among all the
          waiting threads.*/
-      currtp->hdr.pqueue.prio = newprio;
+      currtp->hdr.pqueue.prio = mtx_get_prio(currtp);
 
       /* Awakens the highest priority thread waiting for the unlocked mutex and
          assigns the mutex to it.*/
@@ -464,10 +770,19 @@ void chMtxUnlockS(mutex_t *mp) {
       mp->owner = tp;
       mp->next = tp->mtxlist;
       tp->mtxlist = mp;
+      mtx_raise_ceiling(mp, tp);
+#if CH_CFG_USE_MUTEXES_FAST_PATH == TRUE
+      mtx_update_waiters(mp);
+#endif
       (void) chSchReadyI(tp);
     }
     else {
       mp->owner = NULL;
+
+      /* Leaving the ceiling priority.*/
+      if (mtx_is_ceiling(mp)) {
+        currtp->hdr.pqueue.prio = mtx_get_prio(currtp);
+      }
     }
 #if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
   }
@@ -503,6 +818,10 @@ void chMtxUnlockAllS(void) {
         mp->owner   = tp;
         mp->next    = tp->mtxlist;
         tp->mtxlist = mp;
+        mtx_raise_ceiling(mp, tp);
+#if CH_CFG_USE_MUTEXES_FAST_PATH == TRUE
+        mtx_update_waiters(mp);
+#endif
         (void) chSchReadyI(tp);
       }
       else {
@@ -512,7 +831,11 @@ void chMtxUnlockAllS(void) {
         mp->owner = NULL;
       }
     } while (currtp->mtxlist != NULL);
+#if CH_CFG_USE_RWLOCKS == TRUE
+    currtp->hdr.pqueue.prio = _rwlock_get_prio(currtp, currtp->realprio);
+#else
     currtp->hdr.pqueue.prio = currtp->realprio;
+#endif
     chSchRescheduleS();
   }
 }
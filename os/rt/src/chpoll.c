@@ -0,0 +1,353 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    rt/src/chpoll.c
+ * @brief   Multiplexed wait code.
+ *
+ * @addtogroup polling
+ * @details Multiplexed wait services.
+ *          <h2>Operation mode</h2>
+ *          A poll set groups heterogeneous objects, a single thread can
+ *          wait on the whole set until at least one of the objects is
+ *          ready or a timeout occurs.<br>
+ *          Each object is added to the set using a @p poll_item_t
+ *          structure provided by the caller, the item is linked into the
+ *          pollers queue of the object so no dynamic allocation is
+ *          required. Items are added and removed in constant time, a wait
+ *          operation scans the set once and then sleeps until one of
+ *          the objects signals a state change.<br>
+ *          Being ready means that the next operation on the object would
+ *          not block, the actual operation must be performed by the thread
+ *          after the wait, possibly using a @p TIME_IMMEDIATE timeout
+ *          because another thread could have consumed the resource in the
+ *          meantime.<br>
+ *          Event flags are polled using the pending events mask of the
+ *          waiting thread, event sources are handled by registering an
+ *          event listener as usual.<br>
+ *          The OS library extends the polling to mailboxes, pipes and
+ *          objects FIFOs.
+ * @pre     In order to use the polling APIs the @p CH_CFG_USE_POLL option
+ *          must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if (CH_CFG_USE_POLL == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+#if (CH_CFG_USE_SEMAPHORES == TRUE) || defined(__DOXYGEN__)
+static bool poll_sem_ready(poll_item_t *pip) {
+
+  return chSemGetCounterI((semaphore_t *)pip->objp) > (cnt_t)0;
+}
+#endif
+
+#if (CH_CFG_USE_EVENTS == TRUE) || defined(__DOXYGEN__)
+static bool poll_evt_ready(poll_item_t *pip) {
+
+  return (chThdGetSelfX()->epending & pip->events) != (eventmask_t)0;
+}
+#endif
+
+/**
+ * @brief   Scans a poll set.
+ *
+ * @param[in] psp       pointer to the @p poll_set_t structure
+ * @param[out] maskp    the events mask of the events items in the set
+ * @return              The number of ready items.
+ */
+static cnt_t poll_scan(poll_set_t *psp, eventmask_t *maskp) {
+  poll_item_t *pip = psp->items;
+  cnt_t n = (cnt_t)0;
+
+  *maskp = (eventmask_t)0;
+  while (pip != NULL) {
+    pip->fired = pip->ready(pip);
+    if (pip->fired) {
+      n++;
+    }
+#if CH_CFG_USE_EVENTS == TRUE
+    *maskp |= pip->events;
+#endif
+    pip = pip->next;
+  }
+
+  return n;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Wakes up the threads polling an object.
+ * @note    Use @p chPollSignalI() instead of calling this function
+ *          directly.
+ *
+ * @param[in] qp        pointer to the pollers queue of the object
+ *
+ * @notapi
+ */
+void _poll_signalI(ch_queue_t *qp) {
+  ch_queue_t *lp = qp->next;
+
+  while (lp != qp) {
+    thread_t *tp = ((poll_item_t *)lp)->psp->tp;
+
+    if ((tp != NULL) && (tp->state == CH_STATE_WTPOLL)) {
+      tp->u.rdymsg = MSG_OK;
+      (void) chSchReadyI(tp);
+    }
+    lp = lp->next;
+  }
+}
+
+/**
+ * @brief   Initializes a @p poll_set_t structure.
+ *
+ * @param[out] psp      pointer to the @p poll_set_t structure
+ *
+ * @init
+ */
+void chPollObjectInit(poll_set_t *psp) {
+
+  chDbgCheck(psp != NULL);
+
+  psp->items = NULL;
+  psp->tp    = NULL;
+}
+
+/**
+ * @brief   Adds a generic object to a poll set.
+ * @details This function allows to make any object pollable, the object
+ *          must contain a pollers queue and must call @p chPollSignalI()
+ *          on it each time its state changes.
+ *
+ * @param[in] psp       pointer to the @p poll_set_t structure
+ * @param[out] pip      pointer to the @p poll_item_t structure
+ * @param[in] qp        pointer to the pollers queue of the object or
+ *                      @p NULL if the object does not need one
+ * @param[in] ready     the readiness test function
+ * @param[in] objp      pointer to the polled object
+ *
+ * @api
+ */
+void chPollAddObject(poll_set_t *psp, poll_item_t *pip, ch_queue_t *qp,
+                     poll_ready_t ready, void *objp) {
+
+  chDbgCheck((psp != NULL) && (pip != NULL) && (ready != NULL));
+
+  pip->psp   = psp;
+  pip->ready = ready;
+  pip->objp  = objp;
+#if CH_CFG_USE_EVENTS == TRUE
+  pip->events = (eventmask_t)0;
+#endif
+  pip->fired = false;
+
+  chSysLock();
+
+  chDbgAssert(psp->tp == NULL, "set in use");
+
+  if (qp != NULL) {
+    ch_queue_insert(&pip->link, qp);
+  }
+  else {
+    ch_queue_init(&pip->link);
+  }
+  pip->next  = psp->items;
+  psp->items = pip;
+
+  chSysUnlock();
+}
+
+/**
+ * @brief   Removes an item from its poll set.
+ *
+ * @param[in] pip       pointer to the @p poll_item_t structure
+ *
+ * @api
+ */
+void chPollRemove(poll_item_t *pip) {
+  poll_item_t **pipp;
+
+  chDbgCheck(pip != NULL);
+
+  chSysLock();
+
+  chDbgAssert(pip->psp->tp == NULL, "set in use");
+
+  (void) ch_queue_dequeue(&pip->link);
+  pipp = &pip->psp->items;
+  while (*pipp != pip) {
+    chDbgAssert(*pipp != NULL, "not in set");
+    pipp = &(*pipp)->next;
+  }
+  *pipp = pip->next;
+
+  chSysUnlock();
+}
+
+#if (CH_CFG_USE_SEMAPHORES == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Adds a semaphore to a poll set.
+ * @details The semaphore is ready when its counter is greater than zero.
+ *
+ * @param[in] psp       pointer to the @p poll_set_t structure
+ * @param[out] pip      pointer to the @p poll_item_t structure
+ * @param[in] sp        pointer to the @p semaphore_t structure
+ *
+ * @api
+ */
+void chPollAddSemaphore(poll_set_t *psp, poll_item_t *pip, semaphore_t *sp) {
+
+  chDbgCheck(sp != NULL);
+
+  chPollAddObject(psp, pip, &sp->pollers, poll_sem_ready, (void *)sp);
+}
+#endif /* CH_CFG_USE_SEMAPHORES == TRUE */
+
+#if (CH_CFG_USE_EVENTS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Adds a set of events to a poll set.
+ * @details The item is ready when any of the specified events is pending
+ *          for the waiting thread, the events are not cleared by the wait.
+ *
+ * @param[in] psp       pointer to the @p poll_set_t structure
+ * @param[out] pip      pointer to the @p poll_item_t structure
+ * @param[in] events    the events mask
+ *
+ * @api
+ */
+void chPollAddEvents(poll_set_t *psp, poll_item_t *pip, eventmask_t events) {
+
+  chDbgCheck(events != (eventmask_t)0);
+
+  chPollAddObject(psp, pip, NULL, poll_evt_ready, NULL);
+  pip->events = events;
+}
+#endif /* CH_CFG_USE_EVENTS == TRUE */
+
+/**
+ * @brief   Waits on a poll set.
+ * @details The function returns as soon as at least one object in the set
+ *          is ready, the ready items are marked and can be tested using
+ *          @p chPollIsReadyX().
+ *
+ * @param[in] psp       pointer to the @p poll_set_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of ready items.
+ * @retval 0            if the operation timed out.
+ *
+ * @sclass
+ */
+cnt_t chPollWaitTimeoutS(poll_set_t *psp, sysinterval_t timeout) {
+  thread_t *ctp = chThdGetSelfX();
+  systime_t start = chVTGetSystemTimeX();
+  eventmask_t mask;
+  cnt_t n;
+
+  chDbgCheckClassS();
+  chDbgCheck(psp != NULL);
+  chDbgAssert(psp->tp == NULL, "set in use");
+
+  n = poll_scan(psp, &mask);
+  while ((n == (cnt_t)0) && (timeout != TIME_IMMEDIATE)) {
+    systime_t now;
+
+    /* Sleeping until one of the objects signals a state change.*/
+    psp->tp = ctp;
+#if CH_CFG_USE_EVENTS == TRUE
+    ctp->u.ewmask = mask;
+#endif
+    if (chSchGoSleepTimeoutS(CH_STATE_WTPOLL, timeout) == MSG_TIMEOUT) {
+      timeout = TIME_IMMEDIATE;
+    }
+    psp->tp = NULL;
+
+    /* The object could have been consumed by another thread in the
+       meantime, the wait continues for the remaining time.*/
+    now = chVTGetSystemTimeX();
+    if (timeout != TIME_INFINITE) {
+      sysinterval_t elapsed = chTimeDiffX(start, now);
+
+      timeout = (elapsed < timeout) ? timeout - elapsed : TIME_IMMEDIATE;
+    }
+    start = now;
+    n = poll_scan(psp, &mask);
+  }
+
+  return n;
+}
+
+/**
+ * @brief   Waits on a poll set.
+ * @details The function returns as soon as at least one object in the set
+ *          is ready, the ready items are marked and can be tested using
+ *          @p chPollIsReadyX().
+ *
+ * @param[in] psp       pointer to the @p poll_set_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of ready items.
+ * @retval 0            if the operation timed out.
+ *
+ * @api
+ */
+cnt_t chPollWaitTimeout(poll_set_t *psp, sysinterval_t timeout) {
+  cnt_t n;
+
+  chSysLock();
+  n = chPollWaitTimeoutS(psp, timeout);
+  chSysUnlock();
+
+  return n;
+}
+
+#endif /* CH_CFG_USE_POLL == TRUE */
+
+/** @} */
@@ -0,0 +1,530 @@
+/*
+    ChibiOS - Copyright (C) 2006,2007,2008,2009,2010,2011,2012,2013,2014,
+              2015,2016,2017,2018,2019,2020,2021 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation version 3 of the License.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    rt/src/chrwlock.c
+ * @brief   Read-Write Locks code.
+ *
+ * @addtogroup rwlocks
+ * @details Read-write locks related APIs and services.
+ *          <h2>Operation mode</h2>
+ *          A read-write lock can be held by any number of threads in shared
+ *          mode or by a single thread in exclusive mode.<br>
+ *          Operations defined for read-write locks:
+ *          - <b>Lock Shared</b>: The lock is acquired if there is no
+ *            exclusive owner and no thread is waiting for exclusive access,
+ *            else the thread is queued in a list ordered by priority.
+ *          - <b>Lock Exclusive</b>: The lock is acquired if it is not held,
+ *            else the thread is queued in a list ordered by priority.
+ *          - <b>Unlock</b>: The lock is released by the holder, when the
+ *            last holder releases the lock it is assigned to the highest
+ *            priority waiting writer or, if a waiting reader has a greater
+ *            priority, to all the waiting readers.
+ *          .
+ *          <h2>Writers preference</h2>
+ *          A thread waiting for exclusive access prevents new readers from
+ *          acquiring the lock, writers cannot be starved by a continuous
+ *          stream of readers.
+ *
+ *          <h2>The priority inversion problem</h2>
+ *          Read-write locks implement priority inheritance toward all the
+ *          current holders. When a thread is queued on a lock all holders
+ *          gain the priority of the waiting thread, the boost propagates
+ *          through mutexes and other read-write locks the holders are
+ *          waiting for using the mutexes priority inheritance code.<br>
+ *          A thread priority is recalculated when it releases a lock,
+ *          boosts caused by waiting threads that timed out are retained
+ *          until then.
+ *
+ *          <h2>Constraints</h2>
+ *          Read-write locks are not recursive, a thread can hold up to
+ *          @p CH_CFG_RWLOCKS_MAX_HOLDS locks at the same time, further
+ *          acquisitions fail with @p MSG_RESET.
+ * @pre     In order to use the read-write locks APIs the
+ *          @p CH_CFG_USE_RWLOCKS option must be enabled in @p chconf.h.
+ * @post    Enabling read-write locks requires the holder records in the
+ *          @p thread_t structure, their number is specified by
+ *          @p CH_CFG_RWLOCKS_MAX_HOLDS.
+ * @{
+ */
+
+#include "ch.h"
+
+#if (CH_CFG_USE_RWLOCKS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Priority of the first thread in a threads queue.
+ *
+ * @param[in] qp        pointer to a non-empty threads queue
+ * @return              The priority of the first thread.
+ */
+static inline tprio_t rw_head_prio(ch_queue_t *qp) {
+
+  return ((thread_t *)qp->next)->hdr.pqueue.prio;
+}
+
+/**
+ * @brief   Highest priority among the threads waiting on a read-write lock.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ * @param[in] prio      the minimum priority to be returned
+ * @return              The greater between @p prio and the priorities of
+ *                      the waiting threads.
+ */
+static tprio_t rw_get_waiting_prio(rwlock_t *rwp, tprio_t prio) {
+
+  if (ch_queue_notempty(&rwp->rqueue) &&
+      (rw_head_prio(&rwp->rqueue) > prio)) {
+    prio = rw_head_prio(&rwp->rqueue);
+  }
+  if (ch_queue_notempty(&rwp->wqueue) &&
+      (rw_head_prio(&rwp->wqueue) > prio)) {
+    prio = rw_head_prio(&rwp->wqueue);
+  }
+
+  return prio;
+}
+
+/**
+ * @brief   Searches a free holder record of a thread.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              Pointer to the free holder record.
+ * @retval NULL         if the thread already holds
+ *                      @p CH_CFG_RWLOCKS_MAX_HOLDS locks.
+ */
+static rwlock_holder_t *rw_get_free_hold(thread_t *tp) {
+  rwlock_holder_t *hp;
+
+  for (hp = &tp->rwholds[0];
+       hp < &tp->rwholds[CH_CFG_RWLOCKS_MAX_HOLDS];
+       hp++) {
+    if (hp->rwp == NULL) {
+      return hp;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Adds a thread to the holders of a read-write lock.
+ * @pre     The thread has a free holder record, this is checked before
+ *          the thread acquires the lock or starts waiting for it.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ * @param[in] tp        pointer to the new holder thread
+ */
+static void rw_hold(rwlock_t *rwp, thread_t *tp) {
+  rwlock_holder_t *hp = rw_get_free_hold(tp);
+
+  chDbgAssert(hp != NULL, "too many held locks");
+
+  hp->tp       = tp;
+  hp->rwp      = rwp;
+  hp->next     = rwp->holders;
+  rwp->holders = hp;
+}
+
+/**
+ * @brief   Removes a thread from the holders of a read-write lock.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ * @param[in] tp        pointer to the holder thread
+ */
+static void rw_unhold(rwlock_t *rwp, thread_t *tp) {
+  rwlock_holder_t **hpp = &rwp->holders;
+
+  while ((*hpp)->tp != tp) {
+    hpp = &(*hpp)->next;
+    chDbgAssert(*hpp != NULL, "not held");
+  }
+
+  (*hpp)->rwp = NULL;
+  *hpp = (*hpp)->next;
+}
+
+/**
+ * @brief   Raises the priority of all the holders of a read-write lock.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ * @param[in] prio      the new priority
+ */
+static void rw_boost_holders(rwlock_t *rwp, tprio_t prio) {
+  rwlock_holder_t *hp = rwp->holders;
+
+  while (hp != NULL) {
+    _mtx_boost(hp->tp, prio);
+    hp = hp->next;
+  }
+}
+
+/**
+ * @brief   Assigns a free read-write lock to the waiting threads.
+ * @details The lock is assigned to the first waiting writer unless the
+ *          first waiting reader has a greater priority, in that case it
+ *          is assigned to all the waiting readers. The new holders inherit
+ *          the priority of the threads still waiting.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ */
+static void rw_grant(rwlock_t *rwp) {
+  thread_t *tp;
+  ch_queue_t *qp;
+
+  if (ch_queue_notempty(&rwp->wqueue) &&
+      (ch_queue_isempty(&rwp->rqueue) ||
+       (rw_head_prio(&rwp->wqueue) >= rw_head_prio(&rwp->rqueue)))) {
+    tp = (thread_t *)ch_queue_fifo_remove(&rwp->wqueue);
+    rwp->owner = tp;
+    rw_hold(rwp, tp);
+    tp->u.rdymsg = MSG_OK;
+    (void) chSchReadyI(tp);
+  }
+  else {
+    /* All the waiting readers become holders then the whole queue is
+       made ready at once.*/
+    qp = rwp->rqueue.next;
+    while (qp != &rwp->rqueue) {
+      rwp->readers++;
+      rw_hold(rwp, (thread_t *)qp);
+      qp = qp->next;
+    }
+    chSchReadyAllI(&rwp->rqueue, MSG_OK);
+  }
+
+  /* Threads still waiting are now waiting on the new holders.*/
+  rw_boost_holders(rwp, rw_get_waiting_prio(rwp, IDLEPRIO));
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Re-enqueues a thread waiting on a read-write lock.
+ * @details The thread has been boosted, it is moved to its new position
+ *          in the lock queue and the lock holders inherit its priority.
+ *
+ * @param[in] tp        pointer to the thread waiting on the lock
+ *
+ * @notapi
+ */
+void _rwlock_boost(thread_t *tp) {
+  rwlock_t *rwp = tp->u.wtrwlockp;
+
+  ch_sch_prio_insert(ch_queue_dequeue(&tp->hdr.queue),
+                     tp->state == CH_STATE_WTRWSH ? &rwp->rqueue :
+                                                    &rwp->wqueue);
+  rw_boost_holders(rwp, tp->hdr.pqueue.prio);
+}
+
+/**
+ * @brief   Priority inherited through the held read-write locks.
+ *
+ * @param[in] tp        pointer to the thread
+ * @param[in] prio      the priority inherited through other means
+ * @return              The greater between @p prio and the priorities of
+ *                      the threads waiting on the held locks.
+ *
+ * @notapi
+ */
+tprio_t _rwlock_get_prio(thread_t *tp, tprio_t prio) {
+  unsigned i;
+
+  for (i = 0U; i < (unsigned)CH_CFG_RWLOCKS_MAX_HOLDS; i++) {
+    if (tp->rwholds[i].rwp != NULL) {
+      prio = rw_get_waiting_prio(tp->rwholds[i].rwp, prio);
+    }
+  }
+
+  return prio;
+}
+
+/**
+ * @brief   Initializes a @p rwlock_t structure.
+ *
+ * @param[out] rwp      pointer to a @p rwlock_t structure
+ *
+ * @init
+ */
+void chRWLockObjectInit(rwlock_t *rwp) {
+
+  chDbgCheck(rwp != NULL);
+
+  ch_queue_init(&rwp->rqueue);
+  ch_queue_init(&rwp->wqueue);
+  rwp->owner   = NULL;
+  rwp->holders = NULL;
+  rwp->readers = (cnt_t)0;
+}
+
+/**
+ * @brief   Acquires a read-write lock in shared mode.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A message specifying how the invoking thread has been
+ *                      released from the lock.
+ * @retval MSG_OK       if the lock has been acquired.
+ * @retval MSG_TIMEOUT  if the lock has not been acquired within the specified
+ *                      timeout.
+ * @retval MSG_RESET    if the invoking thread already holds
+ *                      @p CH_CFG_RWLOCKS_MAX_HOLDS locks.
+ *
+ * @api
+ */
+msg_t chRWLockLockSharedTimeout(rwlock_t *rwp, sysinterval_t timeout) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chRWLockLockSharedTimeoutS(rwp, timeout);
+  chSysUnlock();
+
+  return msg;
+}
+
+/**
+ * @brief   Acquires a read-write lock in shared mode.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A message specifying how the invoking thread has been
+ *                      released from the lock.
+ * @retval MSG_OK       if the lock has been acquired.
+ * @retval MSG_TIMEOUT  if the lock has not been acquired within the specified
+ *                      timeout.
+ * @retval MSG_RESET    if the invoking thread already holds
+ *                      @p CH_CFG_RWLOCKS_MAX_HOLDS locks.
+ *
+ * @sclass
+ */
+msg_t chRWLockLockSharedTimeoutS(rwlock_t *rwp, sysinterval_t timeout) {
+  thread_t *currtp = chThdGetSelfX();
+
+  chDbgCheckClassS();
+  chDbgCheck(rwp != NULL);
+
+  /* The thread needs a free holder record, the lock is not acquired
+     if all of them are in use.*/
+  if (rw_get_free_hold(currtp) == NULL) {
+    return MSG_RESET;
+  }
+
+  /* Writers preference, new readers wait if a writer is waiting.*/
+  if ((rwp->owner == NULL) && ch_queue_isempty(&rwp->wqueue)) {
+    rwp->readers++;
+    rw_hold(rwp, currtp);
+    return MSG_OK;
+  }
+
+  if (TIME_IMMEDIATE == timeout) {
+    return MSG_TIMEOUT;
+  }
+
+  chDbgAssert(rwp->owner != currtp, "already owner");
+
+  /* Priority inheritance toward all the current holders.*/
+  rw_boost_holders(rwp, currtp->hdr.pqueue.prio);
+
+  /* Sleep on the lock, the thread releasing it assigns the lock to this
+     thread.*/
+  ch_sch_prio_insert(&currtp->hdr.queue, &rwp->rqueue);
+  currtp->u.wtrwlockp = rwp;
+  return chSchGoSleepTimeoutS(CH_STATE_WTRWSH, timeout);
+}
+
+/**
+ * @brief   Acquires a read-write lock in exclusive mode.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A message specifying how the invoking thread has been
+ *                      released from the lock.
+ * @retval MSG_OK       if the lock has been acquired.
+ * @retval MSG_TIMEOUT  if the lock has not been acquired within the specified
+ *                      timeout.
+ * @retval MSG_RESET    if the invoking thread already holds
+ *                      @p CH_CFG_RWLOCKS_MAX_HOLDS locks.
+ *
+ * @api
+ */
+msg_t chRWLockLockExclusiveTimeout(rwlock_t *rwp, sysinterval_t timeout) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chRWLockLockExclusiveTimeoutS(rwp, timeout);
+  chSchRescheduleS();
+  chSysUnlock();
+
+  return msg;
+}
+
+/**
+ * @brief   Acquires a read-write lock in exclusive mode.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel, a
+ *          timeout can make waiting readers ready.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A message specifying how the invoking thread has been
+ *                      released from the lock.
+ * @retval MSG_OK       if the lock has been acquired.
+ * @retval MSG_TIMEOUT  if the lock has not been acquired within the specified
+ *                      timeout.
+ * @retval MSG_RESET    if the invoking thread already holds
+ *                      @p CH_CFG_RWLOCKS_MAX_HOLDS locks.
+ *
+ * @sclass
+ */
+msg_t chRWLockLockExclusiveTimeoutS(rwlock_t *rwp, sysinterval_t timeout) {
+  thread_t *currtp = chThdGetSelfX();
+  msg_t msg;
+
+  chDbgCheckClassS();
+  chDbgCheck(rwp != NULL);
+
+  /* The thread needs a free holder record, the lock is not acquired
+     if all of them are in use.*/
+  if (rw_get_free_hold(currtp) == NULL) {
+    return MSG_RESET;
+  }
+
+  if (rwp->holders == NULL) {
+    rwp->owner = currtp;
+    rw_hold(rwp, currtp);
+    return MSG_OK;
+  }
+
+  if (TIME_IMMEDIATE == timeout) {
+    return MSG_TIMEOUT;
+  }
+
+  chDbgAssert(rwp->owner != currtp, "already owner");
+
+  /* Priority inheritance toward all the current holders.*/
+  rw_boost_holders(rwp, currtp->hdr.pqueue.prio);
+
+  /* Sleep on the lock, the thread releasing it assigns the lock to this
+     thread.*/
+  ch_sch_prio_insert(&currtp->hdr.queue, &rwp->wqueue);
+  currtp->u.wtrwlockp = rwp;
+  msg = chSchGoSleepTimeoutS(CH_STATE_WTRWEX, timeout);
+
+  /* Readers held back by this thread can join the current readers if no
+     other writer is waiting.*/
+  if ((msg == MSG_TIMEOUT) && (rwp->owner == NULL) &&
+      ch_queue_isempty(&rwp->wqueue)) {
+    rw_grant(rwp);
+  }
+
+  return msg;
+}
+
+/**
+ * @brief   Releases a read-write lock.
+ * @details The lock is released in the mode it has been acquired, the
+ *          priority of the invoking thread is recalculated.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ *
+ * @api
+ */
+void chRWLockUnlock(rwlock_t *rwp) {
+
+  chSysLock();
+  chRWLockUnlockS(rwp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Releases a read-write lock.
+ * @details The lock is released in the mode it has been acquired, the
+ *          priority of the invoking thread is recalculated.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] rwp       pointer to the @p rwlock_t structure
+ *
+ * @sclass
+ */
+void chRWLockUnlockS(rwlock_t *rwp) {
+  thread_t *currtp = chThdGetSelfX();
+
+  chDbgCheckClassS();
+  chDbgCheck(rwp != NULL);
+  chDbgAssert(rwp->holders != NULL, "not held");
+
+  rw_unhold(rwp, currtp);
+  if (rwp->owner == currtp) {
+    rwp->owner = NULL;
+  }
+  else {
+    chDbgAssert(rwp->readers > (cnt_t)0, "readers counter is not positive");
+
+    rwp->readers--;
+  }
+
+  /* If the lock is now free then it is assigned to the waiting threads.*/
+  if (rwp->holders == NULL) {
+    rw_grant(rwp);
+  }
+
+  /* Recalculates the optimal thread priority by scanning the owned
+     mutexes and the held read-write locks.*/
+  currtp->hdr.pqueue.prio = _rwlock_get_prio(currtp, _mtx_get_prio(currtp));
+}
+
+#endif /* CH_CFG_USE_RWLOCKS == TRUE */
+
+/** @} */
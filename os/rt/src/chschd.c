@@ -69,6 +69,14 @@ static void wakeup(void *p) {
   case CH_STATE_SUSPENDED:
     *tp->u.wttrp = NULL;
     break;
+#if (CH_CFG_USE_CONDVARS == TRUE) && (CH_CFG_USE_CONDVARS_TIMEOUT == TRUE)
+  case CH_STATE_WTMTX:
+    /* Handling the special case where a condition variable waiter has
+       been moved on the mutex by a broadcast, the timeout no more
+       applies.*/
+    chSysUnlockFromISR();
+    return;
+#endif
 #if CH_CFG_USE_SEMAPHORES == TRUE
   case CH_STATE_WTSEM:
     chSemFastSignalI(tp->u.wtsemp);
@@ -78,6 +86,10 @@ static void wakeup(void *p) {
     /* Falls through.*/
 #if (CH_CFG_USE_CONDVARS == TRUE) && (CH_CFG_USE_CONDVARS_TIMEOUT == TRUE)
   case CH_STATE_WTCOND:
+#endif
+#if CH_CFG_USE_RWLOCKS == TRUE
+  case CH_STATE_WTRWSH:
+  case CH_STATE_WTRWEX:
 #endif
     /* States requiring dequeuing.*/
     (void) ch_queue_dequeue(&tp->hdr.queue);
@@ -91,6 +103,41 @@ static void wakeup(void *p) {
   chSysUnlockFromISR();
 }
 
+#if (CH_CFG_USE_EDF == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Inserts a thread of the EDF band in the ready list.
+ * @details The thread is positioned behind all threads with higher
+ *          priority and, among the threads at the same priority, by
+ *          absolute deadline.
+ *
+ * @param[in] tp        the thread to be inserted
+ * @param[in] ahead     @p true if the thread must be positioned ahead of
+ *                      the threads with the same deadline
+ * @return              The thread pointer.
+ */
+static thread_t *edf_insert(thread_t *tp, bool ahead) {
+  ch_priority_queue_t *pqp = &ch.rlist.pqueue;
+  ch_priority_queue_t *p = &tp->hdr.pqueue;
+
+  /* Scanning the ready list, the header priority is zero so the scan
+     always stops there.*/
+  do {
+    pqp = pqp->next;
+  } while ((pqp->prio > p->prio) ||
+           ((pqp->prio == p->prio) &&
+            (ahead ? ch_sch_edf_before((thread_t *)pqp, tp) :
+                     !ch_sch_edf_before(tp, (thread_t *)pqp))));
+
+  /* Insertion on prev.*/
+  p->next       = pqp;
+  p->prev       = pqp->prev;
+  p->prev->next = p;
+  pqp->prev     = p;
+
+  return tp;
+}
+#endif /* CH_CFG_USE_EDF == TRUE */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -161,6 +208,13 @@ thread_t *chSchReadyI(thread_t *tp) {
   /* The thread is marked ready.*/
   tp->state = CH_STATE_READY;
 
+#if CH_CFG_USE_EDF == TRUE
+  /* Threads in the EDF band are ordered by deadline.*/
+  if (tp->hdr.pqueue.prio == CH_CFG_EDF_PRIORITY) {
+    return edf_insert(tp, false);
+  }
+#endif
+
   /* Insertion in the priority queue.*/
   return (thread_t *)ch_pqueue_insert_behind(&ch.rlist.pqueue,
                                              &tp->hdr.pqueue);
@@ -193,11 +247,74 @@ thread_t *chSchReadyAheadI(thread_t *tp) {
   /* The thread is marked ready.*/
   tp->state = CH_STATE_READY;
 
+#if CH_CFG_USE_EDF == TRUE
+  /* Threads in the EDF band are ordered by deadline.*/
+  if (tp->hdr.pqueue.prio == CH_CFG_EDF_PRIORITY) {
+    return edf_insert(tp, true);
+  }
+#endif
+
   /* Insertion in the priority queue.*/
   return (thread_t *)ch_pqueue_insert_ahead(&ch.rlist.pqueue,
                                             &tp->hdr.pqueue);
 }
 
+/**
+ * @brief   Inserts all the threads of a queue in the Ready List.
+ * @details The threads are removed from the queue starting from its head
+ *          and each one is positioned behind all threads with higher or
+ *          equal priority, the result is the same of a @p chSchReadyI()
+ *          call on each thread.<br>
+ *          The Ready List scan is resumed from the last inserted thread
+ *          unless the next thread has a greater priority, this way a
+ *          chain of threads already ordered by decreasing priority is
+ *          merged in a single pass.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] qp        pointer to the queue of threads to be made ready
+ * @param[in] msg       the wakeup message
+ *
+ * @iclass
+ */
+void chSchReadyAllI(ch_queue_t *qp, msg_t msg) {
+  ch_priority_queue_t *pqp = &ch.rlist.pqueue;
+  thread_t *tp;
+
+  chDbgCheckClassI();
+  chDbgCheck(qp != NULL);
+
+  while (ch_queue_notempty(qp)) {
+    tp = (thread_t *)ch_queue_fifo_remove(qp);
+
+    chDbgAssert((tp->state != CH_STATE_READY) &&
+                (tp->state != CH_STATE_FINAL),
+                "invalid state");
+
+    /* The thread is marked ready.*/
+    tp->state = CH_STATE_READY;
+    tp->u.rdymsg = msg;
+
+#if CH_CFG_USE_EDF == TRUE
+    /* Threads in the EDF band are ordered by deadline, the scan position
+       is still valid after the insertion.*/
+    if (tp->hdr.pqueue.prio == CH_CFG_EDF_PRIORITY) {
+      (void) edf_insert(tp, false);
+      continue;
+    }
+#endif
+
+    /* The scan restarts from the list header only if the thread has a
+       greater priority than the previous one.*/
+    if (tp->hdr.pqueue.prio > pqp->prio) {
+      pqp = &ch.rlist.pqueue;
+    }
+    pqp = ch_pqueue_insert_behind(pqp, &tp->hdr.pqueue);
+  }
+}
+
 /**
  * @brief   Puts the current thread to sleep into the specified state.
  * @details The thread goes into a sleeping state. The possible
@@ -308,8 +425,10 @@ void chSchWakeupS(thread_t *ntp, msg_t msg) {
   /* If the waken thread has a not-greater priority than the current
      one then it is just inserted in the ready list else it made
      running immediately and the invoking thread goes in the ready
-     list instead.*/
-  if (ntp->hdr.pqueue.prio <= otp->hdr.pqueue.prio) {
+     list instead. In the EDF band an earlier deadline also makes the
+     waken thread running.*/
+  if ((ntp->hdr.pqueue.prio <= otp->hdr.pqueue.prio) &&
+      !ch_sch_edf_before(ntp, otp)) {
     (void) chSchReadyI(ntp);
   }
   else {
@@ -360,6 +479,7 @@ void chSchRescheduleS(void) {
  * @special
  */
 bool chSchIsPreemptionRequired(void) {
+  thread_t *ntp = (thread_t *)ch.rlist.pqueue.next;
   tprio_t p1 = firstprio(&ch.rlist.pqueue);
   tprio_t p2 = currp->hdr.pqueue.prio;
 
@@ -367,12 +487,16 @@ bool chSchIsPreemptionRequired(void) {
   /* If the running thread has not reached its time quantum, reschedule only
      if the first thread on the ready queue has a higher priority.
      Otherwise, if the running thread has used up its time quantum, reschedule
-     if the first thread on the ready queue has equal or higher priority.*/
-  return (currp->ticks > (tslices_t)0) ? (p1 > p2) : (p1 >= p2);
+     if the first thread on the ready queue has equal or higher priority.
+     In the EDF band the deadlines are considered instead.*/
+  if (currp->ticks > (tslices_t)0) {
+    return (p1 > p2) || ch_sch_edf_before(ntp, currp);
+  }
+  return (p1 > p2) || ((p1 == p2) && !ch_sch_edf_before(currp, ntp));
 #else
   /* If the round robin preemption feature is not enabled then performs a
      simpler comparison.*/
-  return p1 > p2;
+  return (p1 > p2) || ch_sch_edf_before(ntp, currp);
 #endif
 }
 #endif /* !defined(CH_SCH_IS_PREEMPTION_REQUIRED_HOOKED) */
@@ -100,6 +100,9 @@ void chSemObjectInit(semaphore_t *sp, cnt_t n) {
 
   ch_queue_init(&sp->queue);
   sp->cnt = n;
+#if CH_CFG_USE_POLL == TRUE
+  ch_queue_init(&sp->pollers);
+#endif
 }
 
 /**
@@ -149,9 +152,12 @@ void chSemResetWithMessageI(semaphore_t *sp, cnt_t n, msg_t msg) {
               "inconsistent semaphore");
 
   sp->cnt = n;
-  while (ch_queue_notempty(&sp->queue)) {
-    chSchReadyI((thread_t *)ch_queue_lifo_remove(&sp->queue))->u.rdymsg = msg;
+  chSchReadyAllI(&sp->queue, msg);
+#if CH_CFG_USE_POLL == TRUE
+  if (n > (cnt_t)0) {
+    chPollSignalI(&sp->pollers);
   }
+#endif
 }
 
 /**
@@ -296,6 +302,12 @@ void chSemSignal(semaphore_t *sp) {
   if (++sp->cnt <= (cnt_t)0) {
     chSchWakeupS((thread_t *)ch_queue_fifo_remove(&sp->queue), MSG_OK);
   }
+#if CH_CFG_USE_POLL == TRUE
+  else {
+    chPollSignalI(&sp->pollers);
+    chSchRescheduleS();
+  }
+#endif
   chSysUnlock();
 }
 
@@ -325,6 +337,11 @@ void chSemSignalI(semaphore_t *sp) {
     tp->u.rdymsg = MSG_OK;
     (void) chSchReadyI(tp);
   }
+#if CH_CFG_USE_POLL == TRUE
+  else {
+    chPollSignalI(&sp->pollers);
+  }
+#endif
 }
 
 /**
@@ -354,6 +371,11 @@ void chSemAddCounterI(semaphore_t *sp, cnt_t n) {
     }
     n--;
   }
+#if CH_CFG_USE_POLL == TRUE
+  if (sp->cnt > (cnt_t)0) {
+    chPollSignalI(&sp->pollers);
+  }
+#endif
 }
 
 /**
@@ -384,6 +406,11 @@ msg_t chSemSignalWait(semaphore_t *sps, semaphore_t *spw) {
   if (++sps->cnt <= (cnt_t)0) {
     chSchReadyI((thread_t *)ch_queue_fifo_remove(&sps->queue))->u.rdymsg = MSG_OK;
   }
+#if CH_CFG_USE_POLL == TRUE
+  else {
+    chPollSignalI(&sps->pollers);
+  }
+#endif
   if (--spw->cnt < (cnt_t)0) {
     thread_t *ctp = currp;
     sem_insert(ctp, &spw->queue);
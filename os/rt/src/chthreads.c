@@ -70,6 +70,46 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if (CH_CFG_USE_PERIODIC == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Waits for the release time of the current activation.
+ * @details The thread sleeps if the release time is in the future, the
+ *          release latency statistics are updated on wakeup.
+ *
+ * @param[in] tp        pointer to the current thread
+ * @param[in] now       current system time
+ */
+static void periodic_release(thread_t *tp, systime_t now) {
+  thread_periodic_t *pp = &tp->periodic;
+  sysinterval_t latency;
+
+#if CH_CFG_USE_EDF == TRUE
+  /* The activation deadline is also used by the EDF band.*/
+  tp->deadline = chTimeAddX(pp->release, pp->deadline);
+  tp->flags |= CH_FLAG_DEADLINE;
+#endif
+
+  if (ch_sch_deadline_before(now, pp->release)) {
+    chThdSleepS(chTimeDiffX(now, pp->release));
+  }
+#if CH_CFG_USE_EDF == TRUE
+  else {
+    /* Late activation, the new deadline could be later than the deadline
+       of a ready thread.*/
+    chSchRescheduleS();
+  }
+#endif
+
+  latency = chTimeDiffX(pp->release, chVTGetSystemTimeX());
+  if (latency < pp->lbest) {
+    pp->lbest = latency;
+  }
+  if (latency > pp->lworst) {
+    pp->lworst = latency;
+  }
+}
+#endif /* CH_CFG_USE_PERIODIC == TRUE */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -97,6 +137,22 @@ thread_t *_thread_init(thread_t *tp, const char *name, tprio_t prio) {
   tp->realprio        = prio;
   tp->mtxlist         = NULL;
 #endif
+#if CH_CFG_USE_EDF == TRUE
+  tp->deadline        = (systime_t)0;
+  tp->dlmisses        = (ucnt_t)0;
+#endif
+#if CH_CFG_USE_PERIODIC == TRUE
+  tp->periodic.period = (sysinterval_t)0;
+#endif
+#if CH_CFG_USE_RWLOCKS == TRUE
+  {
+    unsigned i;
+
+    for (i = 0U; i < (unsigned)CH_CFG_RWLOCKS_MAX_HOLDS; i++) {
+      tp->rwholds[i].rwp = NULL;
+    }
+  }
+#endif
 #if CH_CFG_USE_EVENTS == TRUE
   tp->epending        = (eventmask_t)0;
 #endif
@@ -686,6 +742,11 @@ void chThdSleepUntil(systime_t time) {
  * @note    The system time is assumed to be between @p prev and @p next
  *          else the call is assumed to have been called outside the
  *          allowed time interval, in this case no sleep is performed.
+ * @note    If the @p CH_CFG_USE_EDF option is enabled then the thread is
+ *          considered a periodic task with period <tt>next - prev</tt>,
+ *          the deadline of the next activation is set at the end of its
+ *          period and the deadline of the current activation is checked,
+ *          a miss is counted if it has already expired.
  * @see     chThdSleepUntil()
  *
  * @param[in] prev      absolute system time of the previous deadline
@@ -699,14 +760,166 @@ systime_t chThdSleepUntilWindowed(systime_t prev, systime_t next) {
 
   chSysLock();
   time = chVTGetSystemTimeX();
+#if CH_CFG_USE_EDF == TRUE
+  if (((currp->flags & CH_FLAG_DEADLINE) != (tmode_t)0) &&
+      ch_sch_deadline_before(currp->deadline, time)) {
+    currp->dlmisses++;
+  }
+  currp->deadline = chTimeAddX(next, chTimeDiffX(prev, next));
+  currp->flags |= CH_FLAG_DEADLINE;
+#endif
   if (chTimeIsInRangeX(time, prev, next)) {
     chThdSleepS(chTimeDiffX(time, next));
   }
+#if CH_CFG_USE_EDF == TRUE
+  else {
+    /* Late activation, the new deadline could be later than the deadline
+       of a ready thread.*/
+    chSchRescheduleS();
+  }
+#endif
   chSysUnlock();
 
   return next;
 }
 
+#if (CH_CFG_USE_PERIODIC == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Makes the current thread periodic.
+ * @details The statistics of the thread are reset and the thread sleeps
+ *          until the release time of its first activation, the following
+ *          activations are released every @p period ticks.
+ * @note    The statistics can be inspected at any time using
+ *          @p chThdGetPeriodicX(), also on other threads through the
+ *          registry.
+ *
+ * @param[in] period    the activation period, it must be greater than zero
+ * @param[in] phase     delay of the first activation from now
+ * @param[in] deadline  the relative deadline of each activation, it cannot
+ *                      be greater than @p period, zero means equal to
+ *                      @p period
+ * @param[in] misscb    callback invoked by the thread when an activation
+ *                      completes after its deadline or @p NULL
+ *
+ * @api
+ */
+void chThdSetPeriodic(sysinterval_t period, sysinterval_t phase,
+                      sysinterval_t deadline, periodic_cb_t misscb) {
+  thread_periodic_t *pp = &currp->periodic;
+  systime_t now;
+
+  chDbgCheck((period > (sysinterval_t)0) && (deadline <= period));
+
+  chSysLock();
+  pp->period      = period;
+  pp->deadline    = deadline == (sysinterval_t)0 ? period : deadline;
+  pp->misscb      = misscb;
+  pp->n           = (ucnt_t)0;
+  pp->rbest       = TIME_INFINITE;
+  pp->rworst      = (sysinterval_t)0;
+  pp->rcumulative = (rttime_t)0;
+  pp->lbest       = TIME_INFINITE;
+  pp->lworst      = (sysinterval_t)0;
+  pp->overruns    = (ucnt_t)0;
+  pp->misses      = (ucnt_t)0;
+  now = chVTGetSystemTimeX();
+  pp->release     = chTimeAddX(now, phase);
+  periodic_release(currp, now);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Completes the current activation of a periodic thread.
+ * @details The response time of the activation is recorded then the
+ *          thread sleeps until the release of the next activation. If the
+ *          activation overran its period then the releases already elapsed
+ *          are skipped and the next activation starts immediately.
+ * @note    The deadline miss callback, if any, is invoked by this function
+ *          in thread context.
+ * @pre     The thread must have been made periodic using
+ *          @p chThdSetPeriodic().
+ *
+ * @return              The overrun state.
+ * @retval false        if the activation completed within its period.
+ * @retval true         if the activation overran its period.
+ *
+ * @api
+ */
+bool chThdWaitNextPeriod(void) {
+  thread_t *tp = chThdGetSelfX();
+  thread_periodic_t *pp = &tp->periodic;
+  sysinterval_t response;
+  bool overrun, missed;
+
+  chDbgAssert(pp->period > (sysinterval_t)0, "not periodic");
+
+  chSysLock();
+
+  /* Response time of the completed activation.*/
+  response = chTimeDiffX(pp->release, chVTGetSystemTimeX());
+  pp->n++;
+  pp->rcumulative += (rttime_t)response;
+  if (response < pp->rbest) {
+    pp->rbest = response;
+  }
+  if (response > pp->rworst) {
+    pp->rworst = response;
+  }
+  missed = (bool)(response > pp->deadline);
+  if (missed) {
+    pp->misses++;
+  }
+
+  /* Release time of the next activation.*/
+  overrun = (bool)(response >= pp->period);
+  if (overrun) {
+    pp->overruns++;
+    pp->release = chTimeAddX(pp->release,
+                             (response / pp->period) * pp->period);
+  }
+  else {
+    pp->release = chTimeAddX(pp->release, pp->period);
+  }
+
+  chSysUnlock();
+
+  /* The callback is invoked outside the critical zone.*/
+  if (missed && (pp->misscb != NULL)) {
+    pp->misscb(tp, response);
+  }
+
+  chSysLock();
+  periodic_release(tp, chVTGetSystemTimeX());
+  chSysUnlock();
+
+  return overrun;
+}
+#endif /* CH_CFG_USE_PERIODIC == TRUE */
+
+#if (CH_CFG_USE_EDF == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Sets the absolute deadline of the current thread.
+ * @details Threads at the @p CH_CFG_EDF_PRIORITY priority level are
+ *          scheduled by earliest deadline first, threads without a deadline
+ *          are scheduled after threads having one. The deadline is ignored
+ *          at other priority levels.
+ * @note    Deadlines of threads in the EDF band must be less than half of
+ *          the system time range apart.
+ *
+ * @param[in] deadline  the absolute deadline
+ *
+ * @api
+ */
+void chThdSetDeadline(systime_t deadline) {
+
+  chSysLock();
+  currp->deadline = deadline;
+  currp->flags |= CH_FLAG_DEADLINE;
+  chSchRescheduleS();
+  chSysUnlock();
+}
+#endif /* CH_CFG_USE_EDF == TRUE */
+
 /**
  * @brief   Yields the time slot.
  * @details Yields the CPU control to the next thread in the ready list with
@@ -899,9 +1112,7 @@ void chThdDequeueNextI(threads_queue_t *tqp, msg_t msg) {
  */
 void chThdDequeueAllI(threads_queue_t *tqp, msg_t msg) {
 
-  while (ch_queue_notempty(&tqp->queue)) {
-    chThdDoDequeueNextI(tqp, msg);
-  }
+  chSchReadyAllI(&tqp->queue, msg);
 }
 
 /** @} */
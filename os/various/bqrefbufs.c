@@ -0,0 +1,115 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    bqrefbufs.c
+ * @brief   Buffers queues to reference-counted buffers adapter code.
+ * @details Filled buffers of an input buffers queue are passed along as
+ *          reference-counted buffers wrapping the queue memory, no data
+ *          is copied. The queue buffer is returned to the driver when the
+ *          last reference is released.
+ *
+ * @addtogroup bq_refbufs
+ * @{
+ */
+
+#include "hal.h"
+#include "bqrefbufs.h"
+
+#if (CH_CFG_USE_REF_BUFFERS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static void ibq_release(refbuf_t *rbp) {
+
+  ibqReleaseEmptyBufferS((input_buffers_queue_t *)chRBGetLinkX(rbp));
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Gets the next filled buffer from an input buffers queue.
+ * @details The returned buffer wraps the queue buffer, its payload is the
+ *          data posted by the driver.
+ * @note    The queue buffers are released in order, only one buffer at
+ *          time can be taken from the queue, the next one can be taken
+ *          after all references to the previous one have been released.
+ * @note    The queue must not be accessed using the other input buffers
+ *          queue functions while a buffer is taken.
+ * @note    The last reference must be released from thread context.
+ *
+ * @param[in] ibqp      pointer to the @p input_buffers_queue_t object
+ * @param[in] rbpp      pointer to a @p refbuf_pool_t used for allocating
+ *                      the buffer header, data size can be zero
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the buffer.
+ * @retval NULL         if the operation timed out, the queue has been
+ *                      reset or the buffers pool is empty.
+ *
+ * @api
+ */
+refbuf_t *ibqGetFullRefBufTimeout(input_buffers_queue_t *ibqp,
+                                  refbuf_pool_t *rbpp,
+                                  sysinterval_t timeout) {
+  refbuf_t *rbp = NULL;
+
+  osalSysLock();
+
+  osalDbgAssert(ibqp->ptr == NULL, "buffer already taken");
+
+  if (ibqGetFullBufferTimeoutS(ibqp, timeout) == MSG_OK) {
+    rbp = chRBWrapI(rbpp, (void *)ibqp->ptr,
+                    (size_t)(ibqp->top - ibqp->ptr),
+                    ibq_release, (void *)ibqp);
+    if (rbp == NULL) {
+      /* The buffer is left in the queue, it will be returned again by
+         the next call.*/
+      ibqp->ptr = NULL;
+    }
+  }
+
+  osalSysUnlock();
+
+  return rbp;
+}
+
+#endif /* CH_CFG_USE_REF_BUFFERS == TRUE */
+
+/** @} */
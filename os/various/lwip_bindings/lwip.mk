@@ -6,6 +6,7 @@ include $(LWIPDIR)/Filelists.mk
 
 LWBINDSRC = \
         $(CHIBIOS)/os/various/lwip_bindings/lwipthread.c \
+        $(CHIBIOS)/os/various/lwip_bindings/lwiprefbufs.c \
         $(CHIBIOS)/os/various/lwip_bindings/arch/sys_arch.c
 
 
@@ -0,0 +1,258 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    lwiprefbufs.c
+ * @brief   lwIP reference-counted buffers adapter code.
+ * @details Reference-counted buffers are passed to lwIP without copying:
+ *          - Buffers chains are wrapped into chains of custom pbufs, each
+ *            pbuf holds a reference to its buffer until lwIP frees it.
+ *            The resulting pbufs can be sent using the UDP or RAW APIs
+ *            or passed to a network interface.
+ *          - Buffers written on TCP connections are referenced by lwIP
+ *            and released when acknowledged by the remote side.
+ *          .
+ * @note    Requires @p LWIP_SUPPORT_CUSTOM_PBUF in the lwIP configuration
+ *          and @p CH_CFG_USE_REF_BUFFERS in the kernel configuration.
+ * @note    Functions in this module use the lwIP raw API and must be
+ *          invoked from the lwIP thread or with the lwIP core locked.
+ *
+ * @addtogroup LWIP_THREAD
+ * @{
+ */
+
+#include "ch.h"
+
+#include "lwiprefbufs.h"
+
+#if (LWIP_SUPPORT_CUSTOM_PBUF && (CH_CFG_USE_REF_BUFFERS == TRUE)) ||       \
+    defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/**
+ * @brief   Custom pbuf wrapping a buffer.
+ */
+typedef struct {
+  struct pbuf_custom    pc;
+  refbuf_t              *rbp;
+} lwip_refbuf_pbuf_t;
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+static memory_pool_t rbpbufs_pool;
+static lwip_refbuf_pbuf_t rbpbufs[LWIP_REFBUF_PBUFS];
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static void rbpbuf_free(struct pbuf *p) {
+  lwip_refbuf_pbuf_t *rpp = (lwip_refbuf_pbuf_t *)p;
+
+  chRBRelease(rpp->rbp);
+  chPoolFree(&rbpbufs_pool, (void *)rpp);
+}
+
+static err_t rbtcp_sent(void *arg, struct tcp_pcb *pcb, u16_t len) {
+  lwip_refbuf_tcp_t *rtp = (lwip_refbuf_tcp_t *)arg;
+
+  (void)pcb;
+
+  /* Releasing the fully acknowledged buffers.*/
+  rtp->acked += (size_t)len;
+  while (rtp->cnt > 0U) {
+    refbuf_t *rbp = rtp->inflight[rtp->head];
+
+    if (rtp->acked < chRBGetLengthX(rbp)) {
+      break;
+    }
+
+    rtp->acked -= chRBGetLengthX(rbp);
+    chRBRelease(rbp);
+    rtp->head = (rtp->head + 1U) % LWIP_REFBUF_TCP_INFLIGHT;
+    rtp->cnt--;
+  }
+
+  return ERR_OK;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes the buffers adapter.
+ * @note    This function is invoked by @p lwipInit().
+ */
+void lwipRefBufsInit(void) {
+
+  chPoolObjectInit(&rbpbufs_pool, sizeof (lwip_refbuf_pbuf_t), NULL);
+  chPoolLoadArray(&rbpbufs_pool, rbpbufs, LWIP_REFBUF_PBUFS);
+}
+
+/**
+ * @brief   Wraps a buffers chain into a pbufs chain.
+ * @note    The caller keeps its reference to the buffers chain, the pbufs
+ *          hold their own references until freed by lwIP.
+ *
+ * @param[in] rbp       pointer to the first buffer of a chain
+ * @return              The pbufs chain.
+ * @retval NULL         if there are not enough pbufs available.
+ */
+struct pbuf *lwipRefBufToPbuf(refbuf_t *rbp) {
+  struct pbuf *head = NULL;
+
+  while (rbp != NULL) {
+    size_t n = chRBGetLengthX(rbp);
+
+    if (n > (size_t)0) {
+      lwip_refbuf_pbuf_t *rpp;
+      struct pbuf *p;
+
+      chDbgCheck(n <= (size_t)0xFFFFU);
+
+      rpp = (lwip_refbuf_pbuf_t *)chPoolAlloc(&rbpbufs_pool);
+      if (rpp == NULL) {
+        if (head != NULL) {
+          pbuf_free(head);
+        }
+        return NULL;
+      }
+
+      rpp->rbp = chRBAddRef(rbp);
+      rpp->pc.custom_free_function = rbpbuf_free;
+      p = pbuf_alloced_custom(PBUF_RAW, (u16_t)n, PBUF_REF, &rpp->pc,
+                              chRBGetDataX(rbp), (u16_t)n);
+      if (head == NULL) {
+        head = p;
+      }
+      else {
+        pbuf_cat(head, p);
+      }
+    }
+    rbp = chRBGetNextX(rbp);
+  }
+
+  return head;
+}
+
+/**
+ * @brief   Initializes a TCP transmission context.
+ * @note    The connection argument and sent callback are used by the
+ *          adapter and must not be changed by the application.
+ *
+ * @param[out] rtp      pointer to a @p lwip_refbuf_tcp_t structure
+ * @param[in] pcb       connection to be used
+ */
+void lwipRefBufTcpInit(lwip_refbuf_tcp_t *rtp, struct tcp_pcb *pcb) {
+
+  rtp->pcb   = pcb;
+  rtp->head  = 0U;
+  rtp->cnt   = 0U;
+  rtp->acked = (size_t)0;
+
+  tcp_arg(pcb, (void *)rtp);
+  tcp_sent(pcb, rbtcp_sent);
+}
+
+/**
+ * @brief   Writes a buffers chain on a TCP connection.
+ * @details The data is enqueued without copying, the caller reference to
+ *          the chain is transferred to the adapter which releases the
+ *          buffers when acknowledged.
+ * @note    A partial write is possible only if lwIP runs out of segments
+ *          while the chain is being enqueued, in that case the connection
+ *          should be aborted.
+ *
+ * @param[in] rtp       pointer to a @p lwip_refbuf_tcp_t structure
+ * @param[in] rbp       pointer to the first buffer of a chain
+ * @return              The operation status.
+ * @retval ERR_OK       if the chain has been enqueued.
+ * @retval ERR_MEM      if there is not enough space in the send buffer or
+ *                      too many buffers are waiting for acknowledge, the
+ *                      caller keeps its reference.
+ */
+err_t lwipRefBufTcpWrite(lwip_refbuf_tcp_t *rtp, refbuf_t *rbp) {
+  refbuf_t *p;
+  unsigned nseg = 0U;
+  bool queued = false;
+  err_t err = ERR_OK;
+
+  /* Checking for space in advance in order to not leave the chain
+     partially enqueued.*/
+  for (p = rbp; p != NULL; p = chRBGetNextX(p)) {
+    if (chRBGetLengthX(p) > (size_t)0) {
+      nseg++;
+    }
+  }
+  if ((chRBGetChainLength(rbp) > (size_t)tcp_sndbuf(rtp->pcb)) ||
+      (nseg > LWIP_REFBUF_TCP_INFLIGHT - rtp->cnt)) {
+    return ERR_MEM;
+  }
+
+  for (p = rbp; p != NULL; p = chRBGetNextX(p)) {
+    size_t n = chRBGetLengthX(p);
+
+    if (n > (size_t)0) {
+      chDbgCheck(n <= (size_t)0xFFFFU);
+
+      nseg--;
+      err = tcp_write(rtp->pcb, chRBGetDataX(p), (u16_t)n,
+                      nseg > 0U ? TCP_WRITE_FLAG_MORE : 0U);
+      if (err != ERR_OK) {
+        break;
+      }
+
+      /* Each enqueued buffer is referenced until acknowledged.*/
+      rtp->inflight[(rtp->head + rtp->cnt) % LWIP_REFBUF_TCP_INFLIGHT] =
+          chRBAddRef(p);
+      rtp->cnt++;
+      queued = true;
+    }
+  }
+
+  if ((err == ERR_OK) || queued) {
+    chRBRelease(rbp);
+  }
+
+  return err;
+}
+
+/**
+ * @brief   Releases all the buffers waiting for acknowledge.
+ * @note    This function must be invoked after the connection has been
+ *          closed or aborted.
+ *
+ * @param[in] rtp       pointer to a @p lwip_refbuf_tcp_t structure
+ */
+void lwipRefBufTcpReset(lwip_refbuf_tcp_t *rtp) {
+
+  while (rtp->cnt > 0U) {
+    chRBRelease(rtp->inflight[rtp->head]);
+    rtp->head = (rtp->head + 1U) % LWIP_REFBUF_TCP_INFLIGHT;
+    rtp->cnt--;
+  }
+  rtp->acked = (size_t)0;
+}
+
+#endif /* LWIP_SUPPORT_CUSTOM_PBUF && (CH_CFG_USE_REF_BUFFERS == TRUE) */
+
+/** @} */
@@ -0,0 +1,95 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file lwiprefbufs.h
+ * @brief lwIP reference-counted buffers adapter macros and structures.
+ * @addtogroup LWIP_THREAD
+ * @{
+ */
+
+#ifndef LWIPREFBUFS_H
+#define LWIPREFBUFS_H
+
+#include "ch.h"
+
+#include <lwip/opt.h>
+#include <lwip/pbuf.h>
+#include <lwip/tcp.h>
+
+/**
+ * @brief   Number of pbufs available for wrapping buffers.
+ */
+#if !defined(LWIP_REFBUF_PBUFS) || defined(__DOXYGEN__)
+#define LWIP_REFBUF_PBUFS                   16
+#endif
+
+/**
+ * @brief   Maximum number of buffers waiting for acknowledge on a TCP
+ *          connection.
+ */
+#if !defined(LWIP_REFBUF_TCP_INFLIGHT) || defined(__DOXYGEN__)
+#define LWIP_REFBUF_TCP_INFLIGHT            8
+#endif
+
+#if (LWIP_SUPPORT_CUSTOM_PBUF && (CH_CFG_USE_REF_BUFFERS == TRUE)) ||       \
+    defined(__DOXYGEN__)
+
+/**
+ * @brief   TCP transmission context for reference-counted buffers.
+ * @details Buffers written on the connection are referenced by lwIP
+ *          without copying and are released when acknowledged.
+ */
+typedef struct lwip_refbuf_tcp {
+  /**
+   * @brief   Connection.
+   */
+  struct tcp_pcb        *pcb;
+  /**
+   * @brief   Buffers waiting for acknowledge.
+   */
+  refbuf_t              *inflight[LWIP_REFBUF_TCP_INFLIGHT];
+  /**
+   * @brief   Index of the oldest buffer waiting for acknowledge.
+   */
+  unsigned              head;
+  /**
+   * @brief   Number of buffers waiting for acknowledge.
+   */
+  unsigned              cnt;
+  /**
+   * @brief   Acknowledged bytes of the oldest buffer.
+   */
+  size_t                acked;
+} lwip_refbuf_tcp_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void lwipRefBufsInit(void);
+  struct pbuf *lwipRefBufToPbuf(refbuf_t *rbp);
+  void lwipRefBufTcpInit(lwip_refbuf_tcp_t *rtp, struct tcp_pcb *pcb);
+  err_t lwipRefBufTcpWrite(lwip_refbuf_tcp_t *rtp, refbuf_t *rbp);
+  void lwipRefBufTcpReset(lwip_refbuf_tcp_t *rtp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_SUPPORT_CUSTOM_PBUF && (CH_CFG_USE_REF_BUFFERS == TRUE) */
+
+#endif /* LWIPREFBUFS_H */
+
+/** @} */
@@ -59,6 +59,7 @@
 #include "evtimer.h"
 
 #include "lwipthread.h"
+#include "lwiprefbufs.h"
 
 #include <lwip/opt.h>
 #include <lwip/def.h>
@@ -307,7 +308,7 @@ void lwipDefaultLinkDownCB(void *p)
 static THD_FUNCTION(lwip_thread, p) {
   event_timer_t evt;
   event_listener_t el0, el1;
-  static const MACConfig mac_config = {thisif.hwaddr};
+  static const MACConfig mac_config = {.mac_address = thisif.hwaddr};
   err_t result;
   tcpip_callback_fn link_up_cb = NULL;
   tcpip_callback_fn link_down_cb = NULL;
@@ -442,6 +443,11 @@ static THD_FUNCTION(lwip_thread, p) {
  */
 void lwipInit(const lwipthread_opts_t *opts) {
 
+#if LWIP_SUPPORT_CUSTOM_PBUF && (CH_CFG_USE_REF_BUFFERS == TRUE)
+  /* Buffers adapter initialization.*/
+  lwipRefBufsInit();
+#endif
+
   /* Creating the lwIP thread (it changes priority internally).*/
   chThdCreateStatic(wa_lwip_thread, sizeof (wa_lwip_thread),
                     chThdGetPriorityX() - 1, lwip_thread, (void *)opts);
@@ -158,14 +158,14 @@ static void cmd_threads(BaseSequentialStream *chp, int argc, char *argv[]) {
   tp = chRegFirstThread();
   do {
 #if (CH_DBG_ENABLE_STACK_CHECK == TRUE) || (CH_CFG_USE_DYNAMIC == TRUE)
-    uint32_t stklimit = (uint32_t)tp->wabase;
+    uintptr_t stklimit = (uintptr_t)tp->wabase;
 #else
-    uint32_t stklimit = 0U;
+    uintptr_t stklimit = 0U;
 #endif
     chprintf(chp, "%08lx %08lx %08lx %4lu %4lu %9s %12s" SHELL_NEWLINE_STR,
-             stklimit, (uint32_t)tp->ctx.sp, (uint32_t)tp,
-             (uint32_t)tp->refs - 1,
-             (uint32_t)tp->hdr.pqueue.prio, states[tp->state],
+             (unsigned long)stklimit, (unsigned long)(uintptr_t)tp->ctx.sp,
+             (unsigned long)(uintptr_t)tp, (unsigned long)tp->refs - 1UL,
+             (unsigned long)tp->hdr.pqueue.prio, states[tp->state],
              tp->name == NULL ? "" : tp->name);
     tp = chRegNextThread(tp);
   } while (tp != NULL);
@@ -309,6 +309,9 @@ static void nil_test_008_003_execute(void) {
       chSchWakeupS(tp, MSG_OK);
       chSysUnlock();
       n += 4;
+#if defined(SIMULATOR)
+      _sim_check_for_interrupts();
+#endif
     } while (chVTIsSystemTimeWithinX(start, end));
   }
   test_end_step(2);
@@ -382,6 +385,9 @@ static void nil_test_008_004_execute(void) {
     do {
       chThdWait(chThdCreate(&td));
       n++;
+#if defined(SIMULATOR)
+      _sim_check_for_interrupts();
+#endif
     } while (chVTIsSystemTimeWithinX(start, end));
   }
   test_end_step(1);
@@ -446,6 +452,9 @@ static void nil_test_008_005_execute(void) {
     do {
       chThdWait(chThdCreate(&td));
       n++;
+#if defined(SIMULATOR)
+      _sim_check_for_interrupts();
+#endif
     } while (chVTIsSystemTimeWithinX(start, end));
   }
   test_end_step(1);
@@ -14,44 +14,57 @@
     limitations under the License.
 */
 
+#include <stdlib.h>
+
 #include "ch.h"
+#include "hal.h"
+#include "nil_test_root.h"
+#include "oslib_test_root.h"
+#include "console.h"
 
 /*
- * Blinker thread #1.
+ * Tester thread, the suites are executed once then the simulator exits.
  */
-static THD_WORKING_AREA(waThread1, 128);
-static THD_FUNCTION(Thread1, arg) {
+static THD_WORKING_AREA(waTester, 1024);
+static THD_FUNCTION(Tester, arg) {
 
   (void)arg;
 
-  while (true) {
-    chThdSleepMilliseconds(1000);
-  }
+  test_execute((BaseSequentialStream *)&CD1, &nil_test_suite);
+  test_execute((BaseSequentialStream *)&CD1, &oslib_test_suite);
+  if (test_global_fail)
+    exit(1);
+  else
+    exit(0);
 }
 
 /*
- * Threads creation table, one entry per thread.
+ * Threads creation table, one entry per thread. The tester priority leaves
+ * room for the threads created by the test cases above and below it.
  */
 THD_TABLE_BEGIN
-  THD_TABLE_THREAD(0, "sleeper", waThread1, Thread1, NULL)
+  THD_TABLE_THREAD(3, "tester", waTester, Tester, NULL)
 THD_TABLE_END
 
 /*
- * Application entry point.
+ * Simulator main.
  */
 int main(void) {
 
   /*
    * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
    * - Kernel initialization, the main() function becomes a thread and the
    *   RTOS is active.
    */
+  halInit();
+  conInit();
   chSysInit();
 
-  /* This is now the idle thread loop, you may perform here a low priority
-     task but you must never try to sleep or wait in this loop. Note that
-     this tasks runs at the lowest priority level so any instruction added
-     here will be executed after all other tasks have been started.*/
+  /* This is now the idle thread loop, the simulator waits here for the
+     simulated interrupts.*/
   while (true) {
+    port_wait_for_interrupt();
   }
 }
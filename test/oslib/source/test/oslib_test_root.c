@@ -30,6 +30,11 @@
  * - @subpage oslib_test_sequence_007
  * - @subpage oslib_test_sequence_008
  * - @subpage oslib_test_sequence_009
+ * - @subpage oslib_test_sequence_010
+ * - @subpage oslib_test_sequence_011
+ * - @subpage oslib_test_sequence_012
+ * - @subpage oslib_test_sequence_013
+ * - @subpage oslib_test_sequence_014
  * .
  */
 
@@ -75,6 +80,21 @@ const testsequence_t * const oslib_test_suite_array[] = {
 #endif
 #if ((CH_CFG_USE_FACTORY == TRUE) && (CH_CFG_USE_MEMPOOLS == TRUE) && (CH_CFG_USE_HEAP == TRUE)) || defined(__DOXYGEN__)
   &oslib_test_sequence_009,
+#endif
+#if (CH_CFG_USE_RINGS) || defined(__DOXYGEN__)
+  &oslib_test_sequence_010,
+#endif
+#if (CH_CFG_USE_LF_QUEUES) || defined(__DOXYGEN__)
+  &oslib_test_sequence_011,
+#endif
+#if (CH_CFG_USE_REC_QUEUES) || defined(__DOXYGEN__)
+  &oslib_test_sequence_012,
+#endif
+#if (CH_CFG_USE_REF_BUFFERS) || defined(__DOXYGEN__)
+  &oslib_test_sequence_013,
+#endif
+#if (CH_CFG_USE_POLL) || defined(__DOXYGEN__)
+  &oslib_test_sequence_014,
 #endif
   NULL
 };
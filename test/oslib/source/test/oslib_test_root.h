@@ -33,6 +33,11 @@
 #include "oslib_test_sequence_007.h"
 #include "oslib_test_sequence_008.h"
 #include "oslib_test_sequence_009.h"
+#include "oslib_test_sequence_010.h"
+#include "oslib_test_sequence_011.h"
+#include "oslib_test_sequence_012.h"
+#include "oslib_test_sequence_013.h"
+#include "oslib_test_sequence_014.h"
 
 #if !defined(__DOXYGEN__)
 
@@ -48,7 +48,7 @@
 
 static bool exit_flag;
 
-static int dis_func0(void) {
+static msg_t dis_func0(void) {
 
   test_emit_token('0');
 
@@ -89,7 +89,7 @@ static msg_t dis_func4(msg_t a, msg_t b, msg_t c, msg_t d) {
   return (msg_t)a;
 }
 
-static int dis_func_end(void) {
+static msg_t dis_func_end(void) {
 
   test_emit_token('Z');
   exit_flag = true;
@@ -37,6 +37,7 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage oslib_test_006_001
+ * - @subpage oslib_test_006_002
  * .
  */
 
@@ -59,6 +60,7 @@ typedef struct {
 } cached_object_t;
 
 static oc_hash_header_t hash_headers[NUM_HASH_ENTRIES];
+static oc_hash_header_t hash_headers2[NUM_HASH_ENTRIES * 2];
 static cached_object_t objects[NUM_OBJECTS];
 static objects_cache_t cache1;
 
@@ -243,6 +245,118 @@ static const testcase_t oslib_test_006_001 = {
   oslib_test_006_001_execute
 };
 
+/**
+ * @page oslib_test_006_002 [6.2] Hash table resize
+ *
+ * <h2>Description</h2>
+ * A cache object is filled with objects from several groups, then its
+ * hash table is replaced with a larger one, cached objects must not be
+ * lost.
+ *
+ * <h2>Test Steps</h2>
+ * - [6.2.1] Cache initialization.
+ * - [6.2.2] Filling the cache with objects from different groups.
+ * - [6.2.3] Checking the hash table statistics.
+ * - [6.2.4] Resizing the hash table.
+ * - [6.2.5] Checking cached objects after resize.
+ * .
+ */
+
+static void oslib_test_006_002_execute(void) {
+
+  /* [6.2.1] Cache initialization.*/
+  test_set_step(1);
+  {
+    chCacheObjectInit(&cache1,
+                      NUM_HASH_ENTRIES,
+                      hash_headers,
+                      NUM_OBJECTS,
+                      sizeof (cached_object_t),
+                      objects,
+                      obj_read,
+                      obj_write);
+  }
+  test_end_step(1);
+
+  /* [6.2.2] Filling the cache with objects from different groups.*/
+  test_set_step(2);
+  {
+    uint32_t i;
+    bool error;
+
+    for (i = 0; i < NUM_OBJECTS; i++) {
+      oc_object_t *objp = chCacheGetObject(&cache1, i, i);
+
+      error = chCacheReadObject(&cache1, objp, false);
+
+      test_assert(error == false, "returned error");
+      test_assert((objp->obj_flags & OC_FLAG_NOTSYNC) == 0U, "not in sync");
+
+      chCacheReleaseObject(&cache1, objp);
+    }
+
+    test_assert_sequence("abcd", "unexpected tokens");
+  }
+  test_end_step(2);
+
+  /* [6.2.3] Checking the hash table statistics.*/
+  test_set_step(3);
+  {
+    oc_hash_stats_t stats;
+
+    chCacheGetHashStats(&cache1, &stats);
+
+    test_assert(stats.hashn == NUM_HASH_ENTRIES, "wrong hash size");
+    test_assert(stats.objects == NUM_OBJECTS, "wrong objects count");
+    test_assert((stats.used > 0U) && (stats.used <= NUM_OBJECTS),
+                "wrong used slots");
+    test_assert(stats.maxchain >= 1U, "wrong max chain");
+  }
+  test_end_step(3);
+
+  /* [6.2.4] Resizing the hash table.*/
+  test_set_step(4);
+  {
+    oc_hash_header_t *hhp;
+    oc_hash_stats_t stats;
+
+    hhp = chCacheResizeHash(&cache1, NUM_HASH_ENTRIES * 2, hash_headers2);
+
+    test_assert(hhp == hash_headers, "wrong previous table");
+
+    chCacheGetHashStats(&cache1, &stats);
+
+    test_assert(stats.hashn == NUM_HASH_ENTRIES * 2, "wrong hash size");
+    test_assert(stats.objects == NUM_OBJECTS, "objects lost");
+  }
+  test_end_step(4);
+
+  /* [6.2.5] Checking cached objects after resize.*/
+  test_set_step(5);
+  {
+    uint32_t i;
+
+    for (i = 0; i < NUM_OBJECTS; i++) {
+      oc_object_t *objp = chCacheGetObject(&cache1, i, i);
+
+      test_assert((objp->obj_flags & OC_FLAG_INHASH) != 0U, "not in hash");
+      test_assert((objp->obj_flags & OC_FLAG_NOTSYNC) == 0U, "not in sync");
+
+      chCacheReleaseObject(&cache1, objp);
+    }
+
+    test_assert_sequence("", "unexpected tokens");
+  }
+  test_end_step(5);
+}
+
+static const testcase_t oslib_test_006_002 = {
+  "Hash table resize",
+  NULL,
+  NULL,
+  oslib_test_006_002_execute
+};
+
 /****************************************************************************
  * Exported data.
  ****************************************************************************/
@@ -252,6 +366,7 @@ static const testcase_t oslib_test_006_001 = {
  */
 const testcase_t * const oslib_test_sequence_006_array[] = {
   &oslib_test_006_001,
+  &oslib_test_006_002,
   NULL
 };
 
@@ -0,0 +1,578 @@
+/*
+    ChibiOS - Copyright (C) 2006..2017 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+#include "oslib_test_root.h"
+
+/**
+ * @file    oslib_test_sequence_010.c
+ * @brief   Test Sequence 010 code.
+ *
+ * @page oslib_test_sequence_010 [10] Lock-free Rings
+ *
+ * File: @ref oslib_test_sequence_010.c
+ *
+ * <h2>Description</h2>
+ * This sequence tests the ChibiOS library functionalities related to
+ * lock-free rings.
+ *
+ * <h2>Conditions</h2>
+ * This sequence is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_RINGS
+ * .
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage oslib_test_010_001
+ * - @subpage oslib_test_010_002
+ * - @subpage oslib_test_010_003
+ * - @subpage oslib_test_010_004
+ * - @subpage oslib_test_010_005
+ * .
+ */
+
+#if (CH_CFG_USE_RINGS) || defined(__DOXYGEN__)
+
+/****************************************************************************
+ * Shared code.
+ ****************************************************************************/
+
+#include <string.h>
+
+#define RING_SIZE 16
+#define STREAM_SIZE 256
+#define CHUNK_SIZE 8
+
+static uint8_t buffer[RING_SIZE];
+static RING_DECL(ring1, buffer, RING_SIZE);
+
+static const uint8_t ring_pattern[] = "0123456789ABCDEF";
+
+static THD_WORKING_AREA(waThread1, 256);
+static THD_FUNCTION(Thread1, arg) {
+  uint8_t b[7];
+  unsigned i, j, n;
+
+  (void)arg;
+
+  /* Writing a known sequence in odd sized chunks.*/
+  for (i = 0U; i < STREAM_SIZE; i += n) {
+    n = (STREAM_SIZE - i) < sizeof (b) ? (STREAM_SIZE - i) : sizeof (b);
+    for (j = 0U; j < n; j++) {
+      b[j] = (uint8_t)(i + j);
+    }
+    (void) chRingWriteTimeout(&ring1, b, n, TIME_INFINITE);
+  }
+}
+
+#if CH_CFG_USE_PIPES
+static uint8_t pipe_buffer[RING_SIZE];
+static PIPE_DECL(pipe1, pipe_buffer, RING_SIZE);
+#endif
+
+/****************************************************************************
+ * Test cases.
+ ****************************************************************************/
+
+/**
+ * @page oslib_test_010_001 [10.1] Ring normal API, non-blocking tests
+ *
+ * <h2>Description</h2>
+ * The ring functionality is tested by loading and emptying it, all
+ * conditions are tested.
+ *
+ * <h2>Test Steps</h2>
+ * - [10.1.1] Checking initial state.
+ * - [10.1.2] Reading data, must fail.
+ * - [10.1.3] Filling whole ring.
+ * - [10.1.4] Writing data, must fail.
+ * - [10.1.5] Emptying ring.
+ * - [10.1.6] Small write and small read.
+ * - [10.1.7] Write and read wrapping buffer boundary.
+ * .
+ */
+
+static void oslib_test_010_001_setup(void) {
+  chRingObjectInit(&ring1, buffer, RING_SIZE);
+}
+
+static void oslib_test_010_001_execute(void) {
+
+  /* [10.1.1] Checking initial state.*/
+  test_set_step(1);
+  {
+    test_assert(chRingGetSizeX(&ring1) == RING_SIZE, "wrong size");
+    test_assert((chRingGetUsedCountX(&ring1) == 0) &&
+                (chRingGetFreeCountX(&ring1) == RING_SIZE),
+                "invalid ring state");
+  }
+  test_end_step(1);
+
+  /* [10.1.2] Reading data, must fail.*/
+  test_set_step(2);
+  {
+    size_t n;
+    uint8_t buf[RING_SIZE];
+
+    n = chRingReadX(&ring1, buf, RING_SIZE);
+    test_assert(n == 0, "not empty");
+  }
+  test_end_step(2);
+
+  /* [10.1.3] Filling whole ring.*/
+  test_set_step(3);
+  {
+    size_t n;
+
+    n = chRingWriteX(&ring1, ring_pattern, RING_SIZE);
+    test_assert(n == RING_SIZE, "wrong size");
+    test_assert((chRingGetUsedCountX(&ring1) == RING_SIZE) &&
+                (chRingGetFreeCountX(&ring1) == 0),
+                "invalid ring state");
+  }
+  test_end_step(3);
+
+  /* [10.1.4] Writing data, must fail.*/
+  test_set_step(4);
+  {
+    size_t n;
+
+    n = chRingWriteX(&ring1, ring_pattern, RING_SIZE);
+    test_assert(n == 0, "not full");
+  }
+  test_end_step(4);
+
+  /* [10.1.5] Emptying ring.*/
+  test_set_step(5);
+  {
+    size_t n;
+    uint8_t buf[RING_SIZE];
+
+    n = chRingReadX(&ring1, buf, RING_SIZE);
+    test_assert(n == RING_SIZE, "wrong size");
+    test_assert((chRingGetUsedCountX(&ring1) == 0) &&
+                (chRingGetFreeCountX(&ring1) == RING_SIZE),
+                "invalid ring state");
+    test_assert(memcmp(ring_pattern, buf, RING_SIZE) == 0, "content mismatch");
+  }
+  test_end_step(5);
+
+  /* [10.1.6] Small write and small read.*/
+  test_set_step(6);
+  {
+    size_t n;
+    uint8_t buf[RING_SIZE];
+
+    n = chRingWriteX(&ring1, ring_pattern, 4);
+    test_assert(n == 4, "wrong size");
+    test_assert(chRingGetUsedCountX(&ring1) == 4, "invalid ring state");
+    n = chRingReadX(&ring1, buf, RING_SIZE);
+    test_assert(n == 4, "wrong size");
+    test_assert(chRingGetUsedCountX(&ring1) == 0, "invalid ring state");
+    test_assert(memcmp(ring_pattern, buf, 4) == 0, "content mismatch");
+  }
+  test_end_step(6);
+
+  /* [10.1.7] Write and read wrapping buffer boundary.*/
+  test_set_step(7);
+  {
+    size_t n;
+    uint8_t buf[RING_SIZE];
+
+    n = chRingWriteX(&ring1, ring_pattern, RING_SIZE);
+    test_assert(n == RING_SIZE, "wrong size");
+    n = chRingReadX(&ring1, buf, RING_SIZE);
+    test_assert(n == RING_SIZE, "wrong size");
+    test_assert(chRingGetUsedCountX(&ring1) == 0, "invalid ring state");
+    test_assert(memcmp(ring_pattern, buf, RING_SIZE) == 0, "content mismatch");
+  }
+  test_end_step(7);
+}
+
+static const testcase_t oslib_test_010_001 = {
+  "Ring normal API, non-blocking tests",
+  oslib_test_010_001_setup,
+  NULL,
+  oslib_test_010_001_execute
+};
+
+/**
+ * @page oslib_test_010_002 [10.2] Ring spans
+ *
+ * <h2>Description</h2>
+ * The in-place access to the ring buffer is tested, spans wrapping the
+ * buffer boundary must be returned as two segments.
+ *
+ * <h2>Test Steps</h2>
+ * - [10.2.1] Moving the indexes near the buffer end.
+ * - [10.2.2] Getting the write span, it must be split in two segments,
+ *   filling it partially and committing.
+ * - [10.2.3] Getting the read span, it must be split in two segments,
+ *   checking and releasing it.
+ * - [10.2.4] Getting the read span of an empty ring.
+ * .
+ */
+
+static void oslib_test_010_002_setup(void) {
+  chRingObjectInit(&ring1, buffer, RING_SIZE);
+}
+
+static void oslib_test_010_002_execute(void) {
+
+  /* [10.2.1] Moving the indexes near the buffer end.*/
+  test_set_step(1);
+  {
+    size_t n;
+    uint8_t buf[RING_SIZE];
+
+    n = chRingWriteX(&ring1, ring_pattern, RING_SIZE - 4);
+    test_assert(n == RING_SIZE - 4, "wrong size");
+    n = chRingReadX(&ring1, buf, RING_SIZE - 4);
+    test_assert(n == RING_SIZE - 4, "wrong size");
+  }
+  test_end_step(1);
+
+  /* [10.2.2] Getting the write span, it must be split in two segments,
+     filling it partially and committing.*/
+  test_set_step(2);
+  {
+    ring_span_t span;
+    size_t n;
+
+    n = chRingGetWriteSpanX(&ring1, &span);
+    test_assert(n == RING_SIZE, "wrong size");
+    test_assert((span.p1 == &buffer[RING_SIZE - 4]) && (span.n1 == 4) &&
+                (span.p2 == buffer) && (span.n2 == RING_SIZE - 4),
+                "invalid span");
+    memcpy(span.p1, &ring_pattern[0], 4);
+    memcpy(span.p2, &ring_pattern[4], 4);
+    chRingCommitX(&ring1, 8);
+    test_assert(chRingGetUsedCountX(&ring1) == 8, "invalid ring state");
+  }
+  test_end_step(2);
+
+  /* [10.2.3] Getting the read span, it must be split in two segments,
+     checking and releasing it.*/
+  test_set_step(3);
+  {
+    ring_span_t span;
+    size_t n;
+
+    n = chRingGetReadSpanX(&ring1, &span);
+    test_assert(n == 8, "wrong size");
+    test_assert((span.p1 == &buffer[RING_SIZE - 4]) && (span.n1 == 4) &&
+                (span.p2 == buffer) && (span.n2 == 4),
+                "invalid span");
+    test_assert((memcmp(span.p1, &ring_pattern[0], 4) == 0) &&
+                (memcmp(span.p2, &ring_pattern[4], 4) == 0),
+                "content mismatch");
+    chRingReleaseX(&ring1, n);
+    test_assert(chRingGetUsedCountX(&ring1) == 0, "invalid ring state");
+  }
+  test_end_step(3);
+
+  /* [10.2.4] Getting the read span of an empty ring.*/
+  test_set_step(4);
+  {
+    ring_span_t span;
+    size_t n;
+
+    n = chRingGetReadSpanX(&ring1, &span);
+    test_assert((n == 0) && (span.n1 == 0) && (span.n2 == 0), "not empty");
+  }
+  test_end_step(4);
+}
+
+static const testcase_t oslib_test_010_002 = {
+  "Ring spans",
+  oslib_test_010_002_setup,
+  NULL,
+  oslib_test_010_002_execute
+};
+
+/**
+ * @page oslib_test_010_003 [10.3] Ring timeouts
+ *
+ * <h2>Description</h2>
+ * The ring API is tested for timeouts.
+ *
+ * <h2>Test Steps</h2>
+ * - [10.3.1] Reading while ring is empty.
+ * - [10.3.2] Writing a string larger than ring buffer.
+ * - [10.3.3] Reading a string larger than ring buffer.
+ * .
+ */
+
+static void oslib_test_010_003_setup(void) {
+  chRingObjectInit(&ring1, buffer, RING_SIZE);
+}
+
+static void oslib_test_010_003_execute(void) {
+
+  /* [10.3.1] Reading while ring is empty.*/
+  test_set_step(1);
+  {
+    size_t n;
+    uint8_t buf[RING_SIZE];
+
+    n = chRingReadTimeout(&ring1, buf, RING_SIZE, TIME_MS2I(100));
+    test_assert(n == 0, "wrong size");
+  }
+  test_end_step(1);
+
+  /* [10.3.2] Writing a string larger than ring buffer.*/
+  test_set_step(2);
+  {
+    size_t n;
+
+    n = chRingWriteTimeout(&ring1, ring_pattern, RING_SIZE / 2, TIME_IMMEDIATE);
+    test_assert(n == RING_SIZE / 2, "wrong size");
+    n = chRingWriteTimeout(&ring1, ring_pattern, RING_SIZE, TIME_MS2I(100));
+    test_assert(n == RING_SIZE / 2, "wrong size");
+    test_assert(chRingGetFreeCountX(&ring1) == 0, "invalid ring state");
+  }
+  test_end_step(2);
+
+  /* [10.3.3] Reading a string larger than ring buffer.*/
+  test_set_step(3);
+  {
+    size_t n;
+    uint8_t buf[RING_SIZE * 2];
+
+    n = chRingReadTimeout(&ring1, buf, RING_SIZE * 2, TIME_MS2I(100));
+    test_assert(n == RING_SIZE, "wrong size");
+    test_assert(chRingGetUsedCountX(&ring1) == 0, "invalid ring state");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t oslib_test_010_003 = {
+  "Ring timeouts",
+  oslib_test_010_003_setup,
+  NULL,
+  oslib_test_010_003_execute
+};
+
+/**
+ * @page oslib_test_010_004 [10.4] Ring producer and consumer threads
+ *
+ * <h2>Description</h2>
+ * A producer thread writes a known data stream into the ring while the
+ * consumer thread reads it, both threads have to wait on the ring and
+ * the data must be received unaltered.
+ *
+ * <h2>Test Steps</h2>
+ * - [10.4.1] Starting the producer thread at lower priority.
+ * - [10.4.2] Reading the whole stream in chunks and checking the data.
+ * - [10.4.3] Waiting for the producer thread to terminate, the ring
+ *   must be empty.
+ * .
+ */
+
+static void oslib_test_010_004_setup(void) {
+  chRingObjectInit(&ring1, buffer, RING_SIZE);
+}
+
+static void oslib_test_010_004_execute(void) {
+  thread_t *tp;
+
+  /* [10.4.1] Starting the producer thread at lower priority.*/
+  test_set_step(1);
+  {
+    thread_descriptor_t td = {
+      .name  = "producer",
+      .wbase = waThread1,
+      .wend  = THD_WORKING_AREA_END(waThread1),
+      .prio  = chThdGetPriorityX() - 1,
+      .funcp = Thread1,
+      .arg   = NULL
+    };
+    tp = chThdCreate(&td);
+  }
+  test_end_step(1);
+
+  /* [10.4.2] Reading the whole stream in chunks and checking the data.*/
+  test_set_step(2);
+  {
+    uint8_t buf[CHUNK_SIZE];
+    unsigned i, j;
+    bool ok = true;
+
+    for (i = 0U; i < STREAM_SIZE; i += CHUNK_SIZE) {
+      size_t n = chRingReadTimeout(&ring1, buf, CHUNK_SIZE, TIME_MS2I(100));
+      test_assert(n == CHUNK_SIZE, "wrong size");
+      for (j = 0U; j < CHUNK_SIZE; j++) {
+        if (buf[j] != (uint8_t)(i + j)) {
+          ok = false;
+        }
+      }
+    }
+    test_assert(ok, "content mismatch");
+  }
+  test_end_step(2);
+
+  /* [10.4.3] Waiting for the producer thread to terminate, the ring
+     must be empty.*/
+  test_set_step(3);
+  {
+    (void) chThdWait(tp);
+    test_assert(chRingGetUsedCountX(&ring1) == 0, "invalid ring state");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t oslib_test_010_004 = {
+  "Ring producer and consumer threads",
+  oslib_test_010_004_setup,
+  NULL,
+  oslib_test_010_004_execute
+};
+
+#if (CH_CFG_USE_PIPES) || defined(__DOXYGEN__)
+/**
+ * @page oslib_test_010_005 [10.5] Ring and pipe throughput
+ *
+ * <h2>Description</h2>
+ * The same data transfer pattern is performed using a ring and a pipe,
+ * the number of bytes transferred per second is measured and the result
+ * printed on the output log.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_PIPES
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [10.5.1] Writing and reading a ring in a one second time window.
+ * - [10.5.2] Ring score is printed.
+ * - [10.5.3] Writing and reading a pipe in a one second time window.
+ * - [10.5.4] Pipe score is printed.
+ * .
+ */
+
+static void oslib_test_010_005_setup(void) {
+  chRingObjectInit(&ring1, buffer, RING_SIZE);
+  chPipeObjectInit(&pipe1, pipe_buffer, RING_SIZE);
+}
+
+static void oslib_test_010_005_execute(void) {
+  uint32_t n;
+  systime_t start, end;
+  uint8_t buf[CHUNK_SIZE];
+
+  /* [10.5.1] Writing and reading a ring in a one second time window.*/
+  test_set_step(1);
+  {
+    n = 0;
+    chThdSleep(1);
+    start = chVTGetSystemTimeX();
+    end = chTimeAddX(start, TIME_MS2I(1000));
+    do {
+      (void) chRingWriteTimeout(&ring1, ring_pattern, CHUNK_SIZE, TIME_INFINITE);
+      (void) chRingReadTimeout(&ring1, buf, CHUNK_SIZE, TIME_INFINITE);
+      (void) chRingWriteTimeout(&ring1, ring_pattern, CHUNK_SIZE, TIME_INFINITE);
+      (void) chRingReadTimeout(&ring1, buf, CHUNK_SIZE, TIME_INFINITE);
+      (void) chRingWriteTimeout(&ring1, ring_pattern, CHUNK_SIZE, TIME_INFINITE);
+      (void) chRingReadTimeout(&ring1, buf, CHUNK_SIZE, TIME_INFINITE);
+      (void) chRingWriteTimeout(&ring1, ring_pattern, CHUNK_SIZE, TIME_INFINITE);
+      (void) chRingReadTimeout(&ring1, buf, CHUNK_SIZE, TIME_INFINITE);
+      n += CHUNK_SIZE * 4;
+    #if defined(SIMULATOR)
+      _sim_check_for_interrupts();
+    #endif
+    } while (chVTIsSystemTimeWithinX(start, end));
+  }
+  test_end_step(1);
+
+  /* [10.5.2] Ring score is printed.*/
+  test_set_step(2);
+  {
+    test_print("--- Ring  : ");
+    test_printn(n);
+    test_println(" bytes/S");
+  }
+  test_end_step(2);
+
+  /* [10.5.3] Writing and reading a pipe in a one second time window.*/
+  test_set_step(3);
+  {
+    n = 0;
+    chThdSleep(1);
+    start = chVTGetSystemTimeX();
+    end = chTimeAddX(start, TIME_MS2I(1000));
+    do {
+      (void) chPipeWriteTimeout(&pipe1, ring_pattern, CHUNK_SIZE, TIME_INFINITE);
+      (void) chPipeReadTimeout(&pipe1, buf, CHUNK_SIZE, TIME_INFINITE);
+      (void) chPipeWriteTimeout(&pipe1, ring_pattern, CHUNK_SIZE, TIME_INFINITE);
+      (void) chPipeReadTimeout(&pipe1, buf, CHUNK_SIZE, TIME_INFINITE);
+      (void) chPipeWriteTimeout(&pipe1, ring_pattern, CHUNK_SIZE, TIME_INFINITE);
+      (void) chPipeReadTimeout(&pipe1, buf, CHUNK_SIZE, TIME_INFINITE);
+      (void) chPipeWriteTimeout(&pipe1, ring_pattern, CHUNK_SIZE, TIME_INFINITE);
+      (void) chPipeReadTimeout(&pipe1, buf, CHUNK_SIZE, TIME_INFINITE);
+      n += CHUNK_SIZE * 4;
+    #if defined(SIMULATOR)
+      _sim_check_for_interrupts();
+    #endif
+    } while (chVTIsSystemTimeWithinX(start, end));
+  }
+  test_end_step(3);
+
+  /* [10.5.4] Pipe score is printed.*/
+  test_set_step(4);
+  {
+    test_print("--- Pipe  : ");
+    test_printn(n);
+    test_println(" bytes/S");
+  }
+  test_end_step(4);
+}
+
+static const testcase_t oslib_test_010_005 = {
+  "Ring and pipe throughput",
+  oslib_test_010_005_setup,
+  NULL,
+  oslib_test_010_005_execute
+};
+#endif /* CH_CFG_USE_PIPES */
+
+/****************************************************************************
+ * Exported data.
+ ****************************************************************************/
+
+/**
+ * @brief   Array of test cases.
+ */
+const testcase_t * const oslib_test_sequence_010_array[] = {
+  &oslib_test_010_001,
+  &oslib_test_010_002,
+  &oslib_test_010_003,
+  &oslib_test_010_004,
+#if (CH_CFG_USE_PIPES) || defined(__DOXYGEN__)
+  &oslib_test_010_005,
+#endif
+  NULL
+};
+
+/**
+ * @brief   Lock-free Rings.
+ */
+const testsequence_t oslib_test_sequence_010 = {
+  "Lock-free Rings",
+  oslib_test_sequence_010_array
+};
+
+#endif /* CH_CFG_USE_RINGS */
@@ -0,0 +1,389 @@
+/*
+    ChibiOS - Copyright (C) 2006..2017 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+#include "oslib_test_root.h"
+
+/**
+ * @file    oslib_test_sequence_011.c
+ * @brief   Test Sequence 011 code.
+ *
+ * @page oslib_test_sequence_011 [11] Lock-free Queues
+ *
+ * File: @ref oslib_test_sequence_011.c
+ *
+ * <h2>Description</h2>
+ * This sequence tests the ChibiOS library functionalities related to
+ * lock-free queues.
+ *
+ * <h2>Conditions</h2>
+ * This sequence is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_LF_QUEUES
+ * .
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage oslib_test_011_001
+ * - @subpage oslib_test_011_002
+ * - @subpage oslib_test_011_003
+ * .
+ */
+
+#if (CH_CFG_USE_LF_QUEUES) || defined(__DOXYGEN__)
+
+/****************************************************************************
+ * Shared code.
+ ****************************************************************************/
+
+#define LFQ_SIZE 8
+#define STRESS_PRODUCERS 3
+#define STRESS_MESSAGES 1000
+
+static lfq_cell_t cells[LFQ_SIZE];
+static lf_queue_t lfq1;
+
+static THD_WORKING_AREA(waProducer1, 256);
+static THD_WORKING_AREA(waProducer2, 256);
+static THD_WORKING_AREA(waProducer3, 256);
+static THD_WORKING_AREA(waConsumer1, 256);
+
+static unsigned received[2][STRESS_PRODUCERS];
+static bool ordered;
+
+static THD_FUNCTION(producer_thread, arg) {
+  msg_t id = (msg_t)arg;
+  msg_t i;
+
+  for (i = 0; i < STRESS_MESSAGES; i++) {
+    (void) chLFQPostTimeout(&lfq1, (id << 16) | i, TIME_INFINITE);
+  }
+}
+
+static void consume(unsigned c) {
+  msg_t last[STRESS_PRODUCERS] = {-1, -1, -1};
+  msg_t msg;
+
+  /* Messages from each producer must be received in order, the consumer
+     stops when the queue remains empty for some time.*/
+  while (chLFQFetchTimeout(&lfq1, &msg, TIME_MS2I(100)) == MSG_OK) {
+    msg_t id = msg >> 16;
+    msg_t i = msg & 0xFFFF;
+
+    if ((id < 0) || (id >= STRESS_PRODUCERS) || (i <= last[id])) {
+      ordered = false;
+    }
+    else {
+      last[id] = i;
+      received[c][id]++;
+    }
+  }
+}
+
+static THD_FUNCTION(consumer_thread, arg) {
+
+  (void)arg;
+
+  consume(1U);
+}
+
+/****************************************************************************
+ * Test cases.
+ ****************************************************************************/
+
+/**
+ * @page oslib_test_011_001 [11.1] Lock-free queue normal API, non-blocking tests
+ *
+ * <h2>Description</h2>
+ * The lock-free queue functionality is tested by loading and emptying
+ * it, all conditions are tested.
+ *
+ * <h2>Test Steps</h2>
+ * - [11.1.1] Checking initial state.
+ * - [11.1.2] Fetching a message, must fail.
+ * - [11.1.3] Filling the queue.
+ * - [11.1.4] Posting a message, must fail.
+ * - [11.1.5] Emptying the queue, messages must be in order.
+ * - [11.1.6] Posting and fetching across the cells array boundary.
+ * .
+ */
+
+static void oslib_test_011_001_setup(void) {
+  chLFQObjectInit(&lfq1, cells, LFQ_SIZE);
+}
+
+static void oslib_test_011_001_execute(void) {
+  msg_t msg;
+  unsigned i;
+
+  /* [11.1.1] Checking initial state.*/
+  test_set_step(1);
+  {
+    test_assert(chLFQGetSizeX(&lfq1) == LFQ_SIZE, "wrong size");
+    test_assert(chLFQGetUsedCountX(&lfq1) == 0, "not empty");
+  }
+  test_end_step(1);
+
+  /* [11.1.2] Fetching a message, must fail.*/
+  test_set_step(2);
+  {
+    msg = chLFQFetchX(&lfq1, &msg);
+    test_assert(msg == MSG_TIMEOUT, "not empty");
+  }
+  test_end_step(2);
+
+  /* [11.1.3] Filling the queue.*/
+  test_set_step(3);
+  {
+    for (i = 0; i < LFQ_SIZE; i++) {
+      msg = chLFQPostX(&lfq1, 'A' + i);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+    }
+    test_assert(chLFQGetUsedCountX(&lfq1) == LFQ_SIZE, "not full");
+  }
+  test_end_step(3);
+
+  /* [11.1.4] Posting a message, must fail.*/
+  test_set_step(4);
+  {
+    msg = chLFQPostX(&lfq1, 'X');
+    test_assert(msg == MSG_TIMEOUT, "not full");
+  }
+  test_end_step(4);
+
+  /* [11.1.5] Emptying the queue, messages must be in order.*/
+  test_set_step(5);
+  {
+    for (i = 0; i < LFQ_SIZE; i++) {
+      msg_t msg2;
+
+      msg = chLFQFetchX(&lfq1, &msg2);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+      test_emit_token((char)msg2);
+    }
+    test_assert_sequence("ABCDEFGH", "wrong get sequence");
+    test_assert(chLFQGetUsedCountX(&lfq1) == 0, "not empty");
+  }
+  test_end_step(5);
+
+  /* [11.1.6] Posting and fetching across the cells array boundary.*/
+  test_set_step(6);
+  {
+    for (i = 0; i < LFQ_SIZE / 2; i++) {
+      msg_t msg2;
+
+      (void) chLFQPostX(&lfq1, 'A' + i);
+      (void) chLFQFetchX(&lfq1, &msg2);
+    }
+    for (i = 0; i < LFQ_SIZE; i++) {
+      msg = chLFQPostX(&lfq1, 'A' + i);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+    }
+    for (i = 0; i < LFQ_SIZE; i++) {
+      msg_t msg2;
+
+      msg = chLFQFetchX(&lfq1, &msg2);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+      test_emit_token((char)msg2);
+    }
+    test_assert_sequence("ABCDEFGH", "wrong get sequence");
+  }
+  test_end_step(6);
+}
+
+static const testcase_t oslib_test_011_001 = {
+  "Lock-free queue normal API, non-blocking tests",
+  oslib_test_011_001_setup,
+  NULL,
+  oslib_test_011_001_execute
+};
+
+/**
+ * @page oslib_test_011_002 [11.2] Lock-free queue timeouts
+ *
+ * <h2>Description</h2>
+ * The lock-free queue API is tested for timeouts.
+ *
+ * <h2>Test Steps</h2>
+ * - [11.2.1] Fetching from the empty queue with a timeout, must fail.
+ * - [11.2.2] Filling the queue then posting with a timeout, must fail.
+ * .
+ */
+
+static void oslib_test_011_002_setup(void) {
+  chLFQObjectInit(&lfq1, cells, LFQ_SIZE);
+}
+
+static void oslib_test_011_002_execute(void) {
+  msg_t msg, msg2;
+  unsigned i;
+
+  /* [11.2.1] Fetching from the empty queue with a timeout, must fail.*/
+  test_set_step(1);
+  {
+    msg = chLFQFetchTimeout(&lfq1, &msg2, TIME_MS2I(100));
+    test_assert(msg == MSG_TIMEOUT, "wrong wake-up message");
+  }
+  test_end_step(1);
+
+  /* [11.2.2] Filling the queue then posting with a timeout, must fail.*/
+  test_set_step(2);
+  {
+    for (i = 0; i < LFQ_SIZE; i++) {
+      msg = chLFQPostTimeout(&lfq1, 'A' + i, TIME_INFINITE);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+    }
+    msg = chLFQPostTimeout(&lfq1, 'X', TIME_MS2I(100));
+    test_assert(msg == MSG_TIMEOUT, "wrong wake-up message");
+  }
+  test_end_step(2);
+}
+
+static const testcase_t oslib_test_011_002 = {
+  "Lock-free queue timeouts",
+  oslib_test_011_002_setup,
+  NULL,
+  oslib_test_011_002_execute
+};
+
+/**
+ * @page oslib_test_011_003 [11.3] Lock-free queue stress test
+ *
+ * <h2>Description</h2>
+ * Several producer threads post sequences of messages into a small
+ * lock-free queue while two consumers fetch them, producers and
+ * consumers have to wait on the queue. All messages must be received
+ * and messages from the same producer must be received in order.
+ *
+ * <h2>Test Steps</h2>
+ * - [11.3.1] Starting a consumer thread and the producer threads, each
+ *   thread at its own priority level.
+ * - [11.3.2] Consuming messages in the test thread too.
+ * - [11.3.3] Waiting for all threads to terminate then checking the
+ *   results.
+ * .
+ */
+
+static void oslib_test_011_003_setup(void) {
+  chLFQObjectInit(&lfq1, cells, LFQ_SIZE);
+}
+
+static void oslib_test_011_003_execute(void) {
+  thread_t *tp[STRESS_PRODUCERS + 1];
+  unsigned i;
+
+  /* [11.3.1] Starting a consumer thread and the producer threads, each
+     thread at its own priority level.*/
+  test_set_step(1);
+  {
+    thread_descriptor_t td = {
+      .name  = "consumer",
+      .wbase = waConsumer1,
+      .wend  = THD_WORKING_AREA_END(waConsumer1),
+      .prio  = chThdGetPriorityX() + 1,
+      .funcp = consumer_thread,
+      .arg   = NULL
+    };
+    thread_descriptor_t td1 = {
+      .name  = "producer1",
+      .wbase = waProducer1,
+      .wend  = THD_WORKING_AREA_END(waProducer1),
+      .prio  = chThdGetPriorityX() - 1,
+      .funcp = producer_thread,
+      .arg   = (void *)0
+    };
+    thread_descriptor_t td2 = {
+      .name  = "producer2",
+      .wbase = waProducer2,
+      .wend  = THD_WORKING_AREA_END(waProducer2),
+      .prio  = chThdGetPriorityX() - 2,
+      .funcp = producer_thread,
+      .arg   = (void *)1
+    };
+    thread_descriptor_t td3 = {
+      .name  = "producer3",
+      .wbase = waProducer3,
+      .wend  = THD_WORKING_AREA_END(waProducer3),
+      .prio  = chThdGetPriorityX() - 3,
+      .funcp = producer_thread,
+      .arg   = (void *)2
+    };
+
+    ordered = true;
+    for (i = 0; i < STRESS_PRODUCERS; i++) {
+      received[0][i] = 0U;
+      received[1][i] = 0U;
+    }
+    tp[0] = chThdCreate(&td);
+    tp[1] = chThdCreate(&td1);
+    tp[2] = chThdCreate(&td2);
+    tp[3] = chThdCreate(&td3);
+  }
+  test_end_step(1);
+
+  /* [11.3.2] Consuming messages in the test thread too.*/
+  test_set_step(2);
+  {
+    consume(0U);
+  }
+  test_end_step(2);
+
+  /* [11.3.3] Waiting for all threads to terminate then checking the
+     results.*/
+  test_set_step(3);
+  {
+    for (i = 0; i < STRESS_PRODUCERS + 1; i++) {
+      (void) chThdWait(tp[i]);
+    }
+    test_assert(ordered, "wrong order");
+    for (i = 0; i < STRESS_PRODUCERS; i++) {
+      test_assert(received[0][i] + received[1][i] == STRESS_MESSAGES,
+                  "messages lost");
+    }
+    test_assert(chLFQGetUsedCountX(&lfq1) == 0, "not empty");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t oslib_test_011_003 = {
+  "Lock-free queue stress test",
+  oslib_test_011_003_setup,
+  NULL,
+  oslib_test_011_003_execute
+};
+
+/****************************************************************************
+ * Exported data.
+ ****************************************************************************/
+
+/**
+ * @brief   Array of test cases.
+ */
+const testcase_t * const oslib_test_sequence_011_array[] = {
+  &oslib_test_011_001,
+  &oslib_test_011_002,
+  &oslib_test_011_003,
+  NULL
+};
+
+/**
+ * @brief   Lock-free Queues.
+ */
+const testsequence_t oslib_test_sequence_011 = {
+  "Lock-free Queues",
+  oslib_test_sequence_011_array
+};
+
+#endif /* CH_CFG_USE_LF_QUEUES */
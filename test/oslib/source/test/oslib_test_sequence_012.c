@@ -0,0 +1,518 @@
+/*
+    ChibiOS - Copyright (C) 2006..2017 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+#include "oslib_test_root.h"
+
+/**
+ * @file    oslib_test_sequence_012.c
+ * @brief   Test Sequence 012 code.
+ *
+ * @page oslib_test_sequence_012 [12] Record Queues
+ *
+ * File: @ref oslib_test_sequence_012.c
+ *
+ * <h2>Description</h2>
+ * This sequence tests the ChibiOS library functionalities related to
+ * record queues.
+ *
+ * <h2>Conditions</h2>
+ * This sequence is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_REC_QUEUES
+ * .
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage oslib_test_012_001
+ * - @subpage oslib_test_012_002
+ * - @subpage oslib_test_012_003
+ * - @subpage oslib_test_012_004
+ * - @subpage oslib_test_012_005
+ * .
+ */
+
+#if (CH_CFG_USE_REC_QUEUES) || defined(__DOXYGEN__)
+
+/****************************************************************************
+ * Shared code.
+ ****************************************************************************/
+
+#include <string.h>
+
+#define RECORD_SIZE 8
+#define RECORDS_NUM 4
+#define RQ_SIZE (RQ_RECORD_SIZE(RECORD_SIZE) * RECORDS_NUM)
+#define MIXED_RECORD_SIZE 32
+#define RQ_MIXED_SIZE RQ_BUFFER_SIZE(MIXED_RECORD_SIZE, RECORDS_NUM)
+
+static ALIGNED_VAR(PORT_NATURAL_ALIGN) uint8_t rq_buffer[RQ_SIZE];
+static ALIGNED_VAR(PORT_NATURAL_ALIGN) uint8_t rq_mixed_buffer[RQ_MIXED_SIZE];
+static RECORD_QUEUE_DECL(rq1, rq_buffer, RQ_SIZE);
+
+static const uint8_t rq_pattern[] = "0123456789ABCDEF";
+
+static size_t rq_get_used(void) {
+  size_t n;
+
+  chSysLock();
+  n = chRQGetUsedCountI(&rq1);
+  chSysUnlock();
+
+  return n;
+}
+
+/****************************************************************************
+ * Test cases.
+ ****************************************************************************/
+
+/**
+ * @page oslib_test_012_001 [12.1] Record queue normal API, non-blocking tests
+ *
+ * <h2>Description</h2>
+ * The record queue functionality is tested by loading and emptying it
+ * using the copying API, all conditions are tested.
+ *
+ * <h2>Test Steps</h2>
+ * - [12.1.1] Checking initial state.
+ * - [12.1.2] Receiving a record, must fail.
+ * - [12.1.3] Filling the queue with records of increasing size.
+ * - [12.1.4] Sending a record, must fail.
+ * - [12.1.5] Emptying the queue, sizes and contents must match.
+ * - [12.1.6] Sending and receiving from ISR context.
+ * .
+ */
+
+static void oslib_test_012_001_setup(void) {
+  chRQObjectInit(&rq1, rq_buffer, RQ_SIZE);
+}
+
+static void oslib_test_012_001_execute(void) {
+  msg_t msg;
+  unsigned i;
+
+  /* [12.1.1] Checking initial state.*/
+  test_set_step(1);
+  {
+    test_assert(chRQGetSizeX(&rq1) == RQ_SIZE, "wrong size");
+    test_assert(rq_get_used() == 0, "not empty");
+  }
+  test_end_step(1);
+
+  /* [12.1.2] Receiving a record, must fail.*/
+  test_set_step(2);
+  {
+    uint8_t buf[RECORD_SIZE];
+    size_t n = sizeof (buf);
+
+    msg = chRQReceiveTimeout(&rq1, buf, &n, TIME_IMMEDIATE);
+    test_assert(msg == MSG_TIMEOUT, "not empty");
+  }
+  test_end_step(2);
+
+  /* [12.1.3] Filling the queue with records of increasing size.*/
+  test_set_step(3);
+  {
+    for (i = 0; i < RECORDS_NUM; i++) {
+      msg = chRQSendTimeout(&rq1, rq_pattern, i + 1, TIME_IMMEDIATE);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+    }
+  }
+  test_end_step(3);
+
+  /* [12.1.4] Sending a record, must fail.*/
+  test_set_step(4);
+  {
+    msg = chRQSendTimeout(&rq1, rq_pattern, RECORD_SIZE, TIME_IMMEDIATE);
+    test_assert(msg == MSG_TIMEOUT, "not full");
+  }
+  test_end_step(4);
+
+  /* [12.1.5] Emptying the queue, sizes and contents must match.*/
+  test_set_step(5);
+  {
+    for (i = 0; i < RECORDS_NUM; i++) {
+      uint8_t buf[RECORD_SIZE];
+      size_t n = sizeof (buf);
+
+      msg = chRQReceiveTimeout(&rq1, buf, &n, TIME_IMMEDIATE);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+      test_assert(n == i + 1, "wrong record size");
+      test_assert(memcmp(buf, rq_pattern, n) == 0, "content mismatch");
+    }
+    test_assert(rq_get_used() == 0, "not empty");
+  }
+  test_end_step(5);
+
+  /* [12.1.6] Sending and receiving from ISR context.*/
+  test_set_step(6);
+  {
+    uint8_t buf[RECORD_SIZE];
+    size_t n = sizeof (buf);
+
+    chSysLock();
+    msg = chRQSendI(&rq1, rq_pattern, 3);
+    chSysUnlock();
+    test_assert(msg == MSG_OK, "wrong wake-up message");
+    chSysLock();
+    msg = chRQReceiveI(&rq1, buf, &n);
+    chSysUnlock();
+    test_assert(msg == MSG_OK, "wrong wake-up message");
+    test_assert(n == 3, "wrong record size");
+    test_assert(memcmp(buf, rq_pattern, n) == 0, "content mismatch");
+  }
+  test_end_step(6);
+}
+
+static const testcase_t oslib_test_012_001 = {
+  "Record queue normal API, non-blocking tests",
+  oslib_test_012_001_setup,
+  NULL,
+  oslib_test_012_001_execute
+};
+
+/**
+ * @page oslib_test_012_002 [12.2] Record queue in-place API
+ *
+ * <h2>Description</h2>
+ * Records are written and read in-place using the reserve, commit, peek
+ * and release functions.
+ *
+ * <h2>Test Steps</h2>
+ * - [12.2.1] Reserving space for a record of maximum size, a second
+ *   reservation must fail.
+ * - [12.2.2] Filling the record partially and committing it.
+ * - [12.2.3] Peeking the record, a second peek must fail.
+ * - [12.2.4] Releasing the record.
+ * .
+ */
+
+static void oslib_test_012_002_setup(void) {
+  chRQObjectInit(&rq1, rq_buffer, RQ_SIZE);
+}
+
+static void oslib_test_012_002_execute(void) {
+  uint8_t *p;
+  size_t n;
+
+  /* [12.2.1] Reserving space for a record of maximum size, a second
+     reservation must fail.*/
+  test_set_step(1);
+  {
+    p = chRQReserveTimeout(&rq1, RECORD_SIZE, TIME_IMMEDIATE);
+    test_assert(p != NULL, "reservation failed");
+    test_assert(chRQReserveTimeout(&rq1, 1, TIME_IMMEDIATE) == NULL,
+                "second reservation allowed");
+  }
+  test_end_step(1);
+
+  /* [12.2.2] Filling the record partially and committing it.*/
+  test_set_step(2);
+  {
+    memcpy(p, rq_pattern, RECORD_SIZE / 2);
+    chRQCommit(&rq1, RECORD_SIZE / 2);
+    test_assert(rq_get_used() == RQ_RECORD_SIZE(RECORD_SIZE / 2), "wrong used count");
+  }
+  test_end_step(2);
+
+  /* [12.2.3] Peeking the record, a second peek must fail.*/
+  test_set_step(3);
+  {
+    p = chRQPeekTimeout(&rq1, &n, TIME_IMMEDIATE);
+    test_assert(p != NULL, "peek failed");
+    test_assert(n == RECORD_SIZE / 2, "wrong record size");
+    test_assert(memcmp(p, rq_pattern, n) == 0, "content mismatch");
+    test_assert(chRQPeekTimeout(&rq1, &n, TIME_IMMEDIATE) == NULL,
+                "second peek allowed");
+  }
+  test_end_step(3);
+
+  /* [12.2.4] Releasing the record.*/
+  test_set_step(4);
+  {
+    chRQRelease(&rq1);
+    test_assert(rq_get_used() == 0, "not empty");
+    test_assert(chRQPeekTimeout(&rq1, &n, TIME_IMMEDIATE) == NULL, "not empty");
+  }
+  test_end_step(4);
+}
+
+static const testcase_t oslib_test_012_002 = {
+  "Record queue in-place API",
+  oslib_test_012_002_setup,
+  NULL,
+  oslib_test_012_002_execute
+};
+
+/**
+ * @page oslib_test_012_003 [12.3] Record queue wrap around
+ *
+ * <h2>Description</h2>
+ * A record that does not fit the space at the end of the buffer must be
+ * written at the buffer start, the space left is filled with padding.
+ *
+ * <h2>Test Steps</h2>
+ * - [12.3.1] Sending three records of maximum size and receiving two of
+ *   them.
+ * - [12.3.2] Reserving a record larger than the space at the end of the
+ *   buffer, it must be placed at the buffer start.
+ * - [12.3.3] Receiving the records, the padding must be skipped.
+ * .
+ */
+
+static void oslib_test_012_003_setup(void) {
+  chRQObjectInit(&rq1, rq_buffer, RQ_SIZE);
+}
+
+static void oslib_test_012_003_execute(void) {
+  msg_t msg;
+  uint8_t *p;
+  size_t n;
+
+  /* [12.3.1] Sending three records of maximum size and receiving two of
+     them.*/
+  test_set_step(1);
+  {
+    uint8_t buf[RECORD_SIZE];
+    unsigned i;
+
+    for (i = 0; i < 3; i++) {
+      msg = chRQSendTimeout(&rq1, rq_pattern, RECORD_SIZE, TIME_IMMEDIATE);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+    }
+    for (i = 0; i < 2; i++) {
+      n = sizeof (buf);
+      msg = chRQReceiveTimeout(&rq1, buf, &n, TIME_IMMEDIATE);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+    }
+    test_assert(rq_get_used() == RQ_RECORD_SIZE(RECORD_SIZE), "wrong used count");
+  }
+  test_end_step(1);
+
+  /* [12.3.2] Reserving a record larger than the space at the end of the
+     buffer, it must be placed at the buffer start.*/
+  test_set_step(2);
+  {
+    size_t size = RQ_RECORD_SIZE(RECORD_SIZE) * 2 - sizeof (rq_header_t);
+
+    p = chRQReserveTimeout(&rq1, size, TIME_IMMEDIATE);
+    test_assert(p == &rq_buffer[sizeof (rq_header_t)], "not at buffer start");
+    memcpy(p, rq_pattern, 16);
+    chRQCommit(&rq1, size);
+    test_assert(rq_get_used() == RQ_SIZE, "wrong used count");
+  }
+  test_end_step(2);
+
+  /* [12.3.3] Receiving the records, the padding must be skipped.*/
+  test_set_step(3);
+  {
+    p = chRQPeekTimeout(&rq1, &n, TIME_IMMEDIATE);
+    test_assert((p != NULL) && (n == RECORD_SIZE), "wrong record");
+    chRQRelease(&rq1);
+    p = chRQPeekTimeout(&rq1, &n, TIME_IMMEDIATE);
+    test_assert(p == &rq_buffer[sizeof (rq_header_t)], "padding not skipped");
+    test_assert(memcmp(p, rq_pattern, 16) == 0, "content mismatch");
+    chRQRelease(&rq1);
+    test_assert(rq_get_used() == 0, "not empty");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t oslib_test_012_003 = {
+  "Record queue wrap around",
+  oslib_test_012_003_setup,
+  NULL,
+  oslib_test_012_003_execute
+};
+
+/**
+ * @page oslib_test_012_004 [12.4] Record queue timeouts and reset
+ *
+ * <h2>Description</h2>
+ * The record queue API is tested for timeouts and reset.
+ *
+ * <h2>Test Steps</h2>
+ * - [12.4.1] Receiving from the empty queue with a timeout, must fail.
+ * - [12.4.2] Filling the queue then sending with a timeout, must fail.
+ * - [12.4.3] Resetting the queue, operations must fail until resumed.
+ * .
+ */
+
+static void oslib_test_012_004_setup(void) {
+  chRQObjectInit(&rq1, rq_buffer, RQ_SIZE);
+}
+
+static void oslib_test_012_004_execute(void) {
+  msg_t msg;
+  unsigned i;
+
+  /* [12.4.1] Receiving from the empty queue with a timeout, must fail.*/
+  test_set_step(1);
+  {
+    uint8_t buf[RECORD_SIZE];
+    size_t n = sizeof (buf);
+
+    msg = chRQReceiveTimeout(&rq1, buf, &n, TIME_MS2I(100));
+    test_assert(msg == MSG_TIMEOUT, "wrong wake-up message");
+  }
+  test_end_step(1);
+
+  /* [12.4.2] Filling the queue then sending with a timeout, must fail.*/
+  test_set_step(2);
+  {
+    for (i = 0; i < RECORDS_NUM; i++) {
+      msg = chRQSendTimeout(&rq1, rq_pattern, RECORD_SIZE, TIME_INFINITE);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+    }
+    msg = chRQSendTimeout(&rq1, rq_pattern, RECORD_SIZE, TIME_MS2I(100));
+    test_assert(msg == MSG_TIMEOUT, "wrong wake-up message");
+  }
+  test_end_step(2);
+
+  /* [12.4.3] Resetting the queue, operations must fail until resumed.*/
+  test_set_step(3);
+  {
+    uint8_t buf[RECORD_SIZE];
+    size_t n = sizeof (buf);
+
+    chRQReset(&rq1);
+    test_assert(rq_get_used() == 0, "not empty");
+    msg = chRQSendTimeout(&rq1, rq_pattern, RECORD_SIZE, TIME_INFINITE);
+    test_assert(msg == MSG_RESET, "wrong wake-up message");
+    msg = chRQReceiveTimeout(&rq1, buf, &n, TIME_INFINITE);
+    test_assert(msg == MSG_RESET, "wrong wake-up message");
+    chRQResumeX(&rq1);
+    msg = chRQSendTimeout(&rq1, rq_pattern, RECORD_SIZE, TIME_IMMEDIATE);
+    test_assert(msg == MSG_OK, "wrong wake-up message");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t oslib_test_012_004 = {
+  "Record queue timeouts and reset",
+  oslib_test_012_004_setup,
+  NULL,
+  oslib_test_012_004_execute
+};
+
+/**
+ * @page oslib_test_012_005 [12.5] Record queue sizing with mixed record sizes
+ *
+ * <h2>Description</h2>
+ * A queue buffer sized using RQ_BUFFER_SIZE() must contain the specified
+ * number of records of any size up to the maximum, whatever the wrap
+ * around position.
+ *
+ * <h2>Test Steps</h2>
+ * - [12.5.1] Sending a small record then records of maximum size up to
+ *   the queue depth.
+ * - [12.5.2] Receiving the small record then sending a record of maximum
+ *   size, must succeed.
+ * - [12.5.3] Rotating the queue with records of mixed sizes, the queue is
+ *   kept at its depth and all operations must succeed.
+ * .
+ */
+
+static void oslib_test_012_005_setup(void) {
+  chRQObjectInit(&rq1, rq_mixed_buffer, RQ_MIXED_SIZE);
+}
+
+static void oslib_test_012_005_execute(void) {
+  msg_t msg;
+  unsigned i;
+
+  /* [12.5.1] Sending a small record then records of maximum size up to
+     the queue depth.*/
+  test_set_step(1);
+  {
+    uint8_t buf[MIXED_RECORD_SIZE];
+
+    memset(buf, 0x55, sizeof (buf));
+    msg = chRQSendTimeout(&rq1, buf, 1, TIME_IMMEDIATE);
+    test_assert(msg == MSG_OK, "wrong wake-up message");
+    for (i = 1; i < RECORDS_NUM; i++) {
+      msg = chRQSendTimeout(&rq1, buf, MIXED_RECORD_SIZE, TIME_IMMEDIATE);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+    }
+  }
+  test_end_step(1);
+
+  /* [12.5.2] Receiving the small record then sending a record of maximum
+     size, must succeed.*/
+  test_set_step(2);
+  {
+    uint8_t buf[MIXED_RECORD_SIZE];
+    size_t n = sizeof (buf);
+
+    msg = chRQReceiveTimeout(&rq1, buf, &n, TIME_IMMEDIATE);
+    test_assert((msg == MSG_OK) && (n == 1), "wrong record");
+    msg = chRQSendTimeout(&rq1, buf, MIXED_RECORD_SIZE, TIME_IMMEDIATE);
+    test_assert(msg == MSG_OK, "full below depth");
+  }
+  test_end_step(2);
+
+  /* [12.5.3] Rotating the queue with records of mixed sizes, the queue is
+     kept at its depth and all operations must succeed.*/
+  test_set_step(3);
+  {
+    uint8_t buf[MIXED_RECORD_SIZE];
+
+    for (i = 0; i < 64; i++) {
+      size_t n = sizeof (buf);
+      size_t size = (i % 3U) == 0U ? MIXED_RECORD_SIZE :
+                                     ((i * 7U) % MIXED_RECORD_SIZE) + 1U;
+
+      msg = chRQReceiveTimeout(&rq1, buf, &n, TIME_IMMEDIATE);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+      memset(buf, (int)i, size);
+      msg = chRQSendTimeout(&rq1, buf, size, TIME_IMMEDIATE);
+      test_assert(msg == MSG_OK, "full below depth");
+    }
+  }
+  test_end_step(3);
+}
+
+static const testcase_t oslib_test_012_005 = {
+  "Record queue sizing with mixed record sizes",
+  oslib_test_012_005_setup,
+  NULL,
+  oslib_test_012_005_execute
+};
+
+/****************************************************************************
+ * Exported data.
+ ****************************************************************************/
+
+/**
+ * @brief   Array of test cases.
+ */
+const testcase_t * const oslib_test_sequence_012_array[] = {
+  &oslib_test_012_001,
+  &oslib_test_012_002,
+  &oslib_test_012_003,
+  &oslib_test_012_004,
+  &oslib_test_012_005,
+  NULL
+};
+
+/**
+ * @brief   Record Queues.
+ */
+const testsequence_t oslib_test_sequence_012 = {
+  "Record Queues",
+  oslib_test_sequence_012_array
+};
+
+#endif /* CH_CFG_USE_REC_QUEUES */
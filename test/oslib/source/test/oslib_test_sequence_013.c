@@ -0,0 +1,447 @@
+/*
+    ChibiOS - Copyright (C) 2006..2017 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+#include "oslib_test_root.h"
+
+/**
+ * @file    oslib_test_sequence_013.c
+ * @brief   Test Sequence 013 code.
+ *
+ * @page oslib_test_sequence_013 [13] Reference-counted Buffers
+ *
+ * File: @ref oslib_test_sequence_013.c
+ *
+ * <h2>Description</h2>
+ * This sequence tests the ChibiOS library functionalities related to
+ * reference-counted buffers.
+ *
+ * <h2>Conditions</h2>
+ * This sequence is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_REF_BUFFERS
+ * .
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage oslib_test_013_001
+ * - @subpage oslib_test_013_002
+ * - @subpage oslib_test_013_003
+ * - @subpage oslib_test_013_004
+ * - @subpage oslib_test_013_005
+ * .
+ */
+
+#if (CH_CFG_USE_REF_BUFFERS) || defined(__DOXYGEN__)
+
+/****************************************************************************
+ * Shared code.
+ ****************************************************************************/
+
+#include <string.h>
+
+#define RB_SIZE 32
+#define RB_NUM 2
+
+static ALIGNED_VAR(PORT_NATURAL_ALIGN) uint8_t rb_objects[RB_NUM][REFBUF_OBJECT_SIZE(RB_SIZE)];
+static refbuf_pool_t rbpool1;
+static unsigned rb_released;
+
+static void rb_release(refbuf_t *rbp) {
+
+  (void)rbp;
+  rb_released++;
+}
+
+static cnt_t rb_get_free(void) {
+  cnt_t n;
+
+  chSysLock();
+  n = chGuardedPoolGetCounterI(&rbpool1.pool);
+  chSysUnlock();
+
+  return n;
+}
+
+static void rb_setup(void) {
+
+  chRBPoolObjectInit(&rbpool1, RB_SIZE);
+  chRBPoolLoadArray(&rbpool1, rb_objects, RB_NUM);
+  rb_released = 0U;
+}
+
+/****************************************************************************
+ * Test cases.
+ ****************************************************************************/
+
+/**
+ * @page oslib_test_013_001 [13.1] Buffers allocation and references
+ *
+ * <h2>Description</h2>
+ * Buffers are allocated from a pool, references are added and released,
+ * the buffers must return to the pool only when the last reference is
+ * released.
+ *
+ * <h2>Test Steps</h2>
+ * - [13.1.1] Allocating all the buffers, a further allocation must
+ *   fail.
+ * - [13.1.2] Adding a reference to the first buffer then releasing it
+ *   once, the buffer must not return to the pool.
+ * - [13.1.3] Releasing the last references, the buffers must return to
+ *   the pool.
+ * .
+ */
+
+static void oslib_test_013_001_setup(void) {
+  rb_setup();
+}
+
+static void oslib_test_013_001_execute(void) {
+  refbuf_t *rbp1, *rbp2;
+
+  /* [13.1.1] Allocating all the buffers, a further allocation must
+     fail.*/
+  test_set_step(1);
+  {
+    rbp1 = chRBAllocTimeout(&rbpool1, 0, TIME_IMMEDIATE);
+    test_assert(rbp1 != NULL, "allocation failed");
+    rbp2 = chRBAllocTimeout(&rbpool1, 0, TIME_IMMEDIATE);
+    test_assert(rbp2 != NULL, "allocation failed");
+    test_assert(chRBAllocTimeout(&rbpool1, 0, TIME_IMMEDIATE) == NULL,
+                "allocation not failed");
+  }
+  test_end_step(1);
+
+  /* [13.1.2] Adding a reference to the first buffer then releasing it
+     once, the buffer must not return to the pool.*/
+  test_set_step(2);
+  {
+    test_assert(chRBAddRef(rbp1) == rbp1, "wrong pointer");
+    chRBRelease(rbp1);
+    test_assert(rb_get_free() == 0, "buffer returned to the pool");
+  }
+  test_end_step(2);
+
+  /* [13.1.3] Releasing the last references, the buffers must return to
+     the pool.*/
+  test_set_step(3);
+  {
+    chRBRelease(rbp1);
+    chRBRelease(rbp2);
+    test_assert(rb_get_free() == RB_NUM, "buffers not returned to the pool");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t oslib_test_013_001 = {
+  "Buffers allocation and references",
+  oslib_test_013_001_setup,
+  NULL,
+  oslib_test_013_001_execute
+};
+
+/**
+ * @page oslib_test_013_002 [13.2] Payload manipulation
+ *
+ * <h2>Description</h2>
+ * Space is added and removed at both ends of the payload, headroom and
+ * tailroom are checked.
+ *
+ * <h2>Test Steps</h2>
+ * - [13.2.1] Allocating a buffer with headroom.
+ * - [13.2.2] Appending the payload.
+ * - [13.2.3] Prepending a header in the headroom.
+ * - [13.2.4] Removing the header and trimming the payload.
+ * .
+ */
+
+static void oslib_test_013_002_setup(void) {
+  rb_setup();
+}
+
+static void oslib_test_013_002_execute(void) {
+  refbuf_t *rbp;
+  uint8_t *p;
+
+  /* [13.2.1] Allocating a buffer with headroom.*/
+  test_set_step(1);
+  {
+    rbp = chRBAllocTimeout(&rbpool1, 8, TIME_IMMEDIATE);
+    test_assert(rbp != NULL, "allocation failed");
+    test_assert(chRBGetLengthX(rbp) == 0, "not empty");
+    test_assert(chRBGetHeadroomX(rbp) == 8, "wrong headroom");
+    test_assert(chRBGetTailroomX(rbp) == RB_SIZE - 8, "wrong tailroom");
+  }
+  test_end_step(1);
+
+  /* [13.2.2] Appending the payload.*/
+  test_set_step(2);
+  {
+    p = chRBPutTail(rbp, 4);
+    test_assert(p == chRBGetDataX(rbp), "wrong pointer");
+    memcpy(p, "DATA", 4);
+    test_assert(chRBGetLengthX(rbp) == 4, "wrong length");
+  }
+  test_end_step(2);
+
+  /* [13.2.3] Prepending a header in the headroom.*/
+  test_set_step(3);
+  {
+    p = chRBPushHead(rbp, 4);
+    test_assert(p == chRBGetDataX(rbp), "wrong pointer");
+    memcpy(p, "HEAD", 4);
+    test_assert(chRBGetHeadroomX(rbp) == 4, "wrong headroom");
+    test_assert(chRBGetLengthX(rbp) == 8, "wrong length");
+    test_assert(memcmp(chRBGetDataX(rbp), "HEADDATA", 8) == 0, "wrong payload");
+  }
+  test_end_step(3);
+
+  /* [13.2.4] Removing the header and trimming the payload.*/
+  test_set_step(4);
+  {
+    p = chRBPullHead(rbp, 4);
+    test_assert(memcmp(p, "DATA", 4) == 0, "wrong payload");
+    chRBTrimTail(rbp, 2);
+    test_assert(chRBGetLengthX(rbp) == 2, "wrong length");
+    test_assert(chRBGetTailroomX(rbp) == RB_SIZE - 10, "wrong tailroom");
+    chRBRelease(rbp);
+  }
+  test_end_step(4);
+}
+
+static const testcase_t oslib_test_013_002 = {
+  "Payload manipulation",
+  oslib_test_013_002_setup,
+  NULL,
+  oslib_test_013_002_execute
+};
+
+/**
+ * @page oslib_test_013_003 [13.3] Buffers chains
+ *
+ * <h2>Description</h2>
+ * Two buffers are chained, the chain is read linearly and released as a
+ * whole.
+ *
+ * <h2>Test Steps</h2>
+ * - [13.3.1] Allocating and filling two buffers then chaining them.
+ * - [13.3.2] Copying out data across the buffers boundary.
+ * - [13.3.3] Releasing the chain head, both buffers must return to the
+ *   pool.
+ * .
+ */
+
+static void oslib_test_013_003_setup(void) {
+  rb_setup();
+}
+
+static void oslib_test_013_003_execute(void) {
+  refbuf_t *rbp1, *rbp2;
+
+  /* [13.3.1] Allocating and filling two buffers then chaining them.*/
+  test_set_step(1);
+  {
+    rbp1 = chRBAllocTimeout(&rbpool1, 0, TIME_IMMEDIATE);
+    rbp2 = chRBAllocTimeout(&rbpool1, 0, TIME_IMMEDIATE);
+    test_assert((rbp1 != NULL) && (rbp2 != NULL), "allocation failed");
+    memcpy(chRBPutTail(rbp1, 5), "01234", 5);
+    memcpy(chRBPutTail(rbp2, 5), "56789", 5);
+    chRBChain(rbp1, rbp2);
+    test_assert(chRBGetNextX(rbp1) == rbp2, "not chained");
+    test_assert(chRBGetChainLength(rbp1) == 10, "wrong chain length");
+  }
+  test_end_step(1);
+
+  /* [13.3.2] Copying out data across the buffers boundary.*/
+  test_set_step(2);
+  {
+    uint8_t buf[8];
+
+    test_assert(chRBCopyOut(rbp1, 3, buf, sizeof (buf)) == 7, "wrong size");
+    test_assert(memcmp(buf, "3456789", 7) == 0, "wrong data");
+  }
+  test_end_step(2);
+
+  /* [13.3.3] Releasing the chain head, both buffers must return to the
+     pool.*/
+  test_set_step(3);
+  {
+    chRBRelease(rbp1);
+    test_assert(rb_get_free() == RB_NUM, "buffers not returned to the pool");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t oslib_test_013_003 = {
+  "Buffers chains",
+  oslib_test_013_003_setup,
+  NULL,
+  oslib_test_013_003_execute
+};
+
+/**
+ * @page oslib_test_013_004 [13.4] External memory
+ *
+ * <h2>Description</h2>
+ * A buffer wrapping external memory is allocated, the release callback
+ * must be invoked when the last reference is released.
+ *
+ * <h2>Test Steps</h2>
+ * - [13.4.1] Wrapping the external memory.
+ * - [13.4.2] Releasing the references, the callback must be invoked
+ *   once.
+ * .
+ */
+
+static void oslib_test_013_004_setup(void) {
+  rb_setup();
+}
+
+static void oslib_test_013_004_execute(void) {
+  refbuf_t *rbp;
+  static uint8_t ext[16];
+
+  /* [13.4.1] Wrapping the external memory.*/
+  test_set_step(1);
+  {
+    rbp = chRBWrapTimeout(&rbpool1, ext, sizeof (ext), rb_release,
+                          (void *)ext, TIME_IMMEDIATE);
+    test_assert(rbp != NULL, "allocation failed");
+    test_assert(chRBGetDataX(rbp) == (void *)ext, "wrong pointer");
+    test_assert(chRBGetLengthX(rbp) == sizeof (ext), "wrong length");
+    test_assert(chRBGetLinkX(rbp) == (void *)ext, "wrong link");
+  }
+  test_end_step(1);
+
+  /* [13.4.2] Releasing the references, the callback must be invoked
+     once.*/
+  test_set_step(2);
+  {
+    (void) chRBAddRef(rbp);
+    chRBRelease(rbp);
+    test_assert(rb_released == 0U, "released");
+    chRBRelease(rbp);
+    test_assert(rb_released == 1U, "not released");
+    test_assert(rb_get_free() == RB_NUM, "buffer not returned to the pool");
+  }
+  test_end_step(2);
+}
+
+static const testcase_t oslib_test_013_004 = {
+  "External memory",
+  oslib_test_013_004_setup,
+  NULL,
+  oslib_test_013_004_execute
+};
+
+#if (CH_CFG_USE_PIPES) || defined(__DOXYGEN__)
+/**
+ * @page oslib_test_013_005 [13.5] Buffers transfer through pipes
+ *
+ * <h2>Description</h2>
+ * Buffers are passed through a pipe without copying their contents.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_PIPES
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [13.5.1] Writing two buffers in the pipe, a third write must fail.
+ * - [13.5.2] Reading the buffers back, they must be the same in the
+ *   same order.
+ * .
+ */
+
+static void oslib_test_013_005_setup(void) {
+  rb_setup();
+}
+
+static void oslib_test_013_005_execute(void) {
+  refbuf_t *rbp1, *rbp2;
+  msg_t msg;
+  static uint8_t pipe_buffer[sizeof (refbuf_t *) * 2];
+  static PIPE_DECL(pipe1, pipe_buffer, sizeof (pipe_buffer));
+
+  /* [13.5.1] Writing two buffers in the pipe, a third write must fail.*/
+  test_set_step(1);
+  {
+    rbp1 = chRBAllocTimeout(&rbpool1, 0, TIME_IMMEDIATE);
+    rbp2 = chRBAllocTimeout(&rbpool1, 0, TIME_IMMEDIATE);
+    test_assert((rbp1 != NULL) && (rbp2 != NULL), "allocation failed");
+    msg = chRBPipeWriteTimeout(&pipe1, rbp1, TIME_IMMEDIATE);
+    test_assert(msg == MSG_OK, "write failed");
+    msg = chRBPipeWriteTimeout(&pipe1, rbp2, TIME_IMMEDIATE);
+    test_assert(msg == MSG_OK, "write failed");
+    msg = chRBPipeWriteTimeout(&pipe1, rbp2, TIME_IMMEDIATE);
+    test_assert(msg == MSG_TIMEOUT, "write not failed");
+  }
+  test_end_step(1);
+
+  /* [13.5.2] Reading the buffers back, they must be the same in the
+     same order.*/
+  test_set_step(2);
+  {
+    refbuf_t *rbp;
+
+    msg = chRBPipeReadTimeout(&pipe1, &rbp, TIME_IMMEDIATE);
+    test_assert((msg == MSG_OK) && (rbp == rbp1), "wrong buffer");
+    chRBRelease(rbp);
+    msg = chRBPipeReadTimeout(&pipe1, &rbp, TIME_IMMEDIATE);
+    test_assert((msg == MSG_OK) && (rbp == rbp2), "wrong buffer");
+    chRBRelease(rbp);
+    msg = chRBPipeReadTimeout(&pipe1, &rbp, TIME_IMMEDIATE);
+    test_assert(msg == MSG_TIMEOUT, "read not failed");
+    test_assert(rb_get_free() == RB_NUM, "buffers not returned to the pool");
+  }
+  test_end_step(2);
+}
+
+static const testcase_t oslib_test_013_005 = {
+  "Buffers transfer through pipes",
+  oslib_test_013_005_setup,
+  NULL,
+  oslib_test_013_005_execute
+};
+#endif /* CH_CFG_USE_PIPES */
+
+/****************************************************************************
+ * Exported data.
+ ****************************************************************************/
+
+/**
+ * @brief   Array of test cases.
+ */
+const testcase_t * const oslib_test_sequence_013_array[] = {
+  &oslib_test_013_001,
+  &oslib_test_013_002,
+  &oslib_test_013_003,
+  &oslib_test_013_004,
+#if (CH_CFG_USE_PIPES) || defined(__DOXYGEN__)
+  &oslib_test_013_005,
+#endif
+  NULL
+};
+
+/**
+ * @brief   Reference-counted Buffers.
+ */
+const testsequence_t oslib_test_sequence_013 = {
+  "Reference-counted Buffers",
+  oslib_test_sequence_013_array
+};
+
+#endif /* CH_CFG_USE_REF_BUFFERS */
@@ -0,0 +1,448 @@
+/*
+    ChibiOS - Copyright (C) 2006..2017 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+#include "oslib_test_root.h"
+
+/**
+ * @file    oslib_test_sequence_014.c
+ * @brief   Test Sequence 014 code.
+ *
+ * @page oslib_test_sequence_014 [14] Multiplexed Wait Extensions
+ *
+ * File: @ref oslib_test_sequence_014.c
+ *
+ * <h2>Description</h2>
+ * This sequence tests the ChibiOS library functionalities related to
+ * the multiplexed wait on mailboxes, pipes and objects FIFOs.
+ *
+ * <h2>Conditions</h2>
+ * This sequence is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_POLL
+ * .
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage oslib_test_014_001
+ * - @subpage oslib_test_014_002
+ * - @subpage oslib_test_014_003
+ * - @subpage oslib_test_014_004
+ * .
+ */
+
+#if (CH_CFG_USE_POLL) || defined(__DOXYGEN__)
+
+/****************************************************************************
+ * Shared code.
+ ****************************************************************************/
+
+#include <string.h>
+
+#define MB_SIZE 4
+#define PIPE_SIZE 16
+#define FIFO_SIZE 2
+
+#if CH_CFG_USE_MAILBOXES || defined(__DOXYGEN__)
+static msg_t mb_buffer[MB_SIZE];
+static mailbox_t mb1;
+static virtual_timer_t vt1;
+#endif
+#if CH_CFG_USE_PIPES || defined(__DOXYGEN__)
+static uint8_t pipe_buffer[PIPE_SIZE];
+static pipe_t pipe1;
+#endif
+#if CH_CFG_USE_OBJ_FIFOS || defined(__DOXYGEN__)
+static void *fifo_objects[FIFO_SIZE];
+static msg_t fifo_msgs[FIFO_SIZE];
+static objects_fifo_t fifo1;
+#endif
+static poll_set_t ps1;
+static poll_item_t pi1, pi2;
+
+#if CH_CFG_USE_MAILBOXES || defined(__DOXYGEN__)
+static void mb_post_cb(void *p) {
+
+  chSysLockFromISR();
+  (void) chMBPostI((mailbox_t *)p, (msg_t)0x55);
+  chSysUnlockFromISR();
+}
+#endif
+
+/****************************************************************************
+ * Test cases.
+ ****************************************************************************/
+
+#if (CH_CFG_USE_MAILBOXES) || defined(__DOXYGEN__)
+/**
+ * @page oslib_test_014_001 [14.1] Mailboxes polling
+ *
+ * <h2>Description</h2>
+ * A mailbox is added to a poll set in both directions, the readiness
+ * state of the items is tested while the mailbox is empty, full and
+ * reset.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_MAILBOXES
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [14.1.1] Testing the empty mailbox, only the output direction must
+ *   be ready.
+ * - [14.1.2] Filling the mailbox, only the input direction must be
+ *   ready.
+ * - [14.1.3] Resetting the mailbox, both directions must be ready.
+ * .
+ */
+
+static void oslib_test_014_001_setup(void) {
+  chMBObjectInit(&mb1, mb_buffer, MB_SIZE);
+  chPollObjectInit(&ps1);
+  chPollAddMailbox(&ps1, &pi1, &mb1, CH_POLL_IN);
+  chPollAddMailbox(&ps1, &pi2, &mb1, CH_POLL_OUT);
+}
+
+static void oslib_test_014_001_teardown(void) {
+  chPollRemove(&pi1);
+  chPollRemove(&pi2);
+  chMBReset(&mb1);
+}
+
+static void oslib_test_014_001_execute(void) {
+  cnt_t n;
+  unsigned i;
+
+  /* [14.1.1] Testing the empty mailbox, only the output direction must
+     be ready.*/
+  test_set_step(1);
+  {
+    n = chPollWaitTimeout(&ps1, TIME_IMMEDIATE);
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(!chPollIsReadyX(&pi1), "item ready");
+    test_assert(chPollIsReadyX(&pi2), "item not ready");
+  }
+  test_end_step(1);
+
+  /* [14.1.2] Filling the mailbox, only the input direction must be
+     ready.*/
+  test_set_step(2);
+  {
+    for (i = 0; i < MB_SIZE; i++) {
+      msg_t msg = chMBPostTimeout(&mb1, (msg_t)i, TIME_IMMEDIATE);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+    }
+    n = chPollWaitTimeout(&ps1, TIME_IMMEDIATE);
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(chPollIsReadyX(&pi1), "item not ready");
+    test_assert(!chPollIsReadyX(&pi2), "item ready");
+  }
+  test_end_step(2);
+
+  /* [14.1.3] Resetting the mailbox, both directions must be ready.*/
+  test_set_step(3);
+  {
+    chMBReset(&mb1);
+    n = chPollWaitTimeout(&ps1, TIME_IMMEDIATE);
+    test_assert(n == (cnt_t)2, "wrong ready items");
+    chMBResumeX(&mb1);
+  }
+  test_end_step(3);
+}
+
+static const testcase_t oslib_test_014_001 = {
+  "Mailboxes polling",
+  oslib_test_014_001_setup,
+  oslib_test_014_001_teardown,
+  oslib_test_014_001_execute
+};
+#endif /* CH_CFG_USE_MAILBOXES */
+
+#if (CH_CFG_USE_MAILBOXES) || defined(__DOXYGEN__)
+/**
+ * @page oslib_test_014_002 [14.2] Mailboxes polling wake-up
+ *
+ * <h2>Description</h2>
+ * A message is posted into a mailbox from a virtual timer callback
+ * while a thread is waiting on a poll set, the thread must be awakened.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_MAILBOXES
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [14.2.1] A message is posted after 10mS from a virtual timer
+ *   callback, the wait must be awakened with the item ready.
+ * .
+ */
+
+static void oslib_test_014_002_setup(void) {
+  chMBObjectInit(&mb1, mb_buffer, MB_SIZE);
+  chPollObjectInit(&ps1);
+  chPollAddMailbox(&ps1, &pi1, &mb1, CH_POLL_IN);
+}
+
+static void oslib_test_014_002_teardown(void) {
+  chPollRemove(&pi1);
+  chMBReset(&mb1);
+}
+
+static void oslib_test_014_002_execute(void) {
+  cnt_t n;
+
+  /* [14.2.1] A message is posted after 10mS from a virtual timer
+     callback, the wait must be awakened with the item ready.*/
+  test_set_step(1);
+  {
+    msg_t msg, msg1;
+
+    chVTSet(&vt1, TIME_MS2I(10), mb_post_cb, (void *)&mb1);
+    n = chPollWaitTimeout(&ps1, TIME_MS2I(500));
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(chPollIsReadyX(&pi1), "item not ready");
+    msg1 = chMBFetchTimeout(&mb1, &msg, TIME_IMMEDIATE);
+    test_assert(msg1 == MSG_OK, "wrong wake-up message");
+    test_assert(msg == (msg_t)0x55, "wrong message");
+  }
+  test_end_step(1);
+}
+
+static const testcase_t oslib_test_014_002 = {
+  "Mailboxes polling wake-up",
+  oslib_test_014_002_setup,
+  oslib_test_014_002_teardown,
+  oslib_test_014_002_execute
+};
+#endif /* CH_CFG_USE_MAILBOXES */
+
+#if (CH_CFG_USE_PIPES) || defined(__DOXYGEN__)
+/**
+ * @page oslib_test_014_003 [14.3] Pipes polling
+ *
+ * <h2>Description</h2>
+ * A pipe is added to a poll set in both directions, the readiness state
+ * of the items is tested while the pipe is empty and full.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_PIPES
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [14.3.1] Testing the empty pipe, only the output direction must be
+ *   ready.
+ * - [14.3.2] Filling the pipe, only the input direction must be ready.
+ * - [14.3.3] Emptying the pipe, only the output direction must be
+ *   ready.
+ * .
+ */
+
+static void oslib_test_014_003_setup(void) {
+  chPipeObjectInit(&pipe1, pipe_buffer, PIPE_SIZE);
+  chPollObjectInit(&ps1);
+  chPollAddPipe(&ps1, &pi1, &pipe1, CH_POLL_IN);
+  chPollAddPipe(&ps1, &pi2, &pipe1, CH_POLL_OUT);
+}
+
+static void oslib_test_014_003_teardown(void) {
+  chPollRemove(&pi1);
+  chPollRemove(&pi2);
+}
+
+static void oslib_test_014_003_execute(void) {
+  cnt_t n;
+  uint8_t buf[PIPE_SIZE];
+
+  /* [14.3.1] Testing the empty pipe, only the output direction must be
+     ready.*/
+  test_set_step(1);
+  {
+    n = chPollWaitTimeout(&ps1, TIME_IMMEDIATE);
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(!chPollIsReadyX(&pi1), "item ready");
+    test_assert(chPollIsReadyX(&pi2), "item not ready");
+  }
+  test_end_step(1);
+
+  /* [14.3.2] Filling the pipe, only the input direction must be ready.*/
+  test_set_step(2);
+  {
+    size_t sz;
+
+    memset(buf, 0x55, PIPE_SIZE);
+    sz = chPipeWriteTimeout(&pipe1, buf, PIPE_SIZE, TIME_IMMEDIATE);
+    test_assert(sz == PIPE_SIZE, "wrong size");
+    n = chPollWaitTimeout(&ps1, TIME_IMMEDIATE);
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(chPollIsReadyX(&pi1), "item not ready");
+    test_assert(!chPollIsReadyX(&pi2), "item ready");
+  }
+  test_end_step(2);
+
+  /* [14.3.3] Emptying the pipe, only the output direction must be
+     ready.*/
+  test_set_step(3);
+  {
+    size_t sz;
+
+    sz = chPipeReadTimeout(&pipe1, buf, PIPE_SIZE, TIME_IMMEDIATE);
+    test_assert(sz == PIPE_SIZE, "wrong size");
+    n = chPollWaitTimeout(&ps1, TIME_IMMEDIATE);
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(!chPollIsReadyX(&pi1), "item ready");
+    test_assert(chPollIsReadyX(&pi2), "item not ready");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t oslib_test_014_003 = {
+  "Pipes polling",
+  oslib_test_014_003_setup,
+  oslib_test_014_003_teardown,
+  oslib_test_014_003_execute
+};
+#endif /* CH_CFG_USE_PIPES */
+
+#if (CH_CFG_USE_OBJ_FIFOS) || defined(__DOXYGEN__)
+/**
+ * @page oslib_test_014_004 [14.4] Objects FIFOs polling
+ *
+ * <h2>Description</h2>
+ * An objects FIFO is added to a poll set in both directions, the
+ * readiness state of the items is tested while objects are taken and
+ * sent.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_OBJ_FIFOS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [14.4.1] Testing the initial state, only free objects must be
+ *   available.
+ * - [14.4.2] Taking and sending all the objects, only sent objects must
+ *   be available.
+ * - [14.4.3] Receiving and returning all the objects, only free objects
+ *   must be available.
+ * .
+ */
+
+static void oslib_test_014_004_setup(void) {
+  chFifoObjectInit(&fifo1, sizeof (void *), FIFO_SIZE,
+                   (void *)fifo_objects, fifo_msgs);
+  chPollObjectInit(&ps1);
+  chPollAddObjectsFifo(&ps1, &pi1, &fifo1, CH_POLL_IN);
+  chPollAddObjectsFifo(&ps1, &pi2, &fifo1, CH_POLL_OUT);
+}
+
+static void oslib_test_014_004_teardown(void) {
+  chPollRemove(&pi1);
+  chPollRemove(&pi2);
+}
+
+static void oslib_test_014_004_execute(void) {
+  cnt_t n;
+  unsigned i;
+
+  /* [14.4.1] Testing the initial state, only free objects must be
+     available.*/
+  test_set_step(1);
+  {
+    n = chPollWaitTimeout(&ps1, TIME_IMMEDIATE);
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(!chPollIsReadyX(&pi1), "item ready");
+    test_assert(chPollIsReadyX(&pi2), "item not ready");
+  }
+  test_end_step(1);
+
+  /* [14.4.2] Taking and sending all the objects, only sent objects must
+     be available.*/
+  test_set_step(2);
+  {
+    for (i = 0; i < FIFO_SIZE; i++) {
+      void *objp = chFifoTakeObjectTimeout(&fifo1, TIME_IMMEDIATE);
+      test_assert(objp != NULL, "allocation failed");
+      chFifoSendObject(&fifo1, (void *)objp);
+    }
+    n = chPollWaitTimeout(&ps1, TIME_IMMEDIATE);
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(chPollIsReadyX(&pi1), "item not ready");
+    test_assert(!chPollIsReadyX(&pi2), "item ready");
+  }
+  test_end_step(2);
+
+  /* [14.4.3] Receiving and returning all the objects, only free objects
+     must be available.*/
+  test_set_step(3);
+  {
+    for (i = 0; i < FIFO_SIZE; i++) {
+      void *objp;
+      msg_t msg = chFifoReceiveObjectTimeout(&fifo1, &objp, TIME_IMMEDIATE);
+      test_assert(msg == MSG_OK, "wrong wake-up message");
+      chFifoReturnObject(&fifo1, objp);
+    }
+    n = chPollWaitTimeout(&ps1, TIME_IMMEDIATE);
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(!chPollIsReadyX(&pi1), "item ready");
+    test_assert(chPollIsReadyX(&pi2), "item not ready");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t oslib_test_014_004 = {
+  "Objects FIFOs polling",
+  oslib_test_014_004_setup,
+  oslib_test_014_004_teardown,
+  oslib_test_014_004_execute
+};
+#endif /* CH_CFG_USE_OBJ_FIFOS */
+
+/****************************************************************************
+ * Exported data.
+ ****************************************************************************/
+
+/**
+ * @brief   Array of test cases.
+ */
+const testcase_t * const oslib_test_sequence_014_array[] = {
+#if (CH_CFG_USE_MAILBOXES) || defined(__DOXYGEN__)
+  &oslib_test_014_001,
+#endif
+#if (CH_CFG_USE_MAILBOXES) || defined(__DOXYGEN__)
+  &oslib_test_014_002,
+#endif
+#if (CH_CFG_USE_PIPES) || defined(__DOXYGEN__)
+  &oslib_test_014_003,
+#endif
+#if (CH_CFG_USE_OBJ_FIFOS) || defined(__DOXYGEN__)
+  &oslib_test_014_004,
+#endif
+  NULL
+};
+
+/**
+ * @brief   Multiplexed Wait Extensions.
+ */
+const testsequence_t oslib_test_sequence_014 = {
+  "Multiplexed Wait Extensions",
+  oslib_test_sequence_014_array
+};
+
+#endif /* CH_CFG_USE_POLL */
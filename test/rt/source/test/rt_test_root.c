@@ -32,6 +32,9 @@
  * - @subpage rt_test_sequence_009
  * - @subpage rt_test_sequence_010
  * - @subpage rt_test_sequence_011
+ * - @subpage rt_test_sequence_012
+ * - @subpage rt_test_sequence_013
+ * - @subpage rt_test_sequence_014
  * .
  */
 
@@ -74,6 +77,15 @@ const testsequence_t * const rt_test_suite_array[] = {
   &rt_test_sequence_010,
 #endif
   &rt_test_sequence_011,
+#if (CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+  &rt_test_sequence_012,
+#endif
+#if (CH_CFG_USE_POLL) || defined(__DOXYGEN__)
+  &rt_test_sequence_013,
+#endif
+#if (CH_CFG_USE_IRQ_THREADS) || defined(__DOXYGEN__)
+  &rt_test_sequence_014,
+#endif
   NULL
 };
 
@@ -34,6 +34,10 @@
  * - @subpage rt_test_004_002
  * - @subpage rt_test_004_003
  * - @subpage rt_test_004_004
+ * - @subpage rt_test_004_005
+ * - @subpage rt_test_004_006
+ * - @subpage rt_test_004_007
+ * - @subpage rt_test_004_008
  * .
  */
 
@@ -46,6 +50,91 @@ static THD_FUNCTION(thread, p) {
   test_emit_token(*(char *)p);
 }
 
+static threads_queue_t tq1;
+
+static THD_FUNCTION(thread_queued, p) {
+
+  chSysLock();
+  (void) chThdEnqueueTimeoutS(&tq1, TIME_INFINITE);
+  chSysUnlock();
+  test_emit_token(*(char *)p);
+}
+
+#if CH_CFG_USE_EDF || defined(__DOXYGEN__)
+typedef struct {
+  sysinterval_t     period;
+  unsigned          overrun;
+} edf_task_t;
+
+static systime_t edf_release;
+
+static THD_FUNCTION(edf_thread, p) {
+  char token = *(char *)p;
+
+  /* Earlier tokens have earlier deadlines.*/
+  chThdSetDeadline(chTimeAddX(edf_release,
+                              TIME_MS2I(100) + (sysinterval_t)(token - 'A')));
+  chThdSleepUntil(edf_release);
+  test_emit_token(token);
+}
+
+static THD_FUNCTION(edf_periodic, p) {
+  const edf_task_t *tsp = (const edf_task_t *)p;
+  systime_t prev = chVTGetSystemTimeX();
+  unsigned i;
+
+  for (i = 1U; i <= 4U; i++) {
+    /* The specified activation overruns its period.*/
+    if (i == tsp->overrun) {
+      chThdSleep(tsp->period + (tsp->period / 2U));
+    }
+    prev = chThdSleepUntilWindowed(prev, chTimeAddX(prev, tsp->period));
+  }
+}
+#endif /* CH_CFG_USE_EDF */
+
+#if CH_CFG_USE_PERIODIC || defined(__DOXYGEN__)
+static unsigned periodic_misses, periodic_overruns;
+
+static void periodic_miss(thread_t *tp, sysinterval_t response) {
+
+  (void)tp;
+  (void)response;
+  periodic_misses++;
+}
+
+static void periodic_busy(sysinterval_t interval) {
+  systime_t start = chVTGetSystemTimeX();
+
+  while (chVTIsSystemTimeWithinX(start, chTimeAddX(start, interval))) {
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  }
+}
+
+static THD_FUNCTION(periodic_thread, p) {
+  unsigned i;
+
+  (void)p;
+
+  chThdSetPeriodic(TIME_MS2I(10), TIME_MS2I(5), TIME_MS2I(5), periodic_miss);
+  for (i = 1U; i <= 5U; i++) {
+    /* The second activation keeps the CPU past its deadline, the fourth
+       activation for more than three periods.*/
+    if (i == 2U) {
+      periodic_busy(TIME_MS2I(7));
+    }
+    if (i == 4U) {
+      periodic_busy(TIME_MS2I(35));
+    }
+    if (chThdWaitNextPeriod()) {
+      periodic_overruns++;
+    }
+  }
+}
+#endif /* CH_CFG_USE_PERIODIC */
+
 /****************************************************************************
  * Test cases.
  ****************************************************************************/
@@ -339,6 +428,276 @@ static const testcase_t rt_test_004_004 = {
 };
 #endif /* CH_CFG_USE_MUTEXES */
 
+#if (CH_CFG_USE_EDF) || defined(__DOXYGEN__)
+/**
+ * @page rt_test_004_005 [4.5] Ready List functionality, deadlines order
+ *
+ * <h2>Description</h2>
+ * Five threads in the EDF band are released at the same time, the test
+ * expects the threads to perform their operations in deadline order
+ * regardless of the creation order.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_EDF
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [4.5.1] Raising the test thread priority above the EDF band and
+ *   setting a release time in the near future.
+ * - [4.5.2] Creating 5 threads in the EDF band in pseudo-random
+ *   deadline order, each thread sets its deadline and sleeps until the
+ *   release time.
+ * - [4.5.3] Waiting for the threads, execution sequence is tested.
+ * - [4.5.4] Restoring the test thread priority.
+ * .
+ */
+
+static void rt_test_004_005_execute(void) {
+  tprio_t prio;
+
+  /* [4.5.1] Raising the test thread priority above the EDF band and
+     setting a release time in the near future.*/
+  test_set_step(1);
+  {
+    prio = chThdSetPriority(CH_CFG_EDF_PRIORITY + 1);
+    edf_release = chTimeAddX(chVTGetSystemTimeX(), TIME_MS2I(50));
+  }
+  test_end_step(1);
+
+  /* [4.5.2] Creating 5 threads in the EDF band in pseudo-random
+     deadline order, each thread sets its deadline and sleeps until the
+     release time.*/
+  test_set_step(2);
+  {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, CH_CFG_EDF_PRIORITY, edf_thread, "D");
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, CH_CFG_EDF_PRIORITY, edf_thread, "E");
+    threads[2] = chThdCreateStatic(wa[2], WA_SIZE, CH_CFG_EDF_PRIORITY, edf_thread, "A");
+    threads[3] = chThdCreateStatic(wa[3], WA_SIZE, CH_CFG_EDF_PRIORITY, edf_thread, "C");
+    threads[4] = chThdCreateStatic(wa[4], WA_SIZE, CH_CFG_EDF_PRIORITY, edf_thread, "B");
+  }
+  test_end_step(2);
+
+  /* [4.5.3] Waiting for the threads, execution sequence is tested.*/
+  test_set_step(3);
+  {
+    test_wait_threads();
+    test_assert_sequence("ABCDE", "invalid sequence");
+  }
+  test_end_step(3);
+
+  /* [4.5.4] Restoring the test thread priority.*/
+  test_set_step(4);
+  {
+    (void) chThdSetPriority(prio);
+  }
+  test_end_step(4);
+}
+
+static const testcase_t rt_test_004_005 = {
+  "Ready List functionality, deadlines order",
+  NULL,
+  NULL,
+  rt_test_004_005_execute
+};
+#endif /* CH_CFG_USE_EDF */
+
+#if (CH_CFG_USE_EDF) || defined(__DOXYGEN__)
+/**
+ * @page rt_test_004_006 [4.6] Periodic threads deadlines
+ *
+ * <h2>Description</h2>
+ * A synthetic set of periodic threads is executed in the EDF band using
+ * chThdSleepUntilWindowed(), the deadline misses counter of each thread
+ * is verified.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_EDF
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [4.6.1] Two periodic threads with periods of 10 and 15 milliseconds
+ *   are executed for four periods, no deadline misses are expected.
+ * - [4.6.2] A periodic thread overrunning its second period is
+ *   executed, one deadline miss is expected.
+ * .
+ */
+
+static void rt_test_004_006_execute(void) {
+  static const edf_task_t tasks[3] = {
+    {TIME_MS2I(10), 0U},
+    {TIME_MS2I(15), 0U},
+    {TIME_MS2I(10), 2U}
+  };
+  thread_t *tp1, *tp2;
+
+  /* [4.6.1] Two periodic threads with periods of 10 and 15 milliseconds
+     are executed for four periods, no deadline misses are expected.*/
+  test_set_step(1);
+  {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, CH_CFG_EDF_PRIORITY,
+                                   edf_periodic, (void *)&tasks[0]);
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, CH_CFG_EDF_PRIORITY,
+                                   edf_periodic, (void *)&tasks[1]);
+    tp1 = threads[0];
+    tp2 = threads[1];
+    test_wait_threads();
+    test_assert(chThdGetDeadlineMissesX(tp1) == (ucnt_t)0, "deadline missed");
+    test_assert(chThdGetDeadlineMissesX(tp2) == (ucnt_t)0, "deadline missed");
+  }
+  test_end_step(1);
+
+  /* [4.6.2] A periodic thread overrunning its second period is
+     executed, one deadline miss is expected.*/
+  test_set_step(2);
+  {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, CH_CFG_EDF_PRIORITY,
+                                   edf_periodic, (void *)&tasks[2]);
+    tp1 = threads[0];
+    test_wait_threads();
+    test_assert(chThdGetDeadlineMissesX(tp1) == (ucnt_t)1, "wrong misses count");
+  }
+  test_end_step(2);
+}
+
+static const testcase_t rt_test_004_006 = {
+  "Periodic threads deadlines",
+  NULL,
+  NULL,
+  rt_test_004_006_execute
+};
+#endif /* CH_CFG_USE_EDF */
+
+#if (CH_CFG_USE_PERIODIC) || defined(__DOXYGEN__)
+/**
+ * @page rt_test_004_007 [4.7] Periodic threads API
+ *
+ * <h2>Description</h2>
+ * A periodic thread with a relative deadline shorter than its period is
+ * executed for five activations, one activation keeps the CPU past its
+ * deadline and another one for several periods. The statistics gathered
+ * by the kernel are verified, host delays can only add misses and
+ * overruns so minimum counts are checked.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_PERIODIC
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [4.7.1] Starting the periodic thread and waiting for its
+ *   termination.
+ * - [4.7.2] Verifying the activations, misses and overruns counters.
+ * - [4.7.3] Verifying the response time statistics.
+ * .
+ */
+
+static void rt_test_004_007_execute(void) {
+  const thread_periodic_t *pp;
+
+  /* [4.7.1] Starting the periodic thread and waiting for its
+     termination.*/
+  test_set_step(1);
+  {
+    periodic_misses = 0U;
+    periodic_overruns = 0U;
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() - 1,
+                                   periodic_thread, NULL);
+    pp = chThdGetPeriodicX(threads[0]);
+    test_wait_threads();
+  }
+  test_end_step(1);
+
+  /* [4.7.2] Verifying the activations, misses and overruns counters.*/
+  test_set_step(2);
+  {
+    test_assert(pp->n == (ucnt_t)5, "wrong activations count");
+    test_assert(pp->misses >= (ucnt_t)2, "wrong misses count");
+    test_assert(pp->overruns >= (ucnt_t)1, "wrong overruns count");
+    test_assert(pp->overruns <= pp->misses, "overrun not counted as miss");
+    test_assert(periodic_misses == (unsigned)pp->misses, "callback not invoked");
+    test_assert(periodic_overruns == (unsigned)pp->overruns, "overrun not reported");
+  }
+  test_end_step(2);
+
+  /* [4.7.3] Verifying the response time statistics.*/
+  test_set_step(3);
+  {
+    test_assert(pp->rbest <= pp->rworst, "invalid response times");
+    test_assert(pp->rworst >= TIME_MS2I(35), "wrong worst response time");
+    test_assert(pp->rcumulative >= (rttime_t)pp->rworst, "wrong cumulative time");
+    test_assert(pp->lbest <= pp->lworst, "invalid latencies");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t rt_test_004_007 = {
+  "Periodic threads API",
+  NULL,
+  NULL,
+  rt_test_004_007_execute
+};
+#endif /* CH_CFG_USE_PERIODIC */
+
+/**
+ * @page rt_test_004_008 [4.8] Ready List functionality, batch insertion
+ *
+ * <h2>Description</h2>
+ * Five threads with mixed priorities wait on a threads queue, all of
+ * them are made ready at once, the test expects the threads to perform
+ * their operations in priority order and in queue order among equal
+ * priorities.
+ *
+ * <h2>Test Steps</h2>
+ * - [4.8.1] Creating 5 threads with priorities greater than the test
+ *   thread, each thread enqueues itself on the threads queue.
+ * - [4.8.2] Dequeuing all the threads at once, the execution sequence
+ *   is tested.
+ * .
+ */
+
+static void rt_test_004_008_execute(void) {
+  tprio_t prio;
+
+  /* [4.8.1] Creating 5 threads with priorities greater than the test
+     thread, each thread enqueues itself on the threads queue.*/
+  test_set_step(1);
+  {
+    prio = chThdGetPriorityX();
+    chThdQueueObjectInit(&tq1);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+2, thread_queued, "D");
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+4, thread_queued, "A");
+    threads[2] = chThdCreateStatic(wa[2], WA_SIZE, prio+1, thread_queued, "E");
+    threads[3] = chThdCreateStatic(wa[3], WA_SIZE, prio+3, thread_queued, "B");
+    threads[4] = chThdCreateStatic(wa[4], WA_SIZE, prio+3, thread_queued, "C");
+  }
+  test_end_step(1);
+
+  /* [4.8.2] Dequeuing all the threads at once, the execution sequence
+     is tested.*/
+  test_set_step(2);
+  {
+    chSysLock();
+    chThdDequeueAllI(&tq1, MSG_OK);
+    chSchRescheduleS();
+    chSysUnlock();
+    test_wait_threads();
+    test_assert_sequence("ABCDE", "invalid sequence");
+  }
+  test_end_step(2);
+}
+
+static const testcase_t rt_test_004_008 = {
+  "Ready List functionality, batch insertion",
+  NULL,
+  NULL,
+  rt_test_004_008_execute
+};
+
 /****************************************************************************
  * Exported data.
  ****************************************************************************/
@@ -353,6 +712,16 @@ const testcase_t * const rt_test_sequence_004_array[] = {
 #if (CH_CFG_USE_MUTEXES) || defined(__DOXYGEN__)
   &rt_test_004_004,
 #endif
+#if (CH_CFG_USE_EDF) || defined(__DOXYGEN__)
+  &rt_test_004_005,
+#endif
+#if (CH_CFG_USE_EDF) || defined(__DOXYGEN__)
+  &rt_test_004_006,
+#endif
+#if (CH_CFG_USE_PERIODIC) || defined(__DOXYGEN__)
+  &rt_test_004_007,
+#endif
+  &rt_test_004_008,
   NULL
 };
 
@@ -45,6 +45,7 @@
  * - @subpage rt_test_007_007
  * - @subpage rt_test_007_008
  * - @subpage rt_test_007_009
+ * - @subpage rt_test_007_010
  * .
  */
 
@@ -1078,6 +1079,121 @@ static const testcase_t rt_test_007_009 = {
 };
 #endif /* CH_CFG_USE_CONDVARS */
 
+#if (CH_CFG_USE_MUTEXES_CEILING) || defined(__DOXYGEN__)
+/**
+ * @page rt_test_007_010 [7.10] Priority ceiling protocol
+ *
+ * <h2>Description</h2>
+ * A mutex is initialized with a ceiling priority, the test verifies
+ * that the owner runs at the ceiling priority while holding the mutex
+ * and that the threads using the mutex cannot preempt the owner. The
+ * priority is verified to return to the base priority on unlock, also
+ * when the ceiling mutex is nested inside a priority inheritance mutex.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_MUTEXES_CEILING
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [7.10.1] Reading current base priority.
+ * - [7.10.2] Locking the ceiling mutex, the priority is raised to the
+ *   ceiling P(+2).
+ * - [7.10.3] Two threads are created at priorities P(+1) and P(+2),
+ *   both threads try to lock the mutex but they cannot preempt the
+ *   owner.
+ * - [7.10.4] Unlocking the mutex, the priority returns to the base
+ *   priority and the threads lock the mutex in priority order.
+ * - [7.10.5] Locking the ceiling mutex using chMtxTryLock(), the
+ *   priority is raised to the ceiling.
+ * - [7.10.6] Nesting the ceiling mutex inside a priority inheritance
+ *   mutex, the priority is raised and restored only by the ceiling
+ *   mutex.
+ * .
+ */
+
+static void rt_test_007_010_setup(void) {
+  chMtxObjectInitCeiling(&m1, chThdGetPriorityX() + 2);
+  chMtxObjectInit(&m2);
+}
+
+static void rt_test_007_010_execute(void) {
+  tprio_t prio;
+
+  /* [7.10.1] Reading current base priority.*/
+  test_set_step(1);
+  {
+    prio = chThdGetPriorityX();
+  }
+  test_end_step(1);
+
+  /* [7.10.2] Locking the ceiling mutex, the priority is raised to the
+     ceiling P(+2).*/
+  test_set_step(2);
+  {
+    chMtxLock(&m1);
+    test_assert(chThdGetPriorityX() == prio + 2, "not at ceiling");
+  }
+  test_end_step(2);
+
+  /* [7.10.3] Two threads are created at priorities P(+1) and P(+2),
+     both threads try to lock the mutex but they cannot preempt the
+     owner.*/
+  test_set_step(3);
+  {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread1, "B");
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+2, thread1, "A");
+    test_assert_sequence("", "owner preempted");
+  }
+  test_end_step(3);
+
+  /* [7.10.4] Unlocking the mutex, the priority returns to the base
+     priority and the threads lock the mutex in priority order.*/
+  test_set_step(4);
+  {
+    chMtxUnlock(&m1);
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+    test_wait_threads();
+    test_assert_sequence("AB", "invalid sequence");
+  }
+  test_end_step(4);
+
+  /* [7.10.5] Locking the ceiling mutex using chMtxTryLock(), the
+     priority is raised to the ceiling.*/
+  test_set_step(5);
+  {
+    test_assert(chMtxTryLock(&m1), "not locked");
+    test_assert(chThdGetPriorityX() == prio + 2, "not at ceiling");
+    chMtxUnlock(&m1);
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+  }
+  test_end_step(5);
+
+  /* [7.10.6] Nesting the ceiling mutex inside a priority inheritance
+     mutex, the priority is raised and restored only by the ceiling
+     mutex.*/
+  test_set_step(6);
+  {
+    chMtxLock(&m2);
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+    chMtxLock(&m1);
+    test_assert(chThdGetPriorityX() == prio + 2, "not at ceiling");
+    chMtxUnlock(&m1);
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+    chMtxUnlock(&m2);
+  }
+  test_end_step(6);
+}
+
+static const testcase_t rt_test_007_010 = {
+  "Priority ceiling protocol",
+  rt_test_007_010_setup,
+  NULL,
+  rt_test_007_010_execute
+};
+#endif /* CH_CFG_USE_MUTEXES_CEILING */
+
 /****************************************************************************
  * Exported data.
  ****************************************************************************/
@@ -1108,6 +1224,9 @@ const testcase_t * const rt_test_sequence_007_array[] = {
 #endif
 #if (CH_CFG_USE_CONDVARS) || defined(__DOXYGEN__)
   &rt_test_007_009,
+#endif
+#if (CH_CFG_USE_MUTEXES_CEILING) || defined(__DOXYGEN__)
+  &rt_test_007_010,
 #endif
   NULL
 };
@@ -37,6 +37,9 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage rt_test_008_001
+ * - @subpage rt_test_008_002
+ * - @subpage rt_test_008_003
+ * - @subpage rt_test_008_004
  * .
  */
 
@@ -54,6 +57,64 @@ static THD_FUNCTION(msg_thread1, p) {
   chMsgSend(p, 'D');
 }
 
+#if CH_CFG_USE_MESSAGE_PORTS || defined(__DOXYGEN__)
+static MSG_PORT_DECL(port1, "port1");
+static MSG_PORT_DECL(port2, "port2");
+static sysinterval_t port_timeout;
+static msg_t port_result;
+
+static THD_FUNCTION(port_server, p) {
+  msg_desc_t *mdp;
+
+  (void)p;
+
+  chMsgPortRegister(&port1);
+  chMsgPortRegister(&port2);
+  while (true) {
+    uint8_t *bp;
+    size_t i;
+
+    mdp = chMsgReceiveTimeout(NULL, TIME_INFINITE);
+    bp = chMsgDescGetPayloadX(mdp);
+    if (bp == NULL) {
+      chMsgReply(mdp, MSG_OK);
+      break;
+    }
+
+    /* Payload modified in place.*/
+    for (i = 0U; i < chMsgDescGetSizeX(mdp); i++) {
+      bp[i]++;
+    }
+    chMsgReply(mdp, (msg_t)chMsgDescGetSizeX(mdp));
+  }
+  chMsgPortUnregister(&port2);
+  chMsgPortUnregister(&port1);
+}
+
+static THD_FUNCTION(port_sender, p) {
+  msg_desc_t md;
+
+  (void)p;
+
+  chMsgDescObjectInit(&md, NULL, 0U);
+  port_result = chMsgSendTimeout(&port1, &md, port_timeout);
+}
+
+static THD_FUNCTION(port_withdrawer, p) {
+  msg_desc_t md;
+
+  (void)p;
+
+  /* First message withdrawn right after waking up the receiver.*/
+  chThdSleepMilliseconds(10);
+  chMsgDescObjectInit(&md, NULL, 0U);
+  port_result = chMsgSendTimeout(&port1, &md, TIME_IMMEDIATE);
+  chThdSleepMilliseconds(10);
+  chMsgDescObjectInit(&md, NULL, 0U);
+  (void) chMsgSendTimeout(&port1, &md, TIME_INFINITE);
+}
+#endif /* CH_CFG_USE_MESSAGE_PORTS */
+
 /****************************************************************************
  * Test cases.
  ****************************************************************************/
@@ -109,6 +170,291 @@ static const testcase_t rt_test_008_001 = {
   rt_test_008_001_execute
 };
 
+#if (CH_CFG_USE_MESSAGE_PORTS) || defined(__DOXYGEN__)
+/**
+ * @page rt_test_008_002 [8.2] Message ports, synchronous send
+ *
+ * <h2>Description</h2>
+ * A server thread registers two named ports and serves both of them,
+ * the tester thread finds the ports by name and sends messages to both,
+ * the test expects the payloads to be modified in place and the replies
+ * to be received.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_MESSAGE_PORTS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [8.2.1] Starting the server thread and finding its ports by name.
+ * - [8.2.2] Sending a message to each port, the payload and the replies
+ *   are tested.
+ * - [8.2.3] Stopping the server, the ports are expected to be
+ *   unregistered.
+ * .
+ */
+
+static void rt_test_008_002_execute(void) {
+  msg_desc_t md;
+  uint8_t buf[4];
+  msg_t msg;
+
+  /* [8.2.1] Starting the server thread and finding its ports by name.*/
+  test_set_step(1);
+  {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                   port_server, NULL);
+    test_assert(chMsgPortFind("port1") == &port1, "port1 not found");
+    test_assert(chMsgPortFind("port2") == &port2, "port2 not found");
+    test_assert(chMsgPortFind("port3") == NULL, "unexpected port");
+  }
+  test_end_step(1);
+
+  /* [8.2.2] Sending a message to each port, the payload and the replies
+     are tested.*/
+  test_set_step(2);
+  {
+    buf[0] = 'A';
+    buf[1] = 'B';
+    buf[2] = 'C';
+    buf[3] = 'D';
+    chMsgDescObjectInit(&md, buf, 2U);
+    msg = chMsgSendTimeout(&port1, &md, TIME_INFINITE);
+    test_assert(msg == (msg_t)2, "wrong reply");
+    test_assert(chMsgIsDoneX(&md), "not done");
+    chMsgDescObjectInit(&md, &buf[1], 3U);
+    msg = chMsgSendTimeout(chMsgPortFind("port2"), &md, TIME_INFINITE);
+    test_assert(msg == (msg_t)3, "wrong reply");
+    test_assert((buf[0] == 'B') && (buf[1] == 'D') &&
+                (buf[2] == 'D') && (buf[3] == 'E'), "payload not modified");
+  }
+  test_end_step(2);
+
+  /* [8.2.3] Stopping the server, the ports are expected to be
+     unregistered.*/
+  test_set_step(3);
+  {
+    chMsgDescObjectInit(&md, NULL, 0U);
+    msg = chMsgSendTimeout(&port2, &md, TIME_INFINITE);
+    test_assert(msg == MSG_OK, "wrong reply");
+    test_wait_threads();
+    test_assert(chMsgPortFind("port1") == NULL, "port1 still registered");
+    test_assert(chMsgPortFind("port2") == NULL, "port2 still registered");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t rt_test_008_002 = {
+  "Message ports, synchronous send",
+  NULL,
+  NULL,
+  rt_test_008_002_execute
+};
+#endif /* CH_CFG_USE_MESSAGE_PORTS */
+
+#if (CH_CFG_USE_MESSAGE_PORTS) || defined(__DOXYGEN__)
+/**
+ * @page rt_test_008_003 [8.3] Message ports, asynchronous posting
+ *
+ * <h2>Description</h2>
+ * The tester thread registers a port and posts four messages with
+ * different priorities to it, the test expects the messages to be
+ * received in priority order and in FIFO order among equal priorities,
+ * the replies are then collected.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_MESSAGE_PORTS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [8.3.1] Registering the port and posting four messages.
+ * - [8.3.2] Receiving and replying to all messages, the receive order
+ *   is tested.
+ * - [8.3.3] Collecting the replies then unregistering the port.
+ * .
+ */
+
+static void rt_test_008_003_execute(void) {
+  msg_desc_t md[4];
+  msg_desc_t *mdp;
+  char tokens[4] = {'A', 'B', 'C', 'D'};
+  unsigned i;
+
+  /* [8.3.1] Registering the port and posting four messages.*/
+  test_set_step(1);
+  {
+    chMsgPortRegister(&port1);
+    for (i = 0U; i < 4U; i++) {
+      chMsgDescObjectInit(&md[i], &tokens[i], 1U);
+    }
+    chMsgPost(&port1, &md[0], LOWPRIO);
+    chMsgPost(&port1, &md[1], HIGHPRIO);
+    chMsgPost(&port1, &md[2], NORMALPRIO);
+    chMsgPost(&port1, &md[3], HIGHPRIO);
+    test_assert(!chMsgIsDoneX(&md[0]), "already done");
+    test_assert(chMsgCollectTimeout(&md[0], TIME_IMMEDIATE) == MSG_TIMEOUT,
+                "not timed out");
+  }
+  test_end_step(1);
+
+  /* [8.3.2] Receiving and replying to all messages, the receive order
+     is tested.*/
+  test_set_step(2);
+  {
+    while ((mdp = chMsgReceiveTimeout(&port1, TIME_IMMEDIATE)) != NULL) {
+      test_emit_token(*(char *)chMsgDescGetPayloadX(mdp));
+      chMsgReply(mdp, (msg_t)chMsgDescGetPrioX(mdp));
+    }
+    test_assert_sequence("BDCA", "invalid sequence");
+  }
+  test_end_step(2);
+
+  /* [8.3.3] Collecting the replies then unregistering the port.*/
+  test_set_step(3);
+  {
+    test_assert(chMsgCollectTimeout(&md[0], TIME_INFINITE) == (msg_t)LOWPRIO,
+                "wrong reply");
+    test_assert(chMsgCollectTimeout(&md[1], TIME_INFINITE) == (msg_t)HIGHPRIO,
+                "wrong reply");
+    test_assert(chMsgCollectTimeout(&md[2], TIME_INFINITE) == (msg_t)NORMALPRIO,
+                "wrong reply");
+    test_assert(chMsgCollectTimeout(&md[3], TIME_INFINITE) == (msg_t)HIGHPRIO,
+                "wrong reply");
+    chMsgPortUnregister(&port1);
+  }
+  test_end_step(3);
+}
+
+static const testcase_t rt_test_008_003 = {
+  "Message ports, asynchronous posting",
+  NULL,
+  NULL,
+  rt_test_008_003_execute
+};
+#endif /* CH_CFG_USE_MESSAGE_PORTS */
+
+#if (CH_CFG_USE_MESSAGE_PORTS) || defined(__DOXYGEN__)
+/**
+ * @page rt_test_008_004 [8.4] Message ports, timeouts and reset
+ *
+ * <h2>Description</h2>
+ * The tester thread registers a port but does not receive from it, a
+ * sender thread is expected to time out and its message to be
+ * withdrawn. A second sender waits without timeout and is expected to
+ * be released with MSG_RESET when the port is unregistered. Messages
+ * sent to an unregistered port are expected to be reset immediately
+ * and a withdrawn message is not expected to shorten a receive
+ * timeout.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_MESSAGE_PORTS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [8.4.1] Registering the port, a receive with timeout is expected to
+ *   fail.
+ * - [8.4.2] Starting a sender with a timeout, the message is expected
+ *   to be withdrawn.
+ * - [8.4.3] Starting a sender without timeout then unregistering the
+ *   port.
+ * - [8.4.4] Sending to the unregistered port, the message is expected
+ *   to be reset immediately.
+ * - [8.4.5] Receiving with a timeout while a sender withdraws its
+ *   message, the receiver is expected to wait for the remaining time
+ *   and get the next message.
+ * .
+ */
+
+static void rt_test_008_004_execute(void) {
+  msg_desc_t *mdp;
+  bool b;
+
+  /* [8.4.1] Registering the port, a receive with timeout is expected to
+     fail.*/
+  test_set_step(1);
+  {
+    chMsgPortRegister(&port1);
+    test_assert(chMsgReceiveTimeout(&port1, TIME_MS2I(10)) == NULL,
+                "unexpected message");
+  }
+  test_end_step(1);
+
+  /* [8.4.2] Starting a sender with a timeout, the message is expected
+     to be withdrawn.*/
+  test_set_step(2);
+  {
+    port_timeout = TIME_MS2I(10);
+    port_result = MSG_OK;
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                   port_sender, NULL);
+    test_wait_threads();
+    test_assert(port_result == MSG_TIMEOUT, "not timed out");
+    chSysLock();
+    b = chMsgPortIsPendingI(&port1);
+    chSysUnlock();
+    test_assert(!b, "message not withdrawn");
+  }
+  test_end_step(2);
+
+  /* [8.4.3] Starting a sender without timeout then unregistering the
+     port.*/
+  test_set_step(3);
+  {
+    port_timeout = TIME_INFINITE;
+    port_result = MSG_OK;
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                   port_sender, NULL);
+    chMsgPortUnregister(&port1);
+    test_wait_threads();
+    test_assert(port_result == MSG_RESET, "not reset");
+  }
+  test_end_step(3);
+
+  /* [8.4.4] Sending to the unregistered port, the message is expected
+     to be reset immediately.*/
+  test_set_step(4);
+  {
+    port_timeout = TIME_INFINITE;
+    port_result = MSG_OK;
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                   port_sender, NULL);
+    test_wait_threads();
+    test_assert(port_result == MSG_RESET, "not reset");
+  }
+  test_end_step(4);
+
+  /* [8.4.5] Receiving with a timeout while a sender withdraws its
+     message, the receiver is expected to wait for the remaining time
+     and get the next message.*/
+  test_set_step(5);
+  {
+    chMsgPortRegister(&port1);
+    port_result = MSG_OK;
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                   port_withdrawer, NULL);
+    mdp = chMsgReceiveTimeout(&port1, TIME_MS2I(100));
+    test_assert(mdp != NULL, "premature timeout");
+    chMsgReply(mdp, MSG_OK);
+    test_wait_threads();
+    test_assert(port_result == MSG_TIMEOUT, "not withdrawn");
+    chMsgPortUnregister(&port1);
+  }
+  test_end_step(5);
+}
+
+static const testcase_t rt_test_008_004 = {
+  "Message ports, timeouts and reset",
+  NULL,
+  NULL,
+  rt_test_008_004_execute
+};
+#endif /* CH_CFG_USE_MESSAGE_PORTS */
+
 /****************************************************************************
  * Exported data.
  ****************************************************************************/
@@ -118,6 +464,11 @@ static const testcase_t rt_test_008_001 = {
  */
 const testcase_t * const rt_test_sequence_008_array[] = {
   &rt_test_008_001,
+#if (CH_CFG_USE_MESSAGE_PORTS) || defined(__DOXYGEN__)
+  &rt_test_008_002,
+  &rt_test_008_003,
+  &rt_test_008_004,
+#endif
   NULL
 };
 
@@ -46,6 +46,7 @@
  * - @subpage rt_test_011_010
  * - @subpage rt_test_011_011
  * - @subpage rt_test_011_012
+ * - @subpage rt_test_011_013
  * .
  */
 
@@ -134,6 +135,22 @@ static THD_FUNCTION(bmk_thread8, p) {
   } while(!chThdShouldTerminateX());
 }
 
+#if (CH_CFG_USE_CONDVARS && CH_DBG_STATISTICS) || defined(__DOXYGEN__)
+#define BCAST_WAITERS           16
+
+static CONDVAR_DECL(c1);
+static ALIGNED_VAR(PORT_WORKING_AREA_ALIGN) uint8_t wa_bcast[BCAST_WAITERS][WA_SIZE];
+static char bcast_tokens[] = "ABCDEFGHIJKLMNOP";
+
+static THD_FUNCTION(bmk_thread9, p) {
+
+  chMtxLock(&mtx1);
+  chCondWait(&c1);
+  test_emit_token(*(char *)p);
+  chMtxUnlock(&mtx1);
+}
+#endif
+
 /****************************************************************************
  * Test cases.
  ****************************************************************************/
@@ -912,28 +929,116 @@ static const testcase_t rt_test_011_011 = {
 };
 #endif /* CH_CFG_USE_MUTEXES */
 
+#if (CH_CFG_USE_CONDVARS && CH_DBG_STATISTICS) || defined(__DOXYGEN__)
 /**
- * @page rt_test_011_012 [11.12] RAM Footprint
+ * @page rt_test_011_012 [11.12] Condition variables broadcast
  *
  * <h2>Description</h2>
- * The memory size of the various kernel objects is printed.
+ * Sixteen threads wait on a condition variable, the condition variable
+ * is broadcast while holding the associated mutex. The waiters are
+ * moved on the mutex queue instead of being woken up at once, the
+ * number of context switches required for all threads to complete is
+ * measured.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_CONDVARS && CH_DBG_STATISTICS
+ * .
  *
  * <h2>Test Steps</h2>
- * - [11.12.1] The size of the system area is printed.
- * - [11.12.2] The size of a thread structure is printed.
- * - [11.12.3] The size of a virtual timer structure is printed.
- * - [11.12.4] The size of a semaphore structure is printed.
- * - [11.12.5] The size of a mutex is printed.
- * - [11.12.6] The size of a condition variable is printed.
- * - [11.12.7] The size of an event source is printed.
- * - [11.12.8] The size of an event listener is printed.
- * - [11.12.9] The size of a mailbox is printed.
+ * - [11.12.1] Sixteen threads are created with higher priority, each
+ *   one locks the mutex and waits on the condition variable.
+ * - [11.12.2] The mutex is locked, the condition variable is broadcast
+ *   and the mutex is unlocked, the context switches are counted until
+ *   all threads terminated.
+ * - [11.12.3] The score is printed, the threads are expected to have
+ *   been served in order with one context switch each plus the final
+ *   switch back to the test thread.
  * .
  */
 
+static void rt_test_011_012_setup(void) {
+  chMtxObjectInit(&mtx1);
+  chCondObjectInit(&c1);
+}
+
 static void rt_test_011_012_execute(void) {
+  unsigned i;
+  ucnt_t n;
 
-  /* [11.12.1] The size of the system area is printed.*/
+  /* [11.12.1] Sixteen threads are created with higher priority, each
+     one locks the mutex and waits on the condition variable.*/
+  test_set_step(1);
+  {
+    tprio_t prio = chThdGetPriorityX();
+
+    for (i = 0; i < BCAST_WAITERS; i++) {
+      (void)chThdCreateStatic(wa_bcast[i], WA_SIZE, prio + 1,
+                              bmk_thread9, (void *)&bcast_tokens[i]);
+    }
+  }
+  test_end_step(1);
+
+  /* [11.12.2] The mutex is locked, the condition variable is broadcast
+     and the mutex is unlocked, the context switches are counted until
+     all threads terminated.*/
+  test_set_step(2);
+  {
+    ucnt_t start;
+
+    chMtxLock(&mtx1);
+    start = ch.kernel_stats.n_ctxswc;
+    chCondBroadcast(&c1);
+    chMtxUnlock(&mtx1);
+    n = ch.kernel_stats.n_ctxswc - start;
+  }
+  test_end_step(2);
+
+  /* [11.12.3] The score is printed, the threads are expected to have
+     been served in order with one context switch each plus the final
+     switch back to the test thread.*/
+  test_set_step(3);
+  {
+    test_print("--- Score : ");
+    test_printn(n);
+    test_println(" ctxswc");
+    test_assert_sequence("ABCDEFGHIJKLMNOP", "invalid sequence");
+    test_assert(n <= BCAST_WAITERS + 1, "too many context switches");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t rt_test_011_012 = {
+  "Condition variables broadcast",
+  rt_test_011_012_setup,
+  NULL,
+  rt_test_011_012_execute
+};
+#endif /* CH_CFG_USE_CONDVARS && CH_DBG_STATISTICS */
+
+/**
+ * @page rt_test_011_013 [11.13] RAM Footprint
+ *
+ * <h2>Description</h2>
+ * The memory size of the various kernel objects is printed.
+ *
+ * <h2>Test Steps</h2>
+ * - [11.13.1] The size of the system area is printed.
+ * - [11.13.2] The size of a thread structure is printed.
+ * - [11.13.3] The size of a virtual timer structure is printed.
+ * - [11.13.4] The size of a semaphore structure is printed.
+ * - [11.13.5] The size of a mutex is printed.
+ * - [11.13.6] The size of a condition variable is printed.
+ * - [11.13.7] The size of an event source is printed.
+ * - [11.13.8] The size of an event listener is printed.
+ * - [11.13.9] The size of a mailbox is printed.
+ * .
+ */
+
+static void rt_test_011_013_execute(void) {
+
+  /* [11.13.1] The size of the system area is printed.*/
   test_set_step(1);
   {
     test_print("--- System: ");
@@ -942,7 +1047,7 @@ static void rt_test_011_012_execute(void) {
   }
   test_end_step(1);
 
-  /* [11.12.2] The size of a thread structure is printed.*/
+  /* [11.13.2] The size of a thread structure is printed.*/
   test_set_step(2);
   {
     test_print("--- Thread: ");
@@ -951,7 +1056,7 @@ static void rt_test_011_012_execute(void) {
   }
   test_end_step(2);
 
-  /* [11.12.3] The size of a virtual timer structure is printed.*/
+  /* [11.13.3] The size of a virtual timer structure is printed.*/
   test_set_step(3);
   {
     test_print("--- Timer : ");
@@ -960,7 +1065,7 @@ static void rt_test_011_012_execute(void) {
   }
   test_end_step(3);
 
-  /* [11.12.4] The size of a semaphore structure is printed.*/
+  /* [11.13.4] The size of a semaphore structure is printed.*/
   test_set_step(4);
   {
 #if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
@@ -971,7 +1076,7 @@ static void rt_test_011_012_execute(void) {
   }
   test_end_step(4);
 
-  /* [11.12.5] The size of a mutex is printed.*/
+  /* [11.13.5] The size of a mutex is printed.*/
   test_set_step(5);
   {
 #if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
@@ -982,7 +1087,7 @@ static void rt_test_011_012_execute(void) {
   }
   test_end_step(5);
 
-  /* [11.12.6] The size of a condition variable is printed.*/
+  /* [11.13.6] The size of a condition variable is printed.*/
   test_set_step(6);
   {
 #if CH_CFG_USE_CONDVARS || defined(__DOXYGEN__)
@@ -993,7 +1098,7 @@ static void rt_test_011_012_execute(void) {
   }
   test_end_step(6);
 
-  /* [11.12.7] The size of an event source is printed.*/
+  /* [11.13.7] The size of an event source is printed.*/
   test_set_step(7);
   {
 #if CH_CFG_USE_EVENTS || defined(__DOXYGEN__)
@@ -1004,7 +1109,7 @@ static void rt_test_011_012_execute(void) {
   }
   test_end_step(7);
 
-  /* [11.12.8] The size of an event listener is printed.*/
+  /* [11.13.8] The size of an event listener is printed.*/
   test_set_step(8);
   {
 #if CH_CFG_USE_EVENTS || defined(__DOXYGEN__)
@@ -1015,7 +1120,7 @@ static void rt_test_011_012_execute(void) {
   }
   test_end_step(8);
 
-  /* [11.12.9] The size of a mailbox is printed.*/
+  /* [11.13.9] The size of a mailbox is printed.*/
   test_set_step(9);
   {
 #if CH_CFG_USE_MAILBOXES || defined(__DOXYGEN__)
@@ -1027,11 +1132,11 @@ static void rt_test_011_012_execute(void) {
   test_end_step(9);
 }
 
-static const testcase_t rt_test_011_012 = {
+static const testcase_t rt_test_011_013 = {
   "RAM Footprint",
   NULL,
   NULL,
-  rt_test_011_012_execute
+  rt_test_011_013_execute
 };
 
 /****************************************************************************
@@ -1065,7 +1170,10 @@ const testcase_t * const rt_test_sequence_011_array[] = {
 #if (CH_CFG_USE_MUTEXES) || defined(__DOXYGEN__)
   &rt_test_011_011,
 #endif
+#if (CH_CFG_USE_CONDVARS && CH_DBG_STATISTICS) || defined(__DOXYGEN__)
   &rt_test_011_012,
+#endif
+  &rt_test_011_013,
   NULL
 };
 
@@ -0,0 +1,564 @@
+/*
+    ChibiOS - Copyright (C) 2006..2017 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+#include "rt_test_root.h"
+
+/**
+ * @file    rt_test_sequence_012.c
+ * @brief   Test Sequence 012 code.
+ *
+ * @page rt_test_sequence_012 [12] Read-Write Locks
+ *
+ * File: @ref rt_test_sequence_012.c
+ *
+ * <h2>Description</h2>
+ * This sequence tests the ChibiOS/RT functionalities related to
+ * read-write locks.
+ *
+ * <h2>Conditions</h2>
+ * This sequence is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_RWLOCKS
+ * .
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage rt_test_012_001
+ * - @subpage rt_test_012_002
+ * - @subpage rt_test_012_003
+ * - @subpage rt_test_012_004
+ * - @subpage rt_test_012_005
+ * - @subpage rt_test_012_006
+ * .
+ */
+
+#if (CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+
+/****************************************************************************
+ * Shared code.
+ ****************************************************************************/
+
+static RWLOCK_DECL(rw1);
+
+static THD_FUNCTION(thread_reader, p) {
+
+  chRWLockLockShared(&rw1);
+  test_emit_token(*(char *)p);
+  chRWLockUnlock(&rw1);
+}
+
+static THD_FUNCTION(thread_writer, p) {
+
+  chRWLockLockExclusive(&rw1);
+  test_emit_token(*(char *)p);
+  chRWLockUnlock(&rw1);
+}
+
+static THD_FUNCTION(thread_holder, p) {
+
+  (void)p;
+  chRWLockLockExclusive(&rw1);
+  chThdSleepMilliseconds(50);
+  chRWLockUnlock(&rw1);
+}
+
+static THD_FUNCTION(thread_shared_holder, p) {
+
+  chRWLockLockShared(&rw1);
+  chThdSleepMilliseconds(50);
+  test_emit_token(*(char *)p);
+  chRWLockUnlock(&rw1);
+}
+
+static THD_FUNCTION(thread_writer_timeout, p) {
+
+  if (chRWLockLockExclusiveTimeout(&rw1, TIME_MS2I(20)) == MSG_TIMEOUT) {
+    test_emit_token(*(char *)p);
+  }
+}
+
+/****************************************************************************
+ * Test cases.
+ ****************************************************************************/
+
+/**
+ * @page rt_test_012_001 [12.1] Concurrent readers
+ *
+ * <h2>Description</h2>
+ * The lock is held in shared mode, other readers must be able to
+ * acquire it without waiting while writers must not.
+ *
+ * <h2>Test Steps</h2>
+ * - [12.1.1] The lock is acquired in shared mode then three readers
+ *   with higher priority are created, they must acquire the lock
+ *   without waiting.
+ * - [12.1.2] Exclusive access is attempted while the lock is held in
+ *   shared mode, the attempt must fail.
+ * - [12.1.3] The lock is released then exclusive access is attempted
+ *   again, the attempt must succeed.
+ * .
+ */
+
+static void rt_test_012_001_setup(void) {
+  chRWLockObjectInit(&rw1);
+}
+
+static void rt_test_012_001_execute(void) {
+
+  /* [12.1.1] The lock is acquired in shared mode then three readers
+     with higher priority are created, they must acquire the lock
+     without waiting.*/
+  test_set_step(1);
+  {
+    chRWLockLockShared(&rw1);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX()+1, thread_reader, "A");
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriorityX()+1, thread_reader, "B");
+    threads[2] = chThdCreateStatic(wa[2], WA_SIZE, chThdGetPriorityX()+1, thread_reader, "C");
+    test_assert_sequence("ABC", "invalid sequence");
+    test_wait_threads();
+  }
+  test_end_step(1);
+
+  /* [12.1.2] Exclusive access is attempted while the lock is held in
+     shared mode, the attempt must fail.*/
+  test_set_step(2);
+  {
+    msg_t msg;
+
+    test_assert_lock(chRWLockGetReadersI(&rw1) == (cnt_t)1, "wrong readers count");
+    msg = chRWLockLockExclusiveTimeout(&rw1, TIME_IMMEDIATE);
+    test_assert(msg == MSG_TIMEOUT, "lock not failed");
+  }
+  test_end_step(2);
+
+  /* [12.1.3] The lock is released then exclusive access is attempted
+     again, the attempt must succeed.*/
+  test_set_step(3);
+  {
+    msg_t msg;
+
+    chRWLockUnlock(&rw1);
+    test_assert_lock(chRWLockGetReadersI(&rw1) == (cnt_t)0, "wrong readers count");
+    msg = chRWLockLockExclusiveTimeout(&rw1, TIME_IMMEDIATE);
+    test_assert(msg == MSG_OK, "lock failed");
+    test_assert_lock(chRWLockIsExclusiveI(&rw1), "not exclusive");
+    msg = chRWLockLockSharedTimeout(&rw1, TIME_IMMEDIATE);
+    test_assert(msg == MSG_TIMEOUT, "lock not failed");
+    chRWLockUnlock(&rw1);
+    test_assert_lock(!chRWLockIsExclusiveI(&rw1), "still exclusive");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t rt_test_012_001 = {
+  "Concurrent readers",
+  rt_test_012_001_setup,
+  NULL,
+  rt_test_012_001_execute
+};
+
+/**
+ * @page rt_test_012_002 [12.2] Writers preference
+ *
+ * <h2>Description</h2>
+ * A writer waiting for the lock must prevent new readers from acquiring
+ * it, the writer must be served first when the lock is released.
+ *
+ * <h2>Test Steps</h2>
+ * - [12.2.1] The lock is acquired in shared mode then a writer and a
+ *   reader with higher priorities are created, both must wait.
+ * - [12.2.2] The lock is released, the writer must acquire the lock
+ *   before the reader.
+ * .
+ */
+
+static void rt_test_012_002_setup(void) {
+  chRWLockObjectInit(&rw1);
+}
+
+static void rt_test_012_002_execute(void) {
+
+  /* [12.2.1] The lock is acquired in shared mode then a writer and a
+     reader with higher priorities are created, both must wait.*/
+  test_set_step(1);
+  {
+    tprio_t prio = chThdGetPriorityX();
+
+    chRWLockLockShared(&rw1);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+2, thread_writer, "A");
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+1, thread_reader, "B");
+    test_assert_sequence("", "invalid sequence");
+    test_assert_lock(chRWLockGetReadersI(&rw1) == (cnt_t)1, "wrong readers count");
+  }
+  test_end_step(1);
+
+  /* [12.2.2] The lock is released, the writer must acquire the lock
+     before the reader.*/
+  test_set_step(2);
+  {
+    chRWLockUnlock(&rw1);
+    test_wait_threads();
+    test_assert_sequence("AB", "invalid sequence");
+  }
+  test_end_step(2);
+}
+
+static const testcase_t rt_test_012_002 = {
+  "Writers preference",
+  rt_test_012_002_setup,
+  NULL,
+  rt_test_012_002_execute
+};
+
+/**
+ * @page rt_test_012_003 [12.3] Read-write locks timeouts
+ *
+ * <h2>Description</h2>
+ * Timeouts on both shared and exclusive access are tested, a writer
+ * timing out must let the waiting readers in.
+ *
+ * <h2>Test Steps</h2>
+ * - [12.3.1] A thread holding the lock in exclusive mode is created,
+ *   shared access with timeout and immediate exclusive access must
+ *   fail.
+ * - [12.3.2] The lock is acquired in shared mode then a writer with
+ *   timeout and a reader are created, the reader must acquire the lock
+ *   when the writer times out.
+ * - [12.3.3] The lock is released, the priority inherited from the
+ *   writer must be lost.
+ * .
+ */
+
+static void rt_test_012_003_setup(void) {
+  chRWLockObjectInit(&rw1);
+}
+
+static void rt_test_012_003_execute(void) {
+
+  /* [12.3.1] A thread holding the lock in exclusive mode is created,
+     shared access with timeout and immediate exclusive access must
+     fail.*/
+  test_set_step(1);
+  {
+    msg_t msg;
+
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX()+1, thread_holder, NULL);
+    msg = chRWLockLockSharedTimeout(&rw1, TIME_MS2I(20));
+    test_assert(msg == MSG_TIMEOUT, "lock not failed");
+    msg = chRWLockLockExclusiveTimeout(&rw1, TIME_IMMEDIATE);
+    test_assert(msg == MSG_TIMEOUT, "lock not failed");
+    test_wait_threads();
+  }
+  test_end_step(1);
+
+  /* [12.3.2] The lock is acquired in shared mode then a writer with
+     timeout and a reader are created, the reader must acquire the lock
+     when the writer times out.*/
+  test_set_step(2);
+  {
+    tprio_t prio = chThdGetPriorityX();
+
+    chRWLockLockShared(&rw1);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+2, thread_writer_timeout, "A");
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+1, thread_reader, "B");
+    test_wait_threads();
+    test_assert_sequence("AB", "invalid sequence");
+    test_assert_lock(chRWLockGetReadersI(&rw1) == (cnt_t)1, "wrong readers count");
+  }
+  test_end_step(2);
+
+  /* [12.3.3] The lock is released, the priority inherited from the
+     writer must be lost.*/
+  test_set_step(3);
+  {
+    tprio_t prio = chThdGetSelfX()->realprio;
+
+    test_assert(chThdGetPriorityX() == prio + 2, "wrong priority level");
+    chRWLockUnlock(&rw1);
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t rt_test_012_003 = {
+  "Read-write locks timeouts",
+  rt_test_012_003_setup,
+  NULL,
+  rt_test_012_003_execute
+};
+
+/**
+ * @page rt_test_012_004 [12.4] Priority inheritance
+ *
+ * <h2>Description</h2>
+ * A writer waiting for the lock must boost all the readers holding it,
+ * a reader releasing the lock must return to its base priority.
+ *
+ * <h2>Test Steps</h2>
+ * - [12.4.1] The lock is acquired in shared mode by this thread and by
+ *   a reader with higher priority.
+ * - [12.4.2] A writer with higher priority is created, both readers
+ *   must inherit its priority.
+ * - [12.4.3] The lock is released by this thread, the original priority
+ *   must be restored and the writer must acquire the lock after the
+ *   other reader.
+ * .
+ */
+
+static void rt_test_012_004_setup(void) {
+  chRWLockObjectInit(&rw1);
+}
+
+static void rt_test_012_004_execute(void) {
+
+  /* [12.4.1] The lock is acquired in shared mode by this thread and by
+     a reader with higher priority.*/
+  test_set_step(1);
+  {
+    chRWLockLockShared(&rw1);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX()+1, thread_shared_holder, "A");
+    test_assert_lock(chRWLockGetReadersI(&rw1) == (cnt_t)2, "wrong readers count");
+  }
+  test_end_step(1);
+
+  /* [12.4.2] A writer with higher priority is created, both readers
+     must inherit its priority.*/
+  test_set_step(2);
+  {
+    tprio_t prio = chThdGetPriorityX();
+
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+3, thread_writer, "B");
+    test_assert(chThdGetPriorityX() == prio + 3, "wrong priority level");
+    test_assert(threads[0]->hdr.pqueue.prio == prio + 3, "wrong priority level");
+  }
+  test_end_step(2);
+
+  /* [12.4.3] The lock is released by this thread, the original priority
+     must be restored and the writer must acquire the lock after the
+     other reader.*/
+  test_set_step(3);
+  {
+    tprio_t prio = chThdGetSelfX()->realprio;
+
+    chRWLockUnlock(&rw1);
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+    test_wait_threads();
+    test_assert_sequence("AB", "invalid sequence");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t rt_test_012_004 = {
+  "Priority inheritance",
+  rt_test_012_004_setup,
+  NULL,
+  rt_test_012_004_execute
+};
+
+/**
+ * @page rt_test_012_005 [12.5] Read-write locks lock/unlock performance
+ *
+ * <h2>Description</h2>
+ * The lock is acquired and released in shared and exclusive modes, the
+ * operation is repeated continuously in a one-second time window, the
+ * scores are printed.
+ *
+ * <h2>Test Steps</h2>
+ * - [12.5.1] The lock is acquired in shared mode and released, the
+ *   score is printed.
+ * - [12.5.2] The lock is acquired in exclusive mode and released, the
+ *   score is printed.
+ * .
+ */
+
+static void rt_test_012_005_setup(void) {
+  chRWLockObjectInit(&rw1);
+}
+
+static void rt_test_012_005_execute(void) {
+
+  /* [12.5.1] The lock is acquired in shared mode and released, the
+     score is printed.*/
+  test_set_step(1);
+  {
+    uint32_t n = 0;
+    systime_t start, end;
+
+    start = test_wait_tick();
+    end = chTimeAddX(start, TIME_MS2I(1000));
+    do {
+      chRWLockLockShared(&rw1);
+      chRWLockUnlock(&rw1);
+      chRWLockLockShared(&rw1);
+      chRWLockUnlock(&rw1);
+      chRWLockLockShared(&rw1);
+      chRWLockUnlock(&rw1);
+      chRWLockLockShared(&rw1);
+      chRWLockUnlock(&rw1);
+      n++;
+    #if defined(SIMULATOR)
+      _sim_check_for_interrupts();
+    #endif
+    } while (chVTIsSystemTimeWithinX(start, end));
+
+    test_print("--- Score : ");
+    test_printn(n * 4);
+    test_println(" lock+unlock/S");
+  }
+  test_end_step(1);
+
+  /* [12.5.2] The lock is acquired in exclusive mode and released, the
+     score is printed.*/
+  test_set_step(2);
+  {
+    uint32_t n = 0;
+    systime_t start, end;
+
+    start = test_wait_tick();
+    end = chTimeAddX(start, TIME_MS2I(1000));
+    do {
+      chRWLockLockExclusive(&rw1);
+      chRWLockUnlock(&rw1);
+      chRWLockLockExclusive(&rw1);
+      chRWLockUnlock(&rw1);
+      chRWLockLockExclusive(&rw1);
+      chRWLockUnlock(&rw1);
+      chRWLockLockExclusive(&rw1);
+      chRWLockUnlock(&rw1);
+      n++;
+    #if defined(SIMULATOR)
+      _sim_check_for_interrupts();
+    #endif
+    } while (chVTIsSystemTimeWithinX(start, end));
+
+    test_print("--- Score : ");
+    test_printn(n * 4);
+    test_println(" lock+unlock/S");
+  }
+  test_end_step(2);
+}
+
+static const testcase_t rt_test_012_005 = {
+  "Read-write locks lock/unlock performance",
+  rt_test_012_005_setup,
+  NULL,
+  rt_test_012_005_execute
+};
+
+/**
+ * @page rt_test_012_006 [12.6] Read-write locks holder records limit
+ *
+ * <h2>Description</h2>
+ * A thread acquires the maximum number of read-write locks it can hold,
+ * further acquisitions must fail with MSG_RESET.
+ *
+ * <h2>Test Steps</h2>
+ * - [12.6.1] Acquiring CH_CFG_RWLOCKS_MAX_HOLDS locks in alternate modes,
+ *   must succeed.
+ * - [12.6.2] Acquiring one more lock in both modes, must fail without
+ *   blocking and the lock must be left free.
+ * - [12.6.3] Releasing a lock then acquiring the last one, must succeed,
+ *   then releasing all the locks.
+ * .
+ */
+
+static void rt_test_012_006_execute(void) {
+  rwlock_t rwa[CH_CFG_RWLOCKS_MAX_HOLDS + 1];
+  msg_t msg;
+  unsigned i;
+
+  /* [12.6.1] Acquiring CH_CFG_RWLOCKS_MAX_HOLDS locks in alternate modes,
+     must succeed.*/
+  test_set_step(1);
+  {
+    for (i = 0; i <= CH_CFG_RWLOCKS_MAX_HOLDS; i++) {
+      chRWLockObjectInit(&rwa[i]);
+    }
+    for (i = 0; i < CH_CFG_RWLOCKS_MAX_HOLDS; i++) {
+      if ((i & 1U) == 0U) {
+        msg = chRWLockLockSharedTimeout(&rwa[i], TIME_IMMEDIATE);
+      }
+      else {
+        msg = chRWLockLockExclusiveTimeout(&rwa[i], TIME_IMMEDIATE);
+      }
+      test_assert(msg == MSG_OK, "lock not acquired");
+    }
+  }
+  test_end_step(1);
+
+  /* [12.6.2] Acquiring one more lock in both modes, must fail without
+     blocking and the lock must be left free.*/
+  test_set_step(2);
+  {
+    rwlock_t *rwp = &rwa[CH_CFG_RWLOCKS_MAX_HOLDS];
+
+    msg = chRWLockLockSharedTimeout(rwp, TIME_INFINITE);
+    test_assert(msg == MSG_RESET, "wrong wake-up message");
+    msg = chRWLockLockExclusiveTimeout(rwp, TIME_INFINITE);
+    test_assert(msg == MSG_RESET, "wrong wake-up message");
+    test_assert_lock(chRWLockGetReadersI(rwp) == (cnt_t)0, "wrong readers count");
+    test_assert_lock(!chRWLockIsExclusiveI(rwp), "lock taken");
+  }
+  test_end_step(2);
+
+  /* [12.6.3] Releasing a lock then acquiring the last one, must succeed,
+     then releasing all the locks.*/
+  test_set_step(3);
+  {
+    chRWLockUnlock(&rwa[0]);
+    msg = chRWLockLockExclusiveTimeout(&rwa[CH_CFG_RWLOCKS_MAX_HOLDS],
+                                       TIME_IMMEDIATE);
+    test_assert(msg == MSG_OK, "lock not acquired");
+    for (i = 1; i <= CH_CFG_RWLOCKS_MAX_HOLDS; i++) {
+      chRWLockUnlock(&rwa[i]);
+    }
+  }
+  test_end_step(3);
+}
+
+static const testcase_t rt_test_012_006 = {
+  "Read-write locks holder records limit",
+  NULL,
+  NULL,
+  rt_test_012_006_execute
+};
+
+/****************************************************************************
+ * Exported data.
+ ****************************************************************************/
+
+/**
+ * @brief   Array of test cases.
+ */
+const testcase_t * const rt_test_sequence_012_array[] = {
+  &rt_test_012_001,
+  &rt_test_012_002,
+  &rt_test_012_003,
+  &rt_test_012_004,
+  &rt_test_012_005,
+  &rt_test_012_006,
+  NULL
+};
+
+/**
+ * @brief   Read-Write Locks.
+ */
+const testsequence_t rt_test_sequence_012 = {
+  "Read-Write Locks",
+  rt_test_sequence_012_array
+};
+
+#endif /* CH_CFG_USE_RWLOCKS */
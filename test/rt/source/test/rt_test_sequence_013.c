@@ -0,0 +1,350 @@
+/*
+    ChibiOS - Copyright (C) 2006..2017 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+#include "rt_test_root.h"
+
+/**
+ * @file    rt_test_sequence_013.c
+ * @brief   Test Sequence 013 code.
+ *
+ * @page rt_test_sequence_013 [13] Multiplexed Wait
+ *
+ * File: @ref rt_test_sequence_013.c
+ *
+ * <h2>Description</h2>
+ * This sequence tests the ChibiOS/RT functionalities related to the
+ * multiplexed wait on sets of objects.
+ *
+ * <h2>Conditions</h2>
+ * This sequence is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_POLL
+ * .
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage rt_test_013_001
+ * - @subpage rt_test_013_002
+ * - @subpage rt_test_013_003
+ * .
+ */
+
+#if (CH_CFG_USE_POLL) || defined(__DOXYGEN__)
+
+/****************************************************************************
+ * Shared code.
+ ****************************************************************************/
+
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+static semaphore_t sem1, sem2;
+#endif
+#if CH_CFG_USE_EVENTS || defined(__DOXYGEN__)
+static EVENTSOURCE_DECL(es1);
+static event_listener_t el1;
+#endif
+static poll_set_t ps1;
+static poll_item_t pi1, pi2;
+
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+static THD_FUNCTION(thread_sem, p) {
+
+  chThdSleepMilliseconds(10);
+  chSemSignal((semaphore_t *)p);
+}
+#endif
+
+#if CH_CFG_USE_EVENTS || defined(__DOXYGEN__)
+static THD_FUNCTION(thread_evt, p) {
+
+  chThdSleepMilliseconds(10);
+  chEvtSignal((thread_t *)p, EVENT_MASK(0));
+}
+
+static THD_FUNCTION(thread_bcast, p) {
+
+  chThdSleepMilliseconds(10);
+  chEvtBroadcast((event_source_t *)p);
+}
+#endif
+
+/****************************************************************************
+ * Test cases.
+ ****************************************************************************/
+
+#if (CH_CFG_USE_SEMAPHORES) || defined(__DOXYGEN__)
+/**
+ * @page rt_test_013_001 [13.1] Semaphores polling
+ *
+ * <h2>Description</h2>
+ * Two semaphores are added to a poll set, the readiness state of the
+ * items is tested with immediate waits and with a wait awakened by
+ * another thread.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_SEMAPHORES
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [13.1.1] An immediate wait is performed while both counters are
+ *   zero, no item must be ready.
+ * - [13.1.2] The second semaphore is signaled, the wait must return the
+ *   second item as ready.
+ * - [13.1.3] A thread signaling the first semaphore after a delay is
+ *   created, the wait must be awakened with the first item ready.
+ * .
+ */
+
+static void rt_test_013_001_setup(void) {
+  chSemObjectInit(&sem1, 0);
+  chSemObjectInit(&sem2, 0);
+  chPollObjectInit(&ps1);
+  chPollAddSemaphore(&ps1, &pi1, &sem1);
+  chPollAddSemaphore(&ps1, &pi2, &sem2);
+}
+
+static void rt_test_013_001_teardown(void) {
+  chPollRemove(&pi1);
+  chPollRemove(&pi2);
+}
+
+static void rt_test_013_001_execute(void) {
+  cnt_t n;
+
+  /* [13.1.1] An immediate wait is performed while both counters are
+     zero, no item must be ready.*/
+  test_set_step(1);
+  {
+    n = chPollWaitTimeout(&ps1, TIME_IMMEDIATE);
+    test_assert(n == (cnt_t)0, "unexpected ready items");
+    test_assert(!chPollIsReadyX(&pi1) && !chPollIsReadyX(&pi2), "item ready");
+  }
+  test_end_step(1);
+
+  /* [13.1.2] The second semaphore is signaled, the wait must return the
+     second item as ready.*/
+  test_set_step(2);
+  {
+    chSemSignal(&sem2);
+    n = chPollWaitTimeout(&ps1, TIME_IMMEDIATE);
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(!chPollIsReadyX(&pi1), "item ready");
+    test_assert(chPollIsReadyX(&pi2), "item not ready");
+    test_assert(chPollGetObjectX(&pi2) == (void *)&sem2, "wrong object");
+    test_assert(chSemWaitTimeout(&sem2, TIME_IMMEDIATE) == MSG_OK, "wait failed");
+  }
+  test_end_step(2);
+
+  /* [13.1.3] A thread signaling the first semaphore after a delay is
+     created, the wait must be awakened with the first item ready.*/
+  test_set_step(3);
+  {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() - 1,
+                                   thread_sem, (void *)&sem1);
+    n = chPollWaitTimeout(&ps1, TIME_MS2I(500));
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(chPollIsReadyX(&pi1), "item not ready");
+    test_assert(!chPollIsReadyX(&pi2), "item ready");
+    test_wait_threads();
+  }
+  test_end_step(3);
+}
+
+static const testcase_t rt_test_013_001 = {
+  "Semaphores polling",
+  rt_test_013_001_setup,
+  rt_test_013_001_teardown,
+  rt_test_013_001_execute
+};
+#endif /* CH_CFG_USE_SEMAPHORES */
+
+#if (CH_CFG_USE_SEMAPHORES) || defined(__DOXYGEN__)
+/**
+ * @page rt_test_013_002 [13.2] Poll timeout
+ *
+ * <h2>Description</h2>
+ * A wait is performed on a set with no ready items, the wait must time
+ * out within the expected time window.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_SEMAPHORES
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [13.2.1] A wait with a 20mS timeout is performed, it must return
+ *   with no ready items after the timeout.
+ * .
+ */
+
+static void rt_test_013_002_setup(void) {
+  chSemObjectInit(&sem1, 0);
+  chPollObjectInit(&ps1);
+  chPollAddSemaphore(&ps1, &pi1, &sem1);
+}
+
+static void rt_test_013_002_teardown(void) {
+  chPollRemove(&pi1);
+}
+
+static void rt_test_013_002_execute(void) {
+  cnt_t n;
+  systime_t time;
+
+  /* [13.2.1] A wait with a 20mS timeout is performed, it must return
+     with no ready items after the timeout.*/
+  test_set_step(1);
+  {
+    time = test_wait_tick();
+    n = chPollWaitTimeout(&ps1, TIME_MS2I(20));
+    test_assert(n == (cnt_t)0, "unexpected ready items");
+    test_assert(!chPollIsReadyX(&pi1), "item ready");
+    test_assert_time_window(chTimeAddX(time, TIME_MS2I(20)),
+                            chTimeAddX(time, TIME_MS2I(20) + CH_CFG_ST_TIMEDELTA + 1),
+                            "out of time window");
+  }
+  test_end_step(1);
+}
+
+static const testcase_t rt_test_013_002 = {
+  "Poll timeout",
+  rt_test_013_002_setup,
+  rt_test_013_002_teardown,
+  rt_test_013_002_execute
+};
+#endif /* CH_CFG_USE_SEMAPHORES */
+
+#if (CH_CFG_USE_EVENTS) || defined(__DOXYGEN__)
+/**
+ * @page rt_test_013_003 [13.3] Events polling
+ *
+ * <h2>Description</h2>
+ * An events mask and an event source are added to a poll set, the wait
+ * must be awakened by events signaled directly or through the event
+ * source.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_EVENTS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [13.3.1] An immediate wait is performed with no pending events, no
+ *   item must be ready.
+ * - [13.3.2] A thread signaling an event to this thread after a delay
+ *   is created, the wait must be awakened with the first item ready.
+ * - [13.3.3] A thread broadcasting the event source after a delay is
+ *   created, the wait must be awakened with the second item ready.
+ * .
+ */
+
+static void rt_test_013_003_setup(void) {
+  chEvtGetAndClearEvents(ALL_EVENTS);
+  chPollObjectInit(&ps1);
+  chPollAddEvents(&ps1, &pi1, EVENT_MASK(0));
+  chPollAddEventSource(&ps1, &pi2, &es1, &el1, EVENT_MASK(1));
+}
+
+static void rt_test_013_003_teardown(void) {
+  chPollRemove(&pi1);
+  chPollRemove(&pi2);
+  chEvtUnregister(&es1, &el1);
+  chEvtGetAndClearEvents(ALL_EVENTS);
+}
+
+static void rt_test_013_003_execute(void) {
+  cnt_t n;
+
+  /* [13.3.1] An immediate wait is performed with no pending events, no
+     item must be ready.*/
+  test_set_step(1);
+  {
+    n = chPollWaitTimeout(&ps1, TIME_IMMEDIATE);
+    test_assert(n == (cnt_t)0, "unexpected ready items");
+  }
+  test_end_step(1);
+
+  /* [13.3.2] A thread signaling an event to this thread after a delay
+     is created, the wait must be awakened with the first item ready.*/
+  test_set_step(2);
+  {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() - 1,
+                                   thread_evt, (void *)chThdGetSelfX());
+    n = chPollWaitTimeout(&ps1, TIME_MS2I(500));
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(chPollIsReadyX(&pi1), "item not ready");
+    test_assert(!chPollIsReadyX(&pi2), "item ready");
+    test_assert(chEvtGetAndClearEvents(ALL_EVENTS) == EVENT_MASK(0), "wrong events");
+    test_wait_threads();
+  }
+  test_end_step(2);
+
+  /* [13.3.3] A thread broadcasting the event source after a delay is
+     created, the wait must be awakened with the second item ready.*/
+  test_set_step(3);
+  {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() - 1,
+                                   thread_bcast, (void *)&es1);
+    n = chPollWaitTimeout(&ps1, TIME_MS2I(500));
+    test_assert(n == (cnt_t)1, "wrong ready items");
+    test_assert(!chPollIsReadyX(&pi1), "item ready");
+    test_assert(chPollIsReadyX(&pi2), "item not ready");
+    test_assert(chEvtGetAndClearEvents(ALL_EVENTS) == EVENT_MASK(1), "wrong events");
+    test_wait_threads();
+  }
+  test_end_step(3);
+}
+
+static const testcase_t rt_test_013_003 = {
+  "Events polling",
+  rt_test_013_003_setup,
+  rt_test_013_003_teardown,
+  rt_test_013_003_execute
+};
+#endif /* CH_CFG_USE_EVENTS */
+
+/****************************************************************************
+ * Exported data.
+ ****************************************************************************/
+
+/**
+ * @brief   Array of test cases.
+ */
+const testcase_t * const rt_test_sequence_013_array[] = {
+#if (CH_CFG_USE_SEMAPHORES) || defined(__DOXYGEN__)
+  &rt_test_013_001,
+#endif
+#if (CH_CFG_USE_SEMAPHORES) || defined(__DOXYGEN__)
+  &rt_test_013_002,
+#endif
+#if (CH_CFG_USE_EVENTS) || defined(__DOXYGEN__)
+  &rt_test_013_003,
+#endif
+  NULL
+};
+
+/**
+ * @brief   Multiplexed Wait.
+ */
+const testsequence_t rt_test_sequence_013 = {
+  "Multiplexed Wait",
+  rt_test_sequence_013_array
+};
+
+#endif /* CH_CFG_USE_POLL */
@@ -0,0 +1,234 @@
+/*
+    ChibiOS - Copyright (C) 2006..2017 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+#include "rt_test_root.h"
+
+/**
+ * @file    rt_test_sequence_014.c
+ * @brief   Test Sequence 014 code.
+ *
+ * @page rt_test_sequence_014 [14] Threaded Interrupt Handlers
+ *
+ * File: @ref rt_test_sequence_014.c
+ *
+ * <h2>Description</h2>
+ * This sequence tests the ChibiOS/RT functionalities related to
+ * threaded interrupt handlers.
+ *
+ * <h2>Conditions</h2>
+ * This sequence is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_IRQ_THREADS
+ * .
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage rt_test_014_001
+ * - @subpage rt_test_014_002
+ * .
+ */
+
+#if (CH_CFG_USE_IRQ_THREADS) || defined(__DOXYGEN__)
+
+/****************************************************************************
+ * Shared code.
+ ****************************************************************************/
+
+static irq_thread_t it1;
+static irq_source_t is1, is2, isexit;
+static unsigned rearm;
+
+static void bh_token(void *arg) {
+  irq_source_t *isp = (irq_source_t *)arg;
+
+  /* Source 1 raises itself again while its bottom half is running.*/
+  if ((isp == &is1) && (rearm > 0U)) {
+    rearm--;
+    chIRQRaise(&is1);
+  }
+  test_emit_token(isp == &is1 ? 'A' : 'B');
+}
+
+static void bh_exit(void *arg) {
+
+  (void)arg;
+  chThdExit(MSG_OK);
+}
+
+/****************************************************************************
+ * Test cases.
+ ****************************************************************************/
+
+/**
+ * @page rt_test_014_001 [14.1] Bottom halves execution and coalescing
+ *
+ * <h2>Description</h2>
+ * Two sources are raised from within a critical zone, one of them
+ * multiple times, the bottom halves are expected to be executed once
+ * each in raise order. The direct switch from thread context is also
+ * tested.
+ *
+ * <h2>Test Steps</h2>
+ * - [14.1.1] Raising source 1 three times and source 2 once from within
+ *   a critical zone, only the first raise of each source must queue the
+ *   bottom half.
+ * - [14.1.2] Checking the sources statistics.
+ * - [14.1.3] Raising source 2 from thread context, the bottom half must
+ *   be executed before returning.
+ * .
+ */
+
+static void rt_test_014_001_setup(void) {
+  rearm = 0U;
+  threads[0] = chIRQThreadCreateStatic(&it1, wa[0], WA_SIZE,
+                                       chThdGetPriorityX() + 1, "irq");
+  chIRQSourceObjectInit(&is1, &it1, bh_token, &is1);
+  chIRQSourceObjectInit(&is2, &it1, bh_token, &is2);
+  chIRQSourceObjectInit(&isexit, &it1, bh_exit, NULL);
+}
+
+static void rt_test_014_001_teardown(void) {
+  chIRQRaise(&isexit);
+  test_wait_threads();
+}
+
+static void rt_test_014_001_execute(void) {
+  bool b1, b2, b3, b4;
+
+  /* [14.1.1] Raising source 1 three times and source 2 once from within
+     a critical zone, only the first raise of each source must queue the
+     bottom half.*/
+  test_set_step(1);
+  {
+    chSysLock();
+    b1 = chIRQRaiseI(&is1);
+    b2 = chIRQRaiseI(&is1);
+    b3 = chIRQRaiseI(&is2);
+    b4 = chIRQRaiseI(&is1);
+    test_assert(chIRQIsPendingI(&is1) && chIRQIsPendingI(&is2), "not pending");
+    chSchRescheduleS();
+    chSysUnlock();
+    test_assert(b1 && !b2 && b3 && !b4, "wrong raise results");
+    test_assert_sequence("AB", "invalid sequence");
+  }
+  test_end_step(1);
+
+  /* [14.1.2] Checking the sources statistics.*/
+  test_set_step(2);
+  {
+    test_assert(is1.raised == (ucnt_t)3, "wrong raised counter");
+    test_assert(is1.coalesced == (ucnt_t)2, "wrong coalesced counter");
+    test_assert(is1.served == (ucnt_t)1, "wrong served counter");
+    test_assert(is2.raised == (ucnt_t)1, "wrong raised counter");
+    test_assert(is2.coalesced == (ucnt_t)0, "wrong coalesced counter");
+    test_assert(is2.served == (ucnt_t)1, "wrong served counter");
+    #if CH_CFG_USE_TM == TRUE
+    test_assert(is1.tm.n == (ucnt_t)1, "wrong measurements counter");
+    #endif
+  }
+  test_end_step(2);
+
+  /* [14.1.3] Raising source 2 from thread context, the bottom half must
+     be executed before returning.*/
+  test_set_step(3);
+  {
+    chIRQRaise(&is2);
+    test_emit_token('C');
+    test_assert_sequence("BC", "invalid sequence");
+  }
+  test_end_step(3);
+}
+
+static const testcase_t rt_test_014_001 = {
+  "Bottom halves execution and coalescing",
+  rt_test_014_001_setup,
+  rt_test_014_001_teardown,
+  rt_test_014_001_execute
+};
+
+/**
+ * @page rt_test_014_002 [14.2] Raise during bottom half execution
+ *
+ * <h2>Description</h2>
+ * A bottom half raises its own source while running, the source is
+ * expected to be queued again because the pending state is cleared
+ * before the bottom half is started.
+ *
+ * <h2>Test Steps</h2>
+ * - [14.2.1] Raising source 1 with one re-raise armed, the bottom half
+ *   must run twice.
+ * .
+ */
+
+static void rt_test_014_002_setup(void) {
+  rearm = 0U;
+  threads[0] = chIRQThreadCreateStatic(&it1, wa[0], WA_SIZE,
+                                       chThdGetPriorityX() + 1, "irq");
+  chIRQSourceObjectInit(&is1, &it1, bh_token, &is1);
+  chIRQSourceObjectInit(&is2, &it1, bh_token, &is2);
+  chIRQSourceObjectInit(&isexit, &it1, bh_exit, NULL);
+}
+
+static void rt_test_014_002_teardown(void) {
+  chIRQRaise(&isexit);
+  test_wait_threads();
+}
+
+static void rt_test_014_002_execute(void) {
+
+  /* [14.2.1] Raising source 1 with one re-raise armed, the bottom half
+     must run twice.*/
+  test_set_step(1);
+  {
+    rearm = 1U;
+    chIRQRaise(&is1);
+    test_assert_sequence("AA", "invalid sequence");
+    test_assert(is1.raised == (ucnt_t)2, "wrong raised counter");
+    test_assert(is1.coalesced == (ucnt_t)0, "wrong coalesced counter");
+    test_assert(is1.served == (ucnt_t)2, "wrong served counter");
+  }
+  test_end_step(1);
+}
+
+static const testcase_t rt_test_014_002 = {
+  "Raise during bottom half execution",
+  rt_test_014_002_setup,
+  rt_test_014_002_teardown,
+  rt_test_014_002_execute
+};
+
+/****************************************************************************
+ * Exported data.
+ ****************************************************************************/
+
+/**
+ * @brief   Array of test cases.
+ */
+const testcase_t * const rt_test_sequence_014_array[] = {
+  &rt_test_014_001,
+  &rt_test_014_002,
+  NULL
+};
+
+/**
+ * @brief   Threaded Interrupt Handlers.
+ */
+const testsequence_t rt_test_sequence_014 = {
+  "Threaded Interrupt Handlers",
+  rt_test_sequence_014_array
+};
+
+#endif /* CH_CFG_USE_IRQ_THREADS */